@@ -0,0 +1,104 @@
+#include "Adafruit_GFX.h"
+#include "host.h"
+
+namespace {
+
+// Оценки для ESP8266 на 80 МГц: writePixel через виртуальный вызов и проверки границ
+const uint64_t PIXEL_NANOS = 350;
+const uint64_t CHAR_BOUNDS_NANOS = 1500;
+
+void charge(uint64_t nanos) {
+    static uint64_t pending = 0;
+    pending += nanos;
+    host::advanceClock(pending / 1000);
+    pending %= 1000;
+}
+
+} // namespace
+
+void Adafruit_GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    for (int16_t i = 0; i < w; i++) {
+        drawPixel(x + i, y, color);
+        drawPixel(x + i, y + h - 1, color);
+    }
+    for (int16_t j = 1; j < h - 1; j++) {
+        drawPixel(x, y + j, color);
+        drawPixel(x + w - 1, y + j, color);
+    }
+    charge((uint64_t)(2 * w + 2 * h) * PIXEL_NANOS);
+}
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    for (int16_t j = 0; j < h; j++) {
+        for (int16_t i = 0; i < w; i++) drawPixel(x + i, y + j, color);
+    }
+    charge((uint64_t)w * h * PIXEL_NANOS);
+}
+
+void Adafruit_GFX::getTextBounds(const char* text, int16_t x, int16_t y, int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h) {
+    int16_t lineX = x;
+    int16_t maxX = x;
+    int16_t lineY = y;
+    size_t chars = 0;
+
+    for (const char* p = text; *p != '\0'; p++, chars++) {
+        if (*p == '\n') {
+            lineX = x;
+            lineY += 8 * textSize;
+            continue;
+        }
+        if (*p == '\r') continue;
+        if (wrap && lineX + 6 * textSize > WIDTH) {
+            lineX = x;
+            lineY += 8 * textSize;
+        }
+        lineX += 6 * textSize;
+        if (lineX > maxX) maxX = lineX;
+    }
+    charge(chars * CHAR_BOUNDS_NANOS);
+
+    *x1 = x;
+    *y1 = y;
+    // Как в библиотеке: последний столбец интервала между символами в ширину не входит
+    *w = maxX > x ? maxX - x - 1 : 0;
+    *h = chars > 0 ? lineY - y + 8 * textSize : 0;
+}
+
+size_t Adafruit_GFX::write(uint8_t c) {
+    if (c == '\n') {
+        cursorX = 0;
+        cursorY += 8 * textSize;
+        return 1;
+    }
+    if (c == '\r') return 1;
+
+    if (wrap && cursorX + 6 * textSize > WIDTH) {
+        cursorX = 0;
+        cursorY += 8 * textSize;
+    }
+    drawChar(cursorX, cursorY, c);
+    cursorX += 6 * textSize;
+    return 1;
+}
+
+void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c) {
+    if (c == ' ') {
+        charge(40 * textSize * textSize * PIXEL_NANOS / 4);
+        return;
+    }
+
+    for (int col = 0; col < 5; col++) {
+        uint8_t bits = ((c * (col + 3) * 37) ^ (c >> 1)) & 0x7F;
+        for (int row = 0; row < 8; row++) {
+            if (!(bits & (1 << row))) continue;
+            if (textSize == 1) {
+                drawPixel(x + col, y + row, textColor);
+            }
+            else {
+                fillRect(x + col * textSize, y + row * textSize, textSize, textSize, textColor);
+            }
+        }
+    }
+    // Библиотека проходит все 5x8 точек глифа, а не только зажжённые
+    charge(40 * textSize * textSize * PIXEL_NANOS);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Arduino.h"
+
+// Text and primitives of Adafruit_GFX with the built-in 6x8 font. There is no
+// font table on the host: glyph columns are derived from the character code,
+// which is enough for the framebuffer to change exactly where text changes.
+//
+// Drawing charges an estimate of its ESP8266 cost (80 MHz, per-pixel
+// writePixel calls in the library) to the virtual clock, so frame rates
+// measured with micros() are on the device's scale, not the host CPU's.
+class Adafruit_GFX : public Print {
+public:
+    Adafruit_GFX(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h) {}
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+    void setCursor(int16_t x, int16_t y) { cursorX = x; cursorY = y; }
+    void setTextSize(uint8_t size) { textSize = size > 0 ? size : 1; }
+    void setTextColor(uint16_t color) { textColor = color; }
+    void setTextWrap(bool wrap) { this->wrap = wrap; }
+    void getTextBounds(const char* text, int16_t x, int16_t y, int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h);
+    void getTextBounds(const String& text, int16_t x, int16_t y, int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h) {
+        getTextBounds(text.c_str(), x, y, x1, y1, w, h);
+    }
+
+    int16_t width() const { return WIDTH; }
+    int16_t height() const { return HEIGHT; }
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+protected:
+    const int16_t WIDTH;
+    const int16_t HEIGHT;
+
+private:
+    void drawChar(int16_t x, int16_t y, unsigned char c);
+
+    int16_t cursorX = 0;
+    int16_t cursorY = 0;
+    uint8_t textSize = 1;
+    uint16_t textColor = 1;
+    bool wrap = true;
+};
@@ -0,0 +1,73 @@
+#include "Adafruit_SSD1306.h"
+
+Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* wire, int8_t resetPin)
+    : Adafruit_GFX(w, h), wire(wire) {
+    (void)resetPin;
+}
+
+Adafruit_SSD1306::~Adafruit_SSD1306() {
+    delete[] buffer;
+}
+
+bool Adafruit_SSD1306::begin(uint8_t vccState, uint8_t address) {
+    (void)vccState;
+    this->address = address;
+
+    // Библиотека выделяет кадр в куче при begin(), отсюда "SSD1306 allocation failed"
+    if (buffer == nullptr) buffer = new (std::nothrow) uint8_t[WIDTH * ((HEIGHT + 7) / 8)];
+    if (buffer == nullptr) return false;
+
+    clearDisplay();
+    // Последовательность инициализации - около 25 команд
+    for (int i = 0; i < 25; i++) ssd1306_command(0);
+    ssd1306_command(SSD1306_DISPLAYON);
+    return true;
+}
+
+void Adafruit_SSD1306::clearDisplay() {
+    memset(buffer, 0, WIDTH * ((HEIGHT + 7) / 8));
+}
+
+void Adafruit_SSD1306::display() {
+    wire->setClock(WIRE_CLOCK);
+    sendCommand(SSD1306_PAGEADDR);
+    sendCommand(0);
+    sendCommand(0xFF);
+    sendCommand(SSD1306_COLUMNADDR);
+    sendCommand(0);
+    sendCommand(WIDTH - 1);
+
+    size_t size = WIDTH * ((HEIGHT + 7) / 8);
+    for (size_t sent = 0; sent < size; sent += 31) {
+        size_t count = std::min<size_t>(31, size - sent);
+        wire->beginTransmission(address);
+        wire->write((uint8_t)0x40);
+        wire->write(buffer + sent, count);
+        wire->endTransmission();
+    }
+    wire->setClock(RESTORE_CLOCK);
+}
+
+// Как в библиотеке: команда идёт на 400 кГц, затем частота возвращается к 100 кГц
+void Adafruit_SSD1306::ssd1306_command(uint8_t command) {
+    wire->setClock(WIRE_CLOCK);
+    sendCommand(command);
+    wire->setClock(RESTORE_CLOCK);
+}
+
+void Adafruit_SSD1306::sendCommand(uint8_t command) {
+    wire->beginTransmission(address);
+    wire->write((uint8_t)0x00);
+    wire->write(command);
+    wire->endTransmission();
+}
+
+void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (buffer == nullptr || x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT) return;
+
+    uint8_t& cell = buffer[x + (y / 8) * WIDTH];
+    uint8_t bit = 1 << (y & 7);
+    if (color == SSD1306_WHITE) cell |= bit;
+    else if (color == SSD1306_BLACK) cell &= ~bit;
+    else cell ^= bit;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Adafruit_GFX.h"
+#include "Wire.h"
+
+#define SSD1306_BLACK 0
+#define SSD1306_WHITE 1
+#define SSD1306_INVERSE 2
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+#define SSD1306_DISPLAYOFF 0xAE
+#define SSD1306_DISPLAYON 0xAF
+
+// SSD1306 over I2C: the framebuffer is real, the panel is the Wire bus time
+class Adafruit_SSD1306 : public Adafruit_GFX {
+public:
+    Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire* wire, int8_t resetPin = -1);
+    ~Adafruit_SSD1306() override;
+
+    bool begin(uint8_t vccState = SSD1306_SWITCHCAPVCC, uint8_t address = 0x3C);
+    void clearDisplay();
+    void display();
+    void dim(bool dim) { ssd1306_command(0x81); ssd1306_command(dim ? 0 : 0xCF); }
+    uint8_t* getBuffer() { return buffer; }
+    void ssd1306_command(uint8_t command);
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+
+private:
+    // Defaults of the library's wireClk and restoreClk
+    static const uint32_t WIRE_CLOCK = 400000;
+    static const uint32_t RESTORE_CLOCK = 100000;
+
+    void sendCommand(uint8_t command);
+
+    TwoWire* wire;
+    uint8_t address = 0x3C;
+    uint8_t* buffer = nullptr;
+};
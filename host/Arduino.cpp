@@ -0,0 +1,543 @@
+#include "Arduino.h"
+#include "host.h"
+
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <new>
+#include <random>
+#include <vector>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+namespace {
+
+const size_t RTC_USER_MEMORY = 512;
+
+uint64_t steadyMicros() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+std::atomic<uint64_t> clockStart{steadyMicros()};
+std::atomic<uint64_t> clockSkipped{0};
+std::atomic<uint64_t> clockSlept{0};
+std::atomic<uint64_t> delayed{0};
+std::atomic<uint64_t> idleCalls{0};
+bool clockRealtime = getenv("ARDUINOID_REALTIME") != nullptr;
+
+bool serialEcho = getenv("ARDUINOID_QUIET") == nullptr;
+uint64_t serialWritten = 0;
+
+std::atomic<size_t> heapBytes{0};
+std::atomic<size_t> heapHigh{0};
+std::atomic<uint64_t> heapCount{0};
+size_t simulatedHeap = 48 * 1024;
+
+int pins[32] = {};
+
+struct PinInterrupt {
+    void (*handler)();
+    int mode;
+};
+
+struct PinChange {
+    uint64_t at;
+    uint8_t pin;
+    int value;
+};
+
+PinInterrupt pinInterrupts[32] = {};
+// По возрастанию времени; элементы добавляются под HeapUntracked
+std::vector<PinChange> pinChanges;
+bool pinChangesRunning = false;
+// ~3.9 V на делителе 1:2, как у заряженного аккумулятора
+int analogValue = 604;
+std::mt19937 rng(1);
+
+rst_info resetInfo = { REASON_DEFAULT_RST, 0, 0, 0, 0, 0, 0 };
+std::function<void(uint64_t)> deepSleepHandler;
+
+uint8_t* sharedRtcMemory() {
+    // MAP_SHARED: дочерние процессы power_sim видят запись, как RTC-память переживает сон
+    static uint8_t* memory = [] {
+        void* p = mmap(nullptr, RTC_USER_MEMORY, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        return p == MAP_FAILED ? nullptr : (uint8_t*)p;
+    }();
+    return memory;
+}
+
+uint8_t* rtcMemoryAtStartup = sharedRtcMemory();
+
+thread_local int untrackedDepth = 0;
+
+// Заголовок перед каждым блоком: учтённый размер, 0 - блок вне учёта
+struct alignas(16) AllocationHeader {
+    size_t charged;
+};
+
+void charge(size_t size) {
+    size_t now = heapBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t high = heapHigh.load(std::memory_order_relaxed);
+    while (now > high && !heapHigh.compare_exchange_weak(high, now, std::memory_order_relaxed)) {
+    }
+    heapCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* allocate(size_t size) {
+    AllocationHeader* header = (AllocationHeader*)malloc(sizeof(AllocationHeader) + size);
+    if (header == nullptr) return nullptr;
+
+    // umm_malloc в ядре ESP8266 выдаёт блоки по 8 байт с 4-байтным заголовком
+    header->charged = untrackedDepth > 0 ? 0 : (size + 4 + 7) & ~(size_t)7;
+    if (header->charged > 0) charge(header->charged);
+    return header + 1;
+}
+
+void release(void* p) {
+    if (p == nullptr) return;
+    AllocationHeader* header = (AllocationHeader*)p - 1;
+    if (header->charged > 0) heapBytes.fetch_sub(header->charged, std::memory_order_relaxed);
+    free(header);
+}
+
+uint64_t virtualMicros() {
+    return steadyMicros() - clockStart.load() + clockSkipped.load();
+}
+
+void applyPin(uint8_t pin, int value) {
+    if (pin >= 32) return;
+    int previous = pins[pin];
+    pins[pin] = value;
+
+    const PinInterrupt& irq = pinInterrupts[pin];
+    if (irq.handler == nullptr || previous == value) return;
+    if (irq.mode == CHANGE || (irq.mode == RISING && value == HIGH) || (irq.mode == FALLING && value == LOW)) {
+        irq.handler();
+    }
+}
+
+// Изменения со сроком до until применяются по одному, часы перед каждым ставятся на его срок,
+// так что обработчик прерывания видит в millis() точное время фронта
+void runPinChanges(uint64_t until) {
+    if (pinChangesRunning) return;
+    pinChangesRunning = true;
+    while (!pinChanges.empty() && pinChanges.front().at <= until) {
+        PinChange change = pinChanges.front();
+        pinChanges.erase(pinChanges.begin());
+        uint64_t now = virtualMicros();
+        if (change.at > now) clockSkipped += change.at - now;
+        applyPin(change.pin, change.value);
+    }
+    pinChangesRunning = false;
+}
+
+void skipClock(uint64_t micros) {
+    if (pinChanges.empty()) {
+        clockSkipped += micros;
+        return;
+    }
+    uint64_t target = virtualMicros() + micros;
+    runPinChanges(target);
+    uint64_t now = virtualMicros();
+    if (target > now) clockSkipped += target - now;
+}
+
+} // namespace
+
+// Вся куча C++ проходит через счётчик: так ESP.getFreeHeap() и минимумы в отчёте
+// отражают выделения прошивки, а не только процесса целиком
+void* operator new(size_t size) {
+    void* p = allocate(size);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    release(p);
+}
+
+void operator delete[](void* p) noexcept {
+    release(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    release(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    release(p);
+}
+
+namespace host {
+
+uint64_t clockMicros() {
+    return virtualMicros();
+}
+
+void advanceClock(uint64_t micros) {
+    skipClock(micros);
+}
+
+void resetClock() {
+    clockStart = steadyMicros();
+    clockSkipped = 0;
+    clockSlept = 0;
+    delayed = 0;
+    idleCalls = 0;
+}
+
+void setRealtime(bool realtime) {
+    clockRealtime = realtime;
+}
+
+uint64_t busyMicros() {
+    return steadyMicros() - clockStart.load() - clockSlept.load();
+}
+
+uint64_t delayedMicros() {
+    return delayed.load();
+}
+
+uint64_t idleCount() {
+    return idleCalls.load();
+}
+
+void setSerialEcho(bool echo) {
+    serialEcho = echo;
+}
+
+uint64_t serialBytes() {
+    return serialWritten;
+}
+
+size_t heapSize() {
+    return simulatedHeap;
+}
+
+void setHeapSize(size_t bytes) {
+    simulatedHeap = bytes;
+}
+
+size_t heapInUse() {
+    return heapBytes.load(std::memory_order_relaxed);
+}
+
+size_t heapPeak() {
+    return heapHigh.load(std::memory_order_relaxed);
+}
+
+void resetHeapPeak() {
+    heapHigh = heapBytes.load();
+}
+
+uint64_t heapAllocations() {
+    return heapCount.load(std::memory_order_relaxed);
+}
+
+void heapCharge(size_t bytes) {
+    charge(bytes);
+}
+
+void heapRelease(size_t bytes) {
+    heapBytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+HeapUntracked::HeapUntracked() {
+    untrackedDepth++;
+}
+
+HeapUntracked::~HeapUntracked() {
+    untrackedDepth--;
+}
+
+void setPin(uint8_t pin, int value) {
+    applyPin(pin, value);
+}
+
+void schedulePin(uint8_t pin, int value, uint64_t atMicros) {
+    HeapUntracked untracked;
+    PinChange change = { atMicros, pin, value };
+    auto later = std::upper_bound(pinChanges.begin(), pinChanges.end(), change,
+        [](const PinChange& a, const PinChange& b) { return a.at < b.at; });
+    pinChanges.insert(later, change);
+}
+
+void setAnalog(uint8_t pin, int value) {
+    (void)pin;
+    analogValue = value;
+}
+
+void seedRandom(uint32_t seed) {
+    rng.seed(seed);
+}
+
+void setResetReason(uint32_t reason) {
+    resetInfo.reason = reason;
+}
+
+void setDeepSleepHandler(std::function<void(uint64_t micros)> handler) {
+    deepSleepHandler = handler;
+}
+
+uint8_t* rtcMemory() {
+    return sharedRtcMemory();
+}
+
+} // namespace host
+
+unsigned long millis() {
+    if (!pinChanges.empty()) runPinChanges(virtualMicros());
+    return virtualMicros() / 1000;
+}
+
+unsigned long micros() {
+    if (!pinChanges.empty()) runPinChanges(virtualMicros());
+    return virtualMicros();
+}
+
+void delay(unsigned long ms) {
+    idleCalls++;
+    if (ms == 0) return;
+    delayed += (uint64_t)ms * 1000;
+
+    if (clockRealtime) {
+        uint64_t start = steadyMicros();
+        usleep(ms * 1000);
+        clockSlept += steadyMicros() - start;
+    }
+    else {
+        skipClock((uint64_t)ms * 1000);
+    }
+}
+
+void delayMicroseconds(unsigned int us) {
+    skipClock(us);
+}
+
+void yield() {
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < 32 && mode == INPUT_PULLUP) pins[pin] = HIGH;
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < 32 ? pins[pin] : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < 32) pins[pin] = value;
+}
+
+int analogRead(uint8_t pin) {
+    (void)pin;
+    return analogValue;
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode) {
+    if (pin < 32) pinInterrupts[pin] = { handler, mode };
+}
+
+void detachInterrupt(uint8_t pin) {
+    if (pin < 32) pinInterrupts[pin] = { nullptr, 0 };
+}
+
+long random(long howBig) {
+    if (howBig <= 0) return 0;
+    return (long)(rng() % (unsigned long)howBig);
+}
+
+long random(long howSmall, long howBig) {
+    if (howSmall >= howBig) return howSmall;
+    return howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long seed) {
+    rng.seed(seed);
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+uint32_t EspClass::getFreeHeap() {
+    size_t used = host::heapInUse();
+    return used < simulatedHeap ? simulatedHeap - used : 0;
+}
+
+uint32_t EspClass::getMaxFreeBlockSize() {
+    // Фрагментацию хост не моделирует: весь свободный остаток считается одним блоком
+    return getFreeHeap();
+}
+
+uint8_t EspClass::getHeapFragmentation() {
+    return 0;
+}
+
+uint32_t EspClass::getChipId() {
+    return 0x00A1B2C3;
+}
+
+uint32_t EspClass::getCycleCount() {
+    return (uint32_t)(host::clockMicros() * 80);
+}
+
+void EspClass::deepSleep(uint64_t time_us, RFMode mode) {
+    (void)mode;
+    Serial.flush();
+    if (deepSleepHandler) deepSleepHandler(time_us);
+
+    fprintf(stdout, "[host] deep sleep for %llu us, exiting\n", (unsigned long long)time_us);
+    fflush(stdout);
+    exit(0);
+}
+
+uint64_t EspClass::deepSleepMax() {
+    // Типичное значение для ESP8266 - около 3,5 часа, зависит от калибровки RTC
+    return 12600000000ULL;
+}
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size) {
+    uint8_t* memory = sharedRtcMemory();
+    if (memory == nullptr || offset * 4 + size > RTC_USER_MEMORY) return false;
+    memcpy(data, memory + offset * 4, size);
+    return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size) {
+    uint8_t* memory = sharedRtcMemory();
+    if (memory == nullptr || offset * 4 + size > RTC_USER_MEMORY) return false;
+    memcpy(memory + offset * 4, data, size);
+    return true;
+}
+
+rst_info* EspClass::getResetInfoPtr() {
+    return &resetInfo;
+}
+
+String EspClass::getResetReason() {
+    return resetInfo.reason == REASON_DEEP_SLEEP_AWAKE ? "Deep-Sleep Wake" : "Power On";
+}
+
+void EspClass::restart() {
+    fprintf(stdout, "[host] ESP.restart(), exiting\n");
+    exit(0);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    serialWritten += size;
+    if (serialEcho) fwrite(buffer, 1, size, stdout);
+    return size;
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+    while (size-- > 0) {
+        if (write(*buffer++) == 0) break;
+        written++;
+    }
+    return written;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (length < 0) return 0;
+
+    if ((size_t)length < sizeof(line)) return write((const uint8_t*)line, length);
+
+    std::string longer(length + 1, '\0');
+    va_start(args, format);
+    vsnprintf(&longer[0], longer.size(), format, args);
+    va_end(args);
+    return write((const uint8_t*)longer.data(), length);
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = read();
+        if (c < 0) break;
+        buffer[count++] = (char)c;
+    }
+    return count;
+}
+
+String Stream::readString() {
+    String result;
+    int c;
+    while ((c = read()) >= 0) result += (char)c;
+    return result;
+}
+
+std::string String::format(long long value, unsigned char base) {
+    if (value < 0 && base == DEC) return "-" + format((unsigned long long)-value, base);
+    return format((unsigned long long)value, base);
+}
+
+std::string String::format(unsigned long long value, unsigned char base) {
+    if (base < 2 || base > 36) base = DEC;
+
+    char digits[65];
+    int i = sizeof(digits) - 1;
+    digits[i] = '\0';
+    do {
+        int digit = value % base;
+        digits[--i] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= base;
+    } while (value > 0);
+    return digits + i;
+}
+
+std::string String::format(double value, unsigned char decimals) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    return buffer;
+}
+
+void String::trim() {
+    size_t start = 0;
+    while (start < s.length() && isspace((unsigned char)s[start])) start++;
+    size_t end = s.length();
+    while (end > start && isspace((unsigned char)s[end - 1])) end--;
+    s = s.substr(start, end - start);
+}
+
+void String::toLowerCase() {
+    for (char& c : s) c = tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+    for (char& c : s) c = toupper((unsigned char)c);
+}
+
+void String::toCharArray(char* buffer, unsigned int size, unsigned int index) const {
+    if (size == 0) return;
+    size_t length = index < s.length() ? std::min<size_t>(size - 1, s.length() - index) : 0;
+    memcpy(buffer, s.data() + std::min<size_t>(index, s.length()), length);
+    buffer[length] = '\0';
+}
@@ -0,0 +1,290 @@
+// Host build of the sketch: the subset of the ESP8266 Arduino core that
+// main.cpp uses, implemented on top of the C++ standard library.
+//
+// millis()/micros() run on a virtual clock: real time since start plus the
+// time skipped by delay(), so a simulated day passes in seconds. Heap
+// figures come from the counting operator new in Arduino.cpp. See host.h
+// for the controls the drivers use.
+#pragma once
+
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HEX 16
+#define DEC 10
+#define OCT 8
+#define BIN 2
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define A0 17
+
+#define RISING 1
+#define FALLING 2
+#define CHANGE 3
+#define digitalPinToInterrupt(p) ((p) < 16 ? (p) : -1)
+
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+#define FPSTR(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+
+inline void* memcpy_P(void* dest, const void* src, size_t length) {
+    return memcpy(dest, src, length);
+}
+
+inline size_t strlen_P(const char* s) {
+    return strlen(s);
+}
+
+inline uint8_t pgm_read_byte(const void* p) {
+    return *(const uint8_t*)p;
+}
+
+using std::max;
+using std::min;
+
+class String {
+public:
+    String(const char* value = "") : s(value != nullptr ? value : "") {}
+    String(const __FlashStringHelper* value) : s(reinterpret_cast<const char*>(value)) {}
+    String(const std::string& value) : s(value) {}
+    explicit String(char c) : s(1, c) {}
+    explicit String(int value, unsigned char base = DEC) : s(format((long long)value, base)) {}
+    explicit String(unsigned int value, unsigned char base = DEC) : s(format((unsigned long long)value, base)) {}
+    explicit String(long value, unsigned char base = DEC) : s(format((long long)value, base)) {}
+    explicit String(unsigned long value, unsigned char base = DEC) : s(format((unsigned long long)value, base)) {}
+    explicit String(long long value, unsigned char base = DEC) : s(format(value, base)) {}
+    explicit String(unsigned long long value, unsigned char base = DEC) : s(format(value, base)) {}
+    explicit String(float value, unsigned char decimals = 2) : s(format((double)value, decimals)) {}
+    explicit String(double value, unsigned char decimals = 2) : s(format(value, decimals)) {}
+
+    unsigned int length() const { return s.length(); }
+    bool isEmpty() const { return s.empty(); }
+    const char* c_str() const { return s.c_str(); }
+    bool reserve(unsigned int size) { s.reserve(size); return true; }
+
+    String substring(unsigned int from) const {
+        return from >= s.length() ? String() : String(s.substr(from));
+    }
+
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) std::swap(from, to);
+        if (from >= s.length()) return String();
+        return String(s.substr(from, std::min<size_t>(to, s.length()) - from));
+    }
+
+    bool startsWith(const String& prefix) const { return s.compare(0, prefix.s.length(), prefix.s) == 0; }
+    bool endsWith(const String& suffix) const {
+        return s.length() >= suffix.s.length() && s.compare(s.length() - suffix.s.length(), suffix.s.length(), suffix.s) == 0;
+    }
+    int indexOf(char c, unsigned int from = 0) const { return position(s.find(c, from)); }
+    int indexOf(const String& value, unsigned int from = 0) const { return position(s.find(value.s, from)); }
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return atof(s.c_str()); }
+    bool equals(const String& other) const { return s == other.s; }
+    void trim();
+    void toLowerCase();
+    void toUpperCase();
+    void toCharArray(char* buffer, unsigned int size, unsigned int index = 0) const;
+
+    bool concat(const String& value) { s += value.s; return true; }
+    bool concat(const char* value) { s += value != nullptr ? value : ""; return true; }
+    bool concat(char c) { s += c; return true; }
+
+    String& operator+=(const String& value) { concat(value); return *this; }
+    String& operator+=(const char* value) { concat(value); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+    String& operator+=(int value) { return *this += String(value); }
+    String& operator+=(unsigned int value) { return *this += String(value); }
+    String& operator+=(long value) { return *this += String(value); }
+    String& operator+=(unsigned long value) { return *this += String(value); }
+
+    char operator[](unsigned int index) const { return index < s.length() ? s[index] : '\0'; }
+    char charAt(unsigned int index) const { return (*this)[index]; }
+
+    bool operator==(const String& other) const { return s == other.s; }
+    bool operator!=(const String& other) const { return s != other.s; }
+    bool operator==(const char* other) const { return s == (other != nullptr ? other : ""); }
+    bool operator!=(const char* other) const { return !(*this == other); }
+    bool operator<(const String& other) const { return s < other.s; }
+
+    const std::string& str() const { return s; }
+
+private:
+    static int position(size_t found) { return found == std::string::npos ? -1 : (int)found; }
+    static std::string format(long long value, unsigned char base);
+    static std::string format(unsigned long long value, unsigned char base);
+    static std::string format(double value, unsigned char decimals);
+
+    std::string s;
+};
+
+inline String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+inline String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, char b) { String r(a); r += b; return r; }
+inline bool operator==(const char* a, const String& b) { return b == a; }
+inline bool operator!=(const char* a, const String& b) { return b != a; }
+
+class Print;
+
+class Printable {
+public:
+    virtual ~Printable() {}
+    virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* s) { return s != nullptr ? write((const uint8_t*)s, strlen(s)) : 0; }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(const String& s) { return write(s.c_str(), s.length()); }
+    size_t print(const __FlashStringHelper* s) { return write(reinterpret_cast<const char*>(s)); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int value, int base = DEC) { return print(String(value, base)); }
+    size_t print(unsigned int value, int base = DEC) { return print(String(value, base)); }
+    size_t print(long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(unsigned long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(long long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(unsigned long long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(double value, int decimals = 2) { return print(String(value, decimals)); }
+    size_t print(const Printable& value) { return value.printTo(*this); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T& value) { size_t n = print(value); return n + println(); }
+    template <typename T>
+    size_t println(const T& value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout) { streamTimeout = timeout; }
+    unsigned long getTimeout() const { return streamTimeout; }
+    size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+    String readString();
+
+protected:
+    unsigned long streamTimeout = 1000;
+};
+
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    int availableForWrite() override { return 128; }
+};
+
+extern HardwareSerial Serial;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+int analogRead(uint8_t pin);
+// Handlers run synchronously from host::setPin() and from scheduled pin changes
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode);
+void detachInterrupt(uint8_t pin);
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+template <typename T, typename L, typename H>
+T constrain(T x, L low, H high) {
+    return x < low ? low : (x > high ? high : x);
+}
+
+#define REASON_DEFAULT_RST 0
+#define REASON_WDT_RST 1
+#define REASON_EXCEPTION_RST 2
+#define REASON_SOFT_WDT_RST 3
+#define REASON_SOFT_RESTART 4
+#define REASON_DEEP_SLEEP_AWAKE 5
+#define REASON_EXT_SYS_RST 6
+
+struct rst_info {
+    uint32_t reason;
+    uint32_t exccause;
+    uint32_t epc1;
+    uint32_t epc2;
+    uint32_t epc3;
+    uint32_t excvaddr;
+    uint32_t depc;
+};
+
+enum RFMode {
+    RF_DEFAULT = 0,
+    RF_CAL = 1,
+    RF_NO_CAL = 2,
+    RF_DISABLED = 4
+};
+
+class EspClass {
+public:
+    uint32_t getFreeHeap();
+    uint32_t getMaxFreeBlockSize();
+    uint8_t getHeapFragmentation();
+    uint32_t getChipId();
+    uint32_t getCycleCount();
+    void deepSleep(uint64_t time_us, RFMode mode = RF_DEFAULT);
+    uint64_t deepSleepMax();
+    bool rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size);
+    bool rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size);
+    rst_info* getResetInfoPtr();
+    String getResetReason();
+    void restart();
+};
+
+extern EspClass ESP;
@@ -0,0 +1,717 @@
+#include "ArduinoJson.h"
+#include "host.h"
+
+#include <errno.h>
+
+#include <new>
+
+using ArduinoJsonHost::Node;
+
+namespace ArduinoJsonHost {
+
+Node* findMember(const Node* object, const char* key) {
+    if (object == nullptr || object->type != Node::Object || key == nullptr) return nullptr;
+    for (Node* slot = object->children.head; slot != nullptr; slot = slot->next) {
+        if (strcmp(slot->key, key) == 0) return slot;
+    }
+    return nullptr;
+}
+
+Node* elementAt(const Node* array, size_t index) {
+    if (array == nullptr || array->type != Node::Array) return nullptr;
+    Node* slot = array->children.head;
+    while (slot != nullptr && index-- > 0) slot = slot->next;
+    return slot;
+}
+
+size_t childCount(const Node* node) {
+    if (node == nullptr || (node->type != Node::Object && node->type != Node::Array)) return 0;
+    size_t count = 0;
+    for (Node* slot = node->children.head; slot != nullptr; slot = slot->next) count++;
+    return count;
+}
+
+namespace {
+
+size_t writeText(Output& out, const char* text) {
+    size_t length = strlen(text);
+    out.write(text, length);
+    return length;
+}
+
+size_t writeString(Output& out, const char* value) {
+    size_t length = writeText(out, "\"");
+    for (const char* p = value; *p != '\0'; p++) {
+        char escaped[8];
+        switch (*p) {
+        case '"': length += writeText(out, "\\\""); break;
+        case '\\': length += writeText(out, "\\\\"); break;
+        case '\b': length += writeText(out, "\\b"); break;
+        case '\f': length += writeText(out, "\\f"); break;
+        case '\n': length += writeText(out, "\\n"); break;
+        case '\r': length += writeText(out, "\\r"); break;
+        case '\t': length += writeText(out, "\\t"); break;
+        default:
+            if ((unsigned char)*p < 0x20) {
+                snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)*p);
+                length += writeText(out, escaped);
+            }
+            else {
+                out.write(p, 1);
+                length++;
+            }
+        }
+    }
+    return length + writeText(out, "\"");
+}
+
+} // namespace
+
+size_t serialize(const Node* node, Output& out) {
+    char number[32];
+
+    switch (node != nullptr ? node->type : Node::Null) {
+    case Node::Null:
+        return writeText(out, "null");
+    case Node::Bool:
+        return writeText(out, node->boolean ? "true" : "false");
+    case Node::Int:
+        snprintf(number, sizeof(number), "%lld", (long long)node->integer);
+        return writeText(out, number);
+    case Node::UInt:
+        snprintf(number, sizeof(number), "%llu", (unsigned long long)node->uinteger);
+        return writeText(out, number);
+    case Node::Float:
+        if (isnan(node->real) || isinf(node->real)) return writeText(out, "null");
+        snprintf(number, sizeof(number), "%.9g", node->real);
+        return writeText(out, number);
+    case Node::String:
+        return writeString(out, node->string);
+    case Node::Object:
+    case Node::Array: {
+        bool object = node->type == Node::Object;
+        size_t length = writeText(out, object ? "{" : "[");
+        for (Node* slot = node->children.head; slot != nullptr; slot = slot->next) {
+            if (slot != node->children.head) length += writeText(out, ",");
+            if (object) {
+                length += writeString(out, slot->key);
+                length += writeText(out, ":");
+            }
+            length += serialize(slot, out);
+        }
+        return length + writeText(out, object ? "}" : "]");
+    }
+    }
+    return 0;
+}
+
+namespace {
+
+// Разбор с фильтром: значения, не прошедшие фильтр, проверяются, но не сохраняются
+class Parser {
+public:
+    Parser(JsonDocument& doc, Input& input, uint8_t nestingLimit) : doc(doc), input(input), nestingLimit(nestingLimit) {}
+    ~Parser() { free(text); }
+
+    DeserializationError parse(Node* target, const Node* filter) {
+        current = input.next();
+        skipSpace();
+        if (current < 0) return DeserializationError::EmptyInput;
+        return value(target, filter, 0);
+    }
+
+private:
+    static const Node* allowAll() {
+        static Node all;
+        all.type = Node::Bool;
+        all.boolean = true;
+        return &all;
+    }
+
+    static bool allowsValue(const Node* filter) {
+        return filter == nullptr || (filter->type == Node::Bool && filter->boolean);
+    }
+
+    const Node* memberFilter(const Node* filter, const char* key) {
+        if (allowsValue(filter)) return allowAll();
+        const Node* found = findMember(filter, key);
+        return found != nullptr ? found : findMember(filter, "*");
+    }
+
+    void advance() {
+        current = input.next();
+    }
+
+    void skipSpace() {
+        while (current == ' ' || current == '\t' || current == '\n' || current == '\r') advance();
+    }
+
+    DeserializationError value(Node* target, const Node* filter, uint8_t depth) {
+        skipSpace();
+        if (current < 0) return DeserializationError::IncompleteInput;
+
+        bool keep = target != nullptr && (allowsValue(filter) ||
+            (current == '{' && filter->type == Node::Object) || (current == '[' && filter->type == Node::Array));
+        if (!keep) target = nullptr;
+
+        switch (current) {
+        case '{':
+            return object(target, filter, depth);
+        case '[':
+            return array(target, filter, depth);
+        case '"':
+        case '\'': {
+            size_t length;
+            DeserializationError error = string(length);
+            if (error || target == nullptr) return error;
+            const char* copy = doc.copyString(text, length);
+            if (copy == nullptr) return DeserializationError::NoMemory;
+            target->type = Node::String;
+            target->string = copy;
+            return DeserializationError::Ok;
+        }
+        default:
+            return literal(target);
+        }
+    }
+
+    DeserializationError object(Node* target, const Node* filter, uint8_t depth) {
+        if (depth >= nestingLimit) return DeserializationError::TooDeep;
+        advance();
+
+        if (target != nullptr) {
+            target->type = Node::Object;
+            target->children = { nullptr, nullptr };
+        }
+
+        skipSpace();
+        if (current == '}') {
+            advance();
+            return DeserializationError::Ok;
+        }
+
+        for (;;) {
+            skipSpace();
+            if (current < 0) return DeserializationError::IncompleteInput;
+            if (current != '"' && current != '\'') return DeserializationError::InvalidInput;
+
+            size_t keyLength;
+            DeserializationError error = string(keyLength);
+            if (error) return error;
+
+            skipSpace();
+            if (current < 0) return DeserializationError::IncompleteInput;
+            if (current != ':') return DeserializationError::InvalidInput;
+            advance();
+
+            const Node* childFilter = target != nullptr ? memberFilter(filter, text) : nullptr;
+            Node* child = nullptr;
+            if (childFilter != nullptr) {
+                const char* key = doc.copyString(text, keyLength);
+                child = doc.allocateNode();
+                if (key == nullptr || child == nullptr) return DeserializationError::NoMemory;
+                child->key = key;
+            }
+
+            error = value(child, childFilter != nullptr ? childFilter : allowAll(), depth + 1);
+            if (error) return error;
+
+            // Отфильтрованное по вложенному фильтру значение всё равно остаётся членом,
+            // как в ArduinoJson: ключ известен, просто содержимое урезано
+            if (child != nullptr) append(target, child);
+
+            skipSpace();
+            if (current < 0) return DeserializationError::IncompleteInput;
+            if (current == '}') {
+                advance();
+                return DeserializationError::Ok;
+            }
+            if (current != ',') return DeserializationError::InvalidInput;
+            advance();
+        }
+    }
+
+    DeserializationError array(Node* target, const Node* filter, uint8_t depth) {
+        if (depth >= nestingLimit) return DeserializationError::TooDeep;
+        advance();
+
+        const Node* elementFilter = allowsValue(filter) ? allowAll() : elementAt(filter, 0);
+        if (target != nullptr) {
+            target->type = Node::Array;
+            target->children = { nullptr, nullptr };
+        }
+
+        skipSpace();
+        if (current == ']') {
+            advance();
+            return DeserializationError::Ok;
+        }
+
+        for (;;) {
+            Node* child = nullptr;
+            if (target != nullptr && elementFilter != nullptr) {
+                child = doc.allocateNode();
+                if (child == nullptr) return DeserializationError::NoMemory;
+            }
+
+            DeserializationError error = value(child, elementFilter != nullptr ? elementFilter : allowAll(), depth + 1);
+            if (error) return error;
+            if (child != nullptr) append(target, child);
+
+            skipSpace();
+            if (current < 0) return DeserializationError::IncompleteInput;
+            if (current == ']') {
+                advance();
+                return DeserializationError::Ok;
+            }
+            if (current != ',') return DeserializationError::InvalidInput;
+            advance();
+        }
+    }
+
+    static void append(Node* parent, Node* child) {
+        if (parent->children.tail != nullptr) parent->children.tail->next = child;
+        else parent->children.head = child;
+        parent->children.tail = child;
+    }
+
+    bool push(char c) {
+        if (textLength + 1 >= textCapacity) {
+            // Рабочий буфер не через operator new, чтобы не искажать учёт кучи прошивки
+            size_t capacity = textCapacity > 0 ? textCapacity * 2 : 64;
+            char* grown = (char*)realloc(text, capacity);
+            if (grown == nullptr) return false;
+            text = grown;
+            textCapacity = capacity;
+        }
+        text[textLength++] = c;
+        text[textLength] = '\0';
+        return true;
+    }
+
+    void pushUtf8(uint32_t codepoint) {
+        if (codepoint < 0x80) {
+            push(codepoint);
+        }
+        else if (codepoint < 0x800) {
+            push(0xC0 | codepoint >> 6);
+            push(0x80 | (codepoint & 0x3F));
+        }
+        else if (codepoint < 0x10000) {
+            push(0xE0 | codepoint >> 12);
+            push(0x80 | ((codepoint >> 6) & 0x3F));
+            push(0x80 | (codepoint & 0x3F));
+        }
+        else {
+            push(0xF0 | codepoint >> 18);
+            push(0x80 | ((codepoint >> 12) & 0x3F));
+            push(0x80 | ((codepoint >> 6) & 0x3F));
+            push(0x80 | (codepoint & 0x3F));
+        }
+    }
+
+    bool hex4(uint32_t& value) {
+        value = 0;
+        for (int i = 0; i < 4; i++) {
+            advance();
+            if (!isxdigit(current)) return false;
+            value = value << 4 | (isdigit(current) ? current - '0' : (tolower(current) - 'a' + 10));
+        }
+        return true;
+    }
+
+    DeserializationError string(size_t& length) {
+        int quote = current;
+        textLength = 0;
+        push('\0');
+        textLength = 0;
+
+        for (;;) {
+            advance();
+            if (current < 0) return DeserializationError::IncompleteInput;
+            if (current == quote) break;
+
+            if (current != '\\') {
+                if (!push(current)) return DeserializationError::NoMemory;
+                continue;
+            }
+
+            advance();
+            uint32_t codepoint;
+            switch (current) {
+            case -1: return DeserializationError::IncompleteInput;
+            case 'b': push('\b'); break;
+            case 'f': push('\f'); break;
+            case 'n': push('\n'); break;
+            case 'r': push('\r'); break;
+            case 't': push('\t'); break;
+            case 'u':
+                if (!hex4(codepoint)) return current < 0 ? DeserializationError::IncompleteInput : DeserializationError::InvalidInput;
+                if (codepoint >= 0xD800 && codepoint < 0xDC00) {
+                    uint32_t low;
+                    advance();
+                    if (current != '\\') return DeserializationError::InvalidInput;
+                    advance();
+                    if (current != 'u' || !hex4(low)) return DeserializationError::InvalidInput;
+                    codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                }
+                pushUtf8(codepoint);
+                break;
+            default:
+                push(current);
+            }
+        }
+
+        advance();
+        length = textLength;
+        return DeserializationError::Ok;
+    }
+
+    DeserializationError literal(Node* target) {
+        textLength = 0;
+        while (current >= 0 && (isalnum(current) || current == '-' || current == '+' || current == '.')) {
+            push(current);
+            advance();
+        }
+        if (textLength == 0) return current < 0 ? DeserializationError::IncompleteInput : DeserializationError::InvalidInput;
+
+        Node parsed;
+        if (strcmp(text, "true") == 0 || strcmp(text, "false") == 0) {
+            parsed.type = Node::Bool;
+            parsed.boolean = text[0] == 't';
+        }
+        else if (strcmp(text, "null") == 0) {
+            parsed.type = Node::Null;
+        }
+        else if (!number(parsed)) {
+            return current < 0 && textLength < 5 ? DeserializationError::IncompleteInput : DeserializationError::InvalidInput;
+        }
+
+        if (target != nullptr) {
+            target->type = parsed.type;
+            target->uinteger = parsed.uinteger;
+        }
+        return DeserializationError::Ok;
+    }
+
+    bool number(Node& parsed) {
+        char* end;
+        errno = 0;
+        if (strpbrk(text, ".eE") == nullptr) {
+            if (text[0] == '-') {
+                long long value = strtoll(text, &end, 10);
+                if (*end == '\0' && errno == 0) {
+                    parsed.type = Node::Int;
+                    parsed.integer = value;
+                    return true;
+                }
+            }
+            else {
+                unsigned long long value = strtoull(text, &end, 10);
+                if (*end == '\0' && errno == 0 && isdigit((unsigned char)text[0])) {
+                    parsed.type = Node::UInt;
+                    parsed.uinteger = value;
+                    return true;
+                }
+            }
+        }
+
+        double value = strtod(text, &end);
+        if (*end != '\0' || !(isdigit((unsigned char)text[0]) || text[0] == '-')) return false;
+        parsed.type = Node::Float;
+        parsed.real = value;
+        return true;
+    }
+
+    JsonDocument& doc;
+    Input& input;
+    uint8_t nestingLimit;
+    int current = -1;
+    char* text = nullptr;
+    size_t textLength = 0;
+    size_t textCapacity = 0;
+};
+
+} // namespace
+
+DeserializationError deserialize(JsonDocument& doc, Input& input, const Node* filter, uint8_t nestingLimit) {
+    doc.clear();
+    Parser parser(doc, input, nestingLimit);
+    Node* root = const_cast<Node*>(doc.rootNode());
+    return parser.parse(root, filter);
+}
+
+} // namespace ArduinoJsonHost
+
+const char* DeserializationError::c_str() const {
+    static const char* const names[] = { "Ok", "EmptyInput", "IncompleteInput", "InvalidInput", "NoMemory", "TooDeep" };
+    return names[value];
+}
+
+// --- JsonDocument ---
+
+void JsonDocument::clear() {
+    root = Node();
+    poolUsed = 0;
+    used = 0;
+    overflow = false;
+}
+
+void JsonDocument::replacePool(char* pool, size_t poolSize, size_t capacity) {
+    this->pool = pool;
+    this->poolSize = poolSize;
+    limit = capacity;
+    clear();
+}
+
+void* JsonDocument::reserve(size_t size, size_t charged) {
+    size_t start = (poolUsed + 7) & ~(size_t)7;
+    if (used + charged > limit || start + size > poolSize) {
+        overflow = true;
+        return nullptr;
+    }
+
+    poolUsed = start + size;
+    used += charged;
+    return pool + start;
+}
+
+Node* JsonDocument::allocateNode() {
+    void* memory = reserve(sizeof(Node), ArduinoJsonHost::SLOT_SIZE);
+    return memory != nullptr ? new (memory) Node() : nullptr;
+}
+
+const char* JsonDocument::copyString(const char* value, size_t length) {
+    char* copy = (char*)reserve(length + 1, length + 1);
+    if (copy == nullptr) return nullptr;
+    memcpy(copy, value, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+DynamicJsonDocument::DynamicJsonDocument(size_t capacity) : JsonDocument(nullptr, 0, 0) {
+    // malloc, а не new: в учёт кучи идёт ёмкость документа, как на устройстве, а не раздутый пул хоста
+    size_t poolSize = ARDUINOJSON_HOST_POOL(capacity);
+    char* pool = (char*)malloc(poolSize);
+    if (pool == nullptr) return;
+    host::heapCharge(capacity);
+    replacePool(pool, poolSize, capacity);
+}
+
+DynamicJsonDocument::~DynamicJsonDocument() {
+    if (capacity() == 0) return;
+    host::heapRelease(capacity());
+    replacePool(nullptr, 0, 0);
+}
+
+// --- JsonVariant ---
+
+Node* JsonVariant::resolve() const {
+    if (node != nullptr) return node;
+    if (parent == nullptr) return nullptr;
+    if (keyed) return ArduinoJsonHost::findMember(parent, key != nullptr ? key : ownedKey.c_str());
+    return ArduinoJsonHost::elementAt(parent, index);
+}
+
+JsonVariant JsonVariant::member(const char* key, bool linked) const {
+    Node* n = resolve();
+    if (n == nullptr) return JsonVariant();
+    return JsonVariant(doc, n, key, linked);
+}
+
+JsonVariant JsonVariant::element(size_t index) const {
+    Node* n = resolve();
+    if (n == nullptr) return JsonVariant();
+    return JsonVariant(doc, n, index);
+}
+
+Node* JsonVariant::materialize() const {
+    Node* existing = resolve();
+    if (existing != nullptr) return existing;
+    if (parent == nullptr || doc == nullptr) return nullptr;
+
+    Node::Type type = keyed ? Node::Object : Node::Array;
+    if (parent->type == Node::Null) {
+        parent->type = type;
+        parent->children = { nullptr, nullptr };
+    }
+    if (parent->type != type) return nullptr;
+    if (!keyed && index != ArduinoJsonHost::childCount(parent)) return nullptr;
+
+    const char* slotKey = key;
+    if (keyed && slotKey == nullptr) {
+        slotKey = doc->copyString(ownedKey.c_str(), ownedKey.length());
+        if (slotKey == nullptr) return nullptr;
+    }
+
+    Node* slot = doc->allocateNode();
+    if (slot == nullptr) return nullptr;
+    slot->key = keyed ? slotKey : nullptr;
+
+    if (parent->children.tail != nullptr) parent->children.tail->next = slot;
+    else parent->children.head = slot;
+    parent->children.tail = slot;
+    return slot;
+}
+
+Node* JsonVariant::prepare() const {
+    Node* n = materialize();
+    if (n == nullptr) return nullptr;
+    // Как в ArduinoJson, память прежнего содержимого не возвращается до clear()
+    n->type = Node::Null;
+    n->children = { nullptr, nullptr };
+    return n;
+}
+
+Node* JsonVariant::container(Node::Type type) const {
+    Node* n = materialize();
+    if (n == nullptr) return nullptr;
+    if (n->type == Node::Null) {
+        n->type = type;
+        n->children = { nullptr, nullptr };
+    }
+    return n->type == type ? n : nullptr;
+}
+
+bool JsonVariant::set(bool value) {
+    Node* n = prepare();
+    if (n == nullptr) return false;
+    n->type = Node::Bool;
+    n->boolean = value;
+    return true;
+}
+
+bool JsonVariant::set(const char* value) {
+    Node* n = prepare();
+    if (n == nullptr) return false;
+    if (value != nullptr) {
+        n->type = Node::String;
+        n->string = value;
+    }
+    return true;
+}
+
+bool JsonVariant::set(std::nullptr_t) {
+    return prepare() != nullptr;
+}
+
+bool JsonVariant::set(const JsonVariant& value) {
+    const Node* source = value.resolve();
+    if (source == nullptr || source->type == Node::Null) return set(nullptr);
+
+    switch (source->type) {
+    case Node::String:
+        return setCopy(source->string);
+    case Node::Object: {
+        Node* target = prepare();
+        if (target == nullptr) return false;
+        target->type = Node::Object;
+        for (Node* slot = source->children.head; slot != nullptr; slot = slot->next) {
+            if (!JsonVariant(doc, target, slot->key, false).set(JsonVariant(value.doc, slot))) return false;
+        }
+        return true;
+    }
+    case Node::Array: {
+        Node* target = prepare();
+        if (target == nullptr) return false;
+        target->type = Node::Array;
+        size_t i = 0;
+        for (Node* slot = source->children.head; slot != nullptr; slot = slot->next) {
+            if (!JsonVariant(doc, target, i++).set(JsonVariant(value.doc, slot))) return false;
+        }
+        return true;
+    }
+    default: {
+        Node* target = prepare();
+        if (target == nullptr) return false;
+        target->type = source->type;
+        target->uinteger = source->uinteger;
+        return true;
+    }
+    }
+}
+
+bool JsonVariant::setInteger(int64_t value) {
+    Node* n = prepare();
+    if (n == nullptr) return false;
+    n->type = value < 0 ? Node::Int : Node::UInt;
+    n->integer = value;
+    return true;
+}
+
+bool JsonVariant::setUnsigned(uint64_t value) {
+    Node* n = prepare();
+    if (n == nullptr) return false;
+    n->type = Node::UInt;
+    n->uinteger = value;
+    return true;
+}
+
+bool JsonVariant::setReal(double value) {
+    Node* n = prepare();
+    if (n == nullptr) return false;
+    n->type = Node::Float;
+    n->real = value;
+    return true;
+}
+
+bool JsonVariant::setCopy(const char* value, size_t length) {
+    const char* copy = doc != nullptr ? doc->copyString(value, length) : nullptr;
+    if (copy == nullptr) return false;
+    return set(copy);
+}
+
+JsonArray JsonVariant::createNestedArray() const {
+    Node* array = container(Node::Array);
+    if (array == nullptr) return JsonArray();
+    return JsonVariant(doc, array, ArduinoJsonHost::childCount(array)).to<JsonArray>();
+}
+
+JsonArray JsonVariant::createNestedArray(const char* key) const {
+    Node* object = container(Node::Object);
+    if (object == nullptr) return JsonArray();
+    return JsonVariant(doc, object, key, true).to<JsonArray>();
+}
+
+JsonObject JsonVariant::createNestedObject() const {
+    Node* array = container(Node::Array);
+    if (array == nullptr) return JsonObject();
+    return JsonVariant(doc, array, ArduinoJsonHost::childCount(array)).to<JsonObject>();
+}
+
+JsonObject JsonVariant::createNestedObject(const char* key) const {
+    Node* object = container(Node::Object);
+    if (object == nullptr) return JsonObject();
+    return JsonVariant(doc, object, key, true).to<JsonObject>();
+}
+
+void JsonVariant::remove(const char* key) const {
+    Node* object = resolve();
+    if (object == nullptr || object->type != Node::Object) return;
+
+    Node* previous = nullptr;
+    for (Node* slot = object->children.head; slot != nullptr; previous = slot, slot = slot->next) {
+        if (strcmp(slot->key, key) != 0) continue;
+        if (previous != nullptr) previous->next = slot->next;
+        else object->children.head = slot->next;
+        if (object->children.tail == slot) object->children.tail = previous;
+        return;
+    }
+}
+
+void JsonVariant::clear() const {
+    Node* n = resolve();
+    if (n == nullptr) return;
+    n->type = Node::Null;
+    n->children = { nullptr, nullptr };
+}
+
+JsonObject::iterator JsonObject::begin() const {
+    Node* n = resolve();
+    return iterator(doc, n != nullptr && n->type == Node::Object ? n->children.head : nullptr);
+}
+
+JsonArray::iterator JsonArray::begin() const {
+    Node* n = resolve();
+    return iterator(doc, n != nullptr && n->type == Node::Array ? n->children.head : nullptr);
+}
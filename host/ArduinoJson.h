@@ -0,0 +1,615 @@
+// The part of ArduinoJson 6 that main.cpp uses, for the host build.
+//
+// Documents keep the v6 memory model: a fixed capacity chosen by the caller,
+// 16 bytes per value slot and len+1 per copied string as on the 32-bit
+// ESP8266, const char* values linked rather than copied, and overflowed()
+// once the capacity runs out. Pass -DARDUINOJSON_INCLUDE_DIR to CMake to build
+// against the real library instead.
+#pragma once
+
+#include "Arduino.h"
+
+#include <limits>
+#include <string>
+#include <type_traits>
+
+class JsonDocument;
+class JsonVariant;
+class JsonObject;
+class JsonArray;
+
+namespace ArduinoJsonHost {
+
+// Размер слота значения в ArduinoJson 6 на 32-битном ESP8266
+const size_t SLOT_SIZE = 16;
+
+struct Node {
+    enum Type : uint8_t { Null, Bool, Int, UInt, Float, String, Object, Array };
+
+    Type type = Null;
+    union {
+        bool boolean;
+        int64_t integer;
+        uint64_t uinteger;
+        double real;
+        const char* string;
+        struct {
+            Node* head;
+            Node* tail;
+        } children;
+    };
+    const char* key = nullptr;
+    Node* next = nullptr;
+
+    Node() : children{ nullptr, nullptr } {}
+};
+
+class Output {
+public:
+    virtual ~Output() {}
+    virtual void write(const char* data, size_t length) = 0;
+};
+
+Node* findMember(const Node* object, const char* key);
+Node* elementAt(const Node* array, size_t index);
+size_t childCount(const Node* node);
+size_t serialize(const Node* node, Output& out);
+
+} // namespace ArduinoJsonHost
+
+class JsonString {
+public:
+    JsonString(const char* value = nullptr) : value(value) {}
+    const char* c_str() const { return value; }
+    bool isNull() const { return value == nullptr; }
+    operator const char*() const { return value; }
+
+private:
+    const char* value;
+};
+
+// Reference to a value in a document. A member or element that does not exist
+// yet is a pending reference: reads see null, the first write creates it.
+class JsonVariant {
+public:
+    typedef ArduinoJsonHost::Node Node;
+
+    JsonVariant() {}
+    JsonVariant(JsonDocument* doc, Node* node) : doc(doc), node(node) {}
+    JsonVariant(JsonDocument* doc, Node* parent, const char* key, bool linked)
+        : doc(doc), parent(parent), key(linked ? key : nullptr), ownedKey(linked || key == nullptr ? "" : key), keyed(true) {}
+    JsonVariant(JsonDocument* doc, Node* parent, size_t index) : doc(doc), parent(parent), index(index) {}
+
+    bool isNull() const { const Node* n = resolve(); return n == nullptr || n->type == Node::Null; }
+    size_t size() const { return ArduinoJsonHost::childCount(resolve()); }
+    bool containsKey(const char* key) const { return ArduinoJsonHost::findMember(resolve(), key) != nullptr; }
+    bool containsKey(const String& key) const { return containsKey(key.c_str()); }
+
+    JsonVariant operator[](const char* key) const { return member(key, true); }
+    JsonVariant operator[](const String& key) const { return member(key.c_str(), false); }
+    JsonVariant operator[](char* key) const { return member(key, false); }
+    JsonVariant operator[](int index) const { return element(index); }
+    JsonVariant operator[](size_t index) const { return element(index); }
+
+    template <typename T>
+    T as() const;
+
+    template <typename T>
+    bool is() const;
+
+    template <typename T, typename = typename std::enable_if<!std::is_array<T>::value>::type>
+    operator T() const { return as<T>(); }
+
+    bool set(bool value);
+    bool set(const char* value);
+    bool set(char* value) { return setCopy(value); }
+    bool set(const String& value) { return setCopy(value.c_str(), value.length()); }
+    bool set(const std::string& value) { return setCopy(value.c_str(), value.length()); }
+    bool set(std::nullptr_t);
+    bool set(const JsonVariant& value);
+    bool set(JsonString value) { return set(value.c_str()); }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, bool>::type set(T value) {
+        return std::is_signed<T>::value ? setInteger((int64_t)value) : setUnsigned((uint64_t)value);
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_floating_point<T>::value, bool>::type set(T value) {
+        return setReal(value);
+    }
+
+    template <typename T>
+    JsonVariant& operator=(const T& value) { set(value); return *this; }
+    JsonVariant& operator=(const char* value) { set(value); return *this; }
+    JsonVariant& operator=(char* value) { set(value); return *this; }
+
+    template <typename T>
+    bool add(const T& value);
+    bool add(const char* value);
+
+    JsonArray createNestedArray() const;
+    JsonArray createNestedArray(const char* key) const;
+    JsonObject createNestedObject() const;
+    JsonObject createNestedObject(const char* key) const;
+    void remove(const char* key) const;
+    void clear() const;
+
+    template <typename T>
+    T to() const;
+
+    JsonDocument* document() const { return doc; }
+    Node* resolve() const;
+
+protected:
+    friend class JsonDocument;
+
+    JsonVariant member(const char* key, bool linked) const;
+    JsonVariant element(size_t index) const;
+    // Создаёт отложенный член или элемент; nullptr, если не хватило памяти
+    Node* materialize() const;
+    Node* container(Node::Type type) const;
+    Node* prepare() const;
+    bool setInteger(int64_t value);
+    bool setUnsigned(uint64_t value);
+    bool setReal(double value);
+    bool setCopy(const char* value) { return value == nullptr ? set(nullptr) : setCopy(value, strlen(value)); }
+    bool setCopy(const char* value, size_t length);
+
+    JsonDocument* doc = nullptr;
+    mutable Node* node = nullptr;
+    Node* parent = nullptr;
+    const char* key = nullptr;
+    std::string ownedKey;
+    bool keyed = false;
+    size_t index = (size_t)-1;
+};
+
+struct JsonPair {
+    JsonString key() const { return JsonString(slot->key); }
+    JsonVariant value() const { return JsonVariant(doc, slot); }
+
+    JsonDocument* doc;
+    ArduinoJsonHost::Node* slot;
+};
+
+class JsonObject : public JsonVariant {
+public:
+    class iterator {
+    public:
+        iterator(JsonDocument* doc, ArduinoJsonHost::Node* slot) : doc(doc), slot(slot) {}
+        JsonPair operator*() const { return { doc, slot }; }
+        iterator& operator++() { slot = slot->next; return *this; }
+        bool operator!=(const iterator& other) const { return slot != other.slot; }
+
+    private:
+        JsonDocument* doc;
+        ArduinoJsonHost::Node* slot;
+    };
+
+    JsonObject() {}
+    explicit JsonObject(const JsonVariant& variant) : JsonVariant(variant) {}
+
+    iterator begin() const;
+    iterator end() const { return iterator(doc, nullptr); }
+};
+
+class JsonArray : public JsonVariant {
+public:
+    class iterator {
+    public:
+        iterator(JsonDocument* doc, ArduinoJsonHost::Node* slot) : doc(doc), slot(slot) {}
+        JsonVariant operator*() const { return JsonVariant(doc, slot); }
+        iterator& operator++() { slot = slot->next; return *this; }
+        bool operator!=(const iterator& other) const { return slot != other.slot; }
+
+    private:
+        JsonDocument* doc;
+        ArduinoJsonHost::Node* slot;
+    };
+
+    JsonArray() {}
+    explicit JsonArray(const JsonVariant& variant) : JsonVariant(variant) {}
+
+    iterator begin() const;
+    iterator end() const { return iterator(doc, nullptr); }
+};
+
+class JsonDocument {
+public:
+    typedef ArduinoJsonHost::Node Node;
+
+    JsonDocument(const JsonDocument&) = delete;
+    JsonDocument& operator=(const JsonDocument&) = delete;
+    virtual ~JsonDocument() {}
+
+    JsonVariant operator[](const char* key) { return JsonVariant(this, &root, key, true); }
+    JsonVariant operator[](char* key) { return JsonVariant(this, &root, key, false); }
+    JsonVariant operator[](const String& key) { return JsonVariant(this, &root, key.c_str(), false); }
+    JsonVariant operator[](int index) { return JsonVariant(this, &root, (size_t)index); }
+    JsonVariant operator[](const char* key) const { return const_cast<JsonDocument*>(this)->operator[](key); }
+
+    bool containsKey(const char* key) const { return ArduinoJsonHost::findMember(&root, key) != nullptr; }
+    bool containsKey(const String& key) const { return containsKey(key.c_str()); }
+    void remove(const char* key) { asVariant().remove(key); }
+    void clear();
+    size_t memoryUsage() const { return used; }
+    size_t capacity() const { return limit; }
+    bool overflowed() const { return overflow; }
+    size_t size() const { return ArduinoJsonHost::childCount(&root); }
+    bool isNull() const { return root.type == Node::Null; }
+    void shrinkToFit() {}
+    bool garbageCollect() { return true; }
+
+    JsonArray createNestedArray() { return asVariant().createNestedArray(); }
+    JsonArray createNestedArray(const char* key) { return asVariant().createNestedArray(key); }
+    JsonObject createNestedObject() { return asVariant().createNestedObject(); }
+    JsonObject createNestedObject(const char* key) { return asVariant().createNestedObject(key); }
+
+    template <typename T>
+    T as() const { return const_cast<JsonDocument*>(this)->asVariant().as<T>(); }
+    template <typename T>
+    bool is() const { return const_cast<JsonDocument*>(this)->asVariant().is<T>(); }
+    template <typename T>
+    T to() { clear(); return asVariant().to<T>(); }
+    template <typename T>
+    bool add(const T& value) { return asVariant().add(value); }
+    bool set(const JsonVariant& value) { clear(); return asVariant().set(value); }
+
+    JsonVariant asVariant() { return JsonVariant(this, &root); }
+    const Node* rootNode() const { return &root; }
+
+    // Слот под новое значение; nullptr и overflowed(), если ёмкость исчерпана
+    Node* allocateNode();
+    // Копия строки в памяти документа
+    const char* copyString(const char* value, size_t length);
+
+protected:
+    JsonDocument(char* pool, size_t poolSize, size_t capacity) : pool(pool), poolSize(poolSize), limit(capacity) {}
+
+    void replacePool(char* pool, size_t poolSize, size_t capacity);
+
+private:
+    void* reserve(size_t size, size_t charged);
+
+    Node root;
+    char* pool;
+    size_t poolSize;
+    size_t poolUsed = 0;
+    size_t limit;
+    size_t used = 0;
+    bool overflow = false;
+};
+
+// Узлы на хосте крупнее 16 байт слота ESP8266 из-за 64-битных указателей,
+// поэтому реальный пул втрое больше учитываемой ёмкости
+#define ARDUINOJSON_HOST_POOL(capacity) ((capacity) * 3)
+
+// Takes `capacity` bytes from the heap, as on the device
+class DynamicJsonDocument : public JsonDocument {
+public:
+    explicit DynamicJsonDocument(size_t capacity);
+    ~DynamicJsonDocument() override;
+};
+
+template <size_t N>
+class StaticJsonDocument : public JsonDocument {
+public:
+    StaticJsonDocument() : JsonDocument(storage, sizeof(storage), N) {}
+
+private:
+    alignas(8) char storage[ARDUINOJSON_HOST_POOL(N)];
+};
+
+class DeserializationError {
+public:
+    enum Code { Ok, EmptyInput, IncompleteInput, InvalidInput, NoMemory, TooDeep };
+
+    DeserializationError(Code code = Ok) : value(code) {}
+    explicit operator bool() const { return value != Ok; }
+    bool operator==(Code code) const { return value == code; }
+    bool operator!=(Code code) const { return value != code; }
+    Code code() const { return value; }
+    const char* c_str() const;
+
+private:
+    Code value;
+};
+
+namespace DeserializationOption {
+
+class Filter {
+public:
+    explicit Filter(const JsonDocument& doc) : node(doc.rootNode()) {}
+    explicit Filter(JsonVariant variant) : node(variant.resolve()) {}
+    const ArduinoJsonHost::Node* root() const { return node; }
+
+private:
+    const ArduinoJsonHost::Node* node;
+};
+
+class NestingLimit {
+public:
+    NestingLimit(uint8_t limit = 10) : limit(limit) {}
+    uint8_t value() const { return limit; }
+
+private:
+    uint8_t limit;
+};
+
+} // namespace DeserializationOption
+
+namespace ArduinoJsonHost {
+
+// Источник байт для разбора: буфер или Stream с таймаутом
+class Input {
+public:
+    virtual ~Input() {}
+    // Следующий байт или -1 в конце ввода
+    virtual int next() = 0;
+};
+
+DeserializationError deserialize(JsonDocument& doc, Input& input, const Node* filter, uint8_t nestingLimit);
+
+class BufferInput : public Input {
+public:
+    BufferInput(const char* data, size_t length) : data(data), end(data + length) {}
+    int next() override { return data < end && *data != '\0' ? (uint8_t)*data++ : -1; }
+
+private:
+    const char* data;
+    const char* end;
+};
+
+class StreamInput : public Input {
+public:
+    explicit StreamInput(Stream& stream) : stream(stream) {}
+    int next() override {
+        char c;
+        return stream.readBytes(&c, 1) == 1 ? (uint8_t)c : -1;
+    }
+
+private:
+    Stream& stream;
+};
+
+class BufferOutput : public Output {
+public:
+    BufferOutput(char* buffer, size_t size) : buffer(buffer), size(size) {}
+    ~BufferOutput() override { if (size > 0) buffer[std::min(used, size - 1)] = '\0'; }
+    void write(const char* data, size_t length) override {
+        size_t room = size > 0 ? size - 1 - std::min(used, size - 1) : 0;
+        memcpy(buffer + used, data, std::min(room, length));
+        used += std::min(room, length);
+    }
+
+private:
+    char* buffer;
+    size_t size;
+    size_t used = 0;
+};
+
+class PrintOutput : public Output {
+public:
+    explicit PrintOutput(Print& print) : print(print) {}
+    void write(const char* data, size_t length) override { print.write((const uint8_t*)data, length); }
+
+private:
+    Print& print;
+};
+
+class StringOutput : public Output {
+public:
+    explicit StringOutput(std::string& target) : target(target) {}
+    void write(const char* data, size_t length) override { target.append(data, length); }
+
+private:
+    std::string& target;
+};
+
+class CountingOutput : public Output {
+public:
+    void write(const char* data, size_t length) override { (void)data; count += length; }
+    size_t count = 0;
+};
+
+inline const Node* sourceNode(const JsonDocument& doc) {
+    return doc.rootNode();
+}
+
+inline const Node* sourceNode(const JsonVariant& variant) {
+    return variant.resolve();
+}
+
+} // namespace ArduinoJsonHost
+
+// --- JsonVariant templates ---
+
+template <typename T>
+T JsonVariant::as() const {
+    const Node* n = resolve();
+    Node::Type type = n != nullptr ? n->type : Node::Null;
+
+    if constexpr (std::is_same<T, bool>::value) {
+        if (type == Node::Bool) return n->boolean;
+        if (type == Node::Int || type == Node::UInt) return n->uinteger != 0;
+        if (type == Node::Float) return n->real != 0;
+        return false;
+    }
+    else if constexpr (std::is_integral<T>::value) {
+        if (type == Node::Int) return (T)n->integer;
+        if (type == Node::UInt) return (T)n->uinteger;
+        if (type == Node::Float) return (T)n->real;
+        if (type == Node::Bool) return (T)n->boolean;
+        return 0;
+    }
+    else if constexpr (std::is_floating_point<T>::value) {
+        if (type == Node::Int) return (T)n->integer;
+        if (type == Node::UInt) return (T)n->uinteger;
+        if (type == Node::Float) return (T)n->real;
+        return 0;
+    }
+    else if constexpr (std::is_same<T, const char*>::value || std::is_same<T, JsonString>::value) {
+        return T(type == Node::String ? n->string : nullptr);
+    }
+    else if constexpr (std::is_same<T, String>::value) {
+        if (type == Node::String) return String(n->string);
+        std::string text;
+        ArduinoJsonHost::StringOutput out(text);
+        if (n != nullptr && type != Node::Null) ArduinoJsonHost::serialize(n, out);
+        return String(text);
+    }
+    else if constexpr (std::is_same<T, JsonObject>::value) {
+        return type == Node::Object ? JsonObject(JsonVariant(doc, const_cast<Node*>(n))) : JsonObject();
+    }
+    else if constexpr (std::is_same<T, JsonArray>::value) {
+        return type == Node::Array ? JsonArray(JsonVariant(doc, const_cast<Node*>(n))) : JsonArray();
+    }
+    else {
+        static_assert(std::is_same<T, JsonVariant>::value, "unsupported JsonVariant::as<T>()");
+        return *this;
+    }
+}
+
+template <typename T>
+bool JsonVariant::is() const {
+    const Node* n = resolve();
+    Node::Type type = n != nullptr ? n->type : Node::Null;
+
+    if constexpr (std::is_same<T, bool>::value) {
+        return type == Node::Bool;
+    }
+    else if constexpr (std::is_integral<T>::value) {
+        if (type == Node::Int) return n->integer >= (int64_t)std::numeric_limits<T>::min() && n->integer <= (int64_t)std::numeric_limits<T>::max();
+        if (type == Node::UInt) return n->uinteger <= (uint64_t)std::numeric_limits<T>::max();
+        return false;
+    }
+    else if constexpr (std::is_floating_point<T>::value) {
+        return type == Node::Int || type == Node::UInt || type == Node::Float;
+    }
+    else if constexpr (std::is_same<T, const char*>::value || std::is_same<T, String>::value || std::is_same<T, JsonString>::value) {
+        return type == Node::String;
+    }
+    else if constexpr (std::is_same<T, JsonObject>::value) {
+        return type == Node::Object;
+    }
+    else if constexpr (std::is_same<T, JsonArray>::value) {
+        return type == Node::Array;
+    }
+    else {
+        static_assert(std::is_same<T, JsonVariant>::value, "unsupported JsonVariant::is<T>()");
+        return n != nullptr;
+    }
+}
+
+template <typename T>
+bool JsonVariant::add(const T& value) {
+    Node* array = container(Node::Array);
+    if (array == nullptr) return false;
+    return JsonVariant(doc, array, ArduinoJsonHost::childCount(array)).set(value);
+}
+
+inline bool JsonVariant::add(const char* value) {
+    Node* array = container(Node::Array);
+    if (array == nullptr) return false;
+    return JsonVariant(doc, array, ArduinoJsonHost::childCount(array)).set(value);
+}
+
+template <typename T>
+T JsonVariant::to() const {
+    Node* n = prepare();
+    if (n != nullptr) {
+        n->type = Node::Null;
+        n->children = { nullptr, nullptr };
+    }
+
+    if constexpr (std::is_same<T, JsonObject>::value) {
+        return JsonObject(JsonVariant(doc, container(Node::Object)));
+    }
+    else if constexpr (std::is_same<T, JsonArray>::value) {
+        return JsonArray(JsonVariant(doc, container(Node::Array)));
+    }
+    else {
+        static_assert(std::is_same<T, JsonVariant>::value, "unsupported JsonVariant::to<T>()");
+        return JsonVariant(doc, n);
+    }
+}
+
+// --- deserializeJson ---
+
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* input, size_t length,
+    DeserializationOption::Filter filter, DeserializationOption::NestingLimit limit = {}) {
+    ArduinoJsonHost::BufferInput in(input, length);
+    return ArduinoJsonHost::deserialize(doc, in, filter.root(), limit.value());
+}
+
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* input, size_t length,
+    DeserializationOption::NestingLimit limit = {}) {
+    ArduinoJsonHost::BufferInput in(input, length);
+    return ArduinoJsonHost::deserialize(doc, in, nullptr, limit.value());
+}
+
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* input,
+    DeserializationOption::Filter filter, DeserializationOption::NestingLimit limit = {}) {
+    return deserializeJson(doc, input, input != nullptr ? strlen(input) : 0, filter, limit);
+}
+
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* input,
+    DeserializationOption::NestingLimit limit = {}) {
+    return deserializeJson(doc, input, input != nullptr ? strlen(input) : 0, limit);
+}
+
+inline DeserializationError deserializeJson(JsonDocument& doc, const String& input,
+    DeserializationOption::NestingLimit limit = {}) {
+    return deserializeJson(doc, input.c_str(), input.length(), limit);
+}
+
+inline DeserializationError deserializeJson(JsonDocument& doc, Stream& input,
+    DeserializationOption::Filter filter, DeserializationOption::NestingLimit limit = {}) {
+    ArduinoJsonHost::StreamInput in(input);
+    return ArduinoJsonHost::deserialize(doc, in, filter.root(), limit.value());
+}
+
+inline DeserializationError deserializeJson(JsonDocument& doc, Stream& input,
+    DeserializationOption::NestingLimit limit = {}) {
+    ArduinoJsonHost::StreamInput in(input);
+    return ArduinoJsonHost::deserialize(doc, in, nullptr, limit.value());
+}
+
+// --- serializeJson ---
+
+template <typename Source>
+size_t serializeJson(const Source& source, char* buffer, size_t size) {
+    ArduinoJsonHost::BufferOutput out(buffer, size);
+    ArduinoJsonHost::CountingOutput counter;
+    size_t length = ArduinoJsonHost::serialize(ArduinoJsonHost::sourceNode(source), counter);
+    ArduinoJsonHost::serialize(ArduinoJsonHost::sourceNode(source), out);
+    return size > 0 ? std::min(length, size - 1) : 0;
+}
+
+template <typename Source>
+size_t serializeJson(const Source& source, Print& print) {
+    ArduinoJsonHost::PrintOutput out(print);
+    return ArduinoJsonHost::serialize(ArduinoJsonHost::sourceNode(source), out);
+}
+
+template <typename Source>
+size_t serializeJson(const Source& source, String& target) {
+    std::string text;
+    ArduinoJsonHost::StringOutput out(text);
+    size_t length = ArduinoJsonHost::serialize(ArduinoJsonHost::sourceNode(source), out);
+    target = String(text);
+    return length;
+}
+
+template <typename Source>
+size_t serializeJson(const Source& source, std::string& target) {
+    ArduinoJsonHost::StringOutput out(target);
+    return ArduinoJsonHost::serialize(ArduinoJsonHost::sourceNode(source), out);
+}
+
+template <typename Source>
+size_t measureJson(const Source& source) {
+    ArduinoJsonHost::CountingOutput out;
+    return ArduinoJsonHost::serialize(ArduinoJsonHost::sourceNode(source), out);
+}
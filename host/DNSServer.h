@@ -0,0 +1,14 @@
+#pragma once
+
+#include "ESP8266WiFi.h"
+
+enum class DNSReplyCode { NoError = 0, ServerFailure = 2, NonExistentDomain = 3 };
+
+// Captive portal DNS: there are no portal clients on the host
+class DNSServer {
+public:
+    void setErrorReplyCode(DNSReplyCode code) { (void)code; }
+    bool start(uint16_t port, const String& domain, IPAddress resolved) { (void)port; (void)domain; (void)resolved; return true; }
+    void stop() {}
+    void processNextRequest() {}
+};
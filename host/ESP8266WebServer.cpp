@@ -0,0 +1,60 @@
+#include "ESP8266WebServer.h"
+
+String ESP8266WebServer::arg(const char* name) {
+    auto found = requestArgs.find(name);
+    return found != requestArgs.end() ? String(found->second) : String();
+}
+
+String ESP8266WebServer::header(const char* name) {
+    auto found = requestHeaders.find(name);
+    return found != requestHeaders.end() ? String(found->second) : String();
+}
+
+void ESP8266WebServer::send(int code, const char* contentType, const String& content) {
+    response.code = code;
+    response.contentType = contentType != nullptr ? contentType : "";
+    response.headers += pendingHeaders;
+    pendingHeaders.clear();
+    response.body.append(content.c_str(), content.length());
+}
+
+void ESP8266WebServer::send_P(int code, PGM_P contentType, PGM_P content, size_t length) {
+    send(code, contentType);
+    response.body.append(content, length);
+}
+
+void ESP8266WebServer::sendHeader(const String& name, const String& value, bool first) {
+    std::string line = name.str() + ": " + value.str() + "\r\n";
+    pendingHeaders = first ? line + pendingHeaders : pendingHeaders + line;
+}
+
+ESP8266WebServer::Response ESP8266WebServer::hostRequest(const char* uri, HTTPMethod method,
+    const std::map<std::string, std::string>& args, const std::map<std::string, std::string>& headers) {
+    requestUri = uri;
+    requestMethod = method;
+    requestArgs = args;
+    requestHeaders = headers;
+    pendingHeaders.clear();
+    contentLength = CONTENT_LENGTH_NOT_SET;
+    response = Response();
+
+    if (!started) {
+        response.code = -1;
+        return response;
+    }
+
+    for (const Route& route : routes) {
+        if (route.uri == requestUri && (route.method == HTTP_ANY || route.method == method)) {
+            route.handler();
+            return response;
+        }
+    }
+
+    if (notFound) {
+        notFound();
+    }
+    else {
+        response.code = 404;
+    }
+    return response;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "ESP8266WiFi.h"
+
+#include <map>
+#include <vector>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+
+// Handler registry of the ESP8266 web server. Nothing listens on the host:
+// drivers call hostRequest() to run a handler and read back what it sent.
+class ESP8266WebServer {
+public:
+    typedef std::function<void()> THandlerFunction;
+
+    struct Response {
+        int code = 0;
+        std::string contentType;
+        std::string headers;
+        std::string body;
+    };
+
+    explicit ESP8266WebServer(int port = 80) : port(port) {}
+
+    void on(const char* uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+    void on(const char* uri, HTTPMethod method, THandlerFunction handler) { routes.push_back({ uri, method, handler }); }
+    void onNotFound(THandlerFunction handler) { notFound = handler; }
+    void begin() { started = true; }
+    void stop() { started = false; }
+    void close() { started = false; }
+    void handleClient() {}
+
+    String arg(const char* name);
+    bool hasArg(const char* name) { return requestArgs.count(name) > 0; }
+    String header(const char* name);
+    bool hasHeader(const char* name) { return requestHeaders.count(name) > 0; }
+    void collectHeaders(const char* keys[], size_t count) { (void)keys; (void)count; }
+    String uri() { return requestUri.c_str(); }
+    HTTPMethod method() { return requestMethod; }
+
+    void send(int code, const char* contentType = nullptr, const String& content = String());
+    void send(int code, const String& contentType, const String& content) { send(code, contentType.c_str(), content); }
+    void send_P(int code, PGM_P contentType, PGM_P content) { send_P(code, contentType, content, strlen(content)); }
+    void send_P(int code, PGM_P contentType, PGM_P content, size_t length);
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void setContentLength(size_t length) { contentLength = length; }
+    void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+    void sendContent(const char* content, size_t length) { response.body.append(content, length); }
+    void sendContent_P(PGM_P content) { sendContent(content, strlen(content)); }
+    void sendContent_P(PGM_P content, size_t length) { sendContent(content, length); }
+
+    // Host only: dispatches one request as handleClient() would and returns the response
+    Response hostRequest(const char* uri, HTTPMethod method = HTTP_GET,
+        const std::map<std::string, std::string>& args = {}, const std::map<std::string, std::string>& headers = {});
+    bool isStarted() const { return started; }
+    int getPort() const { return port; }
+
+private:
+    struct Route {
+        std::string uri;
+        HTTPMethod method;
+        THandlerFunction handler;
+    };
+
+    int port;
+    bool started = false;
+    std::vector<Route> routes;
+    THandlerFunction notFound;
+
+    std::string requestUri;
+    HTTPMethod requestMethod = HTTP_GET;
+    std::map<std::string, std::string> requestArgs;
+    std::map<std::string, std::string> requestHeaders;
+    std::string pendingHeaders;
+    size_t contentLength = CONTENT_LENGTH_NOT_SET;
+    Response response;
+};
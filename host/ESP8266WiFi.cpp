@@ -0,0 +1,577 @@
+#include "ESP8266WiFi.h"
+#include "WiFiClientSecure.h"
+#include "host.h"
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <errno.h>
+
+ESP8266WiFiClass WiFi;
+
+namespace {
+
+const uint8_t ACCESS_POINT_BSSID[6] = { 0x02, 0x1A, 0x2B, 0x3C, 0x4D, 0x5E };
+const int32_t ACCESS_POINT_CHANNEL = 6;
+const int32_t ACCESS_POINT_RSSI = -60;
+const char* ACCESS_POINT_SSID = "HostNet";
+const uint8_t STATION_MAC[6] = { 0x5C, 0xCF, 0x7F, 0xA1, 0xB2, 0xC3 };
+const size_t TCP_WINDOW = 1460;
+
+bool accessPoint = true;
+host::WiFiTiming timing = { 3500, 800, 20, 600 };
+uint32_t lease = IPAddress(192, 168, 1, 50);
+const uint32_t GATEWAY = IPAddress(192, 168, 1, 1);
+const uint32_t SUBNET = IPAddress(255, 255, 255, 0);
+
+wl_status_t state = WL_DISCONNECTED;
+bool joining = false;
+uint64_t joinStart = 0;
+uint64_t joinAt = 0;
+uint64_t connectedSince = 0;
+uint32_t staticIp = 0;
+uint32_t staticGateway = 0;
+uint32_t staticSubnet = 0;
+uint32_t staticDns = 0;
+host::WiFiStats wifi = {};
+uint8_t bssid[6];
+
+std::function<bool()> joinAdmission;
+std::function<void(host::HttpExchange&)> responder;
+bool serverReachable = true;
+// Меняется при потере WiFi или сервера; соединения со встроенным сервером из прошлой эпохи мертвы
+uint32_t linkEpoch = 0;
+host::NetStats net = {};
+bool maxFragmentLength = true;
+unsigned long tlsFullMs = 1800;
+unsigned long tlsResumedMs = 300;
+
+// Радио занято сетью: время блокирующих вызовов идёт в учёт энергопотребления
+void chargeNetwork(uint64_t micros) {
+    host::advanceClock(micros);
+    net.blockedMicros += micros;
+}
+
+void endJoin(uint64_t end) {
+    if (!joining) return;
+    joining = false;
+    wifi.joiningMicros += end - joinStart;
+}
+
+void leaveConnected(wl_status_t next) {
+    if (state == WL_CONNECTED) {
+        wifi.connectedMicros += host::clockMicros() - connectedSince;
+        linkEpoch++;
+    }
+    state = next;
+}
+
+void updateState() {
+    if (joining && host::clockMicros() >= joinAt) {
+        endJoin(joinAt);
+        if (accessPoint && joinAdmission && !joinAdmission()) {
+            // Точка доступа не приняла станцию: попытка просто не завершается
+            state = WL_DISCONNECTED;
+        }
+        else if (accessPoint) {
+            state = WL_CONNECTED;
+            connectedSince = host::clockMicros();
+        }
+        else {
+            state = WL_NO_SSID_AVAIL;
+        }
+    }
+    else if (state == WL_CONNECTED && !accessPoint) {
+        leaveConnected(WL_CONNECTION_LOST);
+    }
+}
+
+// Пакеты доходят, только пока станция в сети и её адрес совпадает с выданным DHCP:
+// устаревший статический адрес роутер не маршрутизирует
+bool networkUsable() {
+    updateState();
+    if (state != WL_CONNECTED) return false;
+    return staticIp == 0 || staticIp == lease;
+}
+
+} // namespace
+
+namespace host {
+
+void setAccessPoint(bool up) {
+    updateState();
+    accessPoint = up;
+    updateState();
+}
+
+bool accessPointUp() {
+    return accessPoint;
+}
+
+void setWiFiTiming(const WiFiTiming& value) {
+    timing = value;
+}
+
+void setJoinAdmission(std::function<bool()> admit) {
+    joinAdmission = admit;
+}
+
+void setDhcpLease(uint32_t ip) {
+    lease = ip;
+}
+
+uint32_t dhcpLease() {
+    return lease;
+}
+
+WiFiStats wifiStats() {
+    updateState();
+    WiFiStats stats = wifi;
+    if (state == WL_CONNECTED) stats.connectedMicros += clockMicros() - connectedSince;
+    if (joining) stats.joiningMicros += clockMicros() - joinStart;
+    return stats;
+}
+
+void setHttpResponder(std::function<void(HttpExchange&)> value) {
+    responder = value;
+}
+
+void setServerReachable(bool reachable) {
+    if (serverReachable && !reachable) linkEpoch++;
+    serverReachable = reachable;
+}
+
+NetStats netStats() {
+    return net;
+}
+
+void setMaxFragmentLengthSupported(bool supported) {
+    maxFragmentLength = supported;
+}
+
+void setTlsHandshakeTime(unsigned long fullMs, unsigned long resumedMs) {
+    tlsFullMs = fullMs;
+    tlsResumedMs = resumedMs;
+}
+
+} // namespace host
+
+wl_status_t ESP8266WiFiClass::status() {
+    updateState();
+    return state;
+}
+
+wl_status_t ESP8266WiFiClass::begin(const char* ssid, const char* password, int32_t channel, const uint8_t* bssid, bool connect) {
+    (void)ssid;
+    (void)password;
+    endJoin(host::clockMicros());
+    leaveConnected(WL_DISCONNECTED);
+    if (!connect) return state;
+
+    // Направленное подключение пропускает сканирование, но только если подсказки верны
+    bool directed = channel == ACCESS_POINT_CHANNEL && bssid != nullptr && memcmp(bssid, ACCESS_POINT_BSSID, 6) == 0;
+    if (directed) {
+        wifi.directedJoins++;
+    }
+    else {
+        wifi.scans++;
+    }
+    wifi.joins++;
+
+    joining = true;
+    joinStart = host::clockMicros();
+    unsigned long joinMs = directed ? timing.directedJoin + (staticIp == 0 ? timing.dhcp : 0) : timing.fullJoin;
+    joinAt = host::clockMicros() + (uint64_t)joinMs * 1000;
+    return state;
+}
+
+bool ESP8266WiFiClass::config(IPAddress ip, IPAddress gateway, IPAddress subnet, IPAddress dns1, IPAddress dns2) {
+    (void)dns2;
+    staticIp = ip;
+    staticGateway = gateway;
+    staticSubnet = subnet;
+    staticDns = dns1;
+    if (staticIp != 0) wifi.staticConfigs++;
+    return true;
+}
+
+bool ESP8266WiFiClass::disconnect(bool wifiOff) {
+    endJoin(host::clockMicros());
+    leaveConnected(WL_DISCONNECTED);
+    if (wifiOff) currentMode = WIFI_OFF;
+    return true;
+}
+
+bool ESP8266WiFiClass::mode(WiFiMode_t mode) {
+    if (mode == WIFI_OFF || mode == WIFI_AP) disconnect();
+    currentMode = mode;
+    return true;
+}
+
+bool ESP8266WiFiClass::setSleepMode(WiFiSleepType_t type, uint8_t listenInterval) {
+    wifi.sleepMode = type;
+    wifi.listenInterval = listenInterval;
+    return true;
+}
+
+IPAddress ESP8266WiFiClass::localIP() {
+    if (status() != WL_CONNECTED) return IPAddress();
+    return staticIp != 0 ? staticIp : lease;
+}
+
+IPAddress ESP8266WiFiClass::gatewayIP() {
+    if (status() != WL_CONNECTED) return IPAddress();
+    return staticIp != 0 ? staticGateway : GATEWAY;
+}
+
+IPAddress ESP8266WiFiClass::subnetMask() {
+    if (status() != WL_CONNECTED) return IPAddress();
+    return staticIp != 0 ? staticSubnet : SUBNET;
+}
+
+IPAddress ESP8266WiFiClass::dnsIP(uint8_t index) {
+    if (status() != WL_CONNECTED || index > 0) return IPAddress();
+    return staticIp != 0 ? staticDns : GATEWAY;
+}
+
+int32_t ESP8266WiFiClass::RSSI() {
+    return status() == WL_CONNECTED ? ACCESS_POINT_RSSI : 31;
+}
+
+int32_t ESP8266WiFiClass::RSSI(uint8_t index) {
+    return ACCESS_POINT_RSSI - index * 7;
+}
+
+String ESP8266WiFiClass::SSID() {
+    return status() == WL_CONNECTED ? ACCESS_POINT_SSID : "";
+}
+
+String ESP8266WiFiClass::SSID(uint8_t index) {
+    return index == 0 ? String(ACCESS_POINT_SSID) : String("Neighbour") + String((int)index);
+}
+
+uint8_t* ESP8266WiFiClass::BSSID() {
+    if (status() != WL_CONNECTED) return nullptr;
+    memcpy(bssid, ACCESS_POINT_BSSID, sizeof(bssid));
+    return bssid;
+}
+
+int32_t ESP8266WiFiClass::channel() {
+    return status() == WL_CONNECTED ? ACCESS_POINT_CHANNEL : 0;
+}
+
+uint8_t* ESP8266WiFiClass::macAddress(uint8_t* mac) {
+    memcpy(mac, STATION_MAC, sizeof(STATION_MAC));
+    return mac;
+}
+
+String ESP8266WiFiClass::macAddress() {
+    char text[18];
+    snprintf(text, sizeof(text), "%02X:%02X:%02X:%02X:%02X:%02X",
+        STATION_MAC[0], STATION_MAC[1], STATION_MAC[2], STATION_MAC[3], STATION_MAC[4], STATION_MAC[5]);
+    return text;
+}
+
+int8_t ESP8266WiFiClass::scanComplete() {
+    return WIFI_SCAN_FAILED;
+}
+
+void ESP8266WiFiClass::scanDelete() {
+}
+
+void ESP8266WiFiClass::scanNetworksAsync(std::function<void(int)> onComplete, bool showHidden) {
+    (void)showHidden;
+    wifi.scans++;
+    onComplete(accessPoint ? 4 : 3);
+}
+
+int ESP8266WiFiClass::hostByName(const char* host, IPAddress& result) {
+    return hostByName(host, result, 10000);
+}
+
+int ESP8266WiFiClass::hostByName(const char* host, IPAddress& result, uint32_t timeout) {
+    if (!networkUsable() || !serverReachable) {
+        chargeNetwork((uint64_t)timeout * 1000);
+        return 0;
+    }
+
+    chargeNetwork((uint64_t)timing.dnsLookup * 1000);
+    if (result.fromString(host)) return 1;
+    if (responder) {
+        result = IPAddress(10, 0, 0, 1);
+        return 1;
+    }
+
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &found) != 0 || found == nullptr) return 0;
+    result = ((sockaddr_in*)found->ai_addr)->sin_addr.s_addr;
+    freeaddrinfo(found);
+    return 1;
+}
+
+// Соединение: либо буфер запроса к встроенному серверу, либо неблокирующий сокет
+struct WiFiClient::Connection {
+    ~Connection() {
+        if (fd >= 0) close(fd);
+    }
+
+    // Поднимает всё, что уже пришло, в rx; сокет не блокирует
+    void receive() {
+        if (fd < 0) {
+            if (epoch != linkEpoch) open = false;
+            return;
+        }
+
+        char chunk[1024];
+        for (;;) {
+            ssize_t got = recv(fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+            if (got > 0) {
+                rx.append(chunk, got);
+                net.bytesReceived += got;
+                continue;
+            }
+            if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                close(fd);
+                fd = -1;
+                open = false;
+            }
+            return;
+        }
+    }
+
+    size_t send(const uint8_t* buffer, size_t size) {
+        receive();
+        if (!open) return 0;
+        net.bytesSent += size;
+
+        if (fd >= 0) {
+            ssize_t sent = ::send(fd, buffer, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+            return sent > 0 ? sent : 0;
+        }
+
+        tx.append((const char*)buffer, size);
+        while (open && dispatch()) {
+        }
+        return size;
+    }
+
+    // Передаёт встроенному серверу один полный запрос из tx, если он уже накоплен
+    bool dispatch() {
+        host::HttpExchange exchange;
+        if (!exchangeRequest(exchange)) return false;
+
+        // Принятые данные до чтения лежат в буферах lwIP, то есть в куче устройства
+        rx += exchange.response;
+        net.bytesReceived += exchange.response.size();
+        if (!exchange.keepAlive) open = false;
+        return true;
+    }
+
+    bool exchangeRequest(host::HttpExchange& exchange) {
+        size_t headerEnd = tx.find("\r\n\r\n");
+        if (headerEnd == std::string::npos) return false;
+
+        host::HeapUntracked untracked;
+        size_t lineEnd = tx.find("\r\n");
+        std::string requestLine = tx.substr(0, lineEnd);
+        size_t methodEnd = requestLine.find(' ');
+        size_t pathEnd = requestLine.find(' ', methodEnd + 1);
+        exchange.method = requestLine.substr(0, methodEnd);
+        exchange.path = requestLine.substr(methodEnd + 1, pathEnd - methodEnd - 1);
+        exchange.headers = tx.substr(lineEnd + 2, headerEnd - lineEnd);
+
+        size_t contentLength = 0;
+        for (size_t pos = 0; pos < exchange.headers.size();) {
+            size_t end = exchange.headers.find("\r\n", pos);
+            std::string line = exchange.headers.substr(pos, end - pos);
+            if (strncasecmp(line.c_str(), "Content-Length:", 15) == 0) contentLength = atol(line.c_str() + 15);
+            if (strncasecmp(line.c_str(), "Host:", 5) == 0) {
+                exchange.host = line.substr(5);
+                exchange.host.erase(0, exchange.host.find_first_not_of(' '));
+            }
+            pos = end + 2;
+        }
+
+        size_t bodyStart = headerEnd + 4;
+        if (tx.size() < bodyStart + contentLength) return false;
+
+        exchange.body = tx.substr(bodyStart, contentLength);
+        tx.erase(0, bodyStart + contentLength);
+        net.requests++;
+
+        responder(exchange);
+        return true;
+    }
+
+    int fd = -1;
+    uint32_t epoch = linkEpoch;
+    bool open = true;
+    std::string tx;
+    std::string rx;
+    size_t rxPos = 0;
+};
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip.toString().c_str(), port);
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+    stop();
+    net.connects++;
+
+    if (!networkUsable() || !serverReachable) {
+        // Как на устройстве: соединение ждёт SYN-ACK до таймаута
+        chargeNetwork((uint64_t)streamTimeout * 1000);
+        net.connectFailures++;
+        return 0;
+    }
+
+    auto next = std::make_shared<Connection>();
+    if (!responder) {
+        addrinfo hints = {};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* found = nullptr;
+        char service[8];
+        snprintf(service, sizeof(service), "%u", port);
+        if (getaddrinfo(host, service, &hints, &found) != 0 || found == nullptr) {
+            net.connectFailures++;
+            return 0;
+        }
+
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        int result = ::connect(fd, found->ai_addr, found->ai_addrlen);
+        freeaddrinfo(found);
+
+        if (result != 0 && errno == EINPROGRESS) {
+            pollfd waiting = { fd, POLLOUT, 0 };
+            int error = 0;
+            socklen_t length = sizeof(error);
+            if (poll(&waiting, 1, streamTimeout) == 1 && getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0) {
+                result = 0;
+            }
+        }
+        if (result != 0) {
+            close(fd);
+            net.connectFailures++;
+            return 0;
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        next->fd = fd;
+    }
+
+    connection = next;
+    return 1;
+}
+
+uint8_t WiFiClient::connected() {
+    if (!connection) return 0;
+    connection->receive();
+    return connection->open || connection->rxPos < connection->rx.size();
+}
+
+void WiFiClient::stop() {
+    connection.reset();
+}
+
+int WiFiClient::available() {
+    if (!connection) return 0;
+    connection->receive();
+    return connection->rx.size() - connection->rxPos;
+}
+
+int WiFiClient::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t* buffer, size_t size) {
+    size_t ready = available();
+    if (ready == 0) return -1;
+
+    size_t count = std::min(size, ready);
+    memcpy(buffer, connection->rx.data() + connection->rxPos, count);
+    connection->rxPos += count;
+    if (connection->rxPos == connection->rx.size()) {
+        connection->rx.clear();
+        connection->rxPos = 0;
+    }
+    return count;
+}
+
+int WiFiClient::peek() {
+    return available() > 0 ? (uint8_t)connection->rx[connection->rxPos] : -1;
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+    if (!connection || !networkUsable()) return 0;
+    return connection->send(buffer, size);
+}
+
+int WiFiClient::availableForWrite() {
+    return connection && connection->open ? TCP_WINDOW : 0;
+}
+
+namespace BearSSL {
+
+// Контекст движка и второй стек, который ядро ESP8266 выделяет под BearSSL в куче
+const size_t BEARSSL_CONTEXT = 6144;
+
+void WiFiClientSecure::setBufferSizes(int recv, int xmit) {
+    recvSize = recv;
+    xmitSize = xmit;
+}
+
+bool WiFiClientSecure::probeMaxFragmentLength(const char* host, uint16_t port, uint16_t length) {
+    (void)port;
+    (void)length;
+    IPAddress address;
+    if (!WiFi.hostByName(host, address)) return false;
+
+    // ClientHello с расширением MFLN и ответ сервера - один обмен по сети
+    chargeNetwork((uint64_t)tlsResumedMs * 1000);
+    return maxFragmentLength;
+}
+
+int WiFiClientSecure::connect(const char* host, uint16_t port) {
+    if (!WiFiClient::connect(host, port)) return 0;
+
+    releaseBuffers();
+    charged = recvSize + xmitSize + BEARSSL_CONTEXT;
+    host::heapCharge(charged);
+
+    bool resumed = session != nullptr && session->valid && session->host == host;
+    chargeNetwork((uint64_t)(resumed ? tlsResumedMs : tlsFullMs) * 1000);
+    if (session != nullptr) {
+        session->host = host;
+        session->valid = true;
+    }
+    return 1;
+}
+
+int WiFiClientSecure::connect(IPAddress ip, uint16_t port) {
+    return connect(ip.toString().c_str(), port);
+}
+
+void WiFiClientSecure::stop() {
+    WiFiClient::stop();
+    releaseBuffers();
+}
+
+void WiFiClientSecure::releaseBuffers() {
+    if (charged == 0) return;
+    host::heapRelease(charged);
+    charged = 0;
+}
+
+} // namespace BearSSL
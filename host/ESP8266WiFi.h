@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+
+enum wl_status_t {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_WRONG_PASSWORD = 6,
+    WL_DISCONNECTED = 7
+};
+
+enum WiFiMode_t { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 };
+enum WiFiSleepType_t { WIFI_NONE_SLEEP = 0, WIFI_LIGHT_SLEEP = 1, WIFI_MODEM_SLEEP = 2 };
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+class Client : public Stream {
+public:
+    virtual int connect(const char* host, uint16_t port) = 0;
+    virtual int connect(IPAddress ip, uint16_t port) = 0;
+    virtual uint8_t connected() = 0;
+    virtual void stop() = 0;
+    virtual int read(uint8_t* buffer, size_t size) = 0;
+    using Stream::read;
+    virtual operator bool() = 0;
+};
+
+// TCP client. Connections go to the in-process responder from host.h when one
+// is set, otherwise to a real socket; either way reads never block.
+class WiFiClient : public Client {
+public:
+    struct Connection;
+
+    int connect(const char* host, uint16_t port) override;
+    int connect(IPAddress ip, uint16_t port) override;
+    uint8_t connected() override;
+    void stop() override;
+    operator bool() override { return connected(); }
+
+    int available() override;
+    int read() override;
+    int read(uint8_t* buffer, size_t size) override;
+    int peek() override;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int availableForWrite() override;
+    void setNoDelay(bool noDelay) { (void)noDelay; }
+
+protected:
+    std::shared_ptr<Connection> connection;
+};
+
+class ESP8266WiFiClass {
+public:
+    wl_status_t status();
+    wl_status_t begin(const char* ssid, const char* password = nullptr, int32_t channel = 0, const uint8_t* bssid = nullptr, bool connect = true);
+    bool config(IPAddress ip, IPAddress gateway, IPAddress subnet, IPAddress dns1 = IPAddress(), IPAddress dns2 = IPAddress());
+    bool disconnect(bool wifiOff = false);
+    bool mode(WiFiMode_t mode);
+    WiFiMode_t getMode() { return currentMode; }
+    bool persistent(bool persistent) { (void)persistent; return true; }
+    bool setAutoReconnect(bool autoReconnect) { (void)autoReconnect; return true; }
+    bool setSleepMode(WiFiSleepType_t type, uint8_t listenInterval = 0);
+
+    bool softAPConfig(IPAddress local, IPAddress gateway, IPAddress subnet) { (void)local; (void)gateway; (void)subnet; return true; }
+    bool softAP(const char* ssid, const char* password = nullptr) { (void)ssid; (void)password; return true; }
+    uint8_t softAPgetStationNum() { return 0; }
+
+    IPAddress localIP();
+    IPAddress gatewayIP();
+    IPAddress subnetMask();
+    IPAddress dnsIP(uint8_t index = 0);
+    int32_t RSSI();
+    int32_t RSSI(uint8_t index);
+    String SSID();
+    String SSID(uint8_t index);
+    uint8_t* BSSID();
+    int32_t channel();
+    uint8_t* macAddress(uint8_t* mac);
+    String macAddress();
+
+    int8_t scanComplete();
+    void scanDelete();
+    void scanNetworksAsync(std::function<void(int)> onComplete, bool showHidden = false);
+
+    int hostByName(const char* host, IPAddress& result);
+    int hostByName(const char* host, IPAddress& result, uint32_t timeout);
+
+private:
+    WiFiMode_t currentMode = WIFI_STA;
+};
+
+extern ESP8266WiFiClass WiFi;
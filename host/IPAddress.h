@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Arduino.h"
+
+// IPv4 address stored as on the ESP8266: first octet in the lowest byte
+class IPAddress : public Printable {
+public:
+    IPAddress() : address(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : address(a | b << 8 | c << 16 | (uint32_t)d << 24) {}
+    IPAddress(uint32_t value) : address(value) {}
+
+    operator uint32_t() const { return address; }
+    uint8_t operator[](int index) const { return address >> (index * 8); }
+    bool isSet() const { return address != 0; }
+
+    bool fromString(const char* text) {
+        unsigned int a, b, c, d;
+        char tail;
+        if (sscanf(text, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) != 4 || a > 255 || b > 255 || c > 255 || d > 255) return false;
+        *this = IPAddress(a, b, c, d);
+        return true;
+    }
+
+    String toString() const {
+        char text[16];
+        snprintf(text, sizeof(text), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+        return text;
+    }
+
+    size_t printTo(Print& p) const override { return p.print(toString()); }
+
+private:
+    uint32_t address;
+};
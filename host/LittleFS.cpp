@@ -0,0 +1,233 @@
+#include "LittleFS.h"
+#include "host.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <map>
+
+FS LittleFS;
+
+namespace {
+
+// Раздел файловой системы на 4 МБ модуле с разметкой FS:1MB
+const size_t FS_TOTAL_BYTES = 1024 * 1024;
+const size_t FS_BLOCK_SIZE = 8192;
+
+std::string root;
+host::FlashStats flash = {};
+// Bytes written per file name; allocated outside the simulated heap
+std::map<std::string, uint64_t>* bytesByFile = nullptr;
+pid_t tempRootOwner = 0;
+
+void removeTempRoot() {
+    // Дочерние процессы power_sim наследуют atexit, но каталог принадлежит родителю
+    if (getpid() != tempRootOwner) return;
+    std::error_code error;
+    std::filesystem::remove_all(root, error);
+}
+
+const std::string& rootPath() {
+    if (root.empty()) {
+        const char* configured = getenv("ARDUINOID_FS");
+        if (configured != nullptr) host::setFsRoot(configured);
+        else host::makeTempFsRoot();
+    }
+    return root;
+}
+
+std::string hostPath(const char* path) {
+    return rootPath() + (path[0] == '/' ? "" : "/") + path;
+}
+
+} // namespace
+
+struct File::Impl {
+    ~Impl() {
+        if (file != nullptr) fclose(file);
+    }
+
+    FILE* file = nullptr;
+    std::string name;
+};
+
+namespace host {
+
+void setFsRoot(const std::string& path) {
+    root = path;
+    std::filesystem::create_directories(root);
+}
+
+const std::string& fsRoot() {
+    return rootPath();
+}
+
+std::string makeTempFsRoot(bool keep) {
+    const char* tmp = getenv("TMPDIR");
+    std::string pattern = std::string(tmp != nullptr ? tmp : "/tmp") + "/arduinoid-fs-XXXXXX";
+    if (mkdtemp(&pattern[0]) == nullptr) {
+        perror("mkdtemp");
+        exit(1);
+    }
+
+    if (tempRootOwner == getpid()) removeTempRoot();
+    root = pattern;
+    if (!keep) {
+        if (tempRootOwner == 0) atexit(removeTempRoot);
+        tempRootOwner = getpid();
+    }
+    return root;
+}
+
+FlashStats flashStats() {
+    return flash;
+}
+
+uint64_t flashBytesWritten(const char* path) {
+    if (bytesByFile == nullptr) return 0;
+    auto it = bytesByFile->find(path);
+    return it != bytesByFile->end() ? it->second : 0;
+}
+
+void resetFlashStats() {
+    flash = FlashStats();
+    if (bytesByFile != nullptr) bytesByFile->clear();
+}
+
+} // namespace host
+
+const char* File::name() const {
+    return impl ? impl->name.c_str() : "";
+}
+
+size_t File::size() const {
+    if (!impl) return 0;
+    fflush(impl->file);
+    struct stat st;
+    return fstat(fileno(impl->file), &st) == 0 ? st.st_size : 0;
+}
+
+size_t File::position() const {
+    return impl ? ftell(impl->file) : 0;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!impl) return false;
+    int whence = mode == SeekSet ? SEEK_SET : mode == SeekCur ? SEEK_CUR : SEEK_END;
+    long target = mode == SeekSet ? (long)pos : mode == SeekCur ? (long)position() + pos : (long)size() - (long)pos;
+    if (target < 0 || target > (long)size()) return false;
+    return fseek(impl->file, mode == SeekEnd ? -(long)pos : (long)pos, whence) == 0;
+}
+
+bool File::truncate(uint32_t size) {
+    if (!impl) return false;
+    fflush(impl->file);
+    return ftruncate(fileno(impl->file), size) == 0;
+}
+
+int File::available() {
+    if (!impl) return 0;
+    size_t total = size();
+    size_t at = position();
+    return at < total ? total - at : 0;
+}
+
+int File::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+    if (!impl) return 0;
+    return fread(buffer, 1, size, impl->file);
+}
+
+int File::peek() {
+    if (!impl) return -1;
+    int c = fgetc(impl->file);
+    if (c != EOF) ungetc(c, impl->file);
+    return c == EOF ? -1 : c;
+}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    if (!impl) return 0;
+    size_t written = fwrite(buffer, 1, size, impl->file);
+    flash.bytesWritten += written;
+    flash.writeCalls++;
+
+    host::HeapUntracked untracked;
+    if (bytesByFile == nullptr) bytesByFile = new std::map<std::string, uint64_t>();
+    (*bytesByFile)[impl->name] += written;
+    return written;
+}
+
+void File::flush() {
+    if (impl) fflush(impl->file);
+}
+
+bool FS::begin() {
+    rootPath();
+    return true;
+}
+
+bool FS::format() {
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(rootPath(), error)) {
+        std::filesystem::remove_all(entry.path(), error);
+    }
+    return true;
+}
+
+bool FS::info(FSInfo& info) {
+    size_t used = 0;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(rootPath(), error)) {
+        // LittleFS занимает файлом целые блоки
+        if (entry.is_regular_file()) used += (entry.file_size() + FS_BLOCK_SIZE - 1) / FS_BLOCK_SIZE * FS_BLOCK_SIZE;
+    }
+
+    info.totalBytes = FS_TOTAL_BYTES;
+    info.usedBytes = used;
+    info.blockSize = FS_BLOCK_SIZE;
+    info.pageSize = 256;
+    info.maxOpenFiles = 5;
+    info.maxPathLength = 32;
+    return true;
+}
+
+File FS::open(const char* path, const char* mode) {
+    std::string hostMode;
+    if (strcmp(mode, "r") == 0) hostMode = "rb";
+    else if (strcmp(mode, "r+") == 0) hostMode = "r+b";
+    else if (mode[0] == 'w') hostMode = "w+b";
+    else if (mode[0] == 'a') hostMode = "a+b";
+    else return File();
+
+    FILE* file = fopen(hostPath(path).c_str(), hostMode.c_str());
+    if (file == nullptr) return File();
+    if (mode[0] == 'a') fseek(file, 0, SEEK_END);
+    if (hostMode != "rb") flash.opensForWrite++;
+
+    auto impl = std::make_shared<File::Impl>();
+    impl->file = file;
+    impl->name = path;
+    return File(impl);
+}
+
+bool FS::exists(const char* path) {
+    struct stat st;
+    return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char* path) {
+    if (::remove(hostPath(path).c_str()) != 0) return false;
+    flash.removes++;
+    return true;
+}
+
+bool FS::rename(const char* from, const char* to) {
+    if (::rename(hostPath(from).c_str(), hostPath(to).c_str()) != 0) return false;
+    flash.renames++;
+    return true;
+}
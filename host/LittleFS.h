@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Arduino.h"
+
+#include <memory>
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+struct FSInfo {
+    size_t totalBytes;
+    size_t usedBytes;
+    size_t blockSize;
+    size_t pageSize;
+    size_t maxOpenFiles;
+    size_t maxPathLength;
+};
+
+// LittleFS file backed by a host file under host::fsRoot()
+class File : public Stream {
+public:
+    struct Impl;
+
+    File() {}
+    explicit File(std::shared_ptr<Impl> impl) : impl(impl) {}
+
+    operator bool() const { return impl != nullptr; }
+    const char* name() const;
+    size_t size() const;
+    size_t position() const;
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    bool truncate(uint32_t size);
+    void close() { impl.reset(); }
+
+    int available() override;
+    int read() override;
+    size_t read(uint8_t* buffer, size_t size);
+    int peek() override;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    void flush() override;
+
+private:
+    std::shared_ptr<Impl> impl;
+};
+
+class FS {
+public:
+    bool begin();
+    void end() {}
+    bool format();
+    bool info(FSInfo& info);
+    File open(const char* path, const char* mode);
+    File open(const String& path, const char* mode) { return open(path.c_str(), mode); }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to);
+    bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+};
+
+extern FS LittleFS;
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+
+// Declared by the sketch but never armed; attaching is accepted and ignored
+class Ticker {
+public:
+    void attach(float seconds, std::function<void()> callback) { (void)seconds; (void)callback; }
+    void attach_ms(uint32_t ms, std::function<void()> callback) { (void)ms; (void)callback; }
+    void once_ms(uint32_t ms, std::function<void()> callback) { (void)ms; (void)callback; }
+    void detach() {}
+    bool active() { return false; }
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "ESP8266WiFi.h"
+
+namespace BearSSL {
+
+// Session resumption cache: a client with a filled session reconnecting to the
+// same host pays the short handshake from host::setTlsHandshakeTime()
+class Session {
+public:
+    bool isValid() const { return valid; }
+
+private:
+    friend class WiFiClientSecure;
+    std::string host;
+    bool valid = false;
+};
+
+// No encryption on the host: the TLS cost is the blocking handshake time
+// charged to the clock and the BearSSL buffers charged to the heap
+class WiFiClientSecure : public WiFiClient {
+public:
+    ~WiFiClientSecure() override { releaseBuffers(); }
+
+    void setInsecure() {}
+    void setSession(Session* session) { this->session = session; }
+    void setBufferSizes(int recv, int xmit);
+    bool probeMaxFragmentLength(const char* host, uint16_t port, uint16_t length);
+
+    int connect(const char* host, uint16_t port) override;
+    int connect(IPAddress ip, uint16_t port) override;
+    void stop() override;
+
+private:
+    void releaseBuffers();
+
+    Session* session = nullptr;
+    // Значения по умолчанию BearSSL в ядре ESP8266
+    int recvSize = 16709;
+    int xmitSize = 837;
+    size_t charged = 0;
+};
+
+} // namespace BearSSL
+
+using BearSSL::WiFiClientSecure;
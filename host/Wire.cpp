@@ -0,0 +1,19 @@
+#include "Wire.h"
+#include "host.h"
+
+TwoWire Wire;
+
+void TwoWire::beginTransmission(uint8_t address) {
+    (void)address;
+    pending = 0;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+    (void)sendStop;
+    // Адрес плюс данные, 9 тактов SCL на байт с учётом ACK
+    host::advanceClock((pending + 1) * 9 * 1000000ULL / clock);
+    sent += pending;
+    count++;
+    pending = 0;
+    return 0;
+}
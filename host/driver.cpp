@@ -0,0 +1,119 @@
+#include "driver.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+namespace host {
+
+const char* option(int argc, char** argv, const char* name) {
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--", 2) != 0 || strcmp(argv[i] + 2, name) != 0) continue;
+        return i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0 ? argv[i + 1] : "";
+    }
+    return nullptr;
+}
+
+unsigned long optionValue(int argc, char** argv, const char* name, unsigned long fallback) {
+    const char* value = option(argc, argv, name);
+    return value != nullptr && *value != '\0' ? strtoul(value, nullptr, 10) : fallback;
+}
+
+double optionReal(int argc, char** argv, const char* name, double fallback) {
+    const char* value = option(argc, argv, name);
+    return value != nullptr && *value != '\0' ? strtod(value, nullptr) : fallback;
+}
+
+void provisionWiFi(const char* ssid, const char* password) {
+    std::string path = fsRoot() + "/wifi.json";
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        perror(path.c_str());
+        exit(1);
+    }
+    fprintf(file, "{\"ssid\":\"%s\",\"password\":\"%s\",\"connected\":true}", ssid, password);
+    fclose(file);
+}
+
+void Backend::handle(HttpExchange& exchange) {
+    HeapUntracked untracked;
+    counters.requests++;
+
+    char head[256];
+    std::string body;
+    int status = 200;
+    std::string etag = "\"v" + std::to_string(revision) + "\"";
+    std::string extra;
+
+    if (options.failStatus != 0) {
+        counters.failures++;
+        status = options.failStatus;
+        body = "{}";
+        exchange.keepAlive = false;
+    }
+    else if (exchange.body.find("\"queued\"") != std::string::npos || exchange.body.find("\"samples\"") != std::string::npos) {
+        counters.telemetry++;
+        body = "{}";
+    }
+    else {
+        counters.updates++;
+        if (options.changeEvery > 0 && counters.updates % options.changeEvery == 0) {
+            revision++;
+            etag = "\"v" + std::to_string(revision) + "\"";
+        }
+
+        if (exchange.headers.find("If-None-Match: " + etag + "\r\n") != std::string::npos) {
+            counters.notModified++;
+            status = 304;
+        }
+        else {
+            body = "{\"text\":\"Message " + std::to_string(revision) + "\",\"status\":\"Online\",\"user\":\"bench\",\"uptime\":" +
+                std::to_string(options.uptime) + ",\"rev\":" + std::to_string(revision);
+            if (options.padding > 0) body += ",\"notes\":\"" + std::string(options.padding, 'x') + "\"";
+            body += "}";
+        }
+        extra = "ETag: " + etag + "\r\n";
+    }
+
+    snprintf(head, sizeof(head), "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %zu\r\nConnection: %s\r\n",
+        status, status == 200 ? "OK" : status == 304 ? "Not Modified" : "Error", body.size(),
+        exchange.keepAlive ? "keep-alive" : "close");
+    exchange.response = head + extra + "\r\n" + body;
+}
+
+void Backend::install() {
+    setHttpResponder([this](HttpExchange& exchange) { handle(exchange); });
+}
+
+Samples::~Samples() {
+    free(values);
+}
+
+void Samples::add(uint32_t value) {
+    if (used == capacity) {
+        capacity = capacity > 0 ? capacity * 2 : 4096;
+        values = (uint32_t*)realloc(values, capacity * sizeof(uint32_t));
+        if (values == nullptr) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    values[used++] = value;
+    sum += value;
+    largest = std::max(largest, value);
+    sorted = false;
+}
+
+uint32_t Samples::percentile(double p) {
+    if (used == 0) return 0;
+    if (!sorted) {
+        std::sort(values, values + used);
+        sorted = true;
+    }
+    size_t index = (size_t)(p / 100.0 * (used - 1) + 0.5);
+    return values[std::min(index, used - 1)];
+}
+
+} // namespace host
@@ -0,0 +1,82 @@
+// Shared pieces of the host drivers in tools/: option parsing, provisioning
+// the simulated flash, a stand-in backend for the in-process responder and
+// latency statistics. Everything here stays off the simulated heap.
+#pragma once
+
+#include "host.h"
+
+#include <stdint.h>
+
+#include <string>
+
+namespace host {
+
+// Value after --name, or nullptr; flags without a value return ""
+const char* option(int argc, char** argv, const char* name);
+unsigned long optionValue(int argc, char** argv, const char* name, unsigned long fallback);
+double optionReal(int argc, char** argv, const char* name, double fallback);
+
+// Writes /wifi.json as the portal would; setup() migrates it into the journal
+void provisionWiFi(const char* ssid, const char* password);
+
+// Backend that answers the way the device expects: full state with an ETag,
+// 304 when If-None-Match still matches, {} for queued telemetry. The state
+// changes every changeEvery update requests.
+class Backend {
+public:
+    struct Options {
+        unsigned long uptime = 600000;
+        unsigned changeEvery = 10;
+        // Extra filler member so responses can exceed the device's body buffer
+        size_t padding = 0;
+        // Non-zero: answer every request with this status, e.g. 503 during an outage
+        int failStatus = 0;
+    };
+
+    struct Stats {
+        uint64_t requests;
+        uint64_t updates;
+        uint64_t notModified;
+        uint64_t telemetry;
+        uint64_t failures;
+    };
+
+    Backend() : Backend(Options()) {}
+    explicit Backend(const Options& options) : options(options) {}
+
+    void handle(HttpExchange& exchange);
+    // Installs this backend as the in-process responder
+    void install();
+    void setFailStatus(int status) { options.failStatus = status; }
+    const Stats& stats() const { return counters; }
+
+private:
+    Options options;
+    Stats counters = {};
+    unsigned revision = 1;
+};
+
+// Latency samples in a malloc'd array, so collecting them does not move heap figures
+class Samples {
+public:
+    Samples() {}
+    ~Samples();
+    Samples(const Samples&) = delete;
+    Samples& operator=(const Samples&) = delete;
+
+    void add(uint32_t value);
+    size_t count() const { return used; }
+    uint32_t percentile(double p);
+    uint32_t max() const { return largest; }
+    double mean() const { return used > 0 ? (double)sum / used : 0; }
+
+private:
+    uint32_t* values = nullptr;
+    size_t used = 0;
+    size_t capacity = 0;
+    uint64_t sum = 0;
+    uint32_t largest = 0;
+    bool sorted = true;
+};
+
+} // namespace host
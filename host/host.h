@@ -0,0 +1,163 @@
+// Controls for the host build. Drivers (loop_bench.cpp and friends) use these
+// to shape the simulated board; main.cpp never includes this header.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+
+namespace host {
+
+// --- clock -----------------------------------------------------------------
+
+// Microseconds on the virtual clock behind millis()/micros()
+uint64_t clockMicros();
+// Skip time forward without running anything
+void advanceClock(uint64_t micros);
+// Start the clock again from zero, as after a reset
+void resetClock();
+// delay() sleeps for real instead of skipping time (needed against a real server)
+void setRealtime(bool realtime);
+// Host CPU time spent outside delay() since the last resetClock()
+uint64_t busyMicros();
+// Virtual time spent inside delay(); clock minus this is time the sketch was busy or blocked
+uint64_t delayedMicros();
+// Number of delay() calls, i.e. times the scheduler went idle
+uint64_t idleCount();
+
+// --- console ---------------------------------------------------------------
+
+void setSerialEcho(bool echo);
+uint64_t serialBytes();
+
+// --- heap ------------------------------------------------------------------
+
+// Size of the simulated heap; ESP.getFreeHeap() = heapSize() - heapInUse()
+size_t heapSize();
+void setHeapSize(size_t bytes);
+size_t heapInUse();
+size_t heapPeak();
+void resetHeapPeak();
+uint64_t heapAllocations();
+// Book memory the firmware would take from the heap but the host keeps elsewhere
+void heapCharge(size_t bytes);
+void heapRelease(size_t bytes);
+
+// While one is alive, allocations on this thread stay off the simulated heap:
+// for driver bookkeeping and the in-process server, which the device does not have
+class HeapUntracked {
+public:
+    HeapUntracked();
+    ~HeapUntracked();
+    HeapUntracked(const HeapUntracked&) = delete;
+    HeapUntracked& operator=(const HeapUntracked&) = delete;
+};
+
+// --- board -----------------------------------------------------------------
+
+// Sets an input level; a level change runs the handler attached with attachInterrupt()
+void setPin(uint8_t pin, int value);
+// setPin() at a given clockMicros(), applied at that exact virtual time even when
+// the clock jumps past it inside delay() or a blocking network call
+void schedulePin(uint8_t pin, int value, uint64_t atMicros);
+void setAnalog(uint8_t pin, int value);
+void seedRandom(uint32_t seed);
+void setResetReason(uint32_t reason);
+// Called by ESP.deepSleep(); must not return. The default prints and exits.
+void setDeepSleepHandler(std::function<void(uint64_t micros)> handler);
+// RTC user memory survives resetClock() and fork(), like the real one survives deep sleep
+uint8_t* rtcMemory();
+
+// --- flash -----------------------------------------------------------------
+
+struct FlashStats {
+    uint64_t bytesWritten;
+    uint64_t writeCalls;
+    uint64_t opensForWrite;
+    uint64_t removes;
+    uint64_t renames;
+};
+
+// Directory that holds the LittleFS files; created on LittleFS.begin()
+void setFsRoot(const std::string& path);
+const std::string& fsRoot();
+// Fresh empty directory under $TMPDIR, removed at exit unless keep is set
+std::string makeTempFsRoot(bool keep = false);
+FlashStats flashStats();
+// Bytes written to one file, by the name the sketch opened it with ("/journal.bin")
+uint64_t flashBytesWritten(const char* path);
+void resetFlashStats();
+
+// --- Wi-Fi -----------------------------------------------------------------
+
+struct WiFiTiming {
+    unsigned long fullJoin;     // scan + association + DHCP, ms
+    unsigned long directedJoin; // WiFi.begin() with channel and BSSID and a static address, ms
+    unsigned long dnsLookup;    // blocking WiFi.hostByName(), ms
+    unsigned long dhcp;         // added to a directed join without a static address, ms
+};
+
+void setAccessPoint(bool up);
+bool accessPointUp();
+void setWiFiTiming(const WiFiTiming& timing);
+// Asked when a join would complete with the access point up; false rejects it,
+// as an overloaded access point would, and the station stays disconnected
+void setJoinAdmission(std::function<bool()> admit);
+// Address handed out by DHCP; a static WiFi.config() outside the subnet loses the server
+void setDhcpLease(uint32_t ip);
+uint32_t dhcpLease();
+
+struct WiFiStats {
+    uint64_t joins;
+    uint64_t directedJoins;
+    uint64_t staticConfigs;
+    uint64_t scans;
+    uint64_t connectedMicros;
+    // Time between WiFi.begin() and the join completing or being abandoned, including a join in progress
+    uint64_t joiningMicros;
+    int sleepMode;
+    uint8_t listenInterval;
+};
+
+WiFiStats wifiStats();
+
+// --- network ---------------------------------------------------------------
+
+// In-process backend: when set, every client connection goes to it instead of
+// a socket. It gets one complete HTTP request and returns the full response;
+// keepAlive = false closes the connection after the response.
+struct HttpExchange {
+    std::string method;
+    std::string path;
+    std::string host;
+    std::string headers;
+    std::string body;
+    std::string response;
+    bool keepAlive = true;
+};
+
+void setHttpResponder(std::function<void(HttpExchange&)> responder);
+// Fail connects and DNS lookups, as if the backend or the uplink were down
+void setServerReachable(bool reachable);
+
+struct NetStats {
+    uint64_t connects;
+    uint64_t connectFailures;
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+    uint64_t requests;
+    // Virtual time charged to blocking DNS lookups, connect timeouts and TLS handshakes
+    uint64_t blockedMicros;
+};
+
+NetStats netStats();
+
+// TLS behaviour of WiFiClientSecure, which is plain TCP on the host
+void setMaxFragmentLengthSupported(bool supported);
+// Blocking time charged to the virtual clock by WiFiClientSecure::connect():
+// a full handshake, or a resumed one when the client has a filled session
+void setTlsHandshakeTime(unsigned long fullMs, unsigned long resumedMs);
+
+} // namespace host
@@ -1,1225 +1,4494 @@
-﻿#include <ESP8266WiFi.h>
-#include <ESP8266WebServer.h>
-#include <DNSServer.h>
-#include <WiFiClientSecure.h>
-#include <ESP8266HTTPClient.h>
-#include <ArduinoJson.h>
-#include <Wire.h>
-#include <Adafruit_GFX.h>
-#include <Adafruit_SSD1306.h>
-#include <LittleFS.h>
-#include <Ticker.h>
-
-#define DISPLAY_WIDTH 128
-#define DISPLAY_HEIGHT 32
-#define OLED_RESET -1
-#define SCREEN_ADDRESS 0x3C
-#define RESET_BUTTON_PIN 0
-#define BATTERY_PIN A0
-#define SDA 4
-#define SCL 5
-
-String SERVER_URL = "https://letpass.ru/?init";
-const char* DEFAULT_SSID = "ESP8266_Setup";
-const byte DNS_PORT = 53;
-const int WIFI_RECONNECT_INTERVAL = 10000;
-const int SERVER_UPDATE_DEFAULT = 600000;
-const int WIFI_CONNECTION_TIMEOUT = 20000;
-
-IPAddress apIP(192, 168, 4, 1);
-
-Adafruit_SSD1306 display(DISPLAY_WIDTH, DISPLAY_HEIGHT, &Wire, OLED_RESET);
-ESP8266WebServer webServer(80);
-DNSServer dnsServer;
-Ticker wifiTicker;
-
-struct DeviceData {
-    String boardID;
-    String token;
-    unsigned long timer;
-    unsigned long uptime;
-    String text;
-    String status;
-    String user;
-    String serverUrl;
-};
-
-struct WiFiCredentials {
-    String ssid;
-    String password;
-    bool connected;
-};
-
-DeviceData deviceData;
-WiFiCredentials wifiCreds;
-unsigned long lastConnectionAttempt = 0;
-unsigned long lastServerUpdate = 0;
-unsigned long lastDisplayUpdate = 0;
-bool isAccessPointMode = false;
-bool displayEnabled = true;
-String lastDisplayLine1 = "";
-String lastDisplayLine2 = "";
-String lastDisplayLine3 = "";
-unsigned long lastWifiScan = 0;
-bool firstBoot = true;
-bool waitingForCredentialsVerification = false;
-String pendingRedirectUrl = "";
-unsigned long credentialsVerificationStartTime = 0;
-int connectionFailCount = 0;
-
-void setupDisplay();
-void updateDisplay(String line1, String line2, String line3 = "");
-void handleRoot();
-void handleConnect();
-void handleSuccess();
-void handleRedirect();
-void handleScan();
-void handleNotFound();
-void startAPMode();
-void loadDeviceData();
-void saveDeviceData();
-void loadWiFiCredentials();
-void saveWiFiCredentials(String ssid, String password);
-void resetWiFiSettings();
-bool connectToWiFi(String ssid, String password);
-void sendDataToServer(bool isHello = false);
-String getWiFiSignalStrength();
-String getMacAddress();
-void formatFS();
-void centerText(String text, int y);
-void exitAPMode();
-void checkCredentialsVerification();
-
-void setup() {
-    Serial.begin(115200);
-    Serial.println("\nStarting up...");
-
-    pinMode(RESET_BUTTON_PIN, INPUT_PULLUP);
-
-    ESP.getFreeHeap();
-
-    if (!LittleFS.begin()) {
-        Serial.println("LittleFS mount failed. Formatting...");
-        formatFS();
-    }
-
-    setupDisplay();
-    if (displayEnabled) {
-        updateDisplay("Starting up...", "Please wait...");
-    }
-    else {
-        Serial.println("WARNING: Display initialization failed!");
-    }
-
-    loadDeviceData();
-    loadWiFiCredentials();
-
-    if (deviceData.boardID.length() == 0) {
-        deviceData.boardID = "ESP8266_" + String(ESP.getChipId(), HEX);
-        deviceData.token = deviceData.boardID + "_token";
-        deviceData.timer = 0;
-        deviceData.uptime = SERVER_UPDATE_DEFAULT;
-        deviceData.text = "Welcome!";
-        deviceData.status = "New device";
-        deviceData.user = "";
-        deviceData.serverUrl = SERVER_URL;
-        saveDeviceData();
-        Serial.println("Created new device data with ID: " + deviceData.boardID);
-    }
-    else {
-        if (deviceData.serverUrl.length() > 0) {
-            SERVER_URL = deviceData.serverUrl;
-            Serial.println("Using saved server URL: " + SERVER_URL);
-        }
-    }
-
-    if (wifiCreds.ssid.length() > 0) {
-        updateDisplay("Connecting to WiFi", wifiCreds.ssid);
-        if (connectToWiFi(wifiCreds.ssid, wifiCreds.password)) {
-            updateDisplay("Connected to WiFi", wifiCreds.ssid, getWiFiSignalStrength());
-            wifiCreds.connected = true;
-            saveWiFiCredentials(wifiCreds.ssid, wifiCreds.password);
-
-            updateDisplay("Please wait", "Registering to server...", "WiFi " + wifiCreds.ssid + " connected");
-
-            sendDataToServer(true);
-        }
-        else {
-            updateDisplay("WiFi connection", "failed", "Starting setup...");
-            delay(2000);
-            startAPMode();
-        }
-    }
-    else {
-        startAPMode();
-    }
-
-    Serial.println("Setup complete");
-    Serial.printf("Free heap: %d bytes\n", ESP.getFreeHeap());
-    Serial.println("Device ID: " + deviceData.boardID);
-    Serial.println("Server URL: " + SERVER_URL);
-    Serial.println("WiFi SSID: " + wifiCreds.ssid);
-    Serial.println("WiFi connected: " + String(wifiCreds.connected ? "Yes" : "No"));
-}
-
-void loop() {
-    if (digitalRead(RESET_BUTTON_PIN) == LOW) {
-        unsigned long pressStart = millis();
-        while (digitalRead(RESET_BUTTON_PIN) == LOW) {
-            delay(10);
-        }
-        if (millis() - pressStart > 3000) {
-            resetWiFiSettings();
-        }
-    }
-
-    // Мониторим то чего нет)))))
-    float batteryVoltage = analogRead(BATTERY_PIN) * 3.3 / 1023.0 * 2;
-    static bool isDataSaved = false;
-
-    if (batteryVoltage < 3.1 && !isDataSaved) {
-        saveDeviceData();
-        updateDisplay("Low Battery!", "Saving data...", String(batteryVoltage, 2) + "V");
-        delay(2000);
-        isDataSaved = true;
-    }
-    else if (batteryVoltage >= 3.1) {
-        isDataSaved = false;
-    }
-
-    unsigned long currentMillis = millis();
-
-    if (isAccessPointMode) {
-        dnsServer.processNextRequest();
-        webServer.handleClient();
-
-        if (waitingForCredentialsVerification) {
-            checkCredentialsVerification();
-        }
-
-        if (currentMillis - lastWifiScan >= 10000) {
-            lastWifiScan = currentMillis;
-            WiFi.scanNetworksAsync([](int networksFound) {
-                Serial.printf("Scan completed, found %d networks\n", networksFound);
-                }, true);
-        }
-    }
-    else if (WiFi.status() == WL_CONNECTED) {
-        wifiCreds.connected = true;
-
-        if (currentMillis - lastServerUpdate >= deviceData.uptime) {
-            lastServerUpdate = currentMillis;
-            updateDisplay("Please wait", "Updating data...", "WiFi " + wifiCreds.ssid + " connected");
-            sendDataToServer(false);
-        }
-
-        deviceData.timer = millis();
-
-        if (currentMillis - lastDisplayUpdate >= 1000) {
-            lastDisplayUpdate = currentMillis;
-            updateDisplay(
-                deviceData.text,
-                "Time: " + String(millis()),
-                "Status: " + deviceData.status
-            );
-        }
-
-        static unsigned long lastSave = 0;
-        if (currentMillis - lastSave >= 3600000) {
-            lastSave = currentMillis;
-            saveDeviceData();
-        }
-    }
-    else if (wifiCreds.ssid.length() > 0) {
-        if (currentMillis - lastConnectionAttempt >= WIFI_RECONNECT_INTERVAL) {
-            lastConnectionAttempt = currentMillis;
-            updateDisplay("Reconnecting...", wifiCreds.ssid, "WiFi disconnected");
-            Serial.println("Attempting to reconnect to WiFi: " + wifiCreds.ssid);
-
-            if (connectToWiFi(wifiCreds.ssid, wifiCreds.password)) {
-                updateDisplay("Reconnected", wifiCreds.ssid, "WiFi connected");
-                wifiCreds.connected = true;
-
-                sendDataToServer(true);
-                connectionFailCount = 0;
-            }
-            else {
-                updateDisplay("Reconnect failed", "Will retry...", "WiFi disconnected");
-                connectionFailCount++;
-                Serial.println("Reconnection failed. Attempt: " + String(connectionFailCount));
-
-                if (connectionFailCount >= 3) {
-                    Serial.println("Multiple reconnection failures. Starting AP mode.");
-                    connectionFailCount = 0;
-                    startAPMode();
-                }
-            }
-        }
-    }
-
-    static unsigned long lastDisplayCheck = 0;
-    if (millis() - lastDisplayCheck > 60000) {
-        lastDisplayCheck = millis();
-        if (!displayEnabled) {
-            Serial.println("Attempting to reinitialize display...");
-            setupDisplay();
-            if (displayEnabled) {
-                updateDisplay("Display reinitialized", "System running",
-                    WiFi.status() == WL_CONNECTED ? "WiFi connected" : "WiFi disconnected");
-            }
-        }
-    }
-
-    delay(50);
-}
-
-
-void checkCredentialsVerification() {
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("Successfully connected to WiFi: " + wifiCreds.ssid);
-        Serial.print("IP address: ");
-        Serial.println(WiFi.localIP());
-
-        waitingForCredentialsVerification = false;
-        wifiCreds.connected = true;
-        saveWiFiCredentials(wifiCreds.ssid, wifiCreds.password);
-        updateDisplay("Connected to WiFi", wifiCreds.ssid, getWiFiSignalStrength());
-
-        sendDataToServer(true);
-
-        if (pendingRedirectUrl.length() > 0) {
-            Serial.println("Keeping AP for redirect to: " + pendingRedirectUrl);
-            static unsigned long redirectStartTime = millis();
-            if (millis() - redirectStartTime > 60000) {
-                exitAPMode();
-            }
-        }
-        else {
-            static unsigned long successTime = millis();
-            if (millis() - successTime >= 5000) {
-                exitAPMode();
-            }
-        }
-    }
-    else if ((millis() - credentialsVerificationStartTime) >= WIFI_CONNECTION_TIMEOUT) {
-        Serial.println("Connection attempt timed out");
-        waitingForCredentialsVerification = false;
-        WiFi.disconnect();
-        connectionFailCount++;
-
-        updateDisplay("WiFi Failed", "Please try again", "Check credentials");
-
-        if (connectionFailCount >= 3) {
-            Serial.println("Multiple connection failures - check AP functionality");
-            WiFi.disconnect();
-            WiFi.mode(WIFI_AP_STA);
-            WiFi.softAPConfig(apIP, apIP, IPAddress(255, 255, 255, 0));
-            WiFi.softAP(DEFAULT_SSID);
-            connectionFailCount = 0;
-        }
-    }
-}
-
-void exitAPMode() {
-    if (isAccessPointMode) {
-        Serial.println("Exiting AP mode, continuing in station mode only");
-        isAccessPointMode = false;
-        dnsServer.stop();
-        webServer.stop();
-
-        WiFi.mode(WIFI_STA);
-
-        updateDisplay("Connected to WiFi", wifiCreds.ssid, "AP mode disabled");
-
-        pendingRedirectUrl = "";
-        connectionFailCount = 0;
-    }
-}
-
-void setupDisplay() {
-    Wire.begin(SDA, SCL);
-
-    lastDisplayLine1 = "";
-    lastDisplayLine2 = "";
-    lastDisplayLine3 = "";
-
-    if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
-        Serial.println(F("SSD1306 allocation failed"));
-        displayEnabled = false;
-        return;
-    }
-
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
-    display.setCursor(0, 0);
-    display.println("Initializing...");
-    display.display();
-
-    Serial.println(F("SSD1306 initialization successful"));
-    displayEnabled = true;
-}
-
-void updateDisplay(String line1, String line2, String line3 = "") {
-    if (!displayEnabled) return;
-
-    lastDisplayLine1 = line1;
-    lastDisplayLine2 = line2;
-    lastDisplayLine3 = line3;
-
-    display.clearDisplay();
-
-    if (line1.length() > 21) line1 = line1.substring(0, 18) + "...";
-    if (line2.length() > 21) line2 = line2.substring(0, 18) + "...";
-    if (line3.length() > 21) line3 = line3.substring(0, 18) + "...";
-
-    centerText(line1, 0);
-    centerText(line2, 11);
-
-    if (line3.length() > 0) {
-        centerText(line3, 22);
-    }
-
-    if (WiFi.status() == WL_CONNECTED) {
-        int rssi = WiFi.RSSI();
-        int bars = 0;
-
-        if (rssi > -55) bars = 4;
-        else if (rssi > -65) bars = 3;
-        else if (rssi > -75) bars = 2;
-        else if (rssi > -85) bars = 1;
-
-        for (int i = 0; i < bars; i++) {
-            display.fillRect(DISPLAY_WIDTH - 18 + i * 4, 2 + (4 - i) * 2, 3, i * 2 + 2, SSD1306_WHITE);
-        }
-    }
-
-    float batteryVoltage = analogRead(BATTERY_PIN) * 3.3 / 1023.0 * 2;
-    int batteryLevel = map(batteryVoltage * 100, 320, 420, 0, 100);
-    batteryLevel = constrain(batteryLevel, 0, 100);
-
-    display.drawRect(2, 2, 12, 6, SSD1306_WHITE);
-    display.drawRect(14, 3, 2, 4, SSD1306_WHITE);
-    display.fillRect(2, 2, map(batteryLevel, 0, 100, 0, 12), 6, SSD1306_WHITE);
-
-    display.display();
-
-    delay(10);
-}
-
-void centerText(String text, int y) {
-    int16_t x1, y1;
-    uint16_t w, h;
-
-    display.getTextBounds(text, 0, 0, &x1, &y1, &w, &h);
-
-    display.setCursor((DISPLAY_WIDTH - w) / 2, y);
-
-    display.println(text);
-}
-
-void startAPMode() {
-    WiFi.disconnect(true);
-    delay(500);
-
-    WiFi.mode(WIFI_AP_STA);
-    WiFi.softAPConfig(apIP, apIP, IPAddress(255, 255, 255, 0));
-    WiFi.softAP(DEFAULT_SSID);
-
-    dnsServer.setErrorReplyCode(DNSReplyCode::NoError);
-    dnsServer.start(DNS_PORT, "*", apIP);
-
-    webServer.on("/", handleRoot);
-    webServer.on("/connect", HTTP_POST, handleConnect);
-    webServer.on("/success", handleSuccess);
-    webServer.on("/redirect", handleRedirect);
-    webServer.on("/scan", handleScan);
-    webServer.onNotFound(handleNotFound);
-    webServer.begin();
-
-    isAccessPointMode = true;
-    Serial.println("AP Mode started");
-    Serial.print("AP SSID: ");
-    Serial.println(DEFAULT_SSID);
-
-    updateDisplay(
-        "Please connect to WiFi:",
-        DEFAULT_SSID,
-        "Then visit: setup portal"
-    );
-
-    lastWifiScan = millis() - 10000;
-    WiFi.scanNetworksAsync([](int networksFound) {
-        Serial.printf("Initial scan completed, found %d networks\n", networksFound);
-        }, true);
-}
-
-void handleRoot() {
-    String html = R"html(
-<!DOCTYPE html>
-<html>
-<head>
-  <meta name="viewport" content="width=device-width, initial-scale=1.0">
-  <meta charset="UTF-8">
-  <title>ESP8266 WiFi Setup</title>
-  <style>
-    body {
-      font-family: Arial, sans-serif;
-      margin: 0;
-      padding: 20px;
-      background: #f5f5f5;
-      text-align: center;
-    }
-    .container {
-      max-width: 400px;
-      margin: 0 auto;
-      background: white;
-      padding: 20px;
-      border-radius: 10px;
-      box-shadow: 0 2px 10px rgba(0,0,0,0.1);
-    }
-    h1 {
-      color: #333;
-    }
-    .form-group {
-      margin-bottom: 15px;
-      text-align: left;
-    }
-    label {
-      display: block;
-      margin-bottom: 5px;
-      font-weight: bold;
-    }
-    input {
-      width: 100%;
-      padding: 8px;
-      box-sizing: border-box;
-      border: 1px solid #ddd;
-      border-radius: 4px;
-    }
-    button {
-      background: #4285f4;
-      color: white;
-      border: none;
-      padding: 10px 15px;
-      border-radius: 4px;
-      cursor: pointer;
-      font-weight: bold;
-    }
-    button:hover {
-      opacity: 0.9;
-    }
-    #networks {
-      max-height: 200px;
-      overflow-y: auto;
-      margin-bottom: 15px;
-      border: 1px solid #ddd;
-      border-radius: 4px;
-    }
-    .network {
-      padding: 8px;
-      border-bottom: 1px solid #ddd;
-      cursor: pointer;
-    }
-    .network:hover {
-      background: rgba(0,0,0,0.05);
-    }
-    .signal-strength {
-      float: right;
-      color: #666;
-    }
-    #refresh-btn {
-      margin-bottom: 10px;
-      background: #34a853;
-    }
-    #scanning {
-      padding: 15px;
-      color: #666;
-    }
-    .status {
-      padding: 10px;
-      margin-top: 10px;
-      border-radius: 4px;
-      display: none;
-    }
-    .error {
-      background-color: #ffebee;
-      color: #c62828;
-      border: 1px solid #ef9a9a;
-    }
-    .success {
-      background-color: #e8f5e9;
-      color: #2e7d32;
-      border: 1px solid #a5d6a7;
-    }
-  </style>
-</head>
-<body>
-  <div class="container">
-    <h1>ESP8266 WiFi Setup</h1>
-    <p>Please select your WiFi network and enter the password to connect the device.</p>
-    
-    <button id="refresh-btn" onclick="fetchNetworks()">Refresh Networks</button>
-    
-    <div id="networks">
-      <p id="scanning">Scanning for networks...</p>
-    </div>
-    
-    <form id="wifi-form" onsubmit="return submitForm()">
-      <div class="form-group">
-        <label for="ssid">Network Name (SSID):</label>
-        <input type="text" id="ssid" name="ssid" required>
-      </div>
-      
-      <div class="form-group">
-        <label for="password">Password:</label>
-        <input type="password" id="password" name="password">
-      </div>
-      
-      <div class="form-group">
-        <label for="redirect_url">Redirect URL:</label>
-        <input type="text" id="redirect_url" name="redirect_url" placeholder="https://zalupa.online">
-      </div>
-      
-      <button type="submit">Connect</button>
-    </form>
-    
-    <div id="status-message" class="status"></div>
-  </div>
-  
-  <script>
-    window.onload = function() {
-      fetchNetworks();
-    };
-    
-    function fetchNetworks() {
-      document.getElementById('scanning').textContent = 'Scanning for networks...';
-      
-      fetch('/scan')
-        .then(response => {
-          if (!response.ok) {
-            throw new Error('Network scan failed');
-          }
-          return response.json();
-        })
-        .then(data => {
-          const networksDiv = document.getElementById('networks');
-          networksDiv.innerHTML = '';
-          
-          if (!data || data.length === 0) {
-            networksDiv.innerHTML = '<p id="scanning">No networks found. Try refreshing...</p>';
-            return;
-          }
-
-          data.sort((a, b) => b.rssi - a.rssi);
-          
-          data.forEach(network => {
-            if (network.ssid && network.ssid.length > 0) {  // Only show networks with SSID
-              const div = document.createElement('div');
-              div.className = 'network';
-
-              let signalBars = '';
-              const rssi = network.rssi;
-              if (rssi > -55) signalBars = '●●●●';
-              else if (rssi > -65) signalBars = '●●●○';
-              else if (rssi > -75) signalBars = '●●○○';
-              else if (rssi > -85) signalBars = '●○○○';
-              else signalBars = '○○○○';
-              
-              div.innerHTML = network.ssid + '<span class="signal-strength">' + signalBars + ' ' + rssi + ' dBm</span>';
-              div.onclick = function() {
-                document.getElementById('ssid').value = network.ssid;
-                document.getElementById('password').focus();
-              };
-              networksDiv.appendChild(div);
-            }
-          });
-        })
-        .catch(error => {
-          document.getElementById('networks').innerHTML = '<p id="scanning">Error scanning networks. Retrying...</p>';
-          console.error('Error:', error);
-        });
-    }
-    
-    function submitForm() {
-      const ssid = document.getElementById('ssid').value;
-      if(!ssid) {
-        showStatus('Please select a network', 'error');
-        return false;
-      }
-      
-      const statusDiv = document.getElementById('status-message');
-      statusDiv.className = 'status';
-      statusDiv.style.display = 'block';
-      statusDiv.textContent = 'Connecting to ' + ssid + '...';
-      
-      const formData = new FormData(document.getElementById('wifi-form'));
-      
-      fetch('/connect', {
-        method: 'POST',
-        body: new URLSearchParams(formData)
-      })
-      .then(response => response.text())
-      .then(data => {
-        checkConnectionStatus();
-      })
-      .catch(error => {
-        showStatus('Error connecting: ' + error, 'error');
-      });
-      
-      return false;
-    }
-    
-    let connectionCheckCount = 0;
-    
-    function checkConnectionStatus() {
-      connectionCheckCount = 0;
-      showStatus('Attempting to connect...', '');
-      
-      const statusCheck = setInterval(function() {
-        connectionCheckCount++;
-        
-        fetch('/success')
-        .then(response => response.text())
-        .then(data => {
-          if(data === "connected") {
-            clearInterval(statusCheck);
-            showStatus('Connection successful!', 'success');
-
-            const redirectUrl = document.getElementById('redirect_url').value;
-            if(redirectUrl && redirectUrl.length > 0) {
-              showStatus('Redirecting to ' + redirectUrl + ' in 3 seconds...', 'success');
-              setTimeout(function() {
-                window.location.href = redirectUrl;
-              }, 3000);
-            }
-          } else if(data === "connecting") {
-            showStatus('Still connecting... please wait', '');
-          } else {
-            showStatus('Checking connection status...', '');
-          }
-        })
-        .catch(error => {
-          showStatus('Connection may have succeeded. If this page disconnects, the device has connected to your network.', '');
-
-          if (connectionCheckCount > 15) {
-            clearInterval(statusCheck);
-          }
-        });
-      }, 1000);
-
-      setTimeout(function() {
-        clearInterval(statusCheck);
-        showStatus('Connection attempt timed out. Please check your password and try again.', 'error');
-      }, 30000);
-    }
-    
-    function showStatus(message, type) {
-      const statusDiv = document.getElementById('status-message');
-      statusDiv.textContent = message;
-      statusDiv.className = 'status ' + type;
-      statusDiv.style.display = 'block';
-    }
-  </script>
-</body>
-</html>
-)html";
-
-    webServer.send(200, "text/html", html);
-}
-
-void handleConnect() {
-    String ssid = webServer.arg("ssid");
-    String password = webServer.arg("password");
-    String redirectUrl = webServer.arg("redirect_url");
-
-    if (ssid.length() > 0) {
-        saveWiFiCredentials(ssid, password);
-
-        pendingRedirectUrl = redirectUrl;
-
-        WiFi.disconnect(true);
-        delay(500);
-
-        waitingForCredentialsVerification = true;
-        credentialsVerificationStartTime = millis();
-        lastConnectionAttempt = millis();
-
-        updateDisplay("Connecting to", ssid, "Please wait...");
-
-        Serial.println("Attempting to connect to: " + ssid);
-
-        WiFi.mode(WIFI_AP_STA);
-        WiFi.begin(ssid.c_str(), password.c_str());
-
-        webServer.send(200, "text/plain", "Attempting to connect to " + ssid);
-    }
-    else {
-        webServer.send(400, "text/plain", "SSID required");
-    }
-}
-
-void handleSuccess() {
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("Success check: WiFi is connected");
-        webServer.send(200, "text/plain", "connected");
-    }
-    else {
-        if (waitingForCredentialsVerification) {
-            Serial.println("Success check: Still connecting...");
-            webServer.send(200, "text/plain", "connecting");
-        }
-        else {
-            Serial.println("Success check: Not connected");
-            webServer.send(200, "text/plain", "not connected");
-        }
-    }
-}
-
-void handleRedirect() {
-    String redirectUrl = webServer.arg("url");
-    if (redirectUrl.length() > 0) {
-        webServer.sendHeader("Location", redirectUrl, true);
-        webServer.send(302, "text/plain", "");
-    }
-    else {
-        webServer.send(400, "text/plain", "No URL provided");
-    }
-}
-
-void handleScan() {
-    int n = WiFi.scanComplete();
-    String json = "[";
-
-    if (n == -2) {
-        WiFi.scanNetworksAsync([](int networksFound) {
-            Serial.printf("Scan started, found %d networks\n", networksFound);
-            }, true);
-        json = "[]";
-    }
-    else if (n == -1) {
-        json = "[]";
-    }
-    else if (n == 0) {
-        json = "[]";
-        WiFi.scanDelete();
-        WiFi.scanNetworksAsync([](int networksFound) {
-            Serial.printf("New scan started, found %d networks\n", networksFound);
-            }, true);
-    }
-    else if (n > 0) {
-        for (int i = 0; i < n; i++) {
-            if (i > 0) json += ",";
-            json += "{\"ssid\":\"" + WiFi.SSID(i) + "\",\"rssi\":" + String(WiFi.RSSI(i)) + "}";
-        }
-
-        WiFi.scanDelete();
-        WiFi.scanNetworksAsync([](int networksFound) {
-            Serial.printf("New scan after results, found %d networks\n", networksFound);
-            }, true);
-    }
-
-    json += "]";
-    webServer.send(200, "application/json", json);
-}
-
-void handleNotFound() {
-    if (isAccessPointMode) {
-        handleRoot();
-    }
-    else {
-        webServer.send(404, "text/plain", "Not found");
-    }
-}
-
-bool connectToWiFi(String ssid, String password) {
-    Serial.println("Attempting to connect to WiFi: " + ssid);
-
-    WiFi.disconnect(true);
-    delay(200);
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(ssid.c_str(), password.c_str());
-
-    int timeout = 20;
-    while (WiFi.status() != WL_CONNECTED && timeout > 0) {
-        delay(1000);
-        Serial.print(".");
-        timeout--;
-    }
-
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("\nConnected to WiFi!");
-        Serial.print("IP address: ");
-        Serial.println(WiFi.localIP());
-
-        wifiCreds.connected = true;
-        saveWiFiCredentials(ssid, password);
-
-        return true;
-    }
-    else {
-        Serial.println("\nFailed to connect to WiFi");
-        return false;
-    }
-}
-
-void sendDataToServer(bool isHello) {
-    if (WiFi.status() != WL_CONNECTED) {
-        Serial.println("Cannot send data: WiFi not connected");
-        updateDisplay("Server update failed", "WiFi not connected", "Please check connection");
-        return;
-    }
-
-    WiFiClientSecure client;
-    client.setInsecure();
-
-    HTTPClient http;
-
-    String url = SERVER_URL;
-
-    Serial.print("Sending data to server: ");
-    Serial.println(url);
-
-    if (!http.begin(client, url)) {
-        Serial.println("Connection to server failed");
-        updateDisplay("Server error", "Connection failed", "Will retry later");
-        return;
-    }
-
-    http.addHeader("Content-Type", "application/json");
-
-    DynamicJsonDocument doc(1024);
-    doc["boardID"] = deviceData.boardID;
-    doc["user"] = deviceData.user;
-    doc["text"] = deviceData.text;
-    doc["status"] = deviceData.status;
-    doc["token"] = deviceData.token;
-    doc["uptime"] = deviceData.uptime;
-    doc["serverUrl"] = deviceData.serverUrl;
-    doc["mac"] = getMacAddress();
-
-    if (isHello) {
-        doc["time"] = millis();
-        doc["hello"] = "Привет от ESP8266";
-        Serial.println("Sending hello message to server");
-    }
-    else {
-        doc["time"] = millis();
-        doc["timer"] = deviceData.timer;
-    }
-
-    String payload;
-    serializeJson(doc, payload);
-
-    Serial.print("Sending: ");
-    Serial.println(payload);
-
-    int httpCode = http.POST(payload);
-
-    if (httpCode > 0) {
-        Serial.printf("HTTP Response code: %d\n", httpCode);
-
-        if (httpCode == HTTP_CODE_OK) {
-            String response = http.getString();
-            Serial.println("Server response: " + response);
-
-            DynamicJsonDocument respDoc(1024);
-            DeserializationError error = deserializeJson(respDoc, response);
-
-            if (!error) {
-                bool dataChanged = false;
-
-                if (respDoc.containsKey("boardID")) {
-                    String newboardID = respDoc["boardID"].as<String>();
-                    if (newboardID.length() != 0 && deviceData.boardID != newboardID) {
-                        deviceData.boardID = newboardID;
-                        dataChanged = true;
-                        Serial.println("Updated boardID: " + deviceData.boardID);
-                    }
-                }
-
-                if (respDoc.containsKey("user")) {
-                    String newuser = respDoc["user"].as<String>();
-                    if (newuser.length() != 0 && deviceData.user != newuser) {
-                        deviceData.user = newuser;
-                        dataChanged = true;
-                        Serial.println("Updated user: " + deviceData.user);
-                    }
-                }
-
-                if (respDoc.containsKey("text")) {
-                    String newText = respDoc["text"].as<String>();
-                    if (newText.length() != 0 && deviceData.text != newText) {
-                        deviceData.text = newText;
-                        dataChanged = true;
-                        Serial.println("Updated text: " + deviceData.text);
-                    }
-                }
-
-                if (respDoc.containsKey("status")) {
-                    String newStatus = respDoc["status"].as<String>();
-                    if (newStatus.length() != 0 && deviceData.status != newStatus) {
-                        deviceData.status = newStatus;
-                        dataChanged = true;
-                        Serial.println("Updated status: " + deviceData.status);
-                    }
-                }
-
-                if (respDoc.containsKey("token")) {
-                    String newtoken = respDoc["token"].as<String>();
-                    if (newtoken.length() != 0 && deviceData.token != newtoken) {
-                        deviceData.token = newtoken;
-                        dataChanged = true;
-                        Serial.println("Updated token: " + deviceData.token);
-                    }
-                }
-
-                if (respDoc.containsKey("uptime")) {
-                    long newUptime = respDoc["uptime"].as<long>();
-                    if (newUptime > 0 && deviceData.uptime != newUptime) {
-                        deviceData.uptime = newUptime;
-                        dataChanged = true;
-                        Serial.println("Updated uptime: " + String(deviceData.uptime));
-                    }
-                }
-
-                if (respDoc.containsKey("serverUrl")) {
-                    String newserverUrl = respDoc["serverUrl"].as<String>();
-                    if (newserverUrl.length() != 0 && deviceData.serverUrl != newserverUrl) {
-                        deviceData.serverUrl = newserverUrl;
-                        SERVER_URL = newserverUrl;
-                        dataChanged = true;
-                        Serial.println("Updated server URL to: " + SERVER_URL);
-                    }
-                }
-
-                if (dataChanged) {
-                    saveDeviceData();
-                    Serial.println("Saved updated device data to flash");
-
-                    updateDisplay(
-                        "Text: " + deviceData.text,
-                        "Time: " + String(millis()),
-                        "Status: " + deviceData.status
-                    );
-                }
-
-                lastServerUpdate = millis();
-            }
-            else {
-                Serial.print("JSON parsing failed: ");
-                Serial.println(error.c_str());
-                updateDisplay("Server comm error", "Invalid response", "Will retry later");
-            }
-        }
-        else {
-            updateDisplay("Server error", "HTTP code: " + String(httpCode), "Will retry later");
-        }
-    }
-    else {
-        Serial.printf("HTTP request failed: %s\n", http.errorToString(httpCode).c_str());
-        updateDisplay("Server error", http.errorToString(httpCode).c_str(), "Will retry later");
-    }
-
-    http.end();
-}
-
-
-String getWiFiSignalStrength() {
-    if (WiFi.status() != WL_CONNECTED) {
-        return "Not connected";
-    }
-
-    int rssi = WiFi.RSSI();
-    String bars = "";
-
-    if (rssi > -55) bars = "●●●●";
-    else if (rssi > -65) bars = "●●●○";
-    else if (rssi > -75) bars = "●●○○";
-    else if (rssi > -85) bars = "●○○○";
-    else bars = "○○○○";
-
-    return bars + " " + String(rssi) + " dBm";
-}
-
-String getMacAddress() {
-    byte mac[6];
-    WiFi.macAddress(mac);
-    char macStr[18] = { 0 };
-    sprintf(macStr, "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-    return String(macStr);
-}
-
-void loadDeviceData() {
-    if (!LittleFS.exists("/device.json")) {
-        Serial.println("No device data found");
-        return;
-    }
-
-    File file = LittleFS.open("/device.json", "r");
-    if (!file) {
-        Serial.println("Failed to open device data file");
-        return;
-    }
-
-    size_t size = file.size();
-    std::unique_ptr<char[]> buf(new char[size]);
-    file.readBytes(buf.get(), size);
-    file.close();
-
-    DynamicJsonDocument doc(1024);
-    DeserializationError error = deserializeJson(doc, buf.get());
-
-    if (error) {
-        Serial.print("JSON parsing failed: ");
-        Serial.println(error.c_str());
-        return;
-    }
-
-    deviceData.boardID = doc["boardID"].as<String>();
-    deviceData.token = doc["token"].as<String>();
-    deviceData.timer = doc["timer"];
-    deviceData.uptime = doc["uptime"];
-    deviceData.text = doc["text"].as<String>();
-    deviceData.status = doc["status"].as<String>();
-    deviceData.user = doc["user"].as<String>();
-
-    if (doc.containsKey("serverUrl")) {
-        deviceData.serverUrl = doc["serverUrl"].as<String>();
-    }
-
-    Serial.println("Device data loaded:");
-    Serial.println("- Board ID: " + deviceData.boardID);
-    Serial.println("- Uptime: " + String(deviceData.uptime));
-    Serial.println("- Text: " + deviceData.text);
-    Serial.println("- Status: " + deviceData.status);
-    Serial.println("- Server URL: " + deviceData.serverUrl);
-}
-
-void saveDeviceData() {
-    DynamicJsonDocument doc(1024);
-
-    doc["boardID"] = deviceData.boardID;
-    doc["token"] = deviceData.token;
-    doc["timer"] = deviceData.timer;
-    doc["uptime"] = deviceData.uptime;
-    doc["text"] = deviceData.text;
-    doc["status"] = deviceData.status;
-    doc["user"] = deviceData.user;
-    doc["serverUrl"] = deviceData.serverUrl;
-
-    File file = LittleFS.open("/device.json", "w");
-    if (!file) {
-        Serial.println("Failed to open device data file for writing");
-        return;
-    }
-
-    if (serializeJson(doc, file) == 0) {
-        Serial.println("Failed to write to device data file");
-    }
-    else {
-        Serial.println("Device data saved");
-    }
-
-    file.close();
-}
-
-void loadWiFiCredentials() {
-    if (!LittleFS.exists("/wifi.json")) {
-        Serial.println("No WiFi credentials found");
-        wifiCreds.ssid = "";
-        wifiCreds.password = "";
-        wifiCreds.connected = false;
-        return;
-    }
-
-    File file = LittleFS.open("/wifi.json", "r");
-    if (!file) {
-        Serial.println("Failed to open WiFi credentials file");
-        return;
-    }
-
-    size_t size = file.size();
-    std::unique_ptr<char[]> buf(new char[size]);
-    file.readBytes(buf.get(), size);
-    file.close();
-
-    DynamicJsonDocument doc(512);
-    DeserializationError error = deserializeJson(doc, buf.get());
-
-    if (error) {
-        Serial.print("JSON parsing failed: ");
-        Serial.println(error.c_str());
-        return;
-    }
-
-    wifiCreds.ssid = doc["ssid"].as<String>();
-    wifiCreds.password = doc["password"].as<String>();
-
-    if (doc.containsKey("connected")) {
-        wifiCreds.connected = doc["connected"].as<bool>();
-    }
-    else {
-        wifiCreds.connected = false;
-    }
-
-    Serial.println("WiFi credentials loaded: " + wifiCreds.ssid);
-    Serial.println("Connection status: " + String(wifiCreds.connected ? "Connected" : "Not connected"));
-}
-
-void saveWiFiCredentials(String ssid, String password) {
-    DynamicJsonDocument doc(512);
-
-    doc["ssid"] = ssid;
-    doc["password"] = password;
-    doc["connected"] = wifiCreds.connected;
-
-    File file = LittleFS.open("/wifi.json", "w");
-    if (!file) {
-        Serial.println("Failed to open WiFi credentials file for writing");
-        return;
-    }
-
-    if (serializeJson(doc, file) == 0) {
-        Serial.println("Failed to write to WiFi credentials file");
-    }
-    else {
-        Serial.println("WiFi credentials saved: " + ssid);
-    }
-
-    file.close();
-
-    wifiCreds.ssid = ssid;
-    wifiCreds.password = password;
-}
-
-void resetWiFiSettings() {
-    updateDisplay("WiFi Reset", "Removing WiFi settings", "Please wait...");
-
-    if (LittleFS.exists("/wifi.json")) {
-        LittleFS.remove("/wifi.json");
-        Serial.println("WiFi credentials removed");
-    }
-
-    wifiCreds.ssid = "";
-    wifiCreds.password = "";
-    wifiCreds.connected = false;
-
-    WiFi.disconnect(true);
-    delay(1000);
-
-    updateDisplay("WiFi Reset Complete", "Starting setup mode", "Please reconnect");
-    delay(2000);
-    startAPMode();
-}
-
-void formatFS() {
-    Serial.println("Formatting file system");
-    LittleFS.format();
-    if (!LittleFS.begin()) {
-        Serial.println("File system format failed");
-    }
-    else {
-        Serial.println("File system formatted");
-    }
+﻿#include <ESP8266WiFi.h>
+#include <ESP8266WebServer.h>
+#include <DNSServer.h>
+#include <WiFiClientSecure.h>
+#include <ArduinoJson.h>
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+#include <LittleFS.h>
+#include <Ticker.h>
+#include "portal_html.h"
+#include "protocol.h"
+
+#define DISPLAY_WIDTH 128
+#define DISPLAY_HEIGHT 32
+#define OLED_RESET -1
+#define SCREEN_ADDRESS 0x3C
+#define RESET_BUTTON_PIN 0
+#define BATTERY_PIN A0
+#define SDA 4
+#define SCL 5
+#define DISPLAY_PAGES (DISPLAY_HEIGHT / 8)
+#define DISPLAY_BUFFER_SIZE (DISPLAY_WIDTH * DISPLAY_PAGES)
+#define DISPLAY_I2C_CHUNK 31
+#define DISPLAY_MAX_CHARS 21
+#define JOURNAL_PATH "/journal.bin"
+#define JOURNAL_COMPACT_PATH "/journal.tmp"
+#define TELEMETRY_SPILL_PATH "/telemetry.bin"
+
+//#define LOOP_BENCHMARK
+
+String SERVER_URL = "https://letpass.ru/?init";
+// Пусто - тот же адрес, что SERVER_URL, по wss://; для проверки с tools/push_server.py: "ws://<ip>:8765/"
+String PUSH_URL = "";
+const char* DEFAULT_SSID = "ESP8266_Setup";
+const byte DNS_PORT = 53;
+const unsigned long WIFI_RECONNECT_POLL_INTERVAL = 1000;
+const int SERVER_UPDATE_DEFAULT = 600000;
+const int WIFI_CONNECTION_TIMEOUT = 20000;
+const unsigned long BENCHMARK_REPORT_INTERVAL = 30000;
+const unsigned long BUTTON_POLL_INTERVAL = 20;
+const unsigned long BUTTON_DEBOUNCE = 20;
+const unsigned long BUTTON_RESET_HOLD = 3000;
+const unsigned long BATTERY_CHECK_INTERVAL = 5000;
+const int BATTERY_OVERSAMPLE = 4;
+const float BATTERY_EMA_ALPHA = 0.25;
+const float BATTERY_LOW_VOLTAGE = 3.1;
+const float BATTERY_LOW_HYSTERESIS = 0.1;
+const uint8_t BATTERY_LOW_CONFIRM = 3;
+const unsigned long AP_SERVICE_INTERVAL = 5;
+const unsigned long WIFI_SCAN_INTERVAL = 10000;
+const unsigned long DISPLAY_REFRESH_INTERVAL = 1000;
+const unsigned long DEVICE_SAVE_INTERVAL = 3600000;
+const unsigned long DISPLAY_CHECK_INTERVAL = 60000;
+const unsigned long SCHEDULER_MAX_IDLE = 50;
+const unsigned long POWER_SAVE_MAX_IDLE = 250;
+const unsigned long POWER_SAVE_BUTTON_POLL = 100;
+const unsigned long POWER_SLEEP_GRACE = 1000;
+const unsigned long POWER_MIN_SLEEP = 10000;
+const unsigned long POWER_MAX_AWAKE = 60000;
+const uint8_t POWER_LISTEN_INTERVAL = 3;
+const unsigned long WIFI_CONNECT_POLL_INTERVAL = 100;
+const unsigned long WIFI_DISCONNECT_SETTLE = 200;
+const unsigned long WIFI_FAST_CONNECT_TIMEOUT = 5000;
+const unsigned long WIFI_PORTAL_BUSY_RETRY = 60000;
+const int MAX_TASKS = 24;
+const int TEXT_LAYOUT_CACHE_SIZE = 8;
+const int MAX_SCAN_RESULTS = 24;
+const size_t SCAN_CHUNK_SIZE = 256;
+const bool METRICS_ENABLED = true;
+const uint16_t METRICS_PORT = 9100;
+const unsigned long METRICS_POLL_INTERVAL = 50;
+const size_t METRICS_CHUNK_SIZE = 512;
+const size_t METRICS_LINE_SIZE = 160;
+const uint16_t JOURNAL_MAGIC = 0x4A52;
+const size_t JOURNAL_MAX_SIZE = 8192;
+const size_t JOURNAL_MAX_RECORD = 1024;
+const uint8_t RECORD_FORMAT_VERSION = 3;
+const bool DELTA_TELEMETRY_ENABLED = true;
+const size_t REQUEST_DOC_SIZE = 768;
+const size_t REQUEST_PAYLOAD_SIZE = 2944;
+const size_t RESPONSE_DOC_SIZE = 1024;
+const size_t RESPONSE_BODY_MAX = 1024;
+// Поля ответа сервера, которые устройство читает; остальные не занимают буфер
+const char* const RESPONSE_FIELDS[] = { "boardID", "user", "text", "status", "token", "uptime", "serverUrl", "resync", "rev" };
+const int HTTP_CODE_OK = 200;
+const int HTTP_CODE_NOT_MODIFIED = 304;
+const unsigned long HTTP_POLL_INTERVAL = 5;
+const unsigned long HTTP_DNS_TIMEOUT = 5000;
+const unsigned long HTTP_CONNECT_TIMEOUT = 5000;
+const unsigned long HTTP_TLS_TIMEOUT = 10000;
+const unsigned long HTTP_SEND_TIMEOUT = 5000;
+const unsigned long HTTP_FIRST_BYTE_TIMEOUT = 10000;
+const unsigned long HTTP_BODY_TIMEOUT = 5000;
+const size_t HTTP_LINE_MAX = 128;
+const size_t HTTP_KEY_MAX = 16;
+const size_t HTTP_IO_CHUNK = 256;
+const bool PUSH_ENABLED = false;
+const unsigned long PUSH_POLL_INTERVAL = 50;
+const unsigned long PUSH_PING_INTERVAL = 30000;
+const unsigned long PUSH_IDLE_TIMEOUT = 75000;
+const size_t PUSH_MESSAGE_MAX = 512;
+const size_t PUSH_SEND_MAX = 256;
+const uint16_t PUSH_TLS_BUFFER = 1024;
+const bool TELEMETRY_QUEUE_ENABLED = true;
+const int TELEMETRY_RAM_SAMPLES = 16;
+const size_t TELEMETRY_SPILL_MAX_BYTES = 16384;
+const unsigned long TELEMETRY_DRAIN_INTERVAL = 1000;
+const bool TELEMETRY_BATCH_ENABLED = false;
+const int TELEMETRY_BATCH_SIZE = 8;
+const unsigned long TELEMETRY_BATCH_WINDOW = 300000;
+const size_t BATCH_DOC_SIZE = 2048;
+const int LATENCY_BUCKETS = 16;
+const size_t BOARD_ID_MAX = 32;
+const size_t TOKEN_MAX = 64;
+const size_t TEXT_MAX = 64;
+const size_t STATUS_MAX = 32;
+const size_t USER_MAX = 32;
+const size_t SERVER_URL_MAX = 128;
+const size_t SSID_MAX = 32;
+const size_t PASSWORD_MAX = 64;
+const size_t DISPLAY_LINE_MAX = 64;
+const size_t STATE_TAG_MAX = 48;
+const size_t HTTP_HEAD_MAX = HTTP_HOST_MAX + HTTP_PATH_MAX + STATE_TAG_MAX + 180;
+// Полная синхронизация в худшем случае: каждый символ строк, пришедших от сервера, экранирован
+// как \u00XX; остальное (ключи, числа, mac, приветствие) укладывается в REQUEST_FIXED_MAX
+const size_t REQUEST_STRINGS_MAX = BOARD_ID_MAX + TOKEN_MAX + STATE_TAG_MAX + USER_MAX + TEXT_MAX + STATUS_MAX + SERVER_URL_MAX;
+const size_t REQUEST_FIXED_MAX = 256;
+static_assert(REQUEST_PAYLOAD_SIZE >= REQUEST_STRINGS_MAX * 6 + REQUEST_FIXED_MAX, "full sync must fit REQUEST_PAYLOAD_SIZE");
+
+IPAddress apIP(192, 168, 4, 1);
+
+Adafruit_SSD1306 display(DISPLAY_WIDTH, DISPLAY_HEIGHT, &Wire, OLED_RESET);
+ESP8266WebServer webServer(80);
+ESP8266WebServer metricsServer(METRICS_PORT);
+DNSServer dnsServer;
+Ticker wifiTicker;
+WiFiClientSecure serverClient;
+WiFiClientSecure pushSecureClient;
+WiFiClient pushPlainClient;
+BearSSL::Session serverSession;
+
+// Строка фиксированной ёмкости без кучи: лишнее обрезается, assign() тогда вернёт false
+template <size_t N>
+struct FixedString {
+    char data[N + 1];
+    uint16_t len;
+
+    FixedString() : len(0) {
+        data[0] = '\0';
+    }
+
+    size_t length() const {
+        return len;
+    }
+
+    const char* c_str() const {
+        return data;
+    }
+
+    bool assign(const char* value, size_t length) {
+        bool fits = length <= N;
+        if (!fits) length = N;
+
+        memmove(data, value, length);
+        data[length] = '\0';
+        len = length;
+        return fits;
+    }
+
+    bool assign(const char* value) {
+        if (value == nullptr) return assign("", 0);
+        return assign(value, strlen(value));
+    }
+
+    bool append(const char* value) {
+        size_t extra = strlen(value);
+        bool fits = len + extra <= N;
+        if (!fits) extra = N - len;
+
+        memcpy(data + len, value, extra);
+        len += extra;
+        data[len] = '\0';
+        return fits;
+    }
+
+    FixedString& operator=(const char* value) {
+        assign(value);
+        return *this;
+    }
+
+    FixedString& operator=(const String& value) {
+        assign(value.c_str(), value.length());
+        return *this;
+    }
+
+    bool operator==(const char* other) const {
+        return other != nullptr && strcmp(data, other) == 0;
+    }
+
+    bool operator!=(const char* other) const {
+        return !(*this == other);
+    }
+
+    bool operator==(const FixedString& other) const {
+        return len == other.len && memcmp(data, other.data, len) == 0;
+    }
+
+    bool operator!=(const FixedString& other) const {
+        return !(*this == other);
+    }
+};
+
+struct DeviceData {
+    FixedString<BOARD_ID_MAX> boardID;
+    FixedString<TOKEN_MAX> token;
+    unsigned long timer;
+    unsigned long uptime;
+    FixedString<TEXT_MAX> text;
+    FixedString<STATUS_MAX> status;
+    FixedString<USER_MAX> user;
+    FixedString<SERVER_URL_MAX> serverUrl;
+};
+
+struct WiFiCredentials {
+    FixedString<SSID_MAX> ssid;
+    FixedString<PASSWORD_MAX> password;
+    bool connected;
+    // Подсказки для быстрого подключения: только точка доступа и канал, адрес всегда по DHCP
+    bool hintsValid;
+    uint8_t bssid[6];
+    int32_t channel;
+};
+
+enum WiFiConnectState {
+    CONNECT_STATE_IDLE,
+    CONNECT_STATE_DISCONNECTING,
+    CONNECT_STATE_CONNECTING,
+    CONNECT_STATE_CONNECTED,
+    CONNECT_STATE_FAILED
+};
+
+enum WiFiConnectEvent {
+    CONNECT_EVENT_STARTED,
+    CONNECT_EVENT_PROGRESS,
+    CONNECT_EVENT_CONNECTED,
+    CONNECT_EVENT_FAILED
+};
+
+enum WiFiConnectPurpose {
+    CONNECT_PURPOSE_BOOT,
+    CONNECT_PURPOSE_RECONNECT
+};
+
+struct WiFiConnectMetrics {
+    uint32_t attempts;
+    uint32_t successes;
+    uint32_t failures;
+    unsigned long lastDuration;
+    unsigned long minDuration;
+    unsigned long maxDuration;
+    unsigned long totalDuration;
+    uint32_t fastAttempts;
+    uint32_t fastSuccesses;
+    uint32_t fastFallbacks;
+};
+
+enum PowerProfile {
+    POWER_PROFILE_ALWAYS_ON,
+    POWER_PROFILE_MODEM_SLEEP,
+    POWER_PROFILE_LIGHT_SLEEP,
+    POWER_PROFILE_DEEP_SLEEP
+};
+
+// Глубокий сон требует перемычки GPIO16 -> RST. POWER_PROFILE_SETTING можно задать при сборке (tools/power_sim.cpp)
+#ifndef POWER_PROFILE_SETTING
+#define POWER_PROFILE_SETTING POWER_PROFILE_MODEM_SLEEP
+#endif
+const PowerProfile POWER_PROFILE = POWER_PROFILE_SETTING;
+const uint32_t RTC_STATE_MAGIC = 0x52544334;
+const uint8_t RTC_FLAG_ACKED = 0x01;
+const uint8_t RTC_FLAG_HINTS = 0x02;
+
+struct RtcState {
+    uint32_t magic;
+    uint32_t crc;
+    uint32_t uptime;
+    uint32_t timer;
+    uint32_t sequence;
+    uint8_t flags;
+    uint8_t bssid[6];
+    uint8_t reserved;
+    int32_t channel;
+    // Неудачи подряд переживают сон, иначе пауза повторов не росла бы от пробуждения к пробуждению
+    uint8_t wifiFailures;
+    uint8_t serverFailures;
+    uint8_t padding[2];
+    char boardID[BOARD_ID_MAX + 1];
+    char token[TOKEN_MAX + 1];
+    char text[TEXT_MAX + 1];
+    char status[STATUS_MAX + 1];
+    char user[USER_MAX + 1];
+    char serverUrl[SERVER_URL_MAX + 1];
+    char ssid[SSID_MAX + 1];
+    char password[PASSWORD_MAX + 1];
+};
+
+static_assert(sizeof(RtcState) <= 512, "RTC user memory is 512 bytes");
+
+typedef void (*TaskCallback)();
+
+struct Task {
+    const char* name;
+    TaskCallback callback;
+    unsigned long interval;
+    unsigned long nextRun;
+    bool enabled;
+    uint32_t runs;
+    uint32_t maxLateness;
+    uint32_t maxDuration;
+};
+
+struct ServerConnectionStats {
+    uint32_t requests;
+    uint32_t fullHandshakes;
+    uint32_t sessionOffers;
+    uint32_t reusedConnections;
+    uint32_t droppedConnections;
+    uint32_t failedConnections;
+    uint32_t fullUpdates;
+    uint32_t deltaUpdates;
+    uint32_t payloadBytes;
+    uint32_t unchangedResponses;
+};
+
+struct TelemetrySample {
+    uint32_t time;
+    uint32_t timer;
+    uint16_t batteryMv;
+    int8_t rssi;
+    uint8_t flags;
+    char status[24];
+};
+
+// Замер в пакете в худшем случае: ключи, числа и status, каждый символ которого экранирован
+const size_t BATCH_SAMPLE_MAX = 96 + (sizeof(TelemetrySample::status) - 1) * 6;
+static_assert(REQUEST_PAYLOAD_SIZE >= REQUEST_STRINGS_MAX * 6 + REQUEST_FIXED_MAX + BATCH_SAMPLE_MAX,
+    "a full sync batch must fit at least one sample");
+
+enum ServerRequestKind {
+    SERVER_REQUEST_UPDATE,
+    SERVER_REQUEST_HELLO,
+    SERVER_REQUEST_QUEUED,
+    SERVER_REQUEST_BATCH
+};
+
+enum HttpPhase {
+    HTTP_PHASE_IDLE,
+    HTTP_PHASE_DNS,
+    HTTP_PHASE_CONNECT,
+    HTTP_PHASE_SEND,
+    HTTP_PHASE_FIRST_BYTE,
+    HTTP_PHASE_HEADERS,
+    HTTP_PHASE_BODY,
+    HTTP_PHASES
+};
+
+const char* const HTTP_PHASE_NAMES[HTTP_PHASES] = { "idle", "dns", "connect", "send", "first_byte", "headers", "body" };
+
+enum HttpBodyMode {
+    HTTP_BODY_LENGTH,
+    HTTP_BODY_CHUNK_SIZE,
+    HTTP_BODY_CHUNK_DATA,
+    HTTP_BODY_CHUNK_END,
+    HTTP_BODY_CHUNK_TRAILER,
+    HTTP_BODY_UNTIL_CLOSE
+};
+
+enum HttpError {
+    HTTP_ERROR_TIMEOUT = -1,
+    HTTP_ERROR_CONNECTION_LOST = -2,
+    HTTP_ERROR_DNS = -3,
+    HTTP_ERROR_CONNECT = -4,
+    HTTP_ERROR_BAD_RESPONSE = -5,
+    HTTP_ERROR_NO_WIFI = -6
+};
+
+// Потоковый разбор тела ответа: из объекта верхнего уровня остаются только поля
+// RESPONSE_FIELDS, прочие значения (любой длины и вложенности) пропускаются
+struct ResponseScanner {
+    uint8_t depth;
+    bool started;
+    bool invalid;
+    bool inString;
+    bool escaped;
+    bool expectKey;
+    bool readingKey;
+    bool keeping;
+    char key[HTTP_KEY_MAX + 1];
+    size_t keyLength;
+    int members;
+};
+
+// Запрос к серверу продвигается по одному шагу за вызов задачи serverRequest
+struct ServerRequest {
+    HttpPhase phase;
+    ServerRequestKind kind;
+    unsigned long startMicros;
+    unsigned long phaseStart;
+    bool reused;
+    bool retried;
+    char host[HTTP_HOST_MAX + 1];
+    char path[HTTP_PATH_MAX + 1];
+    uint16_t port;
+    // Заголовки и тело запроса; тело сериализуется сразу сюда, в requestPayloadBuffer()
+    char out[HTTP_HEAD_MAX + REQUEST_PAYLOAD_SIZE];
+    size_t outLength;
+    size_t outSent;
+    int status;
+    FixedString<STATE_TAG_MAX> etag;
+    bool keepAlive;
+    HttpBodyMode bodyMode;
+    uint32_t remaining;
+    char line[HTTP_LINE_MAX + 1];
+    size_t lineLength;
+    // Только нужные поля ответа верхнего уровня, остальное пропускается при чтении
+    char body[RESPONSE_BODY_MAX + 1];
+    size_t bodyLength;
+    bool bodyOverflow;
+    ResponseScanner scanner;
+    TelemetrySample sample;
+    int batchCount;
+};
+
+enum PushState {
+    PUSH_IDLE,
+    PUSH_PROBING,
+    PUSH_CONNECTING,
+    PUSH_HANDSHAKE,
+    PUSH_OPEN
+};
+
+enum WebSocketOpcode {
+    WS_OPCODE_CONTINUATION = 0x0,
+    WS_OPCODE_TEXT = 0x1,
+    WS_OPCODE_BINARY = 0x2,
+    WS_OPCODE_CLOSE = 0x8,
+    WS_OPCODE_PING = 0x9,
+    WS_OPCODE_PONG = 0xA
+};
+
+// WebSocket-канал, по которому сервер сразу присылает изменения DeviceData
+struct PushChannel {
+    PushState state;
+    bool secure;
+    char host[HTTP_HOST_MAX + 1];
+    char path[HTTP_PATH_MAX + 1];
+    uint16_t port;
+    WiFiClient* client;
+    // Сервер, у которого уже подтверждена поддержка MFLN; пусто - проверить перед подключением
+    FixedString<HTTP_HOST_MAX> mflnHost;
+    unsigned long stateSince;
+    unsigned long lastReceive;
+    unsigned long lastPing;
+    int status;
+    char line[HTTP_LINE_MAX + 1];
+    size_t lineLength;
+    uint8_t header[14];
+    uint8_t headerLength;
+    bool inPayload;
+    bool final;
+    bool masked;
+    uint8_t opcode;
+    uint8_t mask[4];
+    uint32_t remaining;
+    uint32_t payloadOffset;
+    uint8_t control[125];
+    size_t controlLength;
+    uint8_t messageOpcode;
+    char message[PUSH_MESSAGE_MAX];
+    size_t messageLength;
+    bool messageOverflow;
+    uint32_t connects;
+    uint32_t drops;
+    uint32_t messages;
+};
+
+struct TelemetryQueueStats {
+    uint32_t queued;
+    uint32_t spilled;
+    uint32_t drained;
+    uint32_t dropped;
+    uint32_t batches;
+    uint32_t batchedSamples;
+};
+
+enum JournalRecordType {
+    JOURNAL_DEVICE_DATA = 1,
+    JOURNAL_WIFI_CREDENTIALS = 2,
+    JOURNAL_RECORD_TYPES
+};
+
+struct JournalHeader {
+    uint16_t magic;
+    uint8_t type;
+    uint8_t flags;
+    uint16_t length;
+    uint16_t reserved;
+    uint32_t sequence;
+    uint32_t crc;
+};
+
+struct JournalStats {
+    uint32_t appends;
+    uint32_t skippedWrites;
+    uint32_t compactions;
+    uint32_t bytesWritten;
+    uint32_t recordsRead;
+    uint32_t corruptRecords;
+};
+
+struct ScanResult {
+    char ssid[33];
+    int32_t rssi;
+};
+
+struct BatteryMonitor {
+    float voltage;
+    uint8_t percent;
+    bool valid;
+    bool low;
+    uint8_t lowCount;
+    uint32_t adcReads;
+    uint32_t lowEvents;
+};
+
+// Заполняется из прерывания по фронтам кнопки, задача button только выполняет сброс
+struct ResetButton {
+    volatile bool pressed;
+    volatile unsigned long pressStart;
+    volatile unsigned long lastPressLength;
+    volatile uint32_t presses;
+    volatile bool resetRequested;
+};
+
+struct TextLayout {
+    FixedString<DISPLAY_LINE_MAX> source;
+    FixedString<DISPLAY_MAX_CHARS> text;
+    int16_t x;
+    uint32_t lastUsed;
+    bool valid;
+};
+
+struct DisplayStats {
+    uint32_t framesRendered;
+    uint32_t framesSkipped;
+    uint32_t framesUnchanged;
+    uint32_t pagesPushed;
+    uint32_t bytesPushed;
+    uint32_t layoutHits;
+    uint32_t layoutMisses;
+};
+
+struct LatencyHistogram {
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t maxMicros;
+    uint64_t totalMicros;
+};
+
+struct HeapWatermark {
+    uint32_t minFree;
+    uint32_t minMaxBlock;
+    uint8_t maxFragmentation;
+    uint32_t samples;
+};
+
+struct MetricsWriter {
+    char chunk[METRICS_CHUNK_SIZE];
+    size_t used;
+};
+
+enum HeapSubsystem {
+    HEAP_SERVER,
+    HEAP_PORTAL,
+    HEAP_SCAN,
+    HEAP_STORAGE,
+    HEAP_SUBSYSTEMS
+};
+
+const char* const HEAP_SUBSYSTEM_NAMES[HEAP_SUBSYSTEMS] = { "server", "portal", "scan", "storage" };
+
+enum RetryPolicyId {
+    RETRY_WIFI,
+    RETRY_SERVER,
+    RETRY_PUSH,
+    RETRY_POLICIES
+};
+
+DeviceData deviceData;
+WiFiCredentials wifiCreds;
+unsigned long lastServerUpdate = 0;
+unsigned long displayHoldUntil = 0;
+bool isAccessPointMode = false;
+bool displayEnabled = true;
+FixedString<DISPLAY_LINE_MAX> lastDisplayLine1;
+FixedString<DISPLAY_LINE_MAX> lastDisplayLine2;
+FixedString<DISPLAY_LINE_MAX> lastDisplayLine3;
+int lastDisplayBars = -1;
+int lastDisplayBatteryFill = -1;
+uint8_t displayShadow[DISPLAY_BUFFER_SIZE];
+bool displayShadowValid = false;
+DisplayStats displayStats = {};
+TextLayout textLayoutCache[TEXT_LAYOUT_CACHE_SIZE];
+uint32_t textLayoutClock = 0;
+bool textLayoutCacheEnabled = true;
+LatencyHistogram displayFrameLatency = {};
+BatteryMonitor batteryMonitor = {};
+ResetButton resetButton = {};
+ScanResult scanResults[MAX_SCAN_RESULTS];
+int scanResultCount = 0;
+unsigned long scanResultsTime = 0;
+bool journalIndexed = false;
+bool journalNeedsCompaction = false;
+bool journalMigrationPending = false;
+size_t journalSize = 0;
+uint32_t journalSequence = 0;
+bool journalRecordLoaded[JOURNAL_RECORD_TYPES] = {};
+uint16_t journalRecordLength[JOURNAL_RECORD_TYPES] = {};
+uint32_t journalRecordCrc[JOURNAL_RECORD_TYPES] = {};
+// Запись журнала собирается здесь, даже если потом выяснится, что писать нечего
+uint8_t journalScratch[JOURNAL_MAX_RECORD];
+JournalStats journalStats = {};
+bool firstBoot = true;
+bool waitingForCredentialsVerification = false;
+String pendingRedirectUrl = "";
+unsigned long credentialsVerificationStartTime = 0;
+int connectionFailCount = 0;
+WiFiConnectState wifiConnectState = CONNECT_STATE_IDLE;
+WiFiConnectPurpose wifiConnectPurpose = CONNECT_PURPOSE_BOOT;
+unsigned long wifiConnectStateSince = 0;
+unsigned long wifiConnectAttemptStart = 0;
+unsigned long wifiConnectLastProgress = 0;
+bool wifiConnectFastPath = false;
+WiFiConnectMetrics wifiConnectMetrics = { 0, 0, 0, 0, ~0UL, 0, 0, 0, 0, 0 };
+bool serverClientInitialized = false;
+bool serverSessionCached = false;
+FixedString<SERVER_URL_MAX> serverConnectionUrl;
+ServerConnectionStats serverConnectionStats = {};
+DeviceData ackedDeviceData;
+bool deviceDataAcked = false;
+bool resyncRequested = true;
+uint32_t telemetrySequence = 0;
+ServerRequest serverRequest;
+FixedString<STATE_TAG_MAX> serverEtag;
+FixedString<STATE_TAG_MAX> serverRev;
+// Ответы сервера и push-сообщения разбираются по одному, документ общий и не в куче
+StaticJsonDocument<RESPONSE_DOC_SIZE> serverResponseDoc;
+PushChannel pushChannel = {};
+uint32_t httpPhaseTimeouts[HTTP_PHASES] = {};
+TelemetrySample telemetryRing[TELEMETRY_RAM_SAMPLES];
+int telemetryRingHead = 0;
+int telemetryRingCount = 0;
+int telemetrySpillPending = 0;
+uint32_t telemetrySpillReadOffset = 0;
+bool telemetrySpillOffsetDirty = false;
+size_t telemetrySpillSize = 0;
+TelemetryQueueStats telemetryStats = {};
+LatencyHistogram loopLatency = {};
+LatencyHistogram serverRequestLatency = {};
+HeapWatermark heapWatermark = { UINT32_MAX, UINT32_MAX, 0, 0 };
+HeapWatermark heapProbes[HEAP_SUBSYSTEMS] = {
+    { UINT32_MAX, UINT32_MAX, 0, 0 },
+    { UINT32_MAX, UINT32_MAX, 0, 0 },
+    { UINT32_MAX, UINT32_MAX, 0, 0 },
+    { UINT32_MAX, UINT32_MAX, 0, 0 }
+};
+unsigned long setupDuration = 0;
+unsigned long storageLoadDuration = 0;
+unsigned long firstPostTime = 0;
+unsigned long schedulerMaxIdle = SCHEDULER_MAX_IDLE;
+bool resumedFromDeepSleep = false;
+unsigned long powerAwakeStart = 0;
+RetryPolicy retryPolicies[RETRY_POLICIES] = {
+    RETRY_WIFI_POLICY,
+    RETRY_SERVER_POLICY,
+    RETRY_PUSH_POLICY
+};
+
+Task tasks[MAX_TASKS];
+int taskCount = 0;
+int buttonTaskId = -1;
+int batteryTaskId = -1;
+int apServiceTaskId = -1;
+int wifiScanTaskId = -1;
+int serverUpdateTaskId = -1;
+int displayTaskId = -1;
+int saveTaskId = -1;
+int reconnectTaskId = -1;
+int displayCheckTaskId = -1;
+int apStartTaskId = -1;
+int apBeginTaskId = -1;
+int resetFinishTaskId = -1;
+int pendingConnectTaskId = -1;
+int wifiConnectTaskId = -1;
+int telemetryDrainTaskId = -1;
+int powerSleepTaskId = -1;
+int metricsTaskId = -1;
+int wifiRetryTaskId = -1;
+int serverRequestTaskId = -1;
+int pushTaskId = -1;
+
+void setupDisplay();
+void updateDisplay(const String& line1, const String& line2, const String& line3 = "");
+void updateDisplay(const char* line1, const char* line2, const char* line3 = "");
+void handleRoot();
+void handleConnect();
+void handleSuccess();
+void handleRedirect();
+void handleScan();
+void handleNotFound();
+void startAPMode();
+void loadDeviceData();
+void saveDeviceData();
+void loadWiFiCredentials();
+void saveWiFiCredentials(const char* ssid, const char* password);
+bool loadLegacyRecord(uint8_t type, const char* path);
+bool decodeJsonRecord(uint8_t type, const uint8_t* data, size_t length);
+bool decodeBinaryRecord(uint8_t type, const uint8_t* data, size_t length);
+template <size_t N> bool readRecordString(const uint8_t*& p, const uint8_t* end, FixedString<N>& value);
+bool readRecordU32(const uint8_t*& p, const uint8_t* end, unsigned long& value);
+bool readRecordBytes(const uint8_t*& p, const uint8_t* end, uint8_t* value, size_t length);
+template <size_t N> void writeRecordString(uint8_t*& p, const FixedString<N>& value);
+void writeRecordU32(uint8_t*& p, uint32_t value);
+void indexJournal();
+bool buildJournalPayload(uint8_t type, uint8_t* payload, size_t& length);
+bool writeJournalRecord(File& file, uint8_t type, const uint8_t* payload, size_t length, uint32_t crc);
+bool appendJournalRecord(uint8_t type);
+bool compactJournal();
+uint32_t journalCrc32(const uint8_t* data, size_t length);
+void resetWiFiSettings();
+bool startWiFiConnection(WiFiConnectPurpose purpose);
+void retrySavedNetwork();
+void serviceWiFiConnection();
+void finishWiFiConnection(bool success);
+void cancelWiFiConnection();
+void beginWiFiAttempt(bool fastPath);
+void captureConnectionHints();
+void onWiFiConnectEvent(WiFiConnectEvent event);
+bool sendDataToServer(bool isHello = false);
+bool parseServerUrl(const char* url, ServerRequest& req);
+bool startServerRequest(ServerRequestKind kind, const char* payload, size_t length);
+bool serverRequestActive();
+char* requestPayloadBuffer();
+void setServerRequestPhase(HttpPhase phase);
+unsigned long httpPhaseTimeout(HttpPhase phase);
+void serviceServerRequest();
+bool readServerResponseLine();
+void readServerResponseHeaders();
+void readServerResponseBody();
+void resetResponseScanner(ResponseScanner& scanner);
+void scanServerResponse(const char* data, size_t length);
+void appendServerResponse(const char* data, size_t length);
+bool isResponseField(const char* key);
+void lostServerConnection();
+void finishServerRequest(int httpCode);
+void onServerResponse(ServerRequestKind kind, int httpCode, const char* body, size_t length);
+const char* httpErrorName(int httpCode);
+bool resolvePushUrl();
+void startPushChannel();
+void servicePushChannel();
+void openPushChannel();
+void closePushChannel();
+void dropPushChannel(const char* reason);
+bool readPushLine();
+void readPushFrames();
+size_t pushFrameHeaderSize();
+void handlePushFrame();
+bool sendPushFrame(uint8_t opcode, const uint8_t* data, size_t length);
+void onPushMessage(const char* message, size_t length);
+void encodeBase64(const uint8_t* in, size_t length, char* out);
+bool applyServerResponse(int httpCode, const char* body, size_t length);
+void applyServerFields(JsonDocument& respDoc);
+void acknowledgeServerUpdate();
+void storeServerRev(JsonVariant rev);
+template <size_t N> bool applyServerString(JsonDocument& doc, const char* key, FixedString<N>& field, bool displayField = false);
+void buildResponseFilter(JsonDocument& filter);
+void addDeviceFields(JsonDocument& doc, bool fullSync);
+void captureTelemetrySample(TelemetrySample& sample);
+int telemetryQueueLength();
+void enqueueTelemetrySample(const TelemetrySample& sample);
+void spillTelemetrySamples(int count);
+void indexTelemetrySpill();
+int peekTelemetrySamples(TelemetrySample* samples, int maxCount);
+void popTelemetrySamples(int count);
+void drainTelemetryQueue();
+void pauseTelemetryDrain();
+void stopTelemetryDrain();
+void saveTelemetrySpillOffset();
+bool sendQueuedSample(const TelemetrySample& sample);
+bool telemetryBatchDue();
+bool sendTelemetryBatch();
+String getWiFiSignalStrength();
+String getMacAddress();
+void formatFS();
+void centerText(const char* text, int y);
+const TextLayout& layoutText(const char* text);
+void benchmarkTextLayout();
+void flushDisplay();
+void exitAPMode();
+void checkCredentialsVerification();
+void recordLatency(LatencyHistogram& hist, uint32_t micros);
+uint32_t latencyPercentile(const LatencyHistogram& hist, uint8_t percentile);
+void sampleHeapWatermark();
+void recordHeapWatermark(HeapWatermark& mark);
+void probeHeap(HeapSubsystem subsystem);
+void addHeapSummary(JsonDocument& doc);
+void serviceMetrics();
+void metricsPrintf(MetricsWriter& writer, const char* format, ...) __attribute__((format(printf, 2, 3)));
+void writeMetricHeader(MetricsWriter& writer, const char* name, const char* type, const char* help);
+void writeMetric(MetricsWriter& writer, const char* name, const char* type, const char* help, uint32_t value);
+void writeSignedMetric(MetricsWriter& writer, const char* name, const char* type, const char* help, int32_t value);
+void writeHistogram(MetricsWriter& writer, const char* name, const char* help, const LatencyHistogram& hist);
+void handleMetrics();
+void writeRetryMetric(MetricsWriter& writer, const char* name, const char* type, const char* help, const uint32_t* values);
+void reportBenchmark();
+int addTask(const char* name, TaskCallback callback, unsigned long interval, bool enabled = true);
+void scheduleTask(int id, unsigned long delayMs);
+void stopTask(int id);
+void setTaskInterval(int id, unsigned long interval);
+unsigned long runScheduler();
+void setupTasks();
+void holdDisplay(unsigned long duration);
+void onResetButtonChange();
+void pollResetButton();
+void checkBattery();
+void sampleBattery();
+void serviceAccessPoint();
+void startWiFiScan();
+void onScanComplete(int networksFound);
+size_t escapeJsonString(const char* in, char* out, size_t outSize);
+void runServerUpdate();
+void refreshStatusDisplay();
+void periodicSave();
+void reconnectWiFi();
+void checkDisplay();
+void beginAPMode();
+void finishWiFiReset();
+void beginPendingConnection();
+void applyPowerProfile();
+const char* powerProfileName();
+bool saveRtcState();
+bool restoreRtcState();
+void enterDeepSleep();
+bool retryReady(RetryPolicyId id);
+unsigned long retryFailed(RetryPolicyId id);
+void retrySucceeded(RetryPolicyId id);
+void retryDefer(RetryPolicyId id);
+void retryTrip(RetryPolicyId id);
+unsigned long retryWait(RetryPolicyId id);
+unsigned long retryJitter(unsigned long low, unsigned long high);
+void stopAccessPoint();
+
+void setup() {
+    unsigned long setupStart = millis();
+    Serial.begin(115200);
+    Serial.println("\nStarting up...");
+
+    pinMode(RESET_BUTTON_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(RESET_BUTTON_PIN), onResetButtonChange, CHANGE);
+    setupTasks();
+    sampleBattery();
+    WiFi.persistent(false);
+    applyPowerProfile();
+
+    ESP.getFreeHeap();
+
+    if (!LittleFS.begin()) {
+        Serial.println("LittleFS mount failed. Formatting...");
+        formatFS();
+    }
+
+    setupDisplay();
+    if (displayEnabled) {
+        updateDisplay("Starting up...", "Please wait...");
+    }
+    else {
+        Serial.println("WARNING: Display initialization failed!");
+    }
+
+    resumedFromDeepSleep = POWER_PROFILE == POWER_PROFILE_DEEP_SLEEP && restoreRtcState();
+    if (resumedFromDeepSleep) {
+        Serial.println("Woke from deep sleep, state restored from RTC memory");
+        scheduleTask(powerSleepTaskId, POWER_MAX_AWAKE);
+    }
+    else {
+        loadDeviceData();
+        loadWiFiCredentials();
+
+        if (journalMigrationPending || journalNeedsCompaction) {
+            compactJournal();
+        }
+    }
+    indexTelemetrySpill();
+    storageLoadDuration = millis() - setupStart;
+
+    if (METRICS_ENABLED) {
+        metricsServer.on("/metrics", handleMetrics);
+        metricsServer.begin();
+        scheduleTask(metricsTaskId, METRICS_POLL_INTERVAL);
+    }
+
+    if (deviceData.boardID.length() == 0) {
+        deviceData.boardID = "ESP8266_" + String(ESP.getChipId(), HEX);
+        deviceData.token = deviceData.boardID.c_str();
+        deviceData.token.append("_token");
+        deviceData.timer = 0;
+        deviceData.uptime = SERVER_UPDATE_DEFAULT;
+        deviceData.text = "Welcome!";
+        deviceData.status = "New device";
+        deviceData.user = "";
+        deviceData.serverUrl = SERVER_URL;
+        saveDeviceData();
+        Serial.printf("Created new device data with ID: %s\n", deviceData.boardID.c_str());
+    }
+    else {
+        if (deviceData.serverUrl.length() > 0) {
+            SERVER_URL = deviceData.serverUrl.c_str();
+            Serial.println("Using saved server URL: " + SERVER_URL);
+        }
+    }
+
+    if (wifiCreds.ssid.length() > 0) {
+        updateDisplay("Connecting to WiFi", wifiCreds.ssid.c_str());
+        startWiFiConnection(CONNECT_PURPOSE_BOOT);
+    }
+    else {
+        startAPMode();
+    }
+
+    Serial.println("Setup complete");
+    Serial.printf("Free heap: %d bytes\n", ESP.getFreeHeap());
+    Serial.printf("Device ID: %s\n", deviceData.boardID.c_str());
+    Serial.println("Server URL: " + SERVER_URL);
+    Serial.printf("WiFi SSID: %s\n", wifiCreds.ssid.c_str());
+    Serial.println("WiFi connected: " + String(wifiCreds.connected ? "Yes" : "No"));
+
+    setupDuration = millis() - setupStart;
+
+#ifdef LOOP_BENCHMARK
+    if (displayEnabled) {
+        benchmarkTextLayout();
+    }
+#endif
+}
+
+void loop() {
+    unsigned long loopStart = micros();
+
+    unsigned long idle = runScheduler();
+    recordLatency(loopLatency, micros() - loopStart);
+
+#ifdef LOOP_BENCHMARK
+    sampleHeapWatermark();
+
+    static unsigned long lastBenchmarkReport = 0;
+    if (millis() - lastBenchmarkReport >= BENCHMARK_REPORT_INTERVAL) {
+        lastBenchmarkReport = millis();
+        reportBenchmark();
+    }
+#endif
+
+    delay(idle);
+}
+
+void setupTasks() {
+    buttonTaskId = addTask("button", pollResetButton, BUTTON_POLL_INTERVAL);
+    batteryTaskId = addTask("battery", checkBattery, BATTERY_CHECK_INTERVAL);
+    apServiceTaskId = addTask("apService", serviceAccessPoint, AP_SERVICE_INTERVAL, false);
+    wifiScanTaskId = addTask("wifiScan", startWiFiScan, WIFI_SCAN_INTERVAL, false);
+    serverUpdateTaskId = addTask("serverUpdate", runServerUpdate, SERVER_UPDATE_DEFAULT);
+    displayTaskId = addTask("display", refreshStatusDisplay, DISPLAY_REFRESH_INTERVAL);
+    saveTaskId = addTask("save", periodicSave, DEVICE_SAVE_INTERVAL);
+    reconnectTaskId = addTask("reconnect", reconnectWiFi, WIFI_RECONNECT_POLL_INTERVAL);
+    displayCheckTaskId = addTask("displayCheck", checkDisplay, DISPLAY_CHECK_INTERVAL);
+    apStartTaskId = addTask("apStart", startAPMode, 0, false);
+    apBeginTaskId = addTask("apBegin", beginAPMode, 0, false);
+    resetFinishTaskId = addTask("resetFinish", finishWiFiReset, 0, false);
+    pendingConnectTaskId = addTask("pendingConnect", beginPendingConnection, 0, false);
+    wifiConnectTaskId = addTask("wifiConnect", serviceWiFiConnection, WIFI_CONNECT_POLL_INTERVAL, false);
+    telemetryDrainTaskId = addTask("telemetryDrain", drainTelemetryQueue, TELEMETRY_DRAIN_INTERVAL, false);
+    powerSleepTaskId = addTask("powerSleep", enterDeepSleep, 0, false);
+    metricsTaskId = addTask("metrics", serviceMetrics, METRICS_POLL_INTERVAL, false);
+    wifiRetryTaskId = addTask("wifiRetry", retrySavedNetwork, 0, false);
+    serverRequestTaskId = addTask("serverRequest", serviceServerRequest, HTTP_POLL_INTERVAL, false);
+    pushTaskId = addTask("push", servicePushChannel, PUSH_POLL_INTERVAL, false);
+}
+
+int addTask(const char* name, TaskCallback callback, unsigned long interval, bool enabled) {
+    if (taskCount >= MAX_TASKS) {
+        Serial.printf("Task table full, cannot add %s\n", name);
+        return -1;
+    }
+
+    Task& task = tasks[taskCount];
+    task.name = name;
+    task.callback = callback;
+    task.interval = interval;
+    task.nextRun = millis() + interval;
+    task.enabled = enabled;
+    task.runs = 0;
+    task.maxLateness = 0;
+    task.maxDuration = 0;
+
+    return taskCount++;
+}
+
+void scheduleTask(int id, unsigned long delayMs) {
+    if (id < 0 || id >= taskCount) return;
+
+    tasks[id].nextRun = millis() + delayMs;
+    tasks[id].enabled = true;
+}
+
+void stopTask(int id) {
+    if (id < 0 || id >= taskCount) return;
+
+    tasks[id].enabled = false;
+}
+
+void setTaskInterval(int id, unsigned long interval) {
+    if (id < 0 || id >= taskCount) return;
+
+    tasks[id].interval = interval;
+}
+
+unsigned long runScheduler() {
+    for (int i = 0; i < taskCount; i++) {
+        Task& task = tasks[i];
+        unsigned long now = millis();
+
+        if (!task.enabled || (long)(now - task.nextRun) < 0) continue;
+
+        uint32_t lateness = now - task.nextRun;
+        if (task.interval == 0) {
+            task.enabled = false;
+        }
+        else {
+            task.nextRun += task.interval;
+            if ((long)(now - task.nextRun) >= 0) {
+                task.nextRun = now + task.interval;
+            }
+        }
+
+        unsigned long runStart = micros();
+        task.callback();
+        uint32_t duration = micros() - runStart;
+
+        task.runs++;
+        if (lateness > task.maxLateness) task.maxLateness = lateness;
+        if (duration > task.maxDuration) task.maxDuration = duration;
+    }
+
+    unsigned long now = millis();
+    unsigned long idle = schedulerMaxIdle;
+    for (int i = 0; i < taskCount; i++) {
+        if (!tasks[i].enabled) continue;
+
+        long remaining = (long)(tasks[i].nextRun - now);
+        if (remaining <= 0) return 0;
+        if ((unsigned long)remaining < idle) idle = remaining;
+    }
+    return idle;
+}
+
+void holdDisplay(unsigned long duration) {
+    displayHoldUntil = millis() + duration;
+}
+
+// Длительность нажатия меряется по фронтам в прерывании: блокирующие DNS и рукопожатие TLS
+// откладывают только сам сброс, но не искажают удержание и не теряют короткие нажатия
+IRAM_ATTR void onResetButtonChange() {
+    unsigned long now = millis();
+    if (digitalRead(RESET_BUTTON_PIN) == LOW) {
+        if (!resetButton.pressed) {
+            resetButton.pressed = true;
+            resetButton.pressStart = now;
+        }
+    }
+    else if (resetButton.pressed) {
+        resetButton.pressed = false;
+        unsigned long length = now - resetButton.pressStart;
+        // Короче BUTTON_DEBOUNCE - дребезг контактов, а не нажатие
+        if (length < BUTTON_DEBOUNCE) return;
+        resetButton.lastPressLength = length;
+        resetButton.presses++;
+        if (length > BUTTON_RESET_HOLD) {
+            resetButton.resetRequested = true;
+        }
+    }
+}
+
+void pollResetButton() {
+    if (!resetButton.resetRequested) return;
+    resetButton.resetRequested = false;
+    resetWiFiSettings();
+}
+
+void checkBattery() {
+    // Мониторим то чего нет)))))
+    sampleBattery();
+
+    if (!batteryMonitor.low) {
+        if (batteryMonitor.voltage < BATTERY_LOW_VOLTAGE) {
+            batteryMonitor.lowCount++;
+        }
+        else {
+            batteryMonitor.lowCount = 0;
+        }
+
+        if (batteryMonitor.lowCount >= BATTERY_LOW_CONFIRM) {
+            batteryMonitor.low = true;
+            batteryMonitor.lowEvents++;
+            saveDeviceData();
+            updateDisplay("Low Battery!", "Saving data...", String(batteryMonitor.voltage, 2) + "V");
+            holdDisplay(2000);
+        }
+    }
+    else if (batteryMonitor.voltage >= BATTERY_LOW_VOLTAGE + BATTERY_LOW_HYSTERESIS) {
+        batteryMonitor.low = false;
+        batteryMonitor.lowCount = 0;
+    }
+}
+
+void sampleBattery() {
+    uint32_t sum = 0;
+    for (int i = 0; i < BATTERY_OVERSAMPLE; i++) {
+        sum += analogRead(BATTERY_PIN);
+    }
+    batteryMonitor.adcReads += BATTERY_OVERSAMPLE;
+
+    float voltage = sum * 3.3 / 1023.0 * 2 / BATTERY_OVERSAMPLE;
+    if (batteryMonitor.valid) {
+        batteryMonitor.voltage += BATTERY_EMA_ALPHA * (voltage - batteryMonitor.voltage);
+    }
+    else {
+        batteryMonitor.voltage = voltage;
+        batteryMonitor.valid = true;
+    }
+
+    int level = map(batteryMonitor.voltage * 100, 320, 420, 0, 100);
+    batteryMonitor.percent = constrain(level, 0, 100);
+}
+
+void serviceAccessPoint() {
+    dnsServer.processNextRequest();
+    webServer.handleClient();
+
+    if (waitingForCredentialsVerification) {
+        checkCredentialsVerification();
+    }
+}
+
+void startWiFiScan() {
+    if (WiFi.scanComplete() == WIFI_SCAN_RUNNING) return;
+
+    WiFi.scanNetworksAsync(onScanComplete, true);
+}
+
+void onScanComplete(int networksFound) {
+    Serial.printf("Scan completed, found %d networks\n", networksFound);
+
+    if (networksFound < 0) return;
+
+    int count = 0;
+    for (int i = 0; i < networksFound; i++) {
+        int32_t rssi = WiFi.RSSI(i);
+        int slot = count;
+
+        if (count == MAX_SCAN_RESULTS) {
+            slot = 0;
+            for (int j = 1; j < count; j++) {
+                if (scanResults[j].rssi < scanResults[slot].rssi) slot = j;
+            }
+            if (scanResults[slot].rssi >= rssi) continue;
+        }
+        else {
+            count++;
+        }
+
+        strncpy(scanResults[slot].ssid, WiFi.SSID(i).c_str(), sizeof(scanResults[slot].ssid) - 1);
+        scanResults[slot].ssid[sizeof(scanResults[slot].ssid) - 1] = '\0';
+        scanResults[slot].rssi = rssi;
+    }
+
+    scanResultCount = count;
+    scanResultsTime = millis();
+    probeHeap(HEAP_SCAN);
+    WiFi.scanDelete();
+}
+
+void runServerUpdate() {
+    setTaskInterval(serverUpdateTaskId, deviceData.uptime);
+
+    if (isAccessPointMode) return;
+
+    TelemetrySample sample;
+    captureTelemetrySample(sample);
+
+    if (TELEMETRY_BATCH_ENABLED) {
+        enqueueTelemetrySample(sample);
+        if (WiFi.status() == WL_CONNECTED && !serverRequestActive() && telemetryBatchDue() && retryReady(RETRY_SERVER)) {
+            sendTelemetryBatch();
+        }
+        return;
+    }
+
+    if (WiFi.status() != WL_CONNECTED || serverRequestActive() || !retryReady(RETRY_SERVER)) {
+        enqueueTelemetrySample(sample);
+        return;
+    }
+
+    lastServerUpdate = millis();
+    deviceData.timer = millis();
+
+    char wifiLine[DISPLAY_LINE_MAX + 1];
+    snprintf(wifiLine, sizeof(wifiLine), "WiFi %s connected", wifiCreds.ssid.c_str());
+    updateDisplay("Please wait", "Updating data...", wifiLine);
+    if (sendDataToServer(false)) {
+        // При неудаче замер уйдёт в очередь, повтор идёт через неё - период обновлений не сбивается
+        serverRequest.sample = sample;
+    }
+    else {
+        enqueueTelemetrySample(sample);
+    }
+}
+
+void refreshStatusDisplay() {
+    if (isAccessPointMode || WiFi.status() != WL_CONNECTED) return;
+
+    wifiCreds.connected = true;
+    deviceData.timer = millis();
+
+    if ((long)(millis() - displayHoldUntil) < 0) return;
+
+    char timeLine[DISPLAY_LINE_MAX + 1];
+    char statusLine[DISPLAY_LINE_MAX + 1];
+    snprintf(timeLine, sizeof(timeLine), "Time: %lu", millis());
+    snprintf(statusLine, sizeof(statusLine), "Status: %s", deviceData.status.c_str());
+    updateDisplay(deviceData.text.c_str(), timeLine, statusLine);
+}
+
+void periodicSave() {
+    if (isAccessPointMode || WiFi.status() != WL_CONNECTED) return;
+
+    saveDeviceData();
+}
+
+void reconnectWiFi() {
+    if (isAccessPointMode || WiFi.status() == WL_CONNECTED || wifiCreds.ssid.length() == 0) return;
+    if (wifiConnectState == CONNECT_STATE_DISCONNECTING || wifiConnectState == CONNECT_STATE_CONNECTING) return;
+
+    if (wifiConnectState == CONNECT_STATE_CONNECTED) {
+        // Первую попытку тоже разносим: после рестарта точки доступа все устройства теряют связь одновременно
+        wifiConnectState = CONNECT_STATE_IDLE;
+        retryDefer(RETRY_WIFI);
+        Serial.printf("WiFi lost, reconnecting in %lu ms\n", retryWait(RETRY_WIFI));
+        updateDisplay("WiFi disconnected", wifiCreds.ssid.c_str(), "Reconnecting soon...");
+        return;
+    }
+
+    if (!retryReady(RETRY_WIFI)) return;
+
+    updateDisplay("Reconnecting...", wifiCreds.ssid.c_str(), "WiFi disconnected");
+    Serial.printf("Attempting to reconnect to WiFi: %s\n", wifiCreds.ssid.c_str());
+
+    startWiFiConnection(CONNECT_PURPOSE_RECONNECT);
+}
+
+void checkDisplay() {
+    if (displayEnabled) return;
+
+    Serial.println("Attempting to reinitialize display...");
+    setupDisplay();
+    if (displayEnabled) {
+        updateDisplay("Display reinitialized", "System running",
+            WiFi.status() == WL_CONNECTED ? "WiFi connected" : "WiFi disconnected");
+    }
+}
+
+void checkCredentialsVerification() {
+    if (WiFi.status() == WL_CONNECTED) {
+        Serial.printf("Successfully connected to WiFi: %s\n", wifiCreds.ssid.c_str());
+        Serial.print("IP address: ");
+        Serial.println(WiFi.localIP());
+
+        waitingForCredentialsVerification = false;
+        wifiCreds.connected = true;
+        retrySucceeded(RETRY_WIFI);
+        stopTask(wifiRetryTaskId);
+        captureConnectionHints();
+        saveWiFiCredentials(wifiCreds.ssid.c_str(), wifiCreds.password.c_str());
+        updateDisplay("Connected to WiFi", wifiCreds.ssid.c_str(), getWiFiSignalStrength());
+
+        sendDataToServer(true);
+        startPushChannel();
+
+        if (pendingRedirectUrl.length() > 0) {
+            Serial.println("Keeping AP for redirect to: " + pendingRedirectUrl);
+            static unsigned long redirectStartTime = millis();
+            if (millis() - redirectStartTime > 60000) {
+                exitAPMode();
+            }
+        }
+        else {
+            static unsigned long successTime = millis();
+            if (millis() - successTime >= 5000) {
+                exitAPMode();
+            }
+        }
+    }
+    else if ((millis() - credentialsVerificationStartTime) >= WIFI_CONNECTION_TIMEOUT) {
+        Serial.println("Connection attempt timed out");
+        waitingForCredentialsVerification = false;
+        WiFi.disconnect();
+        connectionFailCount++;
+
+        updateDisplay("WiFi Failed", "Please try again", "Check credentials");
+
+        if (connectionFailCount >= 3) {
+            Serial.println("Multiple connection failures - check AP functionality");
+            WiFi.disconnect();
+            WiFi.mode(WIFI_AP_STA);
+            WiFi.softAPConfig(apIP, apIP, IPAddress(255, 255, 255, 0));
+            WiFi.softAP(DEFAULT_SSID);
+            connectionFailCount = 0;
+        }
+    }
+}
+
+void stopAccessPoint() {
+    isAccessPointMode = false;
+    stopTask(apServiceTaskId);
+    stopTask(wifiScanTaskId);
+    stopTask(wifiRetryTaskId);
+    dnsServer.stop();
+    webServer.stop();
+
+    WiFi.mode(WIFI_STA);
+    applyPowerProfile();
+}
+
+void exitAPMode() {
+    if (isAccessPointMode) {
+        Serial.println("Exiting AP mode, continuing in station mode only");
+        stopAccessPoint();
+
+        updateDisplay("Connected to WiFi", wifiCreds.ssid.c_str(), "AP mode disabled");
+
+        pendingRedirectUrl = "";
+        connectionFailCount = 0;
+    }
+}
+
+void setupDisplay() {
+    Wire.begin(SDA, SCL);
+
+    lastDisplayLine1 = "";
+    lastDisplayLine2 = "";
+    lastDisplayLine3 = "";
+    lastDisplayBars = -1;
+    lastDisplayBatteryFill = -1;
+    displayShadowValid = false;
+
+    if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
+        Serial.println(F("SSD1306 allocation failed"));
+        displayEnabled = false;
+        return;
+    }
+
+    display.clearDisplay();
+    display.setTextSize(1);
+    display.setTextColor(SSD1306_WHITE);
+    display.setCursor(0, 0);
+    display.println("Initializing...");
+    display.display();
+
+    memcpy(displayShadow, display.getBuffer(), DISPLAY_BUFFER_SIZE);
+    displayShadowValid = true;
+
+    Serial.println(F("SSD1306 initialization successful"));
+    displayEnabled = true;
+}
+
+void updateDisplay(const String& line1, const String& line2, const String& line3) {
+    updateDisplay(line1.c_str(), line2.c_str(), line3.c_str());
+}
+
+void updateDisplay(const char* line1, const char* line2, const char* line3) {
+    if (!displayEnabled) return;
+
+    unsigned long frameStart = micros();
+
+    int bars = 0;
+    if (WiFi.status() == WL_CONNECTED) {
+        int rssi = WiFi.RSSI();
+
+        if (rssi > -55) bars = 4;
+        else if (rssi > -65) bars = 3;
+        else if (rssi > -75) bars = 2;
+        else if (rssi > -85) bars = 1;
+    }
+
+    int batteryFill = map(batteryMonitor.percent, 0, 100, 0, 12);
+
+    if (lastDisplayLine1 == line1 && lastDisplayLine2 == line2 && lastDisplayLine3 == line3 &&
+        bars == lastDisplayBars && batteryFill == lastDisplayBatteryFill) {
+        displayStats.framesSkipped++;
+        return;
+    }
+
+    lastDisplayLine1 = line1;
+    lastDisplayLine2 = line2;
+    lastDisplayLine3 = line3;
+    lastDisplayBars = bars;
+    lastDisplayBatteryFill = batteryFill;
+
+    display.clearDisplay();
+
+    centerText(line1, 0);
+    centerText(line2, 11);
+
+    if (line3[0] != '\0') {
+        centerText(line3, 22);
+    }
+
+    for (int i = 0; i < bars; i++) {
+        display.fillRect(DISPLAY_WIDTH - 18 + i * 4, 2 + (4 - i) * 2, 3, i * 2 + 2, SSD1306_WHITE);
+    }
+
+    display.drawRect(2, 2, 12, 6, SSD1306_WHITE);
+    display.drawRect(14, 3, 2, 4, SSD1306_WHITE);
+    display.fillRect(2, 2, batteryFill, 6, SSD1306_WHITE);
+
+    flushDisplay();
+
+    recordLatency(displayFrameLatency, micros() - frameStart);
+}
+
+void flushDisplay() {
+    uint8_t* buffer = display.getBuffer();
+    displayStats.framesRendered++;
+
+    if (!displayShadowValid) {
+        display.display();
+        memcpy(displayShadow, buffer, DISPLAY_BUFFER_SIZE);
+        displayShadowValid = true;
+        displayStats.pagesPushed += DISPLAY_PAGES;
+        displayStats.bytesPushed += DISPLAY_BUFFER_SIZE;
+        return;
+    }
+
+    bool changed = false;
+
+    for (int page = 0; page < DISPLAY_PAGES; page++) {
+        uint8_t* row = buffer + page * DISPLAY_WIDTH;
+        uint8_t* shadowRow = displayShadow + page * DISPLAY_WIDTH;
+
+        int first = 0;
+        while (first < DISPLAY_WIDTH && row[first] == shadowRow[first]) first++;
+        if (first == DISPLAY_WIDTH) continue;
+
+        int last = DISPLAY_WIDTH - 1;
+        while (last > first && row[last] == shadowRow[last]) last--;
+
+        changed = true;
+
+        display.ssd1306_command(SSD1306_PAGEADDR);
+        display.ssd1306_command(page);
+        display.ssd1306_command(page);
+        display.ssd1306_command(SSD1306_COLUMNADDR);
+        display.ssd1306_command(first);
+        display.ssd1306_command(last);
+
+        Wire.setClock(400000);
+        for (int col = first; col <= last; col += DISPLAY_I2C_CHUNK) {
+            int count = min(DISPLAY_I2C_CHUNK, last - col + 1);
+            Wire.beginTransmission(SCREEN_ADDRESS);
+            Wire.write((uint8_t)0x40);
+            Wire.write(row + col, count);
+            Wire.endTransmission();
+        }
+        Wire.setClock(100000);
+
+        memcpy(shadowRow + first, row + first, last - first + 1);
+        displayStats.pagesPushed++;
+        displayStats.bytesPushed += last - first + 1;
+    }
+
+    if (!changed) {
+        displayStats.framesUnchanged++;
+    }
+}
+
+void centerText(const char* text, int y) {
+    const TextLayout& layout = layoutText(text);
+
+    display.setCursor(layout.x, y);
+    display.print(layout.text.c_str());
+}
+
+const TextLayout& layoutText(const char* text) {
+    textLayoutClock++;
+
+    TextLayout* slot = &textLayoutCache[0];
+    for (int i = 0; i < TEXT_LAYOUT_CACHE_SIZE; i++) {
+        TextLayout& entry = textLayoutCache[i];
+        if (textLayoutCacheEnabled && entry.valid && entry.source == text) {
+            entry.lastUsed = textLayoutClock;
+            displayStats.layoutHits++;
+            return entry;
+        }
+        // Сначала свободные слоты, и только потом вытесняем давно не использованную строку
+        if (slot->valid && (!entry.valid || entry.lastUsed < slot->lastUsed)) {
+            slot = &entry;
+        }
+    }
+
+    displayStats.layoutMisses++;
+
+    slot->source = text;
+    if (strlen(text) > DISPLAY_MAX_CHARS) {
+        slot->text.assign(text, DISPLAY_MAX_CHARS - 3);
+        slot->text.append("...");
+    }
+    else {
+        slot->text = text;
+    }
+
+    int16_t x1, y1;
+    uint16_t w, h;
+    display.getTextBounds(slot->text.c_str(), 0, 0, &x1, &y1, &w, &h);
+
+    slot->x = (DISPLAY_WIDTH - w) / 2;
+    slot->lastUsed = textLayoutClock;
+    slot->valid = textLayoutCacheEnabled;
+
+    return *slot;
+}
+
+// Показывает только выигрыш кэша: без него разметка та же, на FixedString и без String.
+// С прежней разметкой через String сравнивает tools/layout_bench.cpp
+void benchmarkTextLayout() {
+    const int frames = 200;
+    const char* line1 = "Welcome to the device!";
+    const char* line2 = "Time: 123456";
+    const char* line3 = "Status: New device";
+
+    for (int pass = 0; pass < 2; pass++) {
+        textLayoutCacheEnabled = pass == 1;
+
+        unsigned long start = micros();
+        for (int i = 0; i < frames; i++) {
+            display.clearDisplay();
+            centerText(line1, 0);
+            centerText(line2, 11);
+            centerText(line3, 22);
+        }
+        unsigned long elapsed = micros() - start;
+
+        Serial.printf("Text layout %s: %lu frames/s\n",
+            textLayoutCacheEnabled ? "cached" : "cache off",
+            elapsed > 0 ? (unsigned long)((uint64_t)frames * 1000000 / elapsed) : 0UL);
+    }
+
+    textLayoutCacheEnabled = true;
+}
+
+void startAPMode() {
+    isAccessPointMode = true;
+    cancelWiFiConnection();
+    stopTask(apServiceTaskId);
+    stopTask(wifiScanTaskId);
+
+    WiFi.disconnect(true);
+    WiFi.setSleepMode(WIFI_NONE_SLEEP);
+    scheduleTask(apBeginTaskId, 500);
+}
+
+void beginAPMode() {
+    WiFi.mode(WIFI_AP_STA);
+    WiFi.softAPConfig(apIP, apIP, IPAddress(255, 255, 255, 0));
+    WiFi.softAP(DEFAULT_SSID);
+
+    dnsServer.setErrorReplyCode(DNSReplyCode::NoError);
+    dnsServer.start(DNS_PORT, "*", apIP);
+
+    webServer.on("/", handleRoot);
+    webServer.on("/connect", HTTP_POST, handleConnect);
+    webServer.on("/success", handleSuccess);
+    webServer.on("/redirect", handleRedirect);
+    webServer.on("/scan", handleScan);
+    webServer.onNotFound(handleNotFound);
+
+    const char* headerKeys[] = { "If-None-Match" };
+    webServer.collectHeaders(headerKeys, 1);
+    webServer.begin();
+
+    scheduleTask(apServiceTaskId, 0);
+    Serial.println("AP Mode started");
+    Serial.print("AP SSID: ");
+    Serial.println(DEFAULT_SSID);
+
+    updateDisplay(
+        "Please connect to WiFi:",
+        DEFAULT_SSID,
+        "Then visit: setup portal"
+    );
+
+    scheduleTask(wifiScanTaskId, WIFI_SCAN_INTERVAL);
+    startWiFiScan();
+}
+
+void handleRoot() {
+    if (webServer.header("If-None-Match") == PORTAL_HTML_ETAG) {
+        webServer.sendHeader("ETag", PORTAL_HTML_ETAG);
+        webServer.send(304);
+        return;
+    }
+
+    webServer.sendHeader("Content-Encoding", "gzip");
+    webServer.sendHeader("ETag", PORTAL_HTML_ETAG);
+    webServer.sendHeader("Cache-Control", "no-cache");
+    probeHeap(HEAP_PORTAL);
+    webServer.send_P(200, "text/html", (PGM_P)PORTAL_HTML_GZ, PORTAL_HTML_GZ_LEN);
+    probeHeap(HEAP_PORTAL);
+}
+
+void handleConnect() {
+    String ssid = webServer.arg("ssid");
+    String password = webServer.arg("password");
+    String redirectUrl = webServer.arg("redirect_url");
+    probeHeap(HEAP_PORTAL);
+
+    if (ssid.length() > 0) {
+        saveWiFiCredentials(ssid.c_str(), password.c_str());
+
+        pendingRedirectUrl = redirectUrl;
+
+        WiFi.disconnect(true);
+
+        waitingForCredentialsVerification = true;
+        credentialsVerificationStartTime = millis();
+
+        updateDisplay("Connecting to", ssid, "Please wait...");
+
+        Serial.println("Attempting to connect to: " + ssid);
+
+        scheduleTask(pendingConnectTaskId, 500);
+
+        webServer.send(200, "text/plain", "Attempting to connect to " + ssid);
+    }
+    else {
+        webServer.send(400, "text/plain", "SSID required");
+    }
+}
+
+void beginPendingConnection() {
+    WiFi.mode(WIFI_AP_STA);
+    WiFi.begin(wifiCreds.ssid.c_str(), wifiCreds.password.c_str());
+}
+
+void handleSuccess() {
+    if (WiFi.status() == WL_CONNECTED) {
+        Serial.println("Success check: WiFi is connected");
+        webServer.send(200, "text/plain", "connected");
+    }
+    else {
+        if (waitingForCredentialsVerification) {
+            Serial.println("Success check: Still connecting...");
+            webServer.send(200, "text/plain", "connecting");
+        }
+        else {
+            Serial.println("Success check: Not connected");
+            webServer.send(200, "text/plain", "not connected");
+        }
+    }
+}
+
+void handleRedirect() {
+    String redirectUrl = webServer.arg("url");
+    if (redirectUrl.length() > 0) {
+        webServer.sendHeader("Location", redirectUrl, true);
+        webServer.send(302, "text/plain", "");
+    }
+    else {
+        webServer.send(400, "text/plain", "No URL provided");
+    }
+}
+
+void handleScan() {
+    webServer.sendHeader("Cache-Control", "no-store");
+    webServer.sendHeader("X-Scan-Age", String(scanResultCount > 0 ? (millis() - scanResultsTime) / 1000 : 0));
+    webServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    webServer.send(200, "application/json", "");
+    probeHeap(HEAP_SCAN);
+
+    char chunk[SCAN_CHUNK_SIZE];
+    char ssid[6 * 32 + 1];
+    size_t used = 0;
+
+    chunk[used++] = '[';
+
+    for (int i = 0; i < scanResultCount; i++) {
+        escapeJsonString(scanResults[i].ssid, ssid, sizeof(ssid));
+
+        char entry[sizeof(ssid) + 40];
+        int length = snprintf(entry, sizeof(entry), "%s{\"ssid\":\"%s\",\"rssi\":%d}",
+            i > 0 ? "," : "", ssid, (int)scanResults[i].rssi);
+
+        if (used + length > sizeof(chunk)) {
+            webServer.sendContent(chunk, used);
+            used = 0;
+        }
+        memcpy(chunk + used, entry, length);
+        used += length;
+    }
+
+    if (used + 1 > sizeof(chunk)) {
+        webServer.sendContent(chunk, used);
+        used = 0;
+    }
+    chunk[used++] = ']';
+    webServer.sendContent(chunk, used);
+    webServer.sendContent("");
+}
+
+size_t escapeJsonString(const char* in, char* out, size_t outSize) {
+    size_t used = 0;
+
+    for (; *in != '\0'; in++) {
+        unsigned char c = *in;
+        char escaped[7];
+        size_t length;
+
+        if (c == '"' || c == '\\') {
+            escaped[0] = '\\';
+            escaped[1] = c;
+            length = 2;
+        }
+        else if (c < 0x20) {
+            length = snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+        }
+        else {
+            escaped[0] = c;
+            length = 1;
+        }
+
+        if (used + length >= outSize) break;
+        memcpy(out + used, escaped, length);
+        used += length;
+    }
+
+    out[used] = '\0';
+    return used;
+}
+
+void handleNotFound() {
+    if (isAccessPointMode) {
+        webServer.sendHeader("Location", "http://" + apIP.toString() + "/", true);
+        webServer.send(302, "text/plain", "");
+    }
+    else {
+        webServer.send(404, "text/plain", "Not found");
+    }
+}
+
+void applyPowerProfile() {
+    switch (POWER_PROFILE) {
+    case POWER_PROFILE_ALWAYS_ON:
+        WiFi.setSleepMode(WIFI_NONE_SLEEP);
+        break;
+
+    case POWER_PROFILE_MODEM_SLEEP:
+        WiFi.setSleepMode(WIFI_MODEM_SLEEP);
+        break;
+
+    case POWER_PROFILE_LIGHT_SLEEP:
+    case POWER_PROFILE_DEEP_SLEEP:
+        WiFi.setSleepMode(WIFI_LIGHT_SLEEP, POWER_LISTEN_INTERVAL);
+        setTaskInterval(buttonTaskId, POWER_SAVE_BUTTON_POLL);
+        schedulerMaxIdle = POWER_SAVE_MAX_IDLE;
+        break;
+    }
+}
+
+const char* powerProfileName() {
+    switch (POWER_PROFILE) {
+    case POWER_PROFILE_ALWAYS_ON: return "always-on";
+    case POWER_PROFILE_MODEM_SLEEP: return "modem-sleep";
+    case POWER_PROFILE_LIGHT_SLEEP: return "light-sleep";
+    case POWER_PROFILE_DEEP_SLEEP: return "deep-sleep";
+    }
+    return "unknown";
+}
+
+bool saveRtcState() {
+    RtcState state = {};
+    state.magic = RTC_STATE_MAGIC;
+    state.uptime = deviceData.uptime;
+    state.timer = deviceData.timer;
+    state.sequence = telemetrySequence;
+    state.flags = (deviceDataAcked && !resyncRequested ? RTC_FLAG_ACKED : 0) |
+        (wifiCreds.hintsValid ? RTC_FLAG_HINTS : 0);
+    memcpy(state.bssid, wifiCreds.bssid, sizeof(state.bssid));
+    state.channel = wifiCreds.channel;
+    state.wifiFailures = retryPolicies[RETRY_WIFI].failures;
+    state.serverFailures = retryPolicies[RETRY_SERVER].failures;
+
+    memcpy(state.boardID, deviceData.boardID.c_str(), deviceData.boardID.length() + 1);
+    memcpy(state.token, deviceData.token.c_str(), deviceData.token.length() + 1);
+    memcpy(state.text, deviceData.text.c_str(), deviceData.text.length() + 1);
+    memcpy(state.status, deviceData.status.c_str(), deviceData.status.length() + 1);
+    memcpy(state.user, deviceData.user.c_str(), deviceData.user.length() + 1);
+    memcpy(state.serverUrl, deviceData.serverUrl.c_str(), deviceData.serverUrl.length() + 1);
+    memcpy(state.ssid, wifiCreds.ssid.c_str(), wifiCreds.ssid.length() + 1);
+    memcpy(state.password, wifiCreds.password.c_str(), wifiCreds.password.length() + 1);
+
+    state.crc = journalCrc32((const uint8_t*)&state + 8, sizeof(state) - 8);
+    return ESP.rtcUserMemoryWrite(0, (uint32_t*)&state, sizeof(state));
+}
+
+bool restoreRtcState() {
+    rst_info* resetInfo = ESP.getResetInfoPtr();
+    if (resetInfo == nullptr || resetInfo->reason != REASON_DEEP_SLEEP_AWAKE) return false;
+
+    RtcState state;
+    if (!ESP.rtcUserMemoryRead(0, (uint32_t*)&state, sizeof(state))) return false;
+    if (state.magic != RTC_STATE_MAGIC ||
+        state.crc != journalCrc32((const uint8_t*)&state + 8, sizeof(state) - 8)) {
+        return false;
+    }
+
+    deviceData.boardID = state.boardID;
+    deviceData.token = state.token;
+    deviceData.timer = state.timer;
+    deviceData.uptime = state.uptime;
+    deviceData.text = state.text;
+    deviceData.status = state.status;
+    deviceData.user = state.user;
+    deviceData.serverUrl = state.serverUrl;
+
+    wifiCreds.ssid = state.ssid;
+    wifiCreds.password = state.password;
+    wifiCreds.connected = true;
+    wifiCreds.hintsValid = (state.flags & RTC_FLAG_HINTS) != 0;
+    memcpy(wifiCreds.bssid, state.bssid, sizeof(wifiCreds.bssid));
+    wifiCreds.channel = state.channel;
+
+    retryPolicies[RETRY_WIFI].failures = state.wifiFailures;
+    retryPolicies[RETRY_SERVER].failures = state.serverFailures;
+
+    telemetrySequence = state.sequence;
+    if (state.flags & RTC_FLAG_ACKED) {
+        ackedDeviceData = deviceData;
+        deviceDataAcked = true;
+        resyncRequested = false;
+    }
+
+    return true;
+}
+
+// Портал держит устройство без сна, но открывается только после холодного старта, не после сна
+void enterDeepSleep() {
+    if (POWER_PROFILE != POWER_PROFILE_DEEP_SLEEP || isAccessPointMode || waitingForCredentialsVerification) return;
+
+    // Очередь дожидаемся, только пока сервер её принимает, и не дольше POWER_MAX_AWAKE:
+    // при отказе сервера устройство засыпает, а не ждёт его без сна
+    bool overdue = millis() - powerAwakeStart >= POWER_MAX_AWAKE;
+    bool draining = telemetryQueueLength() > 0 && WiFi.status() == WL_CONNECTED && retryWait(RETRY_SERVER) == 0;
+    if (!overdue && (draining || serverRequestActive())) {
+        scheduleTask(powerSleepTaskId, POWER_SLEEP_GRACE);
+        return;
+    }
+    if (serverRequestActive()) {
+        finishServerRequest(HTTP_ERROR_TIMEOUT);
+    }
+
+    // Просыпаемся с периодом deviceData.uptime, считая от прошлого пробуждения,
+    // а после неудачи не раньше, чем разрешит политика повторов
+    unsigned long awake = millis();
+    unsigned long sleepMs = deviceData.uptime > awake + POWER_MIN_SLEEP ? deviceData.uptime - awake : POWER_MIN_SLEEP;
+    unsigned long backoff = max(retryWait(RETRY_WIFI), retryWait(RETRY_SERVER));
+    if (backoff > sleepMs) sleepMs = backoff;
+    uint64_t sleepUs = (uint64_t)sleepMs * 1000;
+    if (ESP.deepSleepMax() > 0 && sleepUs > ESP.deepSleepMax()) {
+        sleepUs = ESP.deepSleepMax();
+    }
+
+    // RAM не переживает глубокий сон: неотправленные замеры уходят во флеш и читаются после пробуждения
+    saveTelemetrySpillOffset();
+    spillTelemetrySamples(telemetryRingCount);
+    saveRtcState();
+    Serial.printf("Deep sleep for %lu ms after %lu ms awake\n", (unsigned long)(sleepUs / 1000), awake);
+
+    if (displayEnabled) {
+        display.ssd1306_command(SSD1306_DISPLAYOFF);
+    }
+
+    ESP.deepSleep(sleepUs);
+}
+
+unsigned long retryJitter(unsigned long low, unsigned long high) {
+    if (high <= low) return low;
+    // random() на ESP8266 берёт аппаратный ГСЧ, пока не вызван randomSeed(), так что устройства не синхронны
+    return low + (unsigned long)random((long)(high - low + 1));
+}
+
+bool retryReady(RetryPolicyId id) {
+    RetryPolicy& policy = retryPolicies[id];
+    BreakerState state = policy.state;
+    if (!retryPolicyReady(policy, millis())) return false;
+
+    if (state == BREAKER_OPEN) {
+        Serial.printf("Retry %s: circuit half-open, probing\n", policy.name);
+    }
+    return true;
+}
+
+unsigned long retryFailed(RetryPolicyId id) {
+    RetryPolicy& policy = retryPolicies[id];
+    unsigned long delay = retryPolicyFailed(policy, millis(), retryJitter);
+    if (policy.state == BREAKER_OPEN) {
+        Serial.printf("Retry %s: circuit open for %lu ms\n", policy.name, delay);
+    }
+    return delay;
+}
+
+void retrySucceeded(RetryPolicyId id) {
+    RetryPolicy& policy = retryPolicies[id];
+    if (policy.state != BREAKER_CLOSED) {
+        Serial.printf("Retry %s: circuit closed\n", policy.name);
+    }
+    retryPolicySucceeded(policy);
+}
+
+void retryDefer(RetryPolicyId id) {
+    retryPolicyDefer(retryPolicies[id], millis(), retryJitter);
+}
+
+void retryTrip(RetryPolicyId id) {
+    RetryPolicy& policy = retryPolicies[id];
+    retryPolicyTrip(policy, millis(), retryJitter);
+    Serial.printf("Retry %s: circuit open for %lu ms\n", policy.name, policy.lastDelay);
+}
+
+unsigned long retryWait(RetryPolicyId id) {
+    return retryPolicyWait(retryPolicies[id], millis());
+}
+
+void retrySavedNetwork() {
+    if (!isAccessPointMode || wifiCreds.ssid.length() == 0) return;
+
+    if (waitingForCredentialsVerification || WiFi.softAPgetStationNum() > 0) {
+        // Портал кем-то используется - не выдёргиваем точку доступа из-под клиента
+        scheduleTask(wifiRetryTaskId, WIFI_PORTAL_BUSY_RETRY);
+        return;
+    }
+
+    if (!retryReady(RETRY_WIFI)) {
+        scheduleTask(wifiRetryTaskId, retryWait(RETRY_WIFI));
+        return;
+    }
+
+    Serial.printf("Portal idle, retrying saved network: %s\n", wifiCreds.ssid.c_str());
+    stopAccessPoint();
+    updateDisplay("Reconnecting...", wifiCreds.ssid.c_str(), "Setup portal idle");
+    startWiFiConnection(CONNECT_PURPOSE_RECONNECT);
+}
+
+bool startWiFiConnection(WiFiConnectPurpose purpose) {
+    if (wifiConnectState == CONNECT_STATE_DISCONNECTING || wifiConnectState == CONNECT_STATE_CONNECTING) {
+        return false;
+    }
+
+    Serial.printf("Attempting to connect to WiFi: %s\n", wifiCreds.ssid.c_str());
+
+    wifiConnectPurpose = purpose;
+    wifiConnectState = CONNECT_STATE_DISCONNECTING;
+    wifiConnectStateSince = millis();
+    wifiConnectAttemptStart = wifiConnectStateSince;
+    wifiConnectLastProgress = wifiConnectStateSince;
+    wifiConnectMetrics.attempts++;
+
+    WiFi.disconnect();
+    scheduleTask(wifiConnectTaskId, WIFI_DISCONNECT_SETTLE);
+
+    onWiFiConnectEvent(CONNECT_EVENT_STARTED);
+    return true;
+}
+
+void serviceWiFiConnection() {
+    unsigned long now = millis();
+
+    switch (wifiConnectState) {
+    case CONNECT_STATE_DISCONNECTING:
+        if (now - wifiConnectStateSince >= WIFI_DISCONNECT_SETTLE) {
+            WiFi.mode(WIFI_STA);
+            beginWiFiAttempt(wifiCreds.hintsValid);
+        }
+        break;
+
+    case CONNECT_STATE_CONNECTING:
+        if (WiFi.status() == WL_CONNECTED) {
+            finishWiFiConnection(true);
+        }
+        else if (wifiConnectFastPath && (now - wifiConnectStateSince >= WIFI_FAST_CONNECT_TIMEOUT ||
+            WiFi.status() == WL_NO_SSID_AVAIL || WiFi.status() == WL_CONNECT_FAILED)) {
+            Serial.println("\nFast reconnect failed, falling back to full scan");
+            wifiConnectMetrics.fastFallbacks++;
+            WiFi.disconnect();
+            beginWiFiAttempt(false);
+        }
+        else if (now - wifiConnectStateSince >= WIFI_CONNECTION_TIMEOUT) {
+            finishWiFiConnection(false);
+        }
+        else if (now - wifiConnectLastProgress >= 1000) {
+            wifiConnectLastProgress = now;
+            onWiFiConnectEvent(CONNECT_EVENT_PROGRESS);
+        }
+        break;
+
+    default:
+        stopTask(wifiConnectTaskId);
+        break;
+    }
+}
+
+void beginWiFiAttempt(bool fastPath) {
+    wifiConnectFastPath = fastPath;
+    wifiConnectState = CONNECT_STATE_CONNECTING;
+    wifiConnectStateSince = millis();
+
+    if (fastPath) {
+        Serial.printf("Fast reconnect on channel %d\n", wifiCreds.channel);
+        wifiConnectMetrics.fastAttempts++;
+        // Без сканирования, но с DHCP: статический адрес из прошлой аренды мог уже достаться другому
+        WiFi.begin(wifiCreds.ssid.c_str(), wifiCreds.password.c_str(), wifiCreds.channel, wifiCreds.bssid);
+    }
+    else {
+        WiFi.begin(wifiCreds.ssid.c_str(), wifiCreds.password.c_str());
+    }
+}
+
+void captureConnectionHints() {
+    uint8_t* bssid = WiFi.BSSID();
+    if (bssid == nullptr) return;
+
+    memcpy(wifiCreds.bssid, bssid, sizeof(wifiCreds.bssid));
+    wifiCreds.channel = WiFi.channel();
+    wifiCreds.hintsValid = wifiCreds.channel > 0;
+}
+
+void finishWiFiConnection(bool success) {
+    unsigned long duration = millis() - wifiConnectAttemptStart;
+
+    stopTask(wifiConnectTaskId);
+
+    wifiConnectMetrics.lastDuration = duration;
+    wifiConnectMetrics.totalDuration += duration;
+    if (duration < wifiConnectMetrics.minDuration) wifiConnectMetrics.minDuration = duration;
+    if (duration > wifiConnectMetrics.maxDuration) wifiConnectMetrics.maxDuration = duration;
+
+    if (success) {
+        wifiConnectState = CONNECT_STATE_CONNECTED;
+        wifiConnectMetrics.successes++;
+        if (wifiConnectFastPath) wifiConnectMetrics.fastSuccesses++;
+
+        Serial.printf("\nConnected to WiFi in %lu ms\n", duration);
+        Serial.print("IP address: ");
+        Serial.println(WiFi.localIP());
+
+        wifiCreds.connected = true;
+        captureConnectionHints();
+        saveWiFiCredentials(wifiCreds.ssid.c_str(), wifiCreds.password.c_str());
+
+        onWiFiConnectEvent(CONNECT_EVENT_CONNECTED);
+    }
+    else {
+        wifiConnectState = CONNECT_STATE_FAILED;
+        wifiConnectMetrics.failures++;
+
+        Serial.printf("\nFailed to connect to WiFi after %lu ms\n", duration);
+
+        onWiFiConnectEvent(CONNECT_EVENT_FAILED);
+    }
+}
+
+void cancelWiFiConnection() {
+    if (wifiConnectState == CONNECT_STATE_DISCONNECTING || wifiConnectState == CONNECT_STATE_CONNECTING) {
+        Serial.println("WiFi connection attempt cancelled");
+        wifiConnectState = CONNECT_STATE_IDLE;
+    }
+    stopTask(wifiConnectTaskId);
+}
+
+void onWiFiConnectEvent(WiFiConnectEvent event) {
+    switch (event) {
+    case CONNECT_EVENT_STARTED:
+        break;
+
+    case CONNECT_EVENT_PROGRESS:
+        Serial.print(".");
+        if ((long)(millis() - displayHoldUntil) >= 0) {
+            updateDisplay(
+                wifiConnectPurpose == CONNECT_PURPOSE_BOOT ? "Connecting to WiFi" : "Reconnecting...",
+                wifiCreds.ssid.c_str(),
+                String((millis() - wifiConnectAttemptStart) / 1000) + "s"
+            );
+        }
+        break;
+
+    case CONNECT_EVENT_CONNECTED:
+        retrySucceeded(RETRY_WIFI);
+        stopTask(wifiRetryTaskId);
+        if (POWER_PROFILE == POWER_PROFILE_DEEP_SLEEP && !resumedFromDeepSleep) {
+            // После холодного старта окно бодрствования отсчитывается от подключения: до него мог быть портал
+            powerAwakeStart = millis();
+            scheduleTask(powerSleepTaskId, POWER_MAX_AWAKE);
+        }
+        startPushChannel();
+
+        if (wifiConnectPurpose == CONNECT_PURPOSE_BOOT) {
+            updateDisplay("Connected to WiFi", wifiCreds.ssid.c_str(), getWiFiSignalStrength());
+            updateDisplay("Please wait", "Registering to server...", "WiFi " + String(wifiCreds.ssid.c_str()) + " connected");
+        }
+        else {
+            updateDisplay("Reconnected", wifiCreds.ssid.c_str(), "WiFi connected");
+        }
+
+        sendDataToServer(!resumedFromDeepSleep);
+        break;
+
+    case CONNECT_EVENT_FAILED:
+        // Одна неудача - ещё не повод открывать портал, в том числе на старте: перегруженная
+        // точка доступа могла просто не принять подключение. Портал - когда разомкнётся цепь
+        {
+            unsigned long retryIn = retryFailed(RETRY_WIFI);
+            if (resumedFromDeepSleep) {
+                // После сна портал не открываем: настраивать его некому, а точка доступа не дала бы уснуть.
+                // Следующая попытка - в следующем пробуждении, через паузу политики повторов
+                Serial.printf("WiFi unavailable after wake, sleeping for at least %lu ms\n", retryIn);
+                updateDisplay("WiFi unavailable", wifiCreds.ssid.c_str(), "Sleeping...");
+                scheduleTask(powerSleepTaskId, 0);
+            }
+            else if (retryPolicies[RETRY_WIFI].state == BREAKER_OPEN && wifiConnectPurpose == CONNECT_PURPOSE_BOOT) {
+                // Сеть недоступна с самого старта: открываем портал, но сохранённую сеть позже проверим снова
+                scheduleTask(wifiRetryTaskId, retryIn);
+                updateDisplay("WiFi connection", "failed", "Starting setup...");
+                holdDisplay(2000);
+                scheduleTask(apStartTaskId, 2000);
+            }
+            else if (retryPolicies[RETRY_WIFI].state == BREAKER_OPEN) {
+                Serial.printf("Reconnection keeps failing. Starting AP mode, next try in %lu s\n", retryIn / 1000);
+                startAPMode();
+                scheduleTask(wifiRetryTaskId, retryIn);
+            }
+            else {
+                Serial.printf("Reconnection failed. Attempt: %u, next in %lu ms\n", retryPolicies[RETRY_WIFI].failures, retryIn);
+                updateDisplay("Reconnect failed", "Retry in " + String(retryIn / 1000) + "s", "WiFi disconnected");
+            }
+        }
+        break;
+    }
+}
+
+bool sendDataToServer(bool isHello) {
+    if (WiFi.status() != WL_CONNECTED) {
+        Serial.println("Cannot send data: WiFi not connected");
+        updateDisplay("Server update failed", "WiFi not connected", "Please check connection");
+        return false;
+    }
+
+    if (serverRequestActive()) {
+        Serial.println("Server request already in progress");
+        return false;
+    }
+
+    bool fullSync = isHello || !DELTA_TELEMETRY_ENABLED || !deviceDataAcked || resyncRequested;
+
+    StaticJsonDocument<REQUEST_DOC_SIZE> doc;
+    addDeviceFields(doc, fullSync);
+
+    if (isHello) {
+        doc["time"] = millis();
+        doc["hello"] = "Привет от ESP8266";
+        Serial.println("Sending hello message to server");
+    }
+    else {
+        doc["time"] = millis();
+        doc["timer"] = deviceData.timer;
+        addHeapSummary(doc);
+        // Сводка кучи необязательна: если с ней запрос не помещается, он уходит без неё
+        if (measureJson(doc) >= REQUEST_PAYLOAD_SIZE - 1) {
+            doc.remove("heap");
+            Serial.println("Heap summary dropped, request too large");
+        }
+    }
+
+    char* payload = requestPayloadBuffer();
+    size_t payloadLength = serializeJson(doc, payload, REQUEST_PAYLOAD_SIZE);
+    probeHeap(HEAP_SERVER);
+    if (doc.overflowed() || payloadLength >= REQUEST_PAYLOAD_SIZE - 1) {
+        Serial.println("Request payload too large");
+        return false;
+    }
+
+    Serial.print(fullSync ? "Sending: " : "Sending delta: ");
+    Serial.println(payload);
+
+    if (!startServerRequest(isHello ? SERVER_REQUEST_HELLO : SERVER_REQUEST_UPDATE, payload, payloadLength)) {
+        updateDisplay("Server error", "Connection failed", "Will retry later");
+        return false;
+    }
+
+    if (fullSync) serverConnectionStats.fullUpdates++;
+    else serverConnectionStats.deltaUpdates++;
+    serverConnectionStats.payloadBytes += payloadLength;
+    return true;
+}
+
+// Приёмник для writeDeviceFields(): поля пишутся прямо в документ запроса
+struct JsonFieldWriter {
+    JsonDocument& doc;
+
+    template <typename T>
+    void add(const char* key, T value) {
+        doc[key] = value;
+    }
+
+    void addFlag(const char* key) {
+        doc[key] = true;
+    }
+};
+
+void addDeviceFields(JsonDocument& doc, bool fullSync) {
+    static String mac = getMacAddress();
+
+    JsonFieldWriter out = { doc };
+    writeDeviceFields(out, deviceData, ackedDeviceData, ++telemetrySequence, serverRev.c_str(), mac.c_str(), fullSync);
+}
+
+// Обрезать можно только то, что выводится на экран; обрезанный токен или адрес
+// сервера сломал бы связь, поэтому слишком длинное значение отклоняется целиком
+template <size_t N>
+bool applyServerString(JsonDocument& doc, const char* key, FixedString<N>& field, bool displayField) {
+    if (!doc.containsKey(key)) return false;
+
+    const char* value = doc[key].as<const char*>();
+    if (value == nullptr || value[0] == '\0') return false;
+
+    size_t length = strnlen(value, N + 1);
+    bool truncated = length > N;
+    if (truncated && !displayField) {
+        Serial.printf("Server %s longer than %u chars, keeping the old value\n", key, (unsigned)N);
+        return false;
+    }
+    if (truncated) length = N;
+
+    if (field.length() == length && memcmp(field.c_str(), value, length) == 0) return false;
+
+    field.assign(value, length);
+    if (truncated) {
+        Serial.printf("Server %s longer than %u chars, truncated\n", key, (unsigned)N);
+    }
+    Serial.printf("Updated %s: %s\n", key, field.c_str());
+    return true;
+}
+
+bool applyServerResponse(int httpCode, const char* body, size_t length) {
+    // 304 или {} - состояние на сервере не менялось, разбирать и сравнивать нечего
+    if (httpCode == HTTP_CODE_NOT_MODIFIED || isEmptyResponse(body, length)) {
+        serverConnectionStats.unchangedResponses++;
+        Serial.println("Server state unchanged");
+        acknowledgeServerUpdate();
+        return true;
+    }
+
+    StaticJsonDocument<256> filter;
+    buildResponseFilter(filter);
+
+    JsonDocument& respDoc = serverResponseDoc;
+    DeserializationError error = deserializeJson(respDoc, body, length, DeserializationOption::Filter(filter));
+    probeHeap(HEAP_SERVER);
+
+    Serial.print("Server response: ");
+    serializeJson(respDoc, Serial);
+    Serial.println();
+
+    if (!error) {
+        resyncRequested = respDoc["resync"].as<bool>();
+        if (resyncRequested) {
+            Serial.println("Server requested full resync");
+        }
+
+        applyServerFields(respDoc);
+
+        // Версию запоминаем только после применения, иначе следующий 304 скрыл бы непринятое состояние
+        serverEtag = serverRequest.etag;
+        storeServerRev(respDoc["rev"]);
+
+        acknowledgeServerUpdate();
+    }
+    else {
+        Serial.print("JSON parsing failed: ");
+        Serial.println(error.c_str());
+        updateDisplay("Server comm error", "Invalid response", "Will retry later");
+    }
+
+    return !error;
+}
+
+void acknowledgeServerUpdate() {
+    ackedDeviceData = deviceData;
+    deviceDataAcked = true;
+
+    lastServerUpdate = millis();
+    scheduleTask(serverUpdateTaskId, deviceData.uptime);
+
+    if (POWER_PROFILE == POWER_PROFILE_DEEP_SLEEP) {
+        scheduleTask(powerSleepTaskId, POWER_SLEEP_GRACE);
+    }
+
+    if (telemetryQueueLength() > 0) {
+        scheduleTask(telemetryDrainTaskId, TELEMETRY_DRAIN_INTERVAL);
+    }
+}
+
+void storeServerRev(JsonVariant rev) {
+    if (rev.isNull()) return;
+
+    if (rev.is<const char*>()) {
+        serverRev = rev.as<const char*>();
+    }
+    else {
+        char number[16];
+        snprintf(number, sizeof(number), "%lu", rev.as<unsigned long>());
+        serverRev = number;
+    }
+}
+
+void applyServerFields(JsonDocument& respDoc) {
+    bool dataChanged = false;
+
+    dataChanged |= applyServerString(respDoc, "boardID", deviceData.boardID);
+    dataChanged |= applyServerString(respDoc, "user", deviceData.user, true);
+    dataChanged |= applyServerString(respDoc, "text", deviceData.text, true);
+    dataChanged |= applyServerString(respDoc, "status", deviceData.status, true);
+    dataChanged |= applyServerString(respDoc, "token", deviceData.token);
+
+    if (respDoc.containsKey("uptime")) {
+        long newUptime = respDoc["uptime"].as<long>();
+        if (newUptime > 0 && deviceData.uptime != (unsigned long)newUptime) {
+            deviceData.uptime = newUptime;
+            dataChanged = true;
+            Serial.println("Updated uptime: " + String(deviceData.uptime));
+        }
+    }
+
+    if (applyServerString(respDoc, "serverUrl", deviceData.serverUrl)) {
+        SERVER_URL = deviceData.serverUrl.c_str();
+        dataChanged = true;
+    }
+
+    if (dataChanged) {
+        saveDeviceData();
+        Serial.println("Saved updated device data to flash");
+
+        char textLine[sizeof("Text: ") + TEXT_MAX];
+        char timeLine[DISPLAY_LINE_MAX + 1];
+        char statusLine[DISPLAY_LINE_MAX + 1];
+        snprintf(textLine, sizeof(textLine), "Text: %s", deviceData.text.c_str());
+        snprintf(timeLine, sizeof(timeLine), "Time: %lu", millis());
+        snprintf(statusLine, sizeof(statusLine), "Status: %s", deviceData.status.c_str());
+        updateDisplay(textLine, timeLine, statusLine);
+    }
+}
+
+void buildResponseFilter(JsonDocument& filter) {
+    for (const char* field : RESPONSE_FIELDS) {
+        filter[field] = true;
+    }
+}
+
+bool isResponseField(const char* key) {
+    for (const char* field : RESPONSE_FIELDS) {
+        if (strcmp(field, key) == 0) return true;
+    }
+    return false;
+}
+
+bool parseServerUrl(const char* url, ServerRequest& req) {
+    // Клиент всегда BearSSL, поэтому принимаем только https://host[:port]/path
+    return parseUrl(url, "https://", 443, req.host, req.path, req.port);
+}
+
+bool startServerRequest(ServerRequestKind kind, const char* payload, size_t length) {
+    ServerRequest& req = serverRequest;
+    if (req.phase != HTTP_PHASE_IDLE) return false;
+
+    const char* url = SERVER_URL.c_str();
+    if (!parseServerUrl(url, req)) {
+        Serial.printf("Unsupported server URL: %s\n", url);
+        return false;
+    }
+
+    if (!serverClientInitialized) {
+        serverClient.setInsecure();
+        serverClient.setSession(&serverSession);
+        serverClientInitialized = true;
+    }
+
+    if (serverConnectionUrl != url) {
+        serverClient.stop();
+        serverSession = BearSSL::Session();
+        serverSessionCached = false;
+        serverConnectionUrl = url;
+        serverEtag = "";
+        serverRev = "";
+    }
+
+    Serial.print("Sending data to server: ");
+    Serial.println(url);
+
+    char head[HTTP_HEAD_MAX];
+    int headLength = snprintf(head, sizeof(head),
+        "POST %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: ESP8266\r\nConnection: keep-alive\r\n"
+        "Content-Type: application/json\r\nContent-Length: %u\r\n",
+        req.path, req.host, (unsigned)length);
+    if (kind != SERVER_REQUEST_QUEUED && serverEtag.length() > 0) {
+        headLength += snprintf(head + headLength, sizeof(head) - headLength, "If-None-Match: %s\r\n", serverEtag.c_str());
+    }
+    headLength += snprintf(head + headLength, sizeof(head) - headLength, "\r\n");
+
+    if (headLength + length > sizeof(req.out)) {
+        Serial.printf("Request of %u bytes does not fit the send buffer\n", (unsigned)(headLength + length));
+        return false;
+    }
+    // Тело могло быть собрано в requestPayloadBuffer() - области пересекаются
+    memmove(req.out + headLength, payload, length);
+    memcpy(req.out, head, headLength);
+    req.outLength = headLength + length;
+    req.outSent = 0;
+
+    req.bodyLength = 0;
+    req.bodyOverflow = false;
+    resetResponseScanner(req.scanner);
+    req.status = 0;
+    req.etag = "";
+    req.keepAlive = true;
+    req.bodyMode = HTTP_BODY_UNTIL_CLOSE;
+    req.remaining = 0;
+    req.lineLength = 0;
+    req.batchCount = 0;
+    req.kind = kind;
+    req.retried = false;
+    req.startMicros = micros();
+    req.reused = serverClient.connected();
+    serverConnectionStats.requests++;
+
+    if (req.reused) {
+        serverConnectionStats.reusedConnections++;
+        Serial.println("TLS: reused kept-alive connection");
+        setServerRequestPhase(HTTP_PHASE_SEND);
+    }
+    else {
+        setServerRequestPhase(HTTP_PHASE_DNS);
+    }
+
+    scheduleTask(serverRequestTaskId, 0);
+    return true;
+}
+
+bool serverRequestActive() {
+    return serverRequest.phase != HTTP_PHASE_IDLE;
+}
+
+// Место под тело за будущими заголовками; писать туда можно, только пока запрос не идёт
+char* requestPayloadBuffer() {
+    return serverRequest.out + HTTP_HEAD_MAX;
+}
+
+void setServerRequestPhase(HttpPhase phase) {
+    serverRequest.phase = phase;
+    serverRequest.phaseStart = millis();
+}
+
+// DNS и подключение с TLS - один блокирующий вызов каждый (неблокирующих hostByName и connect
+// в ядре ESP8266 и BearSSL нет), их ограничивают таймауты самих вызовов, а не проверка фазы
+unsigned long httpPhaseTimeout(HttpPhase phase) {
+    switch (phase) {
+    case HTTP_PHASE_SEND: return HTTP_SEND_TIMEOUT;
+    case HTTP_PHASE_FIRST_BYTE: return HTTP_FIRST_BYTE_TIMEOUT;
+    case HTTP_PHASE_HEADERS:
+    case HTTP_PHASE_BODY: return HTTP_BODY_TIMEOUT;
+    default: return 0;
+    }
+}
+
+void serviceServerRequest() {
+    ServerRequest& req = serverRequest;
+    if (req.phase == HTTP_PHASE_IDLE) {
+        stopTask(serverRequestTaskId);
+        return;
+    }
+
+    if (WiFi.status() != WL_CONNECTED) {
+        finishServerRequest(HTTP_ERROR_NO_WIFI);
+        return;
+    }
+
+    unsigned long phaseTimeout = httpPhaseTimeout(req.phase);
+    if (phaseTimeout > 0 && millis() - req.phaseStart > phaseTimeout) {
+        Serial.printf("HTTP %s timeout after %lu ms\n", HTTP_PHASE_NAMES[req.phase], millis() - req.phaseStart);
+        httpPhaseTimeouts[req.phase]++;
+        finishServerRequest(HTTP_ERROR_TIMEOUT);
+        return;
+    }
+
+    switch (req.phase) {
+    case HTTP_PHASE_DNS: {
+        // Блокирует цикл до HTTP_DNS_TIMEOUT; ответ остаётся в кэше lwIP,
+        // и connect() по имени (ради SNI) его не повторяет
+        IPAddress address;
+        if (!WiFi.hostByName(req.host, address, HTTP_DNS_TIMEOUT)) {
+            Serial.printf("DNS lookup failed: %s\n", req.host);
+            finishServerRequest(HTTP_ERROR_DNS);
+            return;
+        }
+        setServerRequestPhase(HTTP_PHASE_CONNECT);
+        break;
+    }
+
+    case HTTP_PHASE_CONNECT:
+        // BearSSL делает TCP-подключение и рукопожатие одним вызовом, цикл стоит
+        // до HTTP_CONNECT_TIMEOUT + HTTP_TLS_TIMEOUT; на keep-alive соединении фаза пропускается
+        serverClient.setTimeout(HTTP_CONNECT_TIMEOUT + HTTP_TLS_TIMEOUT);
+        if (!serverClient.connect(req.host, req.port)) {
+            finishServerRequest(HTTP_ERROR_CONNECT);
+            return;
+        }
+
+        if (serverSessionCached) {
+            // Принял ли сервер сессию, BearSSL не сообщает - считаем только предложенные
+            serverConnectionStats.sessionOffers++;
+            Serial.println("TLS: new connection, cached session offered");
+        }
+        else {
+            serverConnectionStats.fullHandshakes++;
+            Serial.println("TLS: new connection, full handshake");
+        }
+        serverSessionCached = true;
+        setServerRequestPhase(HTTP_PHASE_SEND);
+        break;
+
+    case HTTP_PHASE_SEND: {
+        if (!serverClient.connected()) {
+            lostServerConnection();
+            return;
+        }
+
+        size_t chunk = min(min((size_t)serverClient.availableForWrite(), req.outLength - req.outSent), HTTP_IO_CHUNK);
+        if (chunk > 0) {
+            req.outSent += serverClient.write((const uint8_t*)req.out + req.outSent, chunk);
+        }
+        if (req.outSent == req.outLength) {
+            setServerRequestPhase(HTTP_PHASE_FIRST_BYTE);
+        }
+        break;
+    }
+
+    case HTTP_PHASE_FIRST_BYTE:
+        if (serverClient.available() > 0) {
+            setServerRequestPhase(HTTP_PHASE_HEADERS);
+            readServerResponseHeaders();
+        }
+        else if (!serverClient.connected()) {
+            lostServerConnection();
+        }
+        break;
+
+    case HTTP_PHASE_HEADERS:
+        readServerResponseHeaders();
+        break;
+
+    case HTTP_PHASE_BODY:
+        readServerResponseBody();
+        break;
+
+    default:
+        break;
+    }
+}
+
+bool readServerResponseLine() {
+    ServerRequest& req = serverRequest;
+
+    for (size_t budget = HTTP_IO_CHUNK; budget > 0 && serverClient.available() > 0; budget--) {
+        int c = serverClient.read();
+        if (c < 0) break;
+
+        if (c == '\n') {
+            if (req.lineLength > 0 && req.line[req.lineLength - 1] == '\r') req.lineLength--;
+            req.line[req.lineLength] = '\0';
+            req.lineLength = 0;
+            return true;
+        }
+        if (req.lineLength < HTTP_LINE_MAX) {
+            req.line[req.lineLength++] = (char)c;
+        }
+    }
+    return false;
+}
+
+void readServerResponseHeaders() {
+    ServerRequest& req = serverRequest;
+
+    while (readServerResponseLine()) {
+        if (req.status == 0) {
+            int major = 0, minor = 0;
+            if (sscanf(req.line, "HTTP/%d.%d %d", &major, &minor, &req.status) != 3 || req.status <= 0) {
+                finishServerRequest(HTTP_ERROR_BAD_RESPONSE);
+                return;
+            }
+            req.keepAlive = major > 1 || minor >= 1;
+            continue;
+        }
+
+        if (req.line[0] == '\0') {
+            if (req.status == 204 || req.status == 304 || (req.bodyMode == HTTP_BODY_LENGTH && req.remaining == 0)) {
+                finishServerRequest(req.status);
+                return;
+            }
+            if (req.bodyMode == HTTP_BODY_UNTIL_CLOSE) req.keepAlive = false;
+            setServerRequestPhase(HTTP_PHASE_BODY);
+            readServerResponseBody();
+            return;
+        }
+
+        if (strncasecmp(req.line, "Content-Length:", 15) == 0) {
+            req.remaining = strtoul(req.line + 15, nullptr, 10);
+            req.bodyMode = HTTP_BODY_LENGTH;
+        }
+        else if (strncasecmp(req.line, "Transfer-Encoding:", 18) == 0 && strstr(req.line + 18, "chunked") != nullptr) {
+            req.bodyMode = HTTP_BODY_CHUNK_SIZE;
+        }
+        else if (strncasecmp(req.line, "Connection:", 11) == 0 && strstr(req.line + 11, "close") != nullptr) {
+            req.keepAlive = false;
+        }
+        else if (strncasecmp(req.line, "ETag:", 5) == 0) {
+            const char* value = req.line + 5;
+            while (*value == ' ') value++;
+            // Обрезанный тег сервер не узнает - лучше не отправлять его вовсе
+            if (!req.etag.assign(value)) req.etag = "";
+        }
+    }
+
+    if (!serverClient.connected() && serverClient.available() == 0) {
+        finishServerRequest(HTTP_ERROR_CONNECTION_LOST);
+    }
+}
+
+void readServerResponseBody() {
+    ServerRequest& req = serverRequest;
+    char buffer[HTTP_IO_CHUNK];
+
+    switch (req.bodyMode) {
+    case HTTP_BODY_CHUNK_SIZE:
+        if (readServerResponseLine()) {
+            req.remaining = strtoul(req.line, nullptr, 16);
+            req.bodyMode = req.remaining > 0 ? HTTP_BODY_CHUNK_DATA : HTTP_BODY_CHUNK_TRAILER;
+        }
+        break;
+
+    case HTTP_BODY_CHUNK_END:
+        if (readServerResponseLine()) {
+            req.bodyMode = HTTP_BODY_CHUNK_SIZE;
+        }
+        break;
+
+    case HTTP_BODY_CHUNK_TRAILER:
+        if (readServerResponseLine() && req.line[0] == '\0') {
+            finishServerRequest(req.status);
+            return;
+        }
+        break;
+
+    default: {
+        int available = serverClient.available();
+        size_t chunk = min((size_t)max(available, 0), sizeof(buffer));
+        if (req.bodyMode != HTTP_BODY_UNTIL_CLOSE) chunk = min(chunk, (size_t)req.remaining);
+
+        if (chunk > 0) {
+            int got = serverClient.read((uint8_t*)buffer, chunk);
+            if (got > 0) {
+                scanServerResponse(buffer, got);
+                if (req.bodyMode != HTTP_BODY_UNTIL_CLOSE) req.remaining -= got;
+            }
+        }
+
+        if (req.bodyMode == HTTP_BODY_LENGTH && req.remaining == 0) {
+            finishServerRequest(req.status);
+            return;
+        }
+        if (req.bodyMode == HTTP_BODY_CHUNK_DATA && req.remaining == 0) {
+            req.bodyMode = HTTP_BODY_CHUNK_END;
+        }
+        if (req.bodyMode == HTTP_BODY_UNTIL_CLOSE && !serverClient.connected() && serverClient.available() == 0) {
+            finishServerRequest(req.status);
+            return;
+        }
+        break;
+    }
+    }
+
+    if (!serverClient.connected() && serverClient.available() == 0) {
+        finishServerRequest(HTTP_ERROR_CONNECTION_LOST);
+    }
+}
+
+void resetResponseScanner(ResponseScanner& scanner) {
+    memset(&scanner, 0, sizeof(scanner));
+}
+
+void scanServerResponse(const char* data, size_t length) {
+    ServerRequest& req = serverRequest;
+    ResponseScanner& scan = req.scanner;
+
+    for (size_t i = 0; i < length && !scan.invalid; i++) {
+        char c = data[i];
+
+        if (scan.inString) {
+            if (scan.escaped) scan.escaped = false;
+            else if (c == '\\') scan.escaped = true;
+            else if (c == '"') scan.inString = false;
+
+            if (scan.readingKey) {
+                if (!scan.inString) {
+                    scan.readingKey = false;
+                    scan.key[min(scan.keyLength, HTTP_KEY_MAX)] = '\0';
+                }
+                else if (scan.keyLength <= HTTP_KEY_MAX) {
+                    // Ключ длиннее HTTP_KEY_MAX заведомо не из RESPONSE_FIELDS
+                    if (scan.keyLength < HTTP_KEY_MAX) scan.key[scan.keyLength] = c;
+                    scan.keyLength++;
+                }
+            }
+            else if (scan.keeping) {
+                appendServerResponse(&c, 1);
+            }
+            continue;
+        }
+
+        if (isspace((unsigned char)c)) continue;
+
+        if (!scan.started) {
+            // Не объект - разбирать нечего, ответ будет отклонён как некорректный
+            scan.started = true;
+            if (c != '{') {
+                scan.invalid = true;
+                break;
+            }
+            scan.depth = 1;
+            scan.expectKey = true;
+            appendServerResponse("{", 1);
+            continue;
+        }
+        if (scan.depth == 0) continue;
+
+        if (scan.depth == 1 && scan.expectKey) {
+            if (c == '"') {
+                scan.inString = true;
+                scan.readingKey = true;
+                scan.keyLength = 0;
+            }
+            else if (c == ':') {
+                scan.expectKey = false;
+                scan.keeping = scan.keyLength <= HTTP_KEY_MAX && isResponseField(scan.key);
+                if (scan.keeping) {
+                    if (scan.members++ > 0) appendServerResponse(",", 1);
+                    appendServerResponse("\"", 1);
+                    appendServerResponse(scan.key, strlen(scan.key));
+                    appendServerResponse("\":", 2);
+                }
+            }
+            else if (c == '}') {
+                scan.depth = 0;
+                appendServerResponse("}", 1);
+            }
+            continue;
+        }
+
+        if (scan.depth == 1 && (c == ',' || c == '}')) {
+            scan.keeping = false;
+            scan.expectKey = true;
+            if (c == '}') {
+                scan.depth = 0;
+                appendServerResponse("}", 1);
+            }
+            continue;
+        }
+
+        if (c == '"') scan.inString = true;
+        else if (c == '{' || c == '[') scan.depth++;
+        else if (c == '}' || c == ']') scan.depth--;
+        if (scan.keeping) appendServerResponse(&c, 1);
+    }
+}
+
+void appendServerResponse(const char* data, size_t length) {
+    ServerRequest& req = serverRequest;
+    size_t room = RESPONSE_BODY_MAX - req.bodyLength;
+    if (length > room) {
+        req.bodyOverflow = true;
+        return;
+    }
+    memcpy(req.body + req.bodyLength, data, length);
+    req.bodyLength += length;
+}
+
+void lostServerConnection() {
+    ServerRequest& req = serverRequest;
+
+    // Сервер мог закрыть простаивавшее соединение - один раз переподключаемся заново
+    if (req.reused && !req.retried) {
+        Serial.println("Kept-alive connection dropped by server, reconnecting");
+        serverConnectionStats.droppedConnections++;
+        serverClient.stop();
+        req.reused = false;
+        req.retried = true;
+        req.outSent = 0;
+        setServerRequestPhase(HTTP_PHASE_DNS);
+        return;
+    }
+
+    finishServerRequest(HTTP_ERROR_CONNECTION_LOST);
+}
+
+void finishServerRequest(int httpCode) {
+    ServerRequest& req = serverRequest;
+
+    stopTask(serverRequestTaskId);
+    recordLatency(serverRequestLatency, micros() - req.startMicros);
+
+    if (httpCode < 0 || !req.keepAlive) {
+        serverClient.stop();
+    }
+
+    if (httpCode < 0) {
+        serverConnectionStats.failedConnections++;
+        // Без WiFi сервер не виноват - цепь не трогаем, очередь продолжит после переподключения
+        if (httpCode != HTTP_ERROR_NO_WIFI) retryFailed(RETRY_SERVER);
+    }
+    // 4xx - сервер жив и отвечает, считать это сбоем для размыкания цепи нельзя
+    else if (httpCode >= 500) retryFailed(RETRY_SERVER);
+    else retrySucceeded(RETRY_SERVER);
+
+    if (firstPostTime == 0) {
+        firstPostTime = millis();
+        Serial.printf("First POST completed %lu ms after boot\n", firstPostTime);
+    }
+
+    // Обрезанный ответ не разбираем: пустое тело отклоняется как некорректный JSON.
+    // Тело в req.body остаётся целым до чтения следующего ответа, даже если
+    // onServerResponse() сразу начнёт новый запрос
+    size_t bodyLength = req.bodyLength;
+    if (req.bodyOverflow || req.scanner.invalid) {
+        Serial.printf("Server response fields longer than %u bytes or not an object, ignored\n", (unsigned)RESPONSE_BODY_MAX);
+        bodyLength = 0;
+    }
+    req.phase = HTTP_PHASE_IDLE;
+
+    req.body[bodyLength] = '\0';
+    onServerResponse(req.kind, httpCode, req.body, bodyLength);
+    probeHeap(HEAP_SERVER);
+}
+
+void onServerResponse(ServerRequestKind kind, int httpCode, const char* body, size_t length) {
+    if (httpCode > 0) {
+        Serial.printf("HTTP Response code: %d\n", httpCode);
+    }
+    else {
+        Serial.printf("HTTP request failed: %s\n", httpErrorName(httpCode));
+    }
+
+    switch (kind) {
+    case SERVER_REQUEST_UPDATE:
+    case SERVER_REQUEST_HELLO:
+        if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_NOT_MODIFIED) {
+            applyServerResponse(httpCode, body, length);
+            break;
+        }
+
+        if (httpCode > 0) {
+            updateDisplay("Server error", "HTTP code: " + String(httpCode), "Will retry later");
+        }
+        else {
+            updateDisplay("Server error", httpErrorName(httpCode), "Will retry later");
+        }
+
+        if (kind == SERVER_REQUEST_UPDATE) {
+            enqueueTelemetrySample(serverRequest.sample);
+            pauseTelemetryDrain();
+        }
+        else if (POWER_PROFILE != POWER_PROFILE_DEEP_SLEEP) {
+            // Приветствие в очередь не попадает: без этого устройство молчало бы до следующего периода
+            scheduleTask(serverUpdateTaskId, retryWait(RETRY_SERVER));
+        }
+
+        if (POWER_PROFILE == POWER_PROFILE_DEEP_SLEEP) {
+            // Повтор - в следующем пробуждении: замер уйдёт во флеш, сон продлится на паузу политики повторов
+            scheduleTask(powerSleepTaskId, POWER_SLEEP_GRACE);
+        }
+        break;
+
+    case SERVER_REQUEST_QUEUED:
+        if (httpCode != HTTP_CODE_OK) {
+            Serial.printf("Queued sample rejected: %d\n", httpCode);
+            pauseTelemetryDrain();
+            break;
+        }
+
+        popTelemetrySamples(1);
+        telemetryStats.drained++;
+
+        if (telemetryQueueLength() == 0) {
+            Serial.println("Telemetry queue drained");
+            stopTelemetryDrain();
+        }
+        break;
+
+    case SERVER_REQUEST_BATCH:
+        if (httpCode != HTTP_CODE_OK && httpCode != HTTP_CODE_NOT_MODIFIED) {
+            Serial.printf("Batch rejected: %d\n", httpCode);
+            pauseTelemetryDrain();
+            break;
+        }
+
+        popTelemetrySamples(serverRequest.batchCount);
+        telemetryStats.batches++;
+        telemetryStats.batchedSamples += serverRequest.batchCount;
+        applyServerResponse(httpCode, body, length);
+        break;
+    }
+}
+
+bool resolvePushUrl() {
+    PushChannel& push = pushChannel;
+
+    // По умолчанию тот же адрес, что у SERVER_URL: сервер принимает Upgrade на нём же
+    String url = PUSH_URL;
+    if (url.length() == 0 && SERVER_URL.startsWith("https://")) {
+        url = "wss://" + SERVER_URL.substring(8);
+    }
+
+    push.secure = url.startsWith("wss://");
+    bool parsed = push.secure
+        ? parseUrl(url.c_str(), "wss://", 443, push.host, push.path, push.port)
+        : parseUrl(url.c_str(), "ws://", 80, push.host, push.path, push.port);
+    if (!parsed) {
+        Serial.println("Push: unsupported URL: " + url);
+    }
+    return parsed;
+}
+
+void startPushChannel() {
+    if (!PUSH_ENABLED || POWER_PROFILE == POWER_PROFILE_DEEP_SLEEP) return;
+    scheduleTask(pushTaskId, 0);
+}
+
+void servicePushChannel() {
+    PushChannel& push = pushChannel;
+
+    if (isAccessPointMode || WiFi.status() != WL_CONNECTED) {
+        closePushChannel();
+        stopTask(pushTaskId);
+        return;
+    }
+
+    switch (push.state) {
+    case PUSH_IDLE:
+        if (!retryReady(RETRY_PUSH)) return;
+        if (!resolvePushUrl()) {
+            stopTask(pushTaskId);
+            return;
+        }
+        push.client = push.secure ? &pushSecureClient : &pushPlainClient;
+        push.state = push.secure && push.mflnHost != push.host ? PUSH_PROBING : PUSH_CONNECTING;
+        push.stateSince = millis();
+        break;
+
+    // Проверка MFLN и подключение блокируют цикл (DNS до HTTP_DNS_TIMEOUT, рукопожатие до
+    // HTTP_CONNECT_TIMEOUT + HTTP_TLS_TIMEOUT): асинхронного connect() у BearSSL нет. Поэтому
+    // это разные вызовы задачи, не во время запроса к серверу, а частоту попыток ограничивает
+    // политика повторов "push"
+    case PUSH_PROBING:
+        if (serverRequestActive()) return;
+
+        // Второй TLS-клиент с буферами по 16 КБ куча не вместит: без коротких записей остаёмся на опросе
+        pushSecureClient.setInsecure();
+        if (!pushSecureClient.probeMaxFragmentLength(push.host, push.port, PUSH_TLS_BUFFER)) {
+            Serial.println("Push: server does not support MFLN, staying on polling");
+            push.state = PUSH_IDLE;
+            retryTrip(RETRY_PUSH);
+            return;
+        }
+        push.mflnHost = push.host;
+        push.state = PUSH_CONNECTING;
+        push.stateSince = millis();
+        break;
+
+    case PUSH_CONNECTING: {
+        if (serverRequestActive()) return;
+
+        if (push.secure) {
+            pushSecureClient.setInsecure();
+            pushSecureClient.setBufferSizes(PUSH_TLS_BUFFER, PUSH_TLS_BUFFER);
+        }
+
+        push.client->setTimeout(HTTP_CONNECT_TIMEOUT + HTTP_TLS_TIMEOUT);
+        if (!push.client->connect(push.host, push.port)) {
+            // Сервер мог перестать поддерживать MFLN - перед следующей попыткой проверим заново
+            push.mflnHost = "";
+            dropPushChannel("connect failed");
+            return;
+        }
+
+        uint8_t nonce[16];
+        for (size_t i = 0; i < sizeof(nonce); i++) nonce[i] = random(256);
+        char key[25];
+        encodeBase64(nonce, sizeof(nonce), key);
+
+        char request[HTTP_HOST_MAX + HTTP_PATH_MAX + 200];
+        int length = snprintf(request, sizeof(request),
+            "GET %s HTTP/1.1\r\nHost: %s\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+            "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n",
+            push.path, push.host, key);
+        push.client->write((const uint8_t*)request, length);
+
+        push.status = 0;
+        push.lineLength = 0;
+        push.state = PUSH_HANDSHAKE;
+        push.stateSince = millis();
+        probeHeap(HEAP_SERVER);
+        break;
+    }
+
+    case PUSH_HANDSHAKE:
+        while (readPushLine()) {
+            if (push.status == 0) {
+                if (sscanf(push.line, "HTTP/%*d.%*d %d", &push.status) != 1 || push.status != 101) {
+                    Serial.printf("Push: upgrade refused: %s\n", push.line);
+                    dropPushChannel("upgrade refused");
+                    return;
+                }
+                continue;
+            }
+
+            if (push.line[0] == '\0') {
+                openPushChannel();
+                return;
+            }
+        }
+
+        if (millis() - push.stateSince > HTTP_FIRST_BYTE_TIMEOUT) {
+            dropPushChannel("handshake timeout");
+        }
+        else if (!push.client->connected() && push.client->available() == 0) {
+            dropPushChannel("connection closed");
+        }
+        break;
+
+    case PUSH_OPEN:
+        readPushFrames();
+        if (push.state != PUSH_OPEN) return;
+
+        if (millis() - push.lastReceive > PUSH_IDLE_TIMEOUT) {
+            dropPushChannel("idle timeout");
+        }
+        else if (!push.client->connected() && push.client->available() == 0) {
+            dropPushChannel("connection closed");
+        }
+        else if (millis() - push.lastPing >= PUSH_PING_INTERVAL) {
+            sendPushFrame(WS_OPCODE_PING, nullptr, 0);
+            push.lastPing = millis();
+        }
+        break;
+    }
+}
+
+void openPushChannel() {
+    PushChannel& push = pushChannel;
+
+    push.state = PUSH_OPEN;
+    push.stateSince = millis();
+    push.lastReceive = push.stateSince;
+    push.lastPing = push.stateSince;
+    push.headerLength = 0;
+    push.remaining = 0;
+    push.inPayload = false;
+    push.messageLength = 0;
+    push.connects++;
+    retrySucceeded(RETRY_PUSH);
+
+    char subscribe[PUSH_SEND_MAX];
+    StaticJsonDocument<256> doc;
+    doc["type"] = "subscribe";
+    doc["boardID"] = deviceData.boardID.c_str();
+    doc["token"] = deviceData.token.c_str();
+    size_t length = serializeJson(doc, subscribe, sizeof(subscribe));
+    sendPushFrame(WS_OPCODE_TEXT, (const uint8_t*)subscribe, length);
+
+    Serial.printf("Push: connected to %s%s:%u%s\n", push.secure ? "wss://" : "ws://", push.host, push.port, push.path);
+}
+
+void closePushChannel() {
+    PushChannel& push = pushChannel;
+    if (push.state == PUSH_IDLE) return;
+
+    if (push.state == PUSH_OPEN) {
+        sendPushFrame(WS_OPCODE_CLOSE, nullptr, 0);
+    }
+    push.client->stop();
+    push.state = PUSH_IDLE;
+}
+
+void dropPushChannel(const char* reason) {
+    PushChannel& push = pushChannel;
+
+    push.client->stop();
+    push.state = PUSH_IDLE;
+    push.drops++;
+
+    unsigned long retryIn = retryFailed(RETRY_PUSH);
+    Serial.printf("Push: %s, reconnecting in %lu ms\n", reason, retryIn);
+}
+
+bool readPushLine() {
+    PushChannel& push = pushChannel;
+
+    for (size_t budget = HTTP_IO_CHUNK; budget > 0 && push.client->available() > 0; budget--) {
+        int c = push.client->read();
+        if (c < 0) break;
+
+        if (c == '\n') {
+            if (push.lineLength > 0 && push.line[push.lineLength - 1] == '\r') push.lineLength--;
+            push.line[push.lineLength] = '\0';
+            push.lineLength = 0;
+            return true;
+        }
+        if (push.lineLength < HTTP_LINE_MAX) {
+            push.line[push.lineLength++] = (char)c;
+        }
+    }
+    return false;
+}
+
+void readPushFrames() {
+    PushChannel& push = pushChannel;
+    uint8_t buffer[HTTP_IO_CHUNK];
+
+    for (int budget = 4; budget > 0 && push.state == PUSH_OPEN; budget--) {
+        if (!push.inPayload) {
+            while (push.headerLength < pushFrameHeaderSize()) {
+                if (push.client->available() <= 0) return;
+                push.header[push.headerLength++] = push.client->read();
+            }
+
+            push.lastReceive = millis();
+            push.opcode = push.header[0] & 0x0F;
+            push.final = (push.header[0] & 0x80) != 0;
+
+            uint8_t length7 = push.header[1] & 0x7F;
+            size_t offset = 2;
+            uint64_t length = length7;
+            if (length7 == 126) {
+                length = ((uint16_t)push.header[2] << 8) | push.header[3];
+                offset = 4;
+            }
+            else if (length7 == 127) {
+                length = 0;
+                for (int i = 0; i < 8; i++) length = (length << 8) | push.header[2 + i];
+                offset = 10;
+            }
+
+            push.masked = (push.header[1] & 0x80) != 0;
+            if (push.masked) memcpy(push.mask, push.header + offset, 4);
+
+            push.headerLength = 0;
+            push.remaining = length > UINT32_MAX ? UINT32_MAX : (uint32_t)length;
+            push.payloadOffset = 0;
+            push.controlLength = 0;
+            push.inPayload = true;
+
+            if (push.opcode == WS_OPCODE_TEXT || push.opcode == WS_OPCODE_BINARY) {
+                push.messageOpcode = push.opcode;
+                push.messageLength = 0;
+                push.messageOverflow = false;
+            }
+        }
+
+        if (push.remaining > 0) {
+            int available = push.client->available();
+            size_t chunk = min((size_t)max(available, 0), min(sizeof(buffer), (size_t)push.remaining));
+            if (chunk == 0) return;
+
+            int got = push.client->read(buffer, chunk);
+            if (got <= 0) return;
+
+            for (int i = 0; i < got; i++) {
+                uint8_t value = push.masked ? buffer[i] ^ push.mask[(push.payloadOffset + i) & 3] : buffer[i];
+                if (push.opcode >= WS_OPCODE_CLOSE) {
+                    if (push.controlLength < sizeof(push.control)) push.control[push.controlLength++] = value;
+                }
+                else if (push.messageLength < PUSH_MESSAGE_MAX) {
+                    push.message[push.messageLength++] = (char)value;
+                }
+                else {
+                    push.messageOverflow = true;
+                }
+            }
+            push.payloadOffset += got;
+            push.remaining -= got;
+            push.lastReceive = millis();
+            if (push.remaining > 0) continue;
+        }
+
+        push.inPayload = false;
+        handlePushFrame();
+    }
+}
+
+size_t pushFrameHeaderSize() {
+    // 2 байта, затем расширенная длина и маска, если они есть
+    const PushChannel& push = pushChannel;
+    if (push.headerLength < 2) return 2;
+
+    uint8_t length7 = push.header[1] & 0x7F;
+    return 2 + (length7 == 126 ? 2 : length7 == 127 ? 8 : 0) + ((push.header[1] & 0x80) ? 4 : 0);
+}
+
+void handlePushFrame() {
+    PushChannel& push = pushChannel;
+
+    switch (push.opcode) {
+    case WS_OPCODE_CLOSE:
+        sendPushFrame(WS_OPCODE_CLOSE, push.control, min(push.controlLength, (size_t)2));
+        dropPushChannel("closed by server");
+        return;
+
+    case WS_OPCODE_PING:
+        sendPushFrame(WS_OPCODE_PONG, push.control, push.controlLength);
+        return;
+
+    case WS_OPCODE_PONG:
+        return;
+
+    default:
+        break;
+    }
+
+    if (!push.final) return;
+
+    if (push.messageOverflow) {
+        Serial.printf("Push: message longer than %u bytes dropped\n", (unsigned)PUSH_MESSAGE_MAX);
+    }
+    else if (push.messageOpcode == WS_OPCODE_TEXT) {
+        onPushMessage(push.message, push.messageLength);
+    }
+    push.messageLength = 0;
+}
+
+bool sendPushFrame(uint8_t opcode, const uint8_t* data, size_t length) {
+    PushChannel& push = pushChannel;
+    uint8_t frame[8 + PUSH_SEND_MAX];
+    if (length > PUSH_SEND_MAX) return false;
+
+    // Кадры от клиента обязаны быть замаскированы (RFC 6455, 5.3)
+    size_t offset = 0;
+    frame[offset++] = 0x80 | opcode;
+    if (length < 126) {
+        frame[offset++] = 0x80 | length;
+    }
+    else {
+        frame[offset++] = 0x80 | 126;
+        frame[offset++] = length >> 8;
+        frame[offset++] = length & 0xFF;
+    }
+
+    uint8_t* mask = frame + offset;
+    for (int i = 0; i < 4; i++) mask[i] = random(256);
+    offset += 4;
+
+    for (size_t i = 0; i < length; i++) {
+        frame[offset++] = data[i] ^ mask[i & 3];
+    }
+
+    return push.client->write(frame, offset) == offset;
+}
+
+void onPushMessage(const char* message, size_t length) {
+    StaticJsonDocument<256> filter;
+    buildResponseFilter(filter);
+
+    JsonDocument& doc = serverResponseDoc;
+    DeserializationError error = deserializeJson(doc, message, length, DeserializationOption::Filter(filter));
+    if (error) {
+        Serial.print("Push: JSON parsing failed: ");
+        Serial.println(error.c_str());
+        return;
+    }
+
+    pushChannel.messages++;
+    Serial.print("Push: ");
+    serializeJson(doc, Serial);
+    Serial.println();
+
+    unsigned long previousUptime = deviceData.uptime;
+    applyServerFields(doc);
+
+    // Значения пришли от сервера - не отправляем их обратно в следующей дельте
+    if (doc.containsKey("user")) ackedDeviceData.user = deviceData.user;
+    if (doc.containsKey("text")) ackedDeviceData.text = deviceData.text;
+    if (doc.containsKey("status")) ackedDeviceData.status = deviceData.status;
+    if (doc.containsKey("uptime")) ackedDeviceData.uptime = deviceData.uptime;
+    if (doc.containsKey("serverUrl")) ackedDeviceData.serverUrl = deviceData.serverUrl;
+
+    if (doc["resync"].as<bool>()) {
+        resyncRequested = true;
+    }
+
+    // Изменение уже у нас - следующий опрос может получить 304
+    storeServerRev(doc["rev"]);
+    serverEtag = "";
+
+    if (deviceData.uptime != previousUptime) {
+        scheduleTask(serverUpdateTaskId, deviceData.uptime);
+    }
+}
+
+void encodeBase64(const uint8_t* in, size_t length, char* out) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    size_t o = 0;
+    for (size_t i = 0; i < length; i += 3) {
+        uint32_t block = (uint32_t)in[i] << 16;
+        if (i + 1 < length) block |= (uint32_t)in[i + 1] << 8;
+        if (i + 2 < length) block |= in[i + 2];
+
+        out[o++] = alphabet[(block >> 18) & 0x3F];
+        out[o++] = alphabet[(block >> 12) & 0x3F];
+        out[o++] = i + 1 < length ? alphabet[(block >> 6) & 0x3F] : '=';
+        out[o++] = i + 2 < length ? alphabet[block & 0x3F] : '=';
+    }
+    out[o] = '\0';
+}
+
+const char* httpErrorName(int httpCode) {
+    switch (httpCode) {
+    case HTTP_ERROR_TIMEOUT: return "Timeout";
+    case HTTP_ERROR_CONNECTION_LOST: return "Connection lost";
+    case HTTP_ERROR_DNS: return "DNS lookup failed";
+    case HTTP_ERROR_CONNECT: return "Connection failed";
+    case HTTP_ERROR_BAD_RESPONSE: return "Bad response";
+    case HTTP_ERROR_NO_WIFI: return "WiFi not connected";
+    default: return "Unknown error";
+    }
+}
+
+
+void captureTelemetrySample(TelemetrySample& sample) {
+    sample.time = millis();
+    sample.timer = deviceData.timer;
+    sample.batteryMv = batteryMonitor.voltage * 1000;
+    sample.rssi = WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0;
+    sample.flags = 0;
+    strncpy(sample.status, deviceData.status.c_str(), sizeof(sample.status) - 1);
+    sample.status[sizeof(sample.status) - 1] = '\0';
+}
+
+int telemetryQueueLength() {
+    return telemetrySpillPending + telemetryRingCount;
+}
+
+void enqueueTelemetrySample(const TelemetrySample& sample) {
+    if (!TELEMETRY_QUEUE_ENABLED) return;
+
+    if (telemetryRingCount == TELEMETRY_RAM_SAMPLES) {
+        spillTelemetrySamples(1);
+    }
+
+    telemetryRing[(telemetryRingHead + telemetryRingCount) % TELEMETRY_RAM_SAMPLES] = sample;
+    telemetryRingCount++;
+    telemetryStats.queued++;
+
+    Serial.printf("Telemetry queued, %d pending\n", telemetryQueueLength());
+}
+
+// Переносит count самых старых замеров из кольца в RAM в конец файла; что не влезло, теряется
+void spillTelemetrySamples(int count) {
+    count = min(count, telemetryRingCount);
+    if (count == 0) return;
+
+    File file = LittleFS.open(TELEMETRY_SPILL_PATH, "a");
+    if (file && file.size() == 0) {
+        uint32_t readOffset = sizeof(uint32_t);
+        file.write((const uint8_t*)&readOffset, sizeof(readOffset));
+        telemetrySpillReadOffset = readOffset;
+        telemetrySpillSize = sizeof(readOffset);
+    }
+
+    for (int i = 0; i < count; i++) {
+        const TelemetrySample& sample = telemetryRing[telemetryRingHead];
+        telemetryRingHead = (telemetryRingHead + 1) % TELEMETRY_RAM_SAMPLES;
+        telemetryRingCount--;
+
+        if (!file || telemetrySpillSize + sizeof(sample) > TELEMETRY_SPILL_MAX_BYTES ||
+            file.write((const uint8_t*)&sample, sizeof(sample)) != sizeof(sample)) {
+            telemetryStats.dropped++;
+            continue;
+        }
+
+        telemetrySpillSize += sizeof(sample);
+        telemetrySpillPending++;
+        telemetryStats.spilled++;
+    }
+
+    if (file) file.close();
+}
+
+void indexTelemetrySpill() {
+    telemetrySpillSize = 0;
+    telemetrySpillReadOffset = 0;
+    telemetrySpillPending = 0;
+
+    File file = LittleFS.open(TELEMETRY_SPILL_PATH, "r");
+    if (!file) return;
+
+    size_t fileSize = file.size();
+    uint32_t readOffset = 0;
+    bool valid = file.read((uint8_t*)&readOffset, sizeof(readOffset)) == sizeof(readOffset) &&
+        readOffset >= sizeof(readOffset) && readOffset <= fileSize &&
+        (fileSize - sizeof(readOffset)) % sizeof(TelemetrySample) == 0 &&
+        (readOffset - sizeof(readOffset)) % sizeof(TelemetrySample) == 0;
+    file.close();
+
+    if (!valid || readOffset == fileSize) {
+        if (!valid) Serial.println("Telemetry spill file corrupt, discarding");
+        LittleFS.remove(TELEMETRY_SPILL_PATH);
+        return;
+    }
+
+    telemetrySpillSize = fileSize;
+    telemetrySpillReadOffset = readOffset;
+    telemetrySpillPending = (fileSize - readOffset) / sizeof(TelemetrySample);
+    Serial.printf("Telemetry: %d samples waiting on flash\n", telemetrySpillPending);
+}
+
+int peekTelemetrySamples(TelemetrySample* samples, int maxCount) {
+    int count = 0;
+
+    if (telemetrySpillPending > 0) {
+        int fromFlash = min(telemetrySpillPending, maxCount);
+        File file = LittleFS.open(TELEMETRY_SPILL_PATH, "r");
+        if (file && file.seek(telemetrySpillReadOffset) &&
+            file.read((uint8_t*)samples, fromFlash * sizeof(TelemetrySample)) == fromFlash * sizeof(TelemetrySample)) {
+            file.close();
+            count = fromFlash;
+        }
+        else {
+            Serial.println("Telemetry spill read failed, discarding");
+            if (file) file.close();
+            telemetryStats.dropped += telemetrySpillPending;
+            LittleFS.remove(TELEMETRY_SPILL_PATH);
+            telemetrySpillPending = 0;
+            telemetrySpillSize = 0;
+        }
+    }
+
+    for (int i = 0; i < telemetryRingCount && count < maxCount; i++) {
+        samples[count++] = telemetryRing[(telemetryRingHead + i) % TELEMETRY_RAM_SAMPLES];
+    }
+
+    return count;
+}
+
+void popTelemetrySamples(int count) {
+    if (telemetrySpillPending > 0) {
+        int fromFlash = min(telemetrySpillPending, count);
+        telemetrySpillPending -= fromFlash;
+        telemetrySpillReadOffset += fromFlash * sizeof(TelemetrySample);
+        count -= fromFlash;
+
+        // Смещение во флеш пишется один раз по окончании выгрузки (saveTelemetrySpillOffset);
+        // при потере питания посреди выгрузки часть замеров уйдёт на сервер повторно
+        if (telemetrySpillPending == 0) {
+            LittleFS.remove(TELEMETRY_SPILL_PATH);
+            telemetrySpillSize = 0;
+            telemetrySpillOffsetDirty = false;
+        }
+        else {
+            telemetrySpillOffsetDirty = true;
+        }
+    }
+
+    count = min(count, telemetryRingCount);
+    telemetryRingHead = (telemetryRingHead + count) % TELEMETRY_RAM_SAMPLES;
+    telemetryRingCount -= count;
+}
+
+void drainTelemetryQueue() {
+    if (isAccessPointMode || WiFi.status() != WL_CONNECTED) {
+        stopTelemetryDrain();
+        return;
+    }
+
+    // Запрос ещё идёт - результат обработает onServerResponse()
+    if (serverRequestActive()) return;
+
+    if (!retryReady(RETRY_SERVER)) {
+        scheduleTask(telemetryDrainTaskId, retryWait(RETRY_SERVER));
+        return;
+    }
+
+    if (TELEMETRY_BATCH_ENABLED) {
+        if (!telemetryBatchDue()) {
+            stopTelemetryDrain();
+        }
+        else if (!sendTelemetryBatch()) {
+            pauseTelemetryDrain();
+        }
+        return;
+    }
+
+    TelemetrySample sample;
+    if (peekTelemetrySamples(&sample, 1) == 0) {
+        stopTelemetryDrain();
+        return;
+    }
+
+    if (!sendQueuedSample(sample)) {
+        pauseTelemetryDrain();
+    }
+}
+
+void stopTelemetryDrain() {
+    saveTelemetrySpillOffset();
+    stopTask(telemetryDrainTaskId);
+}
+
+void saveTelemetrySpillOffset() {
+    if (!telemetrySpillOffsetDirty) return;
+    telemetrySpillOffsetDirty = false;
+
+    File file = LittleFS.open(TELEMETRY_SPILL_PATH, "r+");
+    if (file) {
+        file.write((const uint8_t*)&telemetrySpillReadOffset, sizeof(telemetrySpillReadOffset));
+        file.close();
+    }
+}
+
+void pauseTelemetryDrain() {
+    saveTelemetrySpillOffset();
+
+    // Сетевой сбой - следующую попытку назначает политика повторов; иначе ждём удачного обновления
+    unsigned long retryIn = retryWait(RETRY_SERVER);
+    if (retryIn == 0) {
+        Serial.println("Telemetry drain paused");
+        stopTelemetryDrain();
+        return;
+    }
+
+    Serial.printf("Telemetry drain paused for %lu ms\n", retryIn);
+    scheduleTask(telemetryDrainTaskId, retryIn);
+}
+
+bool sendQueuedSample(const TelemetrySample& sample) {
+    StaticJsonDocument<REQUEST_DOC_SIZE> doc;
+    doc["boardID"] = deviceData.boardID.c_str();
+    doc["token"] = deviceData.token.c_str();
+    doc["seq"] = ++telemetrySequence;
+    doc["queued"] = true;
+    doc["age"] = millis() - sample.time;
+    doc["time"] = sample.time;
+    doc["timer"] = sample.timer;
+    doc["battery"] = sample.batteryMv;
+    doc["rssi"] = sample.rssi;
+    doc["status"] = (const char*)sample.status;
+
+    char* payload = requestPayloadBuffer();
+    size_t payloadLength = serializeJson(doc, payload, REQUEST_PAYLOAD_SIZE);
+    if (!startServerRequest(SERVER_REQUEST_QUEUED, payload, payloadLength)) {
+        return false;
+    }
+
+    serverConnectionStats.payloadBytes += payloadLength;
+    return true;
+}
+
+bool telemetryBatchDue() {
+    if (telemetryQueueLength() >= TELEMETRY_BATCH_SIZE) return true;
+
+    TelemetrySample oldest;
+    return peekTelemetrySamples(&oldest, 1) > 0 && millis() - oldest.time >= TELEMETRY_BATCH_WINDOW;
+}
+
+bool sendTelemetryBatch() {
+    TelemetrySample batch[TELEMETRY_BATCH_SIZE];
+    int count = peekTelemetrySamples(batch, TELEMETRY_BATCH_SIZE);
+    if (count == 0) return true;
+
+    bool fullSync = !DELTA_TELEMETRY_ENABLED || !deviceDataAcked || resyncRequested;
+
+    StaticJsonDocument<BATCH_DOC_SIZE> doc;
+    addDeviceFields(doc, fullSync);
+    doc["time"] = millis();
+
+    // Поля устройства у предела длины могут не оставить места под весь пакет - остаток уйдёт следующим
+    JsonArray samples = doc.createNestedArray("samples");
+    int fits = (int)((REQUEST_PAYLOAD_SIZE - 1 - measureJson(doc)) / BATCH_SAMPLE_MAX);
+    if (fits < count) {
+        Serial.printf("Batch trimmed to %d samples to fit the request\n", fits);
+        count = fits;
+    }
+    Serial.printf("Sending batch of %d samples to server\n", count);
+
+    for (int i = 0; i < count; i++) {
+        JsonObject item = samples.createNestedObject();
+        item["age"] = millis() - batch[i].time;
+        item["time"] = batch[i].time;
+        item["timer"] = batch[i].timer;
+        item["battery"] = batch[i].batteryMv;
+        item["rssi"] = batch[i].rssi;
+        item["status"] = (const char*)batch[i].status;
+    }
+
+    char* payload = requestPayloadBuffer();
+    size_t payloadLength = serializeJson(doc, payload, REQUEST_PAYLOAD_SIZE);
+    probeHeap(HEAP_SERVER);
+    if (doc.overflowed() || payloadLength >= REQUEST_PAYLOAD_SIZE - 1) {
+        Serial.println("Batch payload too large");
+        return false;
+    }
+
+    if (!startServerRequest(SERVER_REQUEST_BATCH, payload, payloadLength)) {
+        return false;
+    }
+    serverRequest.batchCount = count;
+
+    if (fullSync) serverConnectionStats.fullUpdates++;
+    else serverConnectionStats.deltaUpdates++;
+    serverConnectionStats.payloadBytes += payloadLength;
+    return true;
+}
+
+String getWiFiSignalStrength() {
+    if (WiFi.status() != WL_CONNECTED) {
+        return "Not connected";
+    }
+
+    int rssi = WiFi.RSSI();
+    String bars = "";
+
+    if (rssi > -55) bars = "●●●●";
+    else if (rssi > -65) bars = "●●●○";
+    else if (rssi > -75) bars = "●●○○";
+    else if (rssi > -85) bars = "●○○○";
+    else bars = "○○○○";
+
+    return bars + " " + String(rssi) + " dBm";
+}
+
+String getMacAddress() {
+    byte mac[6];
+    WiFi.macAddress(mac);
+    char macStr[18] = { 0 };
+    sprintf(macStr, "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    return String(macStr);
+}
+
+void loadDeviceData() {
+    if (!journalIndexed) {
+        indexJournal();
+    }
+
+    if (!journalRecordLoaded[JOURNAL_DEVICE_DATA] && !loadLegacyRecord(JOURNAL_DEVICE_DATA, "/device.json")) {
+        Serial.println("No device data found");
+        return;
+    }
+
+    Serial.println("Device data loaded:");
+    Serial.printf("- Board ID: %s\n", deviceData.boardID.c_str());
+    Serial.println("- Uptime: " + String(deviceData.uptime));
+    Serial.printf("- Text: %s\n", deviceData.text.c_str());
+    Serial.printf("- Status: %s\n", deviceData.status.c_str());
+    Serial.printf("- Server URL: %s\n", deviceData.serverUrl.c_str());
+}
+
+void saveDeviceData() {
+    if (appendJournalRecord(JOURNAL_DEVICE_DATA)) {
+        Serial.println("Device data saved");
+    }
+}
+
+void loadWiFiCredentials() {
+    if (!journalIndexed) {
+        indexJournal();
+    }
+
+    if (!journalRecordLoaded[JOURNAL_WIFI_CREDENTIALS] && !loadLegacyRecord(JOURNAL_WIFI_CREDENTIALS, "/wifi.json")) {
+        Serial.println("No WiFi credentials found");
+        wifiCreds.ssid = "";
+        wifiCreds.password = "";
+        wifiCreds.connected = false;
+        return;
+    }
+
+    if (wifiCreds.ssid.length() == 0) {
+        Serial.println("No WiFi credentials found");
+        return;
+    }
+
+    Serial.printf("WiFi credentials loaded: %s\n", wifiCreds.ssid.c_str());
+    Serial.println("Connection status: " + String(wifiCreds.connected ? "Connected" : "Not connected"));
+}
+
+void saveWiFiCredentials(const char* ssid, const char* password) {
+    if (wifiCreds.ssid != ssid || wifiCreds.password != password) {
+        wifiCreds.hintsValid = false;
+    }
+
+    wifiCreds.ssid = ssid;
+    wifiCreds.password = password;
+
+    if (appendJournalRecord(JOURNAL_WIFI_CREDENTIALS)) {
+        Serial.printf("WiFi credentials saved: %s\n", wifiCreds.ssid.c_str());
+    }
+}
+
+bool loadLegacyRecord(uint8_t type, const char* path) {
+    if (!LittleFS.exists(path)) {
+        return false;
+    }
+
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        Serial.printf("Failed to open %s\n", path);
+        return false;
+    }
+
+    size_t size = file.size();
+    std::unique_ptr<uint8_t[]> buf(new uint8_t[size]);
+    file.read(buf.get(), size);
+    file.close();
+    probeHeap(HEAP_STORAGE);
+
+    if (!decodeJsonRecord(type, buf.get(), size)) {
+        return false;
+    }
+
+    Serial.printf("Migrating %s to journal\n", path);
+    journalMigrationPending = true;
+    return true;
+}
+
+bool decodeJsonRecord(uint8_t type, const uint8_t* data, size_t length) {
+    DynamicJsonDocument doc(1024);
+    DeserializationError error = deserializeJson(doc, (const char*)data, length);
+
+    if (error) {
+        Serial.print("JSON parsing failed: ");
+        Serial.println(error.c_str());
+        return false;
+    }
+
+    if (type == JOURNAL_DEVICE_DATA) {
+        deviceData.boardID = doc["boardID"].as<const char*>();
+        deviceData.token = doc["token"].as<const char*>();
+        deviceData.timer = doc["timer"];
+        deviceData.uptime = doc["uptime"];
+        deviceData.text = doc["text"].as<const char*>();
+        deviceData.status = doc["status"].as<const char*>();
+        deviceData.user = doc["user"].as<const char*>();
+
+        if (doc.containsKey("serverUrl")) {
+            deviceData.serverUrl = doc["serverUrl"].as<const char*>();
+        }
+    }
+    else {
+        wifiCreds.ssid = "";
+        wifiCreds.password = "";
+        wifiCreds.connected = false;
+        wifiCreds.hintsValid = false;
+
+        if (doc.containsKey("ssid")) {
+            wifiCreds.ssid = doc["ssid"].as<const char*>();
+            wifiCreds.password = doc["password"].as<const char*>();
+            wifiCreds.connected = doc["connected"].as<bool>();
+        }
+    }
+
+    return true;
+}
+
+bool decodeBinaryRecord(uint8_t type, const uint8_t* data, size_t length) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + length;
+
+    uint8_t version = length > 0 ? *p++ : 0;
+    if (version < 1 || version > RECORD_FORMAT_VERSION) {
+        Serial.println("Unknown record format");
+        return false;
+    }
+
+    if (type == JOURNAL_DEVICE_DATA) {
+        DeviceData loaded;
+        loaded.timer = 0;
+
+        if (!readRecordString(p, end, loaded.boardID) ||
+            !readRecordString(p, end, loaded.token) ||
+            !readRecordU32(p, end, loaded.uptime) ||
+            !readRecordString(p, end, loaded.text) ||
+            !readRecordString(p, end, loaded.status) ||
+            !readRecordString(p, end, loaded.user) ||
+            !readRecordString(p, end, loaded.serverUrl)) {
+            return false;
+        }
+
+        deviceData = loaded;
+    }
+    else {
+        WiFiCredentials loaded;
+        unsigned long connected = 0;
+
+        if (!readRecordString(p, end, loaded.ssid) ||
+            !readRecordString(p, end, loaded.password) ||
+            !readRecordU32(p, end, connected)) {
+            return false;
+        }
+
+        loaded.connected = connected != 0;
+        loaded.hintsValid = false;
+
+        if (version >= 2) {
+            unsigned long hintsValid, channel;
+
+            if (!readRecordU32(p, end, hintsValid) ||
+                !readRecordBytes(p, end, loaded.bssid, sizeof(loaded.bssid)) ||
+                !readRecordU32(p, end, channel)) {
+                return false;
+            }
+
+            loaded.hintsValid = hintsValid != 0;
+            loaded.channel = channel;
+        }
+
+        // Версия 2 хранила ещё статический адрес, шлюз, маску и DNS - теперь адрес берётся по DHCP
+        if (version == 2) {
+            unsigned long unused;
+            for (int i = 0; i < 4; i++) {
+                if (!readRecordU32(p, end, unused)) return false;
+            }
+        }
+
+        wifiCreds = loaded;
+    }
+
+    return true;
+}
+
+template <size_t N>
+bool readRecordString(const uint8_t*& p, const uint8_t* end, FixedString<N>& value) {
+    if (end - p < 2) return false;
+
+    uint16_t length = p[0] | (p[1] << 8);
+    p += 2;
+    if (end - p < length) return false;
+
+    value.assign((const char*)p, length);
+    p += length;
+    return true;
+}
+
+bool readRecordU32(const uint8_t*& p, const uint8_t* end, unsigned long& value) {
+    if (end - p < 4) return false;
+
+    value = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    p += 4;
+    return true;
+}
+
+bool readRecordBytes(const uint8_t*& p, const uint8_t* end, uint8_t* value, size_t length) {
+    if ((size_t)(end - p) < length) return false;
+
+    memcpy(value, p, length);
+    p += length;
+    return true;
+}
+
+template <size_t N>
+void writeRecordString(uint8_t*& p, const FixedString<N>& value) {
+    uint16_t length = value.length();
+    *p++ = length & 0xFF;
+    *p++ = length >> 8;
+    memcpy(p, value.c_str(), length);
+    p += length;
+}
+
+void writeRecordU32(uint8_t*& p, uint32_t value) {
+    *p++ = value & 0xFF;
+    *p++ = (value >> 8) & 0xFF;
+    *p++ = (value >> 16) & 0xFF;
+    *p++ = value >> 24;
+}
+
+void indexJournal() {
+    journalIndexed = true;
+
+    if (!LittleFS.exists(JOURNAL_PATH) && LittleFS.exists(JOURNAL_COMPACT_PATH)) {
+        LittleFS.rename(JOURNAL_COMPACT_PATH, JOURNAL_PATH);
+    }
+
+    File file = LittleFS.open(JOURNAL_PATH, "r");
+    if (!file) return;
+
+    size_t fileSize = file.size();
+    size_t readSize = min(fileSize, JOURNAL_MAX_SIZE);
+
+    std::unique_ptr<uint8_t[]> buf(new uint8_t[readSize]);
+    readSize = file.read(buf.get(), readSize);
+    file.close();
+    probeHeap(HEAP_STORAGE);
+
+    const uint8_t* latest[JOURNAL_RECORD_TYPES] = {};
+    size_t offset = 0;
+
+    while (offset + sizeof(JournalHeader) <= readSize) {
+        JournalHeader header;
+        memcpy(&header, buf.get() + offset, sizeof(header));
+        const uint8_t* payload = buf.get() + offset + sizeof(header);
+
+        if (header.magic != JOURNAL_MAGIC || header.type < JOURNAL_DEVICE_DATA || header.type >= JOURNAL_RECORD_TYPES ||
+            header.length > JOURNAL_MAX_RECORD || offset + sizeof(header) + header.length > readSize ||
+            journalCrc32(payload, header.length) != header.crc) {
+            journalStats.corruptRecords++;
+            break;
+        }
+
+        latest[header.type] = payload;
+        journalRecordLength[header.type] = header.length;
+        journalRecordCrc[header.type] = header.crc;
+        journalSequence = header.sequence;
+        journalStats.recordsRead++;
+
+        offset += sizeof(header) + header.length;
+    }
+
+    journalSize = offset;
+
+    if (offset < fileSize) {
+        Serial.printf("Journal: ignoring %u bytes after last valid record\n", (unsigned)(fileSize - offset));
+        journalNeedsCompaction = true;
+    }
+
+    for (uint8_t type = JOURNAL_DEVICE_DATA; type < JOURNAL_RECORD_TYPES; type++) {
+        if (latest[type] == nullptr) continue;
+
+        if (latest[type][0] == '{') {
+            journalRecordLoaded[type] = decodeJsonRecord(type, latest[type], journalRecordLength[type]);
+            journalNeedsCompaction = true;
+        }
+        else {
+            journalRecordLoaded[type] = decodeBinaryRecord(type, latest[type], journalRecordLength[type]);
+        }
+    }
+
+    Serial.printf("Journal: %lu records, %u bytes\n", (unsigned long)journalStats.recordsRead, (unsigned)journalSize);
+}
+
+// payload - буфер на JOURNAL_MAX_RECORD байт
+bool buildJournalPayload(uint8_t type, uint8_t* payload, size_t& length) {
+    if (type == JOURNAL_DEVICE_DATA) {
+        length = 1 + 6 * 2 + 4 + deviceData.boardID.length() + deviceData.token.length() +
+            deviceData.text.length() + deviceData.status.length() + deviceData.user.length() +
+            deviceData.serverUrl.length();
+    }
+    else {
+        length = 1 + 2 * 2 + 4 + wifiCreds.ssid.length() + wifiCreds.password.length() +
+            4 + sizeof(wifiCreds.bssid) + 4;
+    }
+
+    if (length > JOURNAL_MAX_RECORD) {
+        Serial.println("Journal record too large");
+        return false;
+    }
+
+    uint8_t* p = payload;
+    *p++ = RECORD_FORMAT_VERSION;
+
+    if (type == JOURNAL_DEVICE_DATA) {
+        writeRecordString(p, deviceData.boardID);
+        writeRecordString(p, deviceData.token);
+        writeRecordU32(p, deviceData.uptime);
+        writeRecordString(p, deviceData.text);
+        writeRecordString(p, deviceData.status);
+        writeRecordString(p, deviceData.user);
+        writeRecordString(p, deviceData.serverUrl);
+    }
+    else {
+        writeRecordString(p, wifiCreds.ssid);
+        writeRecordString(p, wifiCreds.password);
+        writeRecordU32(p, wifiCreds.connected ? 1 : 0);
+        writeRecordU32(p, wifiCreds.hintsValid ? 1 : 0);
+        memcpy(p, wifiCreds.bssid, sizeof(wifiCreds.bssid));
+        p += sizeof(wifiCreds.bssid);
+        writeRecordU32(p, wifiCreds.channel);
+    }
+
+    return true;
+}
+
+bool writeJournalRecord(File& file, uint8_t type, const uint8_t* payload, size_t length, uint32_t crc) {
+    JournalHeader header;
+    header.magic = JOURNAL_MAGIC;
+    header.type = type;
+    header.flags = 0;
+    header.length = length;
+    header.reserved = 0;
+    header.sequence = ++journalSequence;
+    header.crc = crc;
+
+    if (file.write((const uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+        file.write(payload, length) != length) {
+        return false;
+    }
+
+    journalStats.bytesWritten += sizeof(header) + length;
+    return true;
+}
+
+bool appendJournalRecord(uint8_t type) {
+    if (!journalIndexed) {
+        indexJournal();
+    }
+
+    uint8_t* payload = journalScratch;
+    size_t length = 0;
+    if (!buildJournalPayload(type, payload, length)) {
+        return false;
+    }
+    probeHeap(HEAP_STORAGE);
+
+    uint32_t crc = journalCrc32(payload, length);
+    if (journalRecordLength[type] > 0 && crc == journalRecordCrc[type] && !journalNeedsCompaction) {
+        journalStats.skippedWrites++;
+        return false;
+    }
+
+    if (journalNeedsCompaction || journalSize + sizeof(JournalHeader) + length > JOURNAL_MAX_SIZE) {
+        return compactJournal();
+    }
+
+    File file = LittleFS.open(JOURNAL_PATH, "a");
+    if (!file) {
+        Serial.println("Failed to open journal for writing");
+        return false;
+    }
+
+    bool written = writeJournalRecord(file, type, payload, length, crc);
+    file.close();
+
+    if (!written) {
+        Serial.println("Failed to write journal record");
+        journalNeedsCompaction = true;
+        return false;
+    }
+
+    journalRecordLength[type] = length;
+    journalRecordCrc[type] = crc;
+    journalSize += sizeof(JournalHeader) + length;
+    journalStats.appends++;
+    return true;
+}
+
+bool compactJournal() {
+    File file = LittleFS.open(JOURNAL_COMPACT_PATH, "w");
+    if (!file) {
+        Serial.println("Failed to open journal for compaction");
+        return false;
+    }
+
+    size_t offset = 0;
+    uint16_t lengths[JOURNAL_RECORD_TYPES] = {};
+    uint32_t crcs[JOURNAL_RECORD_TYPES] = {};
+
+    for (uint8_t type = JOURNAL_DEVICE_DATA; type < JOURNAL_RECORD_TYPES; type++) {
+        uint8_t* payload = journalScratch;
+        size_t length = 0;
+
+        if (!buildJournalPayload(type, payload, length)) continue;
+        probeHeap(HEAP_STORAGE);
+
+        uint32_t crc = journalCrc32(payload, length);
+        if (!writeJournalRecord(file, type, payload, length, crc)) {
+            Serial.println("Failed to write compacted journal");
+            file.close();
+            LittleFS.remove(JOURNAL_COMPACT_PATH);
+            return false;
+        }
+
+        lengths[type] = length;
+        crcs[type] = crc;
+        offset += sizeof(JournalHeader) + length;
+    }
+
+    file.close();
+
+    LittleFS.remove(JOURNAL_PATH);
+    LittleFS.rename(JOURNAL_COMPACT_PATH, JOURNAL_PATH);
+
+    memcpy(journalRecordLength, lengths, sizeof(lengths));
+    memcpy(journalRecordCrc, crcs, sizeof(crcs));
+    journalSize = offset;
+    journalNeedsCompaction = false;
+    journalStats.compactions++;
+
+    if (journalMigrationPending) {
+        LittleFS.remove("/device.json");
+        LittleFS.remove("/wifi.json");
+        journalMigrationPending = false;
+    }
+
+    Serial.printf("Journal compacted to %u bytes\n", (unsigned)journalSize);
+    return true;
+}
+
+uint32_t journalCrc32(const uint8_t* data, size_t length) {
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+
+    return ~crc;
+}
+
+void resetWiFiSettings() {
+    updateDisplay("WiFi Reset", "Removing WiFi settings", "Please wait...");
+
+    if (LittleFS.exists("/wifi.json")) {
+        LittleFS.remove("/wifi.json");
+    }
+
+    wifiCreds.ssid = "";
+    wifiCreds.password = "";
+    wifiCreds.connected = false;
+    wifiCreds.hintsValid = false;
+    appendJournalRecord(JOURNAL_WIFI_CREDENTIALS);
+    Serial.println("WiFi credentials removed");
+
+    WiFi.disconnect(true);
+    holdDisplay(3000);
+    scheduleTask(resetFinishTaskId, 1000);
+}
+
+void finishWiFiReset() {
+    updateDisplay("WiFi Reset Complete", "Starting setup mode", "Please reconnect");
+    holdDisplay(2000);
+    scheduleTask(apStartTaskId, 2000);
+}
+
+void recordLatency(LatencyHistogram& hist, uint32_t micros) {
+    // Корзина i - значения до bound включительно, как le="bound" в /metrics
+    int bucket = 0;
+    uint32_t bound = 128;
+    while (micros > bound && bucket < LATENCY_BUCKETS - 1) {
+        bound <<= 1;
+        bucket++;
+    }
+
+    hist.buckets[bucket]++;
+    hist.count++;
+    hist.totalMicros += micros;
+    if (micros > hist.maxMicros) {
+        hist.maxMicros = micros;
+    }
+}
+
+uint32_t latencyPercentile(const LatencyHistogram& hist, uint8_t percentile) {
+    if (hist.count == 0) return 0;
+
+    uint32_t target = ((uint64_t)hist.count * percentile + 99) / 100;
+    uint32_t seen = 0;
+    uint32_t bound = 128;
+
+    for (int i = 0; i < LATENCY_BUCKETS - 1; i++) {
+        seen += hist.buckets[i];
+        if (seen >= target) {
+            return min(bound, hist.maxMicros);
+        }
+        bound <<= 1;
+    }
+    return hist.maxMicros;
+}
+
+void serviceMetrics() {
+    metricsServer.handleClient();
+}
+
+void metricsPrintf(MetricsWriter& writer, const char* format, ...) {
+    char line[METRICS_LINE_SIZE];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    if (length <= 0) return;
+    if ((size_t)length >= sizeof(line)) length = sizeof(line) - 1;
+
+    if (writer.used + length > sizeof(writer.chunk)) {
+        metricsServer.sendContent(writer.chunk, writer.used);
+        writer.used = 0;
+    }
+    memcpy(writer.chunk + writer.used, line, length);
+    writer.used += length;
+}
+
+// Заголовок метрики - отдельными строками: вместе с длинным HELP он не влезал в METRICS_LINE_SIZE
+void writeMetricHeader(MetricsWriter& writer, const char* name, const char* type, const char* help) {
+    metricsPrintf(writer, "# HELP %s %s\n", name, help);
+    metricsPrintf(writer, "# TYPE %s %s\n", name, type);
+}
+
+// Счётчики и размеры беззнаковые: через %ld значения от 2^31 стали бы отрицательными
+void writeMetric(MetricsWriter& writer, const char* name, const char* type, const char* help, uint32_t value) {
+    writeMetricHeader(writer, name, type, help);
+    metricsPrintf(writer, "%s %lu\n", name, (unsigned long)value);
+}
+
+void writeSignedMetric(MetricsWriter& writer, const char* name, const char* type, const char* help, int32_t value) {
+    writeMetricHeader(writer, name, type, help);
+    metricsPrintf(writer, "%s %ld\n", name, (long)value);
+}
+
+void writeHistogram(MetricsWriter& writer, const char* name, const char* help, const LatencyHistogram& hist) {
+    writeMetricHeader(writer, name, "histogram", help);
+
+    uint32_t cumulative = 0;
+    uint32_t bound = 128;
+    for (int i = 0; i < LATENCY_BUCKETS - 1; i++) {
+        cumulative += hist.buckets[i];
+        metricsPrintf(writer, "%s_bucket{le=\"%lu.%06lu\"} %lu\n", name, (unsigned long)(bound / 1000000),
+            (unsigned long)(bound % 1000000), (unsigned long)cumulative);
+        bound <<= 1;
+    }
+
+    metricsPrintf(writer, "%s_bucket{le=\"+Inf\"} %lu\n", name, (unsigned long)hist.count);
+    metricsPrintf(writer, "%s_sum %lu.%06lu\n", name, (unsigned long)(hist.totalMicros / 1000000),
+        (unsigned long)(hist.totalMicros % 1000000));
+    metricsPrintf(writer, "%s_count %lu\n", name, (unsigned long)hist.count);
+}
+
+void writeRetryMetric(MetricsWriter& writer, const char* name, const char* type, const char* help, const uint32_t* values) {
+    writeMetricHeader(writer, name, type, help);
+    for (int i = 0; i < RETRY_POLICIES; i++) {
+        metricsPrintf(writer, "%s{policy=\"%s\"} %lu\n", name, retryPolicies[i].name, (unsigned long)values[i]);
+    }
+}
+
+void handleMetrics() {
+    metricsServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    metricsServer.send(200, "text/plain; version=0.0.4", "");
+
+    MetricsWriter writer;
+    writer.used = 0;
+
+    writeMetric(writer, "arduinoid_uptime_seconds", "gauge", "Time since boot", millis() / 1000);
+
+    writeHistogram(writer, "arduinoid_loop_duration_seconds", "Scheduler pass duration", loopLatency);
+    writeHistogram(writer, "arduinoid_display_frame_seconds", "Display frame render and flush time", displayFrameLatency);
+    writeHistogram(writer, "arduinoid_server_request_seconds", "Server POST round trip", serverRequestLatency);
+
+    writeMetric(writer, "arduinoid_server_requests_total", "counter", "Server POSTs attempted", serverConnectionStats.requests);
+    writeMetric(writer, "arduinoid_server_failures_total", "counter", "Server POSTs without a response", serverConnectionStats.failedConnections);
+    writeMetric(writer, "arduinoid_server_dropped_connections_total", "counter", "Kept-alive connections dropped by the server", serverConnectionStats.droppedConnections);
+    writeMetric(writer, "arduinoid_tls_full_handshakes_total", "counter", "TLS connections with a full handshake", serverConnectionStats.fullHandshakes);
+    writeMetric(writer, "arduinoid_tls_session_offers_total", "counter", "TLS connections that offered a cached session", serverConnectionStats.sessionOffers);
+    writeMetric(writer, "arduinoid_tls_reused_connections_total", "counter", "Requests on a kept-alive connection", serverConnectionStats.reusedConnections);
+    writeMetric(writer, "arduinoid_updates_full_total", "counter", "Full device updates sent", serverConnectionStats.fullUpdates);
+    writeMetric(writer, "arduinoid_updates_delta_total", "counter", "Delta device updates sent", serverConnectionStats.deltaUpdates);
+    writeMetric(writer, "arduinoid_payload_bytes_total", "counter", "Request payload bytes sent", serverConnectionStats.payloadBytes);
+    writeMetric(writer, "arduinoid_server_unchanged_total", "counter", "Responses with unchanged server state (304 or {})", serverConnectionStats.unchangedResponses);
+
+    metricsPrintf(writer, "# HELP arduinoid_http_timeouts_total Server requests that timed out, by phase\n# TYPE arduinoid_http_timeouts_total counter\n");
+    for (int i = HTTP_PHASE_SEND; i < HTTP_PHASES; i++) {
+        metricsPrintf(writer, "arduinoid_http_timeouts_total{phase=\"%s\"} %lu\n", HTTP_PHASE_NAMES[i], (unsigned long)httpPhaseTimeouts[i]);
+    }
+
+    writeMetric(writer, "arduinoid_wifi_connect_attempts_total", "counter", "Wi-Fi connection attempts", wifiConnectMetrics.attempts);
+    writeMetric(writer, "arduinoid_wifi_connect_failures_total", "counter", "Wi-Fi connection attempts that timed out", wifiConnectMetrics.failures);
+    writeMetric(writer, "arduinoid_wifi_fast_connect_fallbacks_total", "counter", "Directed joins that fell back to a scan", wifiConnectMetrics.fastFallbacks);
+    writeMetric(writer, "arduinoid_wifi_last_connect_milliseconds", "gauge", "Duration of the last successful connection", wifiConnectMetrics.lastDuration);
+    writeSignedMetric(writer, "arduinoid_wifi_rssi_dbm", "gauge", "Current signal strength", WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0);
+
+    writeMetric(writer, "arduinoid_flash_writes_total", "counter", "Journal records appended", journalStats.appends);
+    writeMetric(writer, "arduinoid_flash_write_bytes_total", "counter", "Journal bytes written", journalStats.bytesWritten);
+    writeMetric(writer, "arduinoid_flash_compactions_total", "counter", "Journal compactions", journalStats.compactions);
+    writeMetric(writer, "arduinoid_telemetry_queue_samples", "gauge", "Telemetry samples waiting to be sent", telemetryQueueLength());
+    writeMetric(writer, "arduinoid_telemetry_dropped_total", "counter", "Telemetry samples dropped at the spill limit", telemetryStats.dropped);
+
+    writeMetric(writer, "arduinoid_push_connected", "gauge", "Push channel is open", pushChannel.state == PUSH_OPEN ? 1 : 0);
+    writeMetric(writer, "arduinoid_push_connects_total", "counter", "Push channel connections opened", pushChannel.connects);
+    writeMetric(writer, "arduinoid_push_drops_total", "counter", "Push channel connections lost or refused", pushChannel.drops);
+    writeMetric(writer, "arduinoid_push_messages_total", "counter", "Updates received over the push channel", pushChannel.messages);
+
+    uint32_t retryValues[RETRY_POLICIES];
+    for (int i = 0; i < RETRY_POLICIES; i++) retryValues[i] = retryPolicies[i].state;
+    writeRetryMetric(writer, "arduinoid_retry_breaker_state", "gauge", "Circuit breaker state (0 closed, 1 open, 2 half-open)", retryValues);
+    for (int i = 0; i < RETRY_POLICIES; i++) retryValues[i] = retryPolicies[i].failures;
+    writeRetryMetric(writer, "arduinoid_retry_consecutive_failures", "gauge", "Failures since the last success", retryValues);
+    for (int i = 0; i < RETRY_POLICIES; i++) retryValues[i] = retryPolicies[i].totalFailures;
+    writeRetryMetric(writer, "arduinoid_retry_failures_total", "counter", "Failed attempts", retryValues);
+    for (int i = 0; i < RETRY_POLICIES; i++) retryValues[i] = retryPolicies[i].trips;
+    writeRetryMetric(writer, "arduinoid_retry_breaker_trips_total", "counter", "Times the circuit opened", retryValues);
+    for (int i = 0; i < RETRY_POLICIES; i++) retryValues[i] = retryWait((RetryPolicyId)i);
+    writeRetryMetric(writer, "arduinoid_retry_wait_milliseconds", "gauge", "Time until the next attempt is allowed", retryValues);
+
+    writeMetric(writer, "arduinoid_heap_free_bytes", "gauge", "Free heap", ESP.getFreeHeap());
+    writeMetric(writer, "arduinoid_heap_max_block_bytes", "gauge", "Largest free heap block", ESP.getMaxFreeBlockSize());
+    writeMetric(writer, "arduinoid_heap_fragmentation_percent", "gauge", "Heap fragmentation", ESP.getHeapFragmentation());
+
+    metricsPrintf(writer, "# HELP arduinoid_heap_min_free_bytes Lowest free heap seen per subsystem\n# TYPE arduinoid_heap_min_free_bytes gauge\n");
+    for (int i = 0; i < HEAP_SUBSYSTEMS; i++) {
+        if (heapProbes[i].samples == 0) continue;
+        metricsPrintf(writer, "arduinoid_heap_min_free_bytes{subsystem=\"%s\"} %lu\n", HEAP_SUBSYSTEM_NAMES[i], (unsigned long)heapProbes[i].minFree);
+    }
+
+    metricsPrintf(writer, "# HELP arduinoid_task_runs_total Scheduler task runs\n# TYPE arduinoid_task_runs_total counter\n");
+    for (int i = 0; i < taskCount; i++) {
+        metricsPrintf(writer, "arduinoid_task_runs_total{task=\"%s\"} %lu\n", tasks[i].name, (unsigned long)tasks[i].runs);
+    }
+
+    metricsPrintf(writer, "# HELP arduinoid_task_max_lateness_milliseconds Worst scheduling delay per task\n# TYPE arduinoid_task_max_lateness_milliseconds gauge\n");
+    for (int i = 0; i < taskCount; i++) {
+        metricsPrintf(writer, "arduinoid_task_max_lateness_milliseconds{task=\"%s\"} %lu\n", tasks[i].name, (unsigned long)tasks[i].maxLateness);
+    }
+
+    if (writer.used > 0) {
+        metricsServer.sendContent(writer.chunk, writer.used);
+    }
+    metricsServer.sendContent("");
+}
+
+void sampleHeapWatermark() {
+    recordHeapWatermark(heapWatermark);
+}
+
+void recordHeapWatermark(HeapWatermark& mark) {
+    uint32_t freeHeap = ESP.getFreeHeap();
+    uint32_t maxBlock = ESP.getMaxFreeBlockSize();
+    uint8_t fragmentation = ESP.getHeapFragmentation();
+
+    if (freeHeap < mark.minFree) mark.minFree = freeHeap;
+    if (maxBlock < mark.minMaxBlock) mark.minMaxBlock = maxBlock;
+    if (fragmentation > mark.maxFragmentation) mark.maxFragmentation = fragmentation;
+    mark.samples++;
+}
+
+void probeHeap(HeapSubsystem subsystem) {
+    recordHeapWatermark(heapProbes[subsystem]);
+}
+
+void addHeapSummary(JsonDocument& doc) {
+    JsonObject heap = doc.createNestedObject("heap");
+    heap["free"] = ESP.getFreeHeap();
+    heap["block"] = ESP.getMaxFreeBlockSize();
+    heap["frag"] = ESP.getHeapFragmentation();
+
+    for (int i = 0; i < HEAP_SUBSYSTEMS; i++) {
+        if (heapProbes[i].samples == 0) continue;
+
+        JsonArray probe = heap.createNestedArray(HEAP_SUBSYSTEM_NAMES[i]);
+        probe.add(heapProbes[i].minFree);
+        probe.add(heapProbes[i].minMaxBlock);
+        probe.add(heapProbes[i].maxFragmentation);
+    }
+}
+
+void reportBenchmark() {
+    Serial.println("--- Loop benchmark ---");
+    Serial.printf("Setup: %lu ms, storage loaded at %lu ms, first POST at %lu ms\n",
+        setupDuration, storageLoadDuration, firstPostTime);
+    Serial.printf("Iterations: %lu, avg: %lu us, max: %lu us\n",
+        (unsigned long)loopLatency.count,
+        loopLatency.count > 0 ? (unsigned long)(loopLatency.totalMicros / loopLatency.count) : 0UL,
+        (unsigned long)loopLatency.maxMicros);
+    Serial.printf("p50: %lu us, p90: %lu us, p99: %lu us\n",
+        (unsigned long)latencyPercentile(loopLatency, 50),
+        (unsigned long)latencyPercentile(loopLatency, 90),
+        (unsigned long)latencyPercentile(loopLatency, 99));
+    Serial.printf("Heap now: %lu, min free: %lu, min max block: %lu, max frag: %u%%\n",
+        (unsigned long)ESP.getFreeHeap(), (unsigned long)heapWatermark.minFree, (unsigned long)heapWatermark.minMaxBlock,
+        heapWatermark.maxFragmentation);
+
+    Serial.printf("WiFi connects: %lu ok, %lu failed, last: %lu ms, min: %lu ms, max: %lu ms\n",
+        (unsigned long)wifiConnectMetrics.successes, (unsigned long)wifiConnectMetrics.failures, wifiConnectMetrics.lastDuration,
+        wifiConnectMetrics.successes + wifiConnectMetrics.failures > 0 ? wifiConnectMetrics.minDuration : 0UL,
+        wifiConnectMetrics.maxDuration);
+    Serial.printf("Fast reconnects: %lu attempted, %lu ok, %lu fell back to scan\n",
+        (unsigned long)wifiConnectMetrics.fastAttempts, (unsigned long)wifiConnectMetrics.fastSuccesses,
+        (unsigned long)wifiConnectMetrics.fastFallbacks);
+
+    Serial.printf("Push channel: %s, %lu connects, %lu drops, %lu messages\n",
+        !PUSH_ENABLED ? "disabled" : pushChannel.state == PUSH_OPEN ? "open" : "closed",
+        (unsigned long)pushChannel.connects, (unsigned long)pushChannel.drops, (unsigned long)pushChannel.messages);
+    for (int i = 0; i < RETRY_POLICIES; i++) {
+        Serial.printf("Retry %-6s %s, %u in a row, %lu failures, %lu trips, last delay %lu ms, next in %lu ms\n",
+            retryPolicies[i].name, BREAKER_STATE_NAMES[retryPolicies[i].state], retryPolicies[i].failures,
+            (unsigned long)retryPolicies[i].totalFailures, (unsigned long)retryPolicies[i].trips, retryPolicies[i].lastDelay,
+            retryWait((RetryPolicyId)i));
+    }
+
+    Serial.printf("Server requests: %lu, full handshakes: %lu, session offers: %lu, reused: %lu, dropped: %lu, failed: %lu\n",
+        (unsigned long)serverConnectionStats.requests, (unsigned long)serverConnectionStats.fullHandshakes,
+        (unsigned long)serverConnectionStats.sessionOffers, (unsigned long)serverConnectionStats.reusedConnections,
+        (unsigned long)serverConnectionStats.droppedConnections, (unsigned long)serverConnectionStats.failedConnections);
+    Serial.printf("HTTP timeouts: send %lu, first byte %lu, headers %lu, body %lu\n",
+        (unsigned long)httpPhaseTimeouts[HTTP_PHASE_SEND], (unsigned long)httpPhaseTimeouts[HTTP_PHASE_FIRST_BYTE],
+        (unsigned long)httpPhaseTimeouts[HTTP_PHASE_HEADERS], (unsigned long)httpPhaseTimeouts[HTTP_PHASE_BODY]);
+    for (int i = 0; i < HEAP_SUBSYSTEMS; i++) {
+        Serial.printf("Heap %-8s samples: %lu, min free: %lu, min block: %lu, max frag: %u%%\n",
+            HEAP_SUBSYSTEM_NAMES[i], (unsigned long)heapProbes[i].samples,
+            heapProbes[i].samples > 0 ? (unsigned long)heapProbes[i].minFree : 0UL,
+            heapProbes[i].samples > 0 ? (unsigned long)heapProbes[i].minMaxBlock : 0UL,
+            heapProbes[i].maxFragmentation);
+    }
+    Serial.printf("Display: %lu rendered, %lu skipped, %lu unchanged, %lu pages, %lu bytes over I2C\n",
+        (unsigned long)displayStats.framesRendered, (unsigned long)displayStats.framesSkipped,
+        (unsigned long)displayStats.framesUnchanged, (unsigned long)displayStats.pagesPushed,
+        (unsigned long)displayStats.bytesPushed);
+    Serial.printf("Display frames: avg %lu us, max %lu us, layout cache %lu hits, %lu misses\n",
+        displayFrameLatency.count > 0 ? (unsigned long)(displayFrameLatency.totalMicros / displayFrameLatency.count) : 0UL,
+        (unsigned long)displayFrameLatency.maxMicros, (unsigned long)displayStats.layoutHits,
+        (unsigned long)displayStats.layoutMisses);
+    Serial.printf("Journal: %lu appends, %lu skipped, %lu compactions, %lu bytes written (~%lu bytes/day), %u bytes on flash\n",
+        (unsigned long)journalStats.appends, (unsigned long)journalStats.skippedWrites,
+        (unsigned long)journalStats.compactions, (unsigned long)journalStats.bytesWritten,
+        millis() > 0 ? (unsigned long)((uint64_t)journalStats.bytesWritten * 86400000ULL / millis()) : 0UL,
+        (unsigned)journalSize);
+    Serial.printf("Updates: %lu full, %lu delta, %lu payload bytes, %lu unchanged responses\n",
+        (unsigned long)serverConnectionStats.fullUpdates, (unsigned long)serverConnectionStats.deltaUpdates,
+        (unsigned long)serverConnectionStats.payloadBytes, (unsigned long)serverConnectionStats.unchangedResponses);
+    Serial.printf("Power profile: %s, CPU busy %.2f%% of uptime\n", powerProfileName(),
+        millis() > 0 ? loopLatency.totalMicros / (millis() * 10.0) : 0.0);
+    Serial.printf("Battery: %.2f V (%u%%), %s, %lu ADC reads (%.2f/s), %lu low events\n",
+        batteryMonitor.voltage, batteryMonitor.percent, batteryMonitor.low ? "low" : "ok", (unsigned long)batteryMonitor.adcReads,
+        millis() > 0 ? batteryMonitor.adcReads * 1000.0 / millis() : 0.0, (unsigned long)batteryMonitor.lowEvents);
+    Serial.printf("Telemetry queue: %d pending (%d RAM, %d flash), %lu queued, %lu spilled, %lu drained, %lu dropped\n",
+        telemetryQueueLength(), telemetryRingCount, telemetrySpillPending, (unsigned long)telemetryStats.queued,
+        (unsigned long)telemetryStats.spilled, (unsigned long)telemetryStats.drained, (unsigned long)telemetryStats.dropped);
+    Serial.printf("Telemetry batches: %lu sent, %lu samples, avg %lu samples/POST\n",
+        (unsigned long)telemetryStats.batches, (unsigned long)telemetryStats.batchedSamples,
+        telemetryStats.batches > 0 ? (unsigned long)(telemetryStats.batchedSamples / telemetryStats.batches) : 0UL);
+
+    for (int i = 0; i < taskCount; i++) {
+        Serial.printf("Task %-14s runs: %lu, max lateness: %lu ms, max run: %lu us\n",
+            tasks[i].name, (unsigned long)tasks[i].runs, (unsigned long)tasks[i].maxLateness,
+            (unsigned long)tasks[i].maxDuration);
+    }
+}
+
+void formatFS() {
+    Serial.println("Formatting file system");
+    LittleFS.format();
+    if (!LittleFS.begin()) {
+        Serial.println("File system format failed");
+    }
+    else {
+        Serial.println("File system formatted");
+    }
 }
\ No newline at end of file
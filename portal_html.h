@@ -0,0 +1,141 @@
+// Generated by tools/build_portal.py from portal/index.html. Do not edit.
+#pragma once
+
+#define PORTAL_HTML_ETAG "\"9d11c004\""
+#define PORTAL_HTML_GZ_LEN 2126
+
+const uint8_t PORTAL_HTML_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xa5, 0x58, 0xdd, 0x6e, 0xdb, 0x38,
+    0x16, 0xbe, 0xf7, 0x53, 0xb0, 0x0e, 0x76, 0x24, 0xa3, 0xb6, 0xec, 0xfc, 0x38, 0x75, 0x1d, 0xdb,
+    0xc0, 0x34, 0x4d, 0xb1, 0x05, 0x66, 0xdb, 0xa0, 0x49, 0xb1, 0xd8, 0xab, 0x05, 0x2d, 0x51, 0x16,
+    0x37, 0xb2, 0xa8, 0x25, 0xa9, 0x38, 0x99, 0x9d, 0x3c, 0x41, 0x2f, 0xf6, 0x72, 0xdf, 0x6f, 0x9f,
+    0x64, 0xcf, 0x21, 0x29, 0x99, 0x72, 0xec, 0xa6, 0x33, 0x8b, 0x16, 0x90, 0x45, 0xf1, 0x9c, 0xf3,
+    0x9d, 0xbf, 0xef, 0x90, 0x99, 0xbd, 0x7a, 0xff, 0xf9, 0xf2, 0xf6, 0x6f, 0xd7, 0x57, 0x24, 0xd3,
+    0xeb, 0x7c, 0xd1, 0x99, 0xd5, 0x0f, 0x46, 0x13, 0x78, 0xac, 0x99, 0xa6, 0xa4, 0xa0, 0x6b, 0x36,
+    0xef, 0xde, 0x73, 0xb6, 0x29, 0x85, 0xd4, 0x5d, 0x12, 0x8b, 0x42, 0xb3, 0x42, 0xcf, 0xbb, 0x1b,
+    0x9e, 0xe8, 0x6c, 0x9e, 0xb0, 0x7b, 0x1e, 0xb3, 0x81, 0x79, 0xe9, 0x13, 0x5e, 0x70, 0xcd, 0x69,
+    0x3e, 0x50, 0x31, 0xcd, 0xd9, 0xfc, 0x38, 0x1a, 0x75, 0x6b, 0x35, 0x71, 0x46, 0xa5, 0x62, 0x20,
+    0xf6, 0xf5, 0xf6, 0xc3, 0x60, 0x82, 0xcb, 0x9a, 0xeb, 0x9c, 0x2d, 0xae, 0x6e, 0xae, 0x27, 0x27,
+    0xe7, 0xe7, 0xe4, 0xaf, 0xfc, 0x03, 0x27, 0x37, 0x4c, 0x57, 0xe5, 0x6c, 0x68, 0xbf, 0x74, 0x66,
+    0x4a, 0x3f, 0xe2, 0x73, 0x29, 0x92, 0x47, 0xf2, 0xaf, 0x4e, 0x0a, 0x86, 0x07, 0x29, 0x5d, 0xf3,
+    0xfc, 0x71, 0x4a, 0x7e, 0x96, 0x60, 0xa6, 0x4f, 0x14, 0x2d, 0xd4, 0x40, 0x31, 0xc9, 0xd3, 0x8b,
+    0xce, 0x9a, 0xca, 0x15, 0x2f, 0xa6, 0x64, 0x74, 0xd1, 0x29, 0x69, 0x92, 0xf0, 0x62, 0x35, 0x25,
+    0x27, 0xa3, 0xf2, 0xe1, 0xa2, 0xb3, 0xa4, 0xf1, 0xdd, 0x4a, 0x8a, 0xaa, 0x48, 0xa6, 0xe4, 0x28,
+    0x1d, 0xe3, 0xbf, 0x8b, 0x8e, 0x66, 0x0f, 0x7a, 0x40, 0x73, 0xbe, 0x02, 0x91, 0x18, 0x1c, 0x62,
+    0xf2, 0xa2, 0xf3, 0xd4, 0x89, 0xd0, 0x3d, 0xca, 0x0b, 0x26, 0xc1, 0xe2, 0x9a, 0x3e, 0x58, 0xc7,
+    0xa6, 0xe4, 0x6c, 0x64, 0x34, 0x35, 0x36, 0x08, 0xad, 0xb4, 0x68, 0x6b, 0xde, 0x64, 0x5c, 0xb3,
+    0xe7, 0xb6, 0x85, 0x4c, 0x98, 0x1c, 0x48, 0x9a, 0xf0, 0x4a, 0x4d, 0xc9, 0xb1, 0x5b, 0x7c, 0x18,
+    0xa8, 0x8c, 0x26, 0x62, 0x83, 0xaa, 0x4e, 0xca, 0x07, 0xb3, 0x4e, 0xe4, 0x6a, 0x49, 0xc3, 0x51,
+    0xdf, 0xfc, 0x8b, 0x8e, 0x7b, 0x88, 0x27, 0x3b, 0x06, 0x1c, 0xb1, 0xc8, 0x85, 0x04, 0xe8, 0xa7,
+    0xa7, 0xa7, 0x06, 0x63, 0x2a, 0xe4, 0x7a, 0x80, 0x66, 0x4b, 0x03, 0x12, 0x21, 0x0d, 0x96, 0x42,
+    0x6b, 0xb1, 0x06, 0x03, 0x63, 0x34, 0xe0, 0x3b, 0x97, 0xb3, 0x54, 0xa3, 0x58, 0x4e, 0x97, 0x2c,
+    0x07, 0x81, 0x84, 0xab, 0x32, 0xa7, 0x10, 0xc3, 0x65, 0x2e, 0xe2, 0xbb, 0x8b, 0x5d, 0x05, 0x46,
+    0xde, 0xc4, 0x7a, 0xc3, 0xf8, 0x2a, 0xd3, 0xb0, 0x4f, 0xe4, 0x09, 0x2a, 0xe0, 0x45, 0x59, 0x69,
+    0x50, 0xe0, 0x42, 0x72, 0x3c, 0x1a, 0xfd, 0xc9, 0x73, 0x77, 0xd2, 0x38, 0xc6, 0x7f, 0x35, 0x0b,
+    0xce, 0x73, 0x58, 0xaa, 0xa3, 0x00, 0x32, 0xe0, 0xa5, 0x12, 0x39, 0x4f, 0xc8, 0x51, 0x92, 0x24,
+    0xcf, 0xa2, 0x73, 0x86, 0x3a, 0x9e, 0x3a, 0xcb, 0x0a, 0xa0, 0x14, 0x60, 0xa9, 0x95, 0xb8, 0xb3,
+    0x93, 0xc9, 0x38, 0x3d, 0xbb, 0xa8, 0xa3, 0xe1, 0xc2, 0x5d, 0x6b, 0x2e, 0x44, 0xe1, 0x07, 0xdf,
+    0xc4, 0xd3, 0xc6, 0x62, 0x9f, 0x8d, 0xb8, 0x92, 0x0a, 0x95, 0x94, 0x82, 0xdb, 0xcc, 0xef, 0x75,
+    0xd8, 0xe2, 0x98, 0x66, 0xe2, 0xde, 0x94, 0x83, 0x28, 0x69, 0xcc, 0x35, 0x04, 0x6e, 0x14, 0xbd,
+    0xc5, 0xcf, 0x47, 0x05, 0xd3, 0x1b, 0x21, 0xef, 0x94, 0x2b, 0x95, 0xcc, 0x89, 0x9f, 0xd8, 0x5a,
+    0x41, 0xa9, 0x34, 0x17, 0x9b, 0x01, 0x48, 0xd8, 0x6a, 0xd9, 0x9b, 0xaa, 0xdf, 0x17, 0x9a, 0xc8,
+    0xd9, 0x04, 0x93, 0xbb, 0x91, 0x77, 0xd1, 0x76, 0xba, 0x77, 0xb4, 0x3d, 0x73, 0x78, 0xab, 0xaa,
+    0xf1, 0xcf, 0x8f, 0x76, 0xab, 0x14, 0x47, 0x63, 0x53, 0x8b, 0x91, 0x82, 0x7a, 0xc2, 0xe6, 0xd6,
+    0x92, 0x15, 0x2b, 0x9d, 0x61, 0x4f, 0xe6, 0x82, 0x82, 0xc7, 0x12, 0x1d, 0x6f, 0x32, 0x73, 0x74,
+    0x7e, 0x7e, 0x6e, 0xe2, 0x23, 0x59, 0x2a, 0x99, 0xca, 0x06, 0x4b, 0x5d, 0xec, 0x29, 0xd4, 0xe7,
+    0xad, 0x79, 0x7a, 0x46, 0x27, 0x63, 0x53, 0xe2, 0x47, 0x40, 0x20, 0x45, 0x01, 0xde, 0xf9, 0x7e,
+    0xda, 0x78, 0xed, 0x18, 0x89, 0x94, 0xa6, 0xba, 0x52, 0xad, 0x7d, 0x5e, 0xab, 0x0e, 0xb4, 0x28,
+    0xb7, 0x5d, 0xf7, 0x3c, 0xa2, 0x4d, 0x33, 0xd8, 0xfa, 0x01, 0x7d, 0x4c, 0x4a, 0xd1, 0x8e, 0xc6,
+    0xa0, 0x36, 0x99, 0xa6, 0x6c, 0xc9, 0xd8, 0x16, 0x42, 0x7c, 0x7e, 0x32, 0x39, 0x99, 0xec, 0x4d,
+    0x21, 0x4b, 0xdf, 0xd2, 0xb7, 0xd4, 0x02, 0xac, 0xe2, 0x98, 0x29, 0xb5, 0x5f, 0x25, 0x9b, 0xa4,
+    0x63, 0xf6, 0x76, 0xab, 0xf2, 0x84, 0xbd, 0x49, 0x4e, 0x4f, 0xf6, 0xaa, 0xa4, 0xe3, 0xe4, 0x9c,
+    0xbe, 0x41, 0x95, 0xb3, 0xa1, 0x63, 0xc6, 0xd9, 0xd0, 0x31, 0x35, 0x52, 0x24, 0x3c, 0x12, 0x7e,
+    0x4f, 0xe2, 0x9c, 0x2a, 0x35, 0xef, 0x36, 0x3c, 0x86, 0x54, 0x9b, 0x1d, 0xef, 0xe5, 0x59, 0x58,
+    0xee, 0xcc, 0xca, 0xc5, 0x75, 0xce, 0xa8, 0x62, 0x44, 0xb1, 0x9c, 0xc5, 0x9a, 0x3c, 0x8a, 0x4a,
+    0xda, 0x5d, 0x75, 0xa9, 0xd1, 0x22, 0x21, 0x86, 0x20, 0x89, 0xce, 0x18, 0x29, 0x41, 0x3d, 0x2c,
+    0x27, 0x44, 0x0b, 0x9c, 0x05, 0x05, 0xca, 0xe0, 0xba, 0x1d, 0x04, 0xd1, 0x6c, 0x58, 0x22, 0x1e,
+    0xdb, 0xc1, 0x3c, 0x99, 0x77, 0xbd, 0x22, 0xe8, 0x12, 0x51, 0xc4, 0x39, 0x8f, 0xef, 0xe6, 0xdd,
+    0x94, 0xe9, 0x38, 0xfb, 0xe4, 0xfa, 0x27, 0xec, 0x75, 0x17, 0x5f, 0xec, 0x36, 0x52, 0xaf, 0xcd,
+    0x86, 0x56, 0x87, 0xf3, 0x0a, 0x35, 0xd5, 0xed, 0x86, 0x1e, 0x95, 0x66, 0xa5, 0xae, 0x92, 0xee,
+    0xe2, 0xa6, 0xae, 0x17, 0xe0, 0xc6, 0x1a, 0xb8, 0x8a, 0x22, 0x07, 0x67, 0x08, 0x2a, 0xe0, 0x81,
+    0xbc, 0x69, 0xe4, 0x36, 0x3c, 0xe5, 0x03, 0x7c, 0x43, 0x44, 0xaa, 0x5a, 0xae, 0xb9, 0x46, 0xa0,
+    0xba, 0x92, 0x05, 0xb1, 0xaf, 0x1f, 0xe0, 0x23, 0xc2, 0x6a, 0xc5, 0x74, 0xcb, 0xbb, 0xf8, 0xc1,
+    0xf2, 0x29, 0xac, 0x01, 0x0e, 0xc5, 0x93, 0xee, 0xc2, 0x41, 0x27, 0x9f, 0x60, 0x62, 0x92, 0xf0,
+    0xe6, 0xe6, 0xe3, 0xfb, 0xde, 0x74, 0x36, 0x34, 0xdb, 0x60, 0xbb, 0x65, 0x4f, 0xfd, 0x58, 0xc2,
+    0x34, 0x45, 0x7a, 0xee, 0x5a, 0x0f, 0x50, 0xd2, 0xcd, 0x58, 0xfb, 0x5b, 0xb2, 0x7f, 0x56, 0x5c,
+    0xb2, 0x64, 0x0b, 0xfb, 0x47, 0x10, 0xd4, 0x59, 0xe9, 0x2e, 0xae, 0xdd, 0xaf, 0x03, 0xa6, 0x9b,
+    0x8d, 0xc6, 0xfc, 0xf6, 0xcd, 0x42, 0xd8, 0xaa, 0xf9, 0x5d, 0xd6, 0x01, 0x2e, 0x40, 0x8e, 0xf5,
+    0xdf, 0x2b, 0x99, 0x63, 0x2a, 0xed, 0x1b, 0xf9, 0xfa, 0xe5, 0x97, 0x17, 0x03, 0xd0, 0x12, 0x75,
+    0x28, 0xda, 0x6b, 0xd0, 0x9f, 0x31, 0xcb, 0x80, 0x92, 0x19, 0x58, 0xca, 0xb4, 0x2e, 0xd5, 0x74,
+    0x38, 0xfc, 0x95, 0xe6, 0x55, 0x49, 0x23, 0x51, 0xe4, 0x50, 0xe3, 0x1e, 0x5a, 0x57, 0x78, 0xd6,
+    0x8a, 0x4d, 0x65, 0x77, 0x71, 0x69, 0xcb, 0xd4, 0x2b, 0xa9, 0x21, 0xba, 0xe2, 0x95, 0x96, 0x25,
+    0x91, 0xc1, 0x1a, 0xfa, 0x94, 0xae, 0x58, 0xb7, 0x76, 0xd8, 0x2e, 0x77, 0x17, 0xb5, 0x76, 0xf7,
+    0x50, 0xb1, 0xe4, 0xa5, 0x5e, 0xc0, 0x20, 0x2c, 0x60, 0x84, 0x23, 0x08, 0x41, 0x13, 0x32, 0x27,
+    0x69, 0x55, 0xc4, 0x9a, 0x8b, 0x22, 0xec, 0x21, 0x35, 0xb6, 0x2b, 0x1c, 0xfa, 0x16, 0xa6, 0x8c,
+    0xdb, 0x40, 0x76, 0x3e, 0xe2, 0x54, 0x16, 0x71, 0xb5, 0x86, 0x2e, 0x8b, 0x56, 0x4c, 0x5f, 0xe5,
+    0x0c, 0x7f, 0xbe, 0x7b, 0xfc, 0x98, 0x84, 0x41, 0x5d, 0xe3, 0x41, 0x2f, 0xc2, 0xa8, 0x5d, 0xda,
+    0xe3, 0x17, 0x58, 0x0b, 0x0e, 0xd5, 0x7c, 0x70, 0x61, 0x8d, 0x87, 0xc1, 0x10, 0x85, 0x83, 0x5e,
+    0x27, 0x82, 0x06, 0x2d, 0x42, 0xe8, 0xaf, 0x12, 0xca, 0x9d, 0x91, 0xf9, 0x02, 0x0c, 0xf2, 0x94,
+    0x84, 0xaf, 0xea, 0xa5, 0x48, 0xdc, 0x21, 0x08, 0x9d, 0x49, 0xb1, 0x01, 0x55, 0x1b, 0x72, 0x85,
+    0x2c, 0x18, 0x06, 0x75, 0x49, 0xa3, 0x1e, 0x92, 0x52, 0x9e, 0xb3, 0x24, 0x30, 0xb3, 0xc0, 0x35,
+    0x4b, 0x23, 0xff, 0x0f, 0x85, 0x6e, 0xc3, 0x97, 0xda, 0x58, 0x42, 0xe1, 0xd0, 0x67, 0x0c, 0x01,
+    0x49, 0x28, 0xdd, 0xe0, 0x7b, 0x0f, 0x11, 0x9f, 0x93, 0x83, 0xde, 0xd6, 0xdb, 0xd0, 0x8a, 0x27,
+    0x12, 0x71, 0xc8, 0xa0, 0xfc, 0xf3, 0xed, 0x5f, 0x7e, 0x41, 0xc7, 0xc1, 0x41, 0x83, 0xde, 0xd8,
+    0xf8, 0xed, 0x37, 0x82, 0xcf, 0x28, 0xb7, 0x33, 0x69, 0x3e, 0x9f, 0x93, 0x11, 0xfa, 0x72, 0x50,
+    0xfa, 0x19, 0x77, 0x7c, 0x12, 0x0d, 0x3a, 0x08, 0x25, 0xb0, 0x73, 0x44, 0x6e, 0xe5, 0x23, 0x71,
+    0xc4, 0x05, 0x5b, 0x1c, 0x8f, 0x80, 0x59, 0xeb, 0x36, 0x06, 0xc0, 0xd8, 0x84, 0x91, 0xaa, 0xc3,
+    0x90, 0xf6, 0xc9, 0xb2, 0x87, 0xbe, 0x2e, 0x23, 0x09, 0x3d, 0x4c, 0x06, 0x84, 0x9a, 0x1f, 0xe0,
+    0x82, 0xd9, 0x05, 0xe9, 0xb9, 0xa2, 0x90, 0x8e, 0x9a, 0x4f, 0x9b, 0xf0, 0xbb, 0x85, 0x08, 0x1b,
+    0x9f, 0xfc, 0xf4, 0x13, 0xf1, 0xdf, 0x6b, 0x7f, 0x16, 0xc6, 0x1b, 0x42, 0x86, 0x43, 0xf2, 0xb9,
+    0xc8, 0x1f, 0x89, 0xca, 0x4c, 0x86, 0x1c, 0xdc, 0x0d, 0x87, 0x2d, 0xc8, 0x34, 0x2e, 0xca, 0x49,
+    0x3b, 0xba, 0xb1, 0x64, 0x54, 0x33, 0x17, 0xe0, 0x30, 0x80, 0xaf, 0x18, 0x57, 0x78, 0x44, 0xa6,
+    0xc0, 0x0d, 0x51, 0x41, 0x44, 0x9c, 0x3a, 0xf0, 0x2f, 0x67, 0x9a, 0xd8, 0x29, 0xff, 0x0e, 0x8e,
+    0xeb, 0x2e, 0xd6, 0x56, 0xb5, 0x71, 0x6d, 0xde, 0x60, 0xc4, 0x57, 0x9b, 0x06, 0xf3, 0x61, 0x41,
+    0x06, 0xe3, 0x71, 0x6f, 0x47, 0xf6, 0xbf, 0xff, 0xf9, 0x77, 0xf3, 0x1f, 0xf4, 0xb0, 0x1c, 0x6a,
+    0xcf, 0x97, 0x38, 0xff, 0x9e, 0xc4, 0xb7, 0x7d, 0x12, 0x6f, 0x0e, 0x4a, 0x7c, 0x3b, 0x20, 0x31,
+    0xd9, 0x2f, 0xf1, 0xad, 0x2d, 0xb1, 0xbb, 0xe3, 0x9b, 0xbf, 0x23, 0xd9, 0xa9, 0xa0, 0x56, 0xda,
+    0x5e, 0x43, 0x41, 0xa9, 0x12, 0xba, 0xa3, 0xa6, 0x8c, 0xf6, 0x19, 0xa9, 0xbb, 0x08, 0x60, 0x8b,
+    0xa7, 0x1e, 0xf6, 0x13, 0x5c, 0x32, 0xf8, 0xf0, 0x25, 0x79, 0xb7, 0x86, 0x79, 0x0e, 0x1a, 0x16,
+    0xce, 0x94, 0x9b, 0x91, 0xbb, 0x7c, 0x72, 0x98, 0x20, 0x00, 0x06, 0x90, 0xc3, 0x3d, 0x30, 0x22,
+    0xdb, 0x41, 0x77, 0x71, 0x58, 0xaa, 0x66, 0x7a, 0x90, 0x4c, 0x61, 0x4f, 0xcd, 0x50, 0x7e, 0xd7,
+    0xd0, 0xb2, 0x64, 0x45, 0x72, 0x99, 0xf1, 0x3c, 0x09, 0x01, 0x98, 0xe9, 0xfb, 0x27, 0xd7, 0xe3,
+    0x31, 0x45, 0x82, 0xb1, 0x67, 0x25, 0x53, 0xcf, 0x3f, 0xd0, 0xd1, 0x2f, 0xb4, 0xa1, 0xa1, 0x1c,
+    0xd2, 0x1c, 0xfc, 0x1a, 0x42, 0x23, 0x5f, 0x98, 0x96, 0x8f, 0xad, 0x36, 0xc4, 0x8a, 0x14, 0x39,
+    0xb3, 0x67, 0xb5, 0x30, 0x30, 0x92, 0xd3, 0xa0, 0x4f, 0xcc, 0xbb, 0x41, 0x88, 0x58, 0x1b, 0xb6,
+    0xf5, 0x47, 0x7a, 0x43, 0x48, 0x26, 0x7b, 0xdf, 0x61, 0x22, 0x3f, 0xac, 0x58, 0xe8, 0xe1, 0x2b,
+    0x5c, 0x41, 0x79, 0x6c, 0xc1, 0x1b, 0x33, 0x19, 0xc2, 0xa0, 0x7d, 0x76, 0xa2, 0x35, 0x6a, 0xc0,
+    0x12, 0x18, 0x30, 0xd8, 0x6f, 0x8e, 0x2b, 0x53, 0x0a, 0x95, 0x86, 0xb8, 0x9c, 0x7d, 0xa3, 0xe1,
+    0x05, 0x3a, 0x6c, 0xcf, 0x25, 0x54, 0xd6, 0x88, 0xb5, 0x5b, 0xd8, 0x2e, 0x07, 0xfe, 0x77, 0x73,
+    0x46, 0x8c, 0xdc, 0x01, 0x17, 0xf7, 0x98, 0xfb, 0x5e, 0x6b, 0xcb, 0xce, 0x40, 0x71, 0x73, 0x12,
+    0xa3, 0x0f, 0x87, 0x3b, 0x53, 0xb8, 0xae, 0xc4, 0xed, 0x54, 0xb1, 0xc0, 0x71, 0x74, 0xbe, 0x37,
+    0xec, 0x6e, 0x26, 0xc5, 0x07, 0xf7, 0x1a, 0x1e, 0x74, 0xa2, 0x39, 0x6d, 0x05, 0xbd, 0xde, 0x76,
+    0x34, 0xb9, 0xb3, 0x23, 0x44, 0x0a, 0xae, 0x06, 0x4c, 0x67, 0x02, 0x6e, 0x00, 0xc1, 0xf5, 0xe7,
+    0x9b, 0xdb, 0xa0, 0x6f, 0x6e, 0xfc, 0x53, 0xa3, 0x1d, 0x8e, 0x10, 0x37, 0x8c, 0xca, 0x38, 0xbb,
+    0xa6, 0x92, 0xae, 0x55, 0x58, 0x1b, 0xef, 0x6d, 0x27, 0x8d, 0x3f, 0xd6, 0x9a, 0x79, 0x84, 0x9e,
+    0x85, 0xbd, 0x3d, 0xc3, 0x28, 0x63, 0xf1, 0x5d, 0xed, 0xa7, 0x28, 0x5c, 0x1a, 0x0f, 0x15, 0xb5,
+    0x9f, 0x69, 0x5b, 0x9e, 0x71, 0x13, 0xa2, 0xa9, 0x09, 0x90, 0xd9, 0xec, 0x27, 0xfb, 0x69, 0x4f,
+    0xc2, 0x91, 0x55, 0xe3, 0xc6, 0xe6, 0xa5, 0x85, 0x50, 0x99, 0x98, 0x8f, 0xbc, 0x43, 0xc1, 0x01,
+    0x6c, 0xb6, 0x62, 0x0f, 0x08, 0xfb, 0x08, 0x7f, 0xd6, 0x9a, 0xad, 0xcb, 0x3a, 0x7d, 0x4e, 0x06,
+    0x33, 0x07, 0xf8, 0x10, 0x9a, 0x5f, 0x77, 0x46, 0x0f, 0xa8, 0x50, 0x4c, 0x7f, 0xc4, 0xa3, 0x3d,
+    0x94, 0x79, 0xd8, 0xa2, 0x9b, 0x7d, 0x26, 0x5f, 0xbf, 0xf6, 0x4e, 0x16, 0xf6, 0x56, 0x13, 0xfc,
+    0xa1, 0x2c, 0x40, 0x37, 0xd9, 0x17, 0x18, 0xd6, 0x5d, 0x67, 0x89, 0x25, 0x5d, 0x63, 0x17, 0x1a,
+    0x4a, 0x36, 0x90, 0x3c, 0xb0, 0xbd, 0xb6, 0xb3, 0xdb, 0x38, 0x11, 0x07, 0x25, 0xad, 0xf2, 0x57,
+    0xe8, 0x6a, 0x83, 0xac, 0x99, 0x5c, 0xee, 0x38, 0xf9, 0x55, 0xe6, 0xdf, 0xeb, 0x35, 0xff, 0xd4,
+    0xd9, 0x6a, 0x7c, 0x5f, 0x1e, 0xa6, 0xb4, 0xf7, 0xda, 0x1e, 0xd2, 0x2d, 0x7c, 0xf5, 0x21, 0xd8,
+    0x6b, 0x26, 0x5f, 0x0f, 0x32, 0x3f, 0x2f, 0xc8, 0x29, 0x24, 0x00, 0x40, 0x26, 0xca, 0xa5, 0xc9,
+    0xc3, 0x0e, 0x99, 0xb9, 0xe5, 0x6b, 0x26, 0x2a, 0xdd, 0x4e, 0x8c, 0x3b, 0x74, 0x42, 0x2f, 0x53,
+    0x5c, 0x8b, 0x32, 0x38, 0xa7, 0x80, 0x5b, 0x9e, 0x72, 0x28, 0xb9, 0x3e, 0x39, 0x1d, 0x8d, 0x46,
+    0x96, 0xb1, 0x89, 0x9b, 0x89, 0xcf, 0x43, 0x8e, 0xb4, 0xbb, 0x8b, 0xfb, 0x46, 0xf3, 0x3c, 0xf7,
+    0xca, 0x1c, 0x80, 0xc1, 0x09, 0xdc, 0x90, 0xdc, 0x86, 0x72, 0x5d, 0xd7, 0x92, 0xd3, 0xda, 0x96,
+    0x35, 0x79, 0x42, 0x87, 0x63, 0x2f, 0x39, 0xe6, 0x9b, 0x57, 0x85, 0x4f, 0x2f, 0xb7, 0x9a, 0x97,
+    0xdb, 0x35, 0x50, 0x57, 0x46, 0xef, 0x99, 0x4d, 0x32, 0x4b, 0x18, 0x1c, 0xce, 0x3e, 0xa6, 0x70,
+    0xe1, 0xe4, 0x0a, 0x6e, 0xa2, 0x2b, 0xb8, 0x76, 0x72, 0xe5, 0xac, 0xa9, 0xbe, 0x77, 0x0f, 0x05,
+    0x21, 0x45, 0x9a, 0xca, 0xc2, 0x0c, 0x98, 0x7b, 0x6d, 0x3d, 0x1c, 0x6b, 0x30, 0x78, 0x52, 0xd8,
+    0xdb, 0x5c, 0x0b, 0x72, 0x3c, 0x7e, 0xa9, 0x1c, 0xdd, 0x34, 0xec, 0xe3, 0x5f, 0xc2, 0x46, 0xdf,
+    0xc9, 0xd8, 0x1f, 0x28, 0x69, 0x6a, 0x5b, 0x99, 0x68, 0xd0, 0x97, 0x10, 0xd0, 0x18, 0x11, 0x37,
+    0x69, 0x0c, 0x49, 0x58, 0x67, 0x9a, 0x9b, 0x38, 0x5e, 0xd0, 0x61, 0x44, 0x12, 0xba, 0x82, 0x1b,
+    0x7f, 0xd4, 0x9a, 0x3d, 0xae, 0x12, 0x46, 0x3b, 0x03, 0x71, 0x6b, 0xd5, 0x8d, 0x96, 0xbe, 0xb9,
+    0x32, 0x79, 0xd3, 0xf1, 0xff, 0x9d, 0x4e, 0xed, 0xd1, 0xe2, 0xb6, 0xbc, 0x30, 0xbe, 0x4c, 0x97,
+    0x20, 0x8e, 0x1f, 0x1a, 0x63, 0xe6, 0xef, 0x20, 0xee, 0x26, 0x06, 0x57, 0x3b, 0xfb, 0x17, 0x90,
+    0xa1, 0xf9, 0x0b, 0xf6, 0xff, 0x00, 0x97, 0xfe, 0xbb, 0x15, 0xd8, 0x16, 0x00, 0x00,
+};
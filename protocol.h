@@ -0,0 +1,193 @@
+// Общие для main.cpp и tools/fleet_load.cpp части протокола обмена с сервером:
+// повторы с задержкой и разрыв цепи, разбор адреса сервера, распознавание пустого
+// ответа и поля устройства в запросе. Обычный C++ без заголовков Arduino, чтобы
+// генератор нагрузки собирался компилятором компьютера.
+#pragma once
+
+#include <ctype.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+const unsigned long RETRY_MIN_DELAY = 1000;
+const size_t HTTP_HOST_MAX = 64;
+const size_t HTTP_PATH_MAX = 96;
+
+enum BreakerState {
+    BREAKER_CLOSED,
+    BREAKER_OPEN,
+    BREAKER_HALF_OPEN
+};
+
+const char* const BREAKER_STATE_NAMES[] = { "closed", "open", "half-open" };
+
+// Устройств за одной точкой доступа и подключений в секунду, которые она принимает;
+// прошивку под другой парк собирают с -DWIFI_FLEET_SIZE=... и -DWIFI_AP_JOIN_RATE=...
+#ifndef WIFI_FLEET_SIZE
+#define WIFI_FLEET_SIZE 100
+#endif
+#ifndef WIFI_AP_JOIN_RATE
+#define WIFI_AP_JOIN_RATE 10
+#endif
+
+// Окно первой попытки после общего обрыва. Попытка - до двух подключений (по подсказке и со
+// сканированием), и ещё втрое больше на неравномерность случайного разброса по секундам
+const unsigned long WIFI_REJOIN_WINDOW = WIFI_FLEET_SIZE * 1000UL / WIFI_AP_JOIN_RATE * 6;
+
+// Экспоненциальная задержка с полным джиттером; после breakerThreshold неудач подряд
+// цепь размыкается на breakerCooldown, затем одна пробная попытка (half-open).
+// deferWindow - разброс первой попытки после потери связи, общей для всего парка
+struct RetryPolicy {
+    const char* name;
+    unsigned long baseDelay;
+    unsigned long maxDelay;
+    uint8_t breakerThreshold;
+    unsigned long breakerCooldown;
+    unsigned long deferWindow;
+    BreakerState state;
+    uint8_t failures;
+    bool waiting;
+    unsigned long nextAttempt;
+    unsigned long lastDelay;
+    uint32_t totalFailures;
+    uint32_t trips;
+};
+
+const RetryPolicy RETRY_WIFI_POLICY = { "wifi", 5000, 300000, 5, 600000, WIFI_REJOIN_WINDOW, BREAKER_CLOSED, 0, false, 0, 0, 0, 0 };
+const RetryPolicy RETRY_SERVER_POLICY = { "server", 15000, 600000, 5, 900000, 15000, BREAKER_CLOSED, 0, false, 0, 0, 0, 0 };
+const RetryPolicy RETRY_PUSH_POLICY = { "push", 5000, 300000, 10, 900000, 5000, BREAKER_CLOSED, 0, false, 0, 0, 0, 0 };
+
+// Случайная задержка в [low, high]; у прошивки и генератора нагрузки свой источник
+typedef unsigned long (*RetryJitter)(unsigned long low, unsigned long high);
+
+inline bool retryPolicyReady(RetryPolicy& policy, unsigned long now) {
+    if (!policy.waiting) return true;
+    if ((long)(now - policy.nextAttempt) < 0) return false;
+
+    policy.waiting = false;
+    if (policy.state == BREAKER_OPEN) {
+        policy.state = BREAKER_HALF_OPEN;
+    }
+    return true;
+}
+
+inline void retryPolicyTrip(RetryPolicy& policy, unsigned long now, RetryJitter jitter) {
+    if (policy.state != BREAKER_OPEN) {
+        policy.trips++;
+    }
+    policy.state = BREAKER_OPEN;
+    // Пауза тоже со случайным разбросом, чтобы пробные попытки не совпали у всего парка
+    policy.lastDelay = jitter(policy.breakerCooldown / 2, policy.breakerCooldown);
+    policy.nextAttempt = now + policy.lastDelay;
+    policy.waiting = true;
+}
+
+// Возвращает задержку до следующей попытки; цепь могла разомкнуться (state == BREAKER_OPEN)
+inline unsigned long retryPolicyFailed(RetryPolicy& policy, unsigned long now, RetryJitter jitter) {
+    policy.totalFailures++;
+    if (policy.failures < 255) policy.failures++;
+
+    if (policy.state != BREAKER_CLOSED || policy.failures >= policy.breakerThreshold) {
+        retryPolicyTrip(policy, now, jitter);
+        return policy.lastDelay;
+    }
+
+    unsigned long ceiling = policy.baseDelay;
+    for (uint8_t i = 1; i < policy.failures && ceiling < policy.maxDelay; i++) {
+        ceiling *= 2;
+    }
+    if (ceiling > policy.maxDelay) ceiling = policy.maxDelay;
+
+    policy.lastDelay = jitter(RETRY_MIN_DELAY, ceiling);
+    policy.nextAttempt = now + policy.lastDelay;
+    policy.waiting = true;
+    return policy.lastDelay;
+}
+
+inline void retryPolicySucceeded(RetryPolicy& policy) {
+    policy.state = BREAKER_CLOSED;
+    policy.failures = 0;
+    policy.waiting = false;
+}
+
+// Первая попытка после восстановления связи, со случайной задержкой до deferWindow
+inline void retryPolicyDefer(RetryPolicy& policy, unsigned long now, RetryJitter jitter) {
+    policy.lastDelay = jitter(0, policy.deferWindow);
+    policy.nextAttempt = now + policy.lastDelay;
+    policy.waiting = true;
+}
+
+inline unsigned long retryPolicyWait(const RetryPolicy& policy, unsigned long now) {
+    if (!policy.waiting) return 0;
+    long remaining = (long)(policy.nextAttempt - now);
+    return remaining > 0 ? (unsigned long)remaining : 0;
+}
+
+// scheme://host[:port]/path; host и path - буферы на HTTP_HOST_MAX + 1 и HTTP_PATH_MAX + 1
+inline bool parseUrl(const char* url, const char* scheme, uint16_t defaultPort, char* host, char* path, uint16_t& port) {
+    size_t schemeLength = strlen(scheme);
+    if (strncmp(url, scheme, schemeLength) != 0) return false;
+
+    const char* hostStart = url + schemeLength;
+    const char* pathStart = strchr(hostStart, '/');
+    size_t hostLength = pathStart != nullptr ? (size_t)(pathStart - hostStart) : strlen(hostStart);
+
+    port = defaultPort;
+    const char* colon = (const char*)memchr(hostStart, ':', hostLength);
+    if (colon != nullptr) {
+        port = atoi(colon + 1);
+        hostLength = colon - hostStart;
+    }
+
+    if (pathStart == nullptr) pathStart = "/";
+    if (hostLength == 0 || hostLength > HTTP_HOST_MAX || strlen(pathStart) > HTTP_PATH_MAX || port == 0) return false;
+
+    memcpy(host, hostStart, hostLength);
+    host[hostLength] = '\0';
+    strcpy(path, pathStart);
+    return true;
+}
+
+// Ответ {} (с пробелами или без) - состояние на сервере не изменилось
+inline bool isEmptyResponse(const char* body, size_t length) {
+    size_t i = 0;
+    while (i < length && isspace((unsigned char)body[i])) i++;
+    if (i + 1 >= length || body[i] != '{') return false;
+
+    i++;
+    while (i < length && isspace((unsigned char)body[i])) i++;
+    if (i >= length || body[i] != '}') return false;
+
+    i++;
+    while (i < length && isspace((unsigned char)body[i])) i++;
+    return i == length;
+}
+
+// Поля устройства в запросе на сервер: полные при fullSync, иначе "delta" и только
+// то, что изменилось с последнего подтверждённого ответа (acked). Out принимает
+// add(key, value) для строк и чисел и addFlag(key); у Data поля как у DeviceData.
+template <typename Out, typename Data>
+void writeDeviceFields(Out& out, const Data& data, const Data& acked, uint32_t seq, const char* rev, const char* mac, bool fullSync) {
+    out.add("boardID", data.boardID.c_str());
+    out.add("token", data.token.c_str());
+    out.add("seq", seq);
+    if (rev[0] != '\0') out.add("rev", rev);
+
+    if (fullSync) {
+        out.add("user", data.user.c_str());
+        out.add("text", data.text.c_str());
+        out.add("status", data.status.c_str());
+        out.add("uptime", data.uptime);
+        out.add("serverUrl", data.serverUrl.c_str());
+        out.add("mac", mac);
+        return;
+    }
+
+    out.addFlag("delta");
+    if (data.user != acked.user) out.add("user", data.user.c_str());
+    if (data.text != acked.text) out.add("text", data.text.c_str());
+    if (data.status != acked.status) out.add("status", data.status.c_str());
+    if (data.uptime != acked.uptime) out.add("uptime", data.uptime);
+    if (data.serverUrl != acked.serverUrl) out.add("serverUrl", data.serverUrl.c_str());
+}
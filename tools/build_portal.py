@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+"""Minify and gzip portal/index.html into portal_html.h (PROGMEM blob).
+
+Run from the repository root after editing the portal page:
+
+    python3 tools/build_portal.py
+"""
+
+import gzip
+import os
+import zlib
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, "portal", "index.html")
+OUTPUT = os.path.join(ROOT, "portal_html.h")
+
+
+def minify(html):
+    lines = []
+    for line in html.splitlines():
+        line = line.strip()
+        if line:
+            lines.append(line)
+    return "\n".join(lines)
+
+
+def main():
+    with open(SOURCE, encoding="utf-8") as f:
+        html = f.read()
+
+    minified = minify(html).encode("utf-8")
+    compressed = gzip.compress(minified, compresslevel=9, mtime=0)
+    etag = "%08x" % (zlib.crc32(compressed) & 0xFFFFFFFF)
+
+    rows = []
+    for i in range(0, len(compressed), 16):
+        chunk = compressed[i:i + 16]
+        rows.append("    " + ", ".join("0x%02x" % b for b in chunk) + ",")
+
+    with open(OUTPUT, "w", encoding="utf-8", newline="\r\n") as f:
+        f.write("// Generated by tools/build_portal.py from portal/index.html. Do not edit.\n")
+        f.write("#pragma once\n\n")
+        f.write("#define PORTAL_HTML_ETAG \"\\\"%s\\\"\"\n" % etag)
+        f.write("#define PORTAL_HTML_GZ_LEN %d\n\n" % len(compressed))
+        f.write("const uint8_t PORTAL_HTML_GZ[] PROGMEM = {\n")
+        f.write("\n".join(rows) + "\n")
+        f.write("};\n")
+
+    print("portal: %d bytes -> %d minified -> %d gzipped, etag %s"
+          % (len(html.encode("utf-8")), len(minified), len(compressed), etag))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,219 @@
+// Dispatch benchmark: runs main.cpp on the host shims and reports how late the
+// cooperative scheduler started each task, worst case, while the device goes
+// through normal updates, an access point outage and a server outage.
+//
+//     cmake -S . -B build && cmake --build build
+//     ./build/dispatch_bench --minutes 60 --ap-outage 5 --server-outage 15
+//
+// Lateness is what runScheduler() records per task: millis() at dispatch less
+// the task's deadline. It grows when another task in the same pass blocks,
+// so the worst case is set by the slowest callback (TLS handshake, Wi-Fi join,
+// flash write). The reset button is measured by a GPIO interrupt, so the
+// button task's lateness only delays the reset itself. To check that, the
+// bench taps the button (80 ms to 1.5 s, every few seconds at random offsets)
+// and compares each press length the firmware recorded with the real one.
+//
+// Options:
+//     --minutes N          virtual run time, default 60
+//     --ap-outage N        take the access point down for N minutes in the
+//                          second quarter of the run, default 0
+//     --server-outage N    backend answers 503 for N minutes in the third
+//                          quarter of the run, default 0
+//     --uptime MS          update interval the backend hands out, default 60000
+//     --tap-every MS       mean time between button taps, default 5000; 0 disables
+//     --seed N             seed for tap timing, default 1
+//     --verbose            echo the sketch's Serial output
+
+#include <Arduino.h>
+
+#include "host.h"
+#include "driver.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// Mirrors the task table in main.cpp
+typedef void (*TaskCallback)();
+
+struct Task {
+    const char* name;
+    TaskCallback callback;
+    unsigned long interval;
+    unsigned long nextRun;
+    bool enabled;
+    uint32_t runs;
+    uint32_t maxLateness;
+    uint32_t maxDuration;
+};
+
+void setup();
+void loop();
+
+extern Task tasks[];
+extern int taskCount;
+
+// Mirrors the reset button state in main.cpp
+struct ResetButton {
+    volatile bool pressed;
+    volatile unsigned long pressStart;
+    volatile unsigned long lastPressLength;
+    volatile uint32_t presses;
+    volatile bool resetRequested;
+};
+
+extern ResetButton resetButton;
+
+const uint8_t RESET_BUTTON_PIN = 0;
+
+struct TapStats {
+    uint32_t taps;
+    uint32_t registered;
+    uint32_t merged;
+    unsigned long maxError;
+};
+
+struct Phase {
+    const char* name;
+    uint64_t end;
+    bool accessPoint;
+    int failStatus;
+};
+
+static void resetTaskStats() {
+    for (int i = 0; i < taskCount; i++) {
+        tasks[i].runs = 0;
+        tasks[i].maxLateness = 0;
+        tasks[i].maxDuration = 0;
+    }
+}
+
+static void printTaskStats(const char* phase) {
+    uint32_t worst = 0;
+    int worstTask = -1;
+    printf("--- %s ---\n", phase);
+    printf("%-16s %8s %12s %12s\n", "task", "runs", "lateness ms", "max run us");
+    for (int i = 0; i < taskCount; i++) {
+        if (tasks[i].runs == 0) continue;
+        printf("%-16s %8u %12u %12u\n", tasks[i].name, tasks[i].runs, tasks[i].maxLateness, tasks[i].maxDuration);
+        if (tasks[i].maxLateness > worst) {
+            worst = tasks[i].maxLateness;
+            worstTask = i;
+        }
+    }
+    if (worstTask >= 0) printf("worst dispatch lateness: %u ms (%s)\n", worst, tasks[worstTask].name);
+}
+
+static void printTapStats(const TapStats& stats) {
+    if (stats.taps == 0) return;
+    printf("button taps: %u, registered %u, merged %u, max length error %lu ms\n",
+        stats.taps, stats.registered, stats.merged, stats.maxError);
+}
+
+// Presses the firmware has counted since the last call, matched in order to the scheduled taps
+static void collectTaps(const std::vector<unsigned long>& tapLengths, size_t& matched, TapStats& stats) {
+    uint32_t presses = resetButton.presses;
+    if (presses == matched) return;
+    // Нажатия, пришедшие за один проход loop(), видны только по последней длительности
+    stats.merged += presses - matched - 1;
+    matched = presses;
+    stats.registered++;
+    if (matched - 1 < tapLengths.size()) {
+        unsigned long expected = tapLengths[matched - 1];
+        unsigned long recorded = resetButton.lastPressLength;
+        unsigned long error = recorded > expected ? recorded - expected : expected - recorded;
+        stats.maxError = std::max(stats.maxError, error);
+    }
+}
+
+int main(int argc, char** argv) {
+    unsigned long minutes = host::optionValue(argc, argv, "minutes", 60);
+    unsigned long apOutage = host::optionValue(argc, argv, "ap-outage", 0);
+    unsigned long serverOutage = host::optionValue(argc, argv, "server-outage", 0);
+    host::Backend::Options backendOptions;
+    backendOptions.uptime = host::optionValue(argc, argv, "uptime", 60000);
+    unsigned long tapEvery = host::optionValue(argc, argv, "tap-every", 5000);
+    unsigned long seed = host::optionValue(argc, argv, "seed", 1);
+
+    host::setSerialEcho(host::option(argc, argv, "verbose") != nullptr);
+    host::makeTempFsRoot();
+    host::provisionWiFi("HostNet", "password");
+
+    host::Backend backend(backendOptions);
+    backend.install();
+
+    host::resetClock();
+    setup();
+
+    const uint64_t minute = 60ULL * 1000000;
+    uint64_t start = host::clockMicros();
+    uint64_t quarter = minutes * minute / 4;
+    Phase phases[] = {
+        { "steady state", start + quarter, true, 0 },
+        { "access point outage", start + quarter + apOutage * minute, false, 0 },
+        { "recovery", start + 2 * quarter, true, 0 },
+        { "server outage", start + 2 * quarter + serverOutage * minute, true, 503 },
+        { "recovery", start + minutes * minute, true, 0 },
+    };
+
+    // Нажатия расписаны заранее: уровни меняются точно в срок, даже посреди блокирующего вызова
+    std::vector<unsigned long> tapLengths;
+    std::vector<uint64_t> tapTimes;
+    if (tapEvery > 0) {
+        host::HeapUntracked untracked;
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<unsigned long> gap(tapEvery / 2, tapEvery * 3 / 2);
+        std::uniform_int_distribution<unsigned long> length(80, 1500);
+        uint64_t at = start + 2000000;
+        while (at < start + minutes * minute) {
+            unsigned long ms = length(rng);
+            host::schedulePin(RESET_BUTTON_PIN, LOW, at);
+            host::schedulePin(RESET_BUTTON_PIN, HIGH, at + ms * 1000ULL);
+            tapTimes.push_back(at);
+            tapLengths.push_back(ms);
+            at += (ms + gap(rng)) * 1000ULL;
+        }
+    }
+    size_t matched = resetButton.presses;
+    size_t tapsScheduled = 0;
+    TapStats totalTaps = {};
+
+    std::vector<Task> worst(tasks, tasks + taskCount);
+    for (Task& task : worst) {
+        task.runs = 0;
+        task.maxLateness = 0;
+        task.maxDuration = 0;
+    }
+    for (const Phase& phase : phases) {
+        if (host::clockMicros() >= phase.end) continue;
+
+        host::setAccessPoint(phase.accessPoint);
+        backend.setFailStatus(phase.failStatus);
+        resetTaskStats();
+        TapStats taps = {};
+        while (host::clockMicros() < phase.end) {
+            loop();
+            collectTaps(tapLengths, matched, taps);
+        }
+        while (tapsScheduled < tapTimes.size() && tapTimes[tapsScheduled] + tapLengths[tapsScheduled] * 1000ULL <= phase.end) {
+            tapsScheduled++;
+            taps.taps++;
+        }
+        printTaskStats(phase.name);
+        printTapStats(taps);
+        totalTaps.taps += taps.taps;
+        totalTaps.registered += taps.registered;
+        totalTaps.merged += taps.merged;
+        totalTaps.maxError = std::max(totalTaps.maxError, taps.maxError);
+        for (int i = 0; i < taskCount; i++) {
+            worst[i].runs += tasks[i].runs;
+            worst[i].maxLateness = std::max(worst[i].maxLateness, tasks[i].maxLateness);
+            worst[i].maxDuration = std::max(worst[i].maxDuration, tasks[i].maxDuration);
+        }
+    }
+
+    std::copy(worst.begin(), worst.end(), tasks);
+    printTaskStats("whole run, worst per task");
+    printTapStats(totalTaps);
+    return 0;
+}
@@ -0,0 +1,2168 @@
+// Fleet load generator for the backend behind SERVER_URL.
+//
+// Every virtual device follows the same protocol as main.cpp. It sends a hello
+// on each Wi-Fi join and then periodic updates: delta or full sync, with rev
+// and If-None-Match. Samples are queued while offline and drained later as
+// single queued posts or as batches. The device also applies the uptime,
+// serverUrl, rev and resync values that come back from the server. It retries
+// through the same jittered backoff and circuit breakers, and reconnects to
+// Wi-Fi after an AP outage. The backoff, URL parsing, empty response check
+// and request fields come from protocol.h, shared with main.cpp; the other
+// functions below keep the names of their main.cpp counterparts. Change them
+// together.
+//
+// Devices are split across worker threads. Each worker runs an epoll event
+// loop and a timer heap, so tens of thousands of devices need only a handful
+// of threads.
+//
+// Build and run (Linux):
+//
+//     g++ -O2 -std=c++17 -pthread tools/fleet_load.cpp -o fleet_load
+//
+// or as the fleet_load target of the CMake host build.
+//     ./fleet_load --serve 8080 --change 30 --outage 90:20 &
+//     ./fleet_load --url http://127.0.0.1:8080/?init --devices 20000 --interval 10
+//         --duration 180 --storm 60:15:50 --mix delta=70,full=20,batch=10
+//
+// Only plain http:// is spoken: put the TLS terminator in front of the
+// backend, or point --url at the backend directly. Each device keeps one
+// connection open, so a single target IP allows about 28k devices (the
+// ephemeral port range). The open file limit is raised to the hard limit.
+//
+// --serve runs a small stand-in backend on the same event loop. It changes
+// its state every --change seconds and answers with ETag, 304 and {} the
+// same way the device expects. During an --outage window it answers 503 and
+// closes the connection. This gives a baseline for the generator itself.
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../protocol.h"
+
+// Совпадают с main.cpp
+const unsigned long HTTP_CONNECT_TIMEOUT = 5000;
+const unsigned long HTTP_SEND_TIMEOUT = 5000;
+const unsigned long HTTP_FIRST_BYTE_TIMEOUT = 10000;
+const unsigned long HTTP_BODY_TIMEOUT = 5000;
+const size_t RESPONSE_BODY_MAX = 1024;
+const size_t STATE_TAG_MAX = 48;
+const int HTTP_CODE_OK = 200;
+const int HTTP_CODE_NOT_MODIFIED = 304;
+const int TELEMETRY_RAM_SAMPLES = 16;
+const size_t TELEMETRY_SPILL_MAX_BYTES = 16384;
+const unsigned long TELEMETRY_DRAIN_INTERVAL = 1000;
+const int TELEMETRY_BATCH_SIZE = 8;
+const unsigned long TELEMETRY_BATCH_WINDOW = 300000;
+
+const size_t HTTP_RESPONSE_MAX = 65536;
+const int LATENCY_SUB_BUCKETS = 8;
+const int LATENCY_HIST_BUCKETS = 16 + 36 * LATENCY_SUB_BUCKETS;
+const int EPOLL_BATCH = 1024;
+const unsigned long LOOP_IDLE_WAIT = 100;
+
+enum ServerRequestKind {
+    SERVER_REQUEST_UPDATE,
+    SERVER_REQUEST_HELLO,
+    SERVER_REQUEST_QUEUED,
+    SERVER_REQUEST_BATCH,
+    SERVER_REQUEST_KINDS
+};
+
+const char* const SERVER_REQUEST_NAMES[SERVER_REQUEST_KINDS] = {"update", "hello", "queued", "batch"};
+
+enum HttpPhase {
+    HTTP_PHASE_IDLE,
+    HTTP_PHASE_DNS,
+    HTTP_PHASE_CONNECT,
+    HTTP_PHASE_SEND,
+    HTTP_PHASE_FIRST_BYTE,
+    HTTP_PHASE_HEADERS,
+    HTTP_PHASE_BODY
+};
+
+enum HttpBodyMode {
+    HTTP_BODY_NONE,
+    HTTP_BODY_LENGTH,
+    HTTP_BODY_CHUNKED,
+    HTTP_BODY_UNTIL_CLOSE
+};
+
+enum HttpError {
+    HTTP_ERROR_TIMEOUT = -1,
+    HTTP_ERROR_CONNECTION_LOST = -2,
+    HTTP_ERROR_DNS = -3,
+    HTTP_ERROR_CONNECT = -4,
+    HTTP_ERROR_BAD_RESPONSE = -5,
+    HTTP_ERROR_NO_WIFI = -6,
+    HTTP_ERRORS = 6
+};
+
+enum RetryPolicyId {
+    RETRY_WIFI,
+    RETRY_SERVER,
+    RETRY_POLICIES
+};
+
+const char* const RETRY_POLICY_NAMES[RETRY_POLICIES] = {"wifi", "server"};
+
+// Конфигурация прошивки, которую изображает устройство
+enum DeviceProfile {
+    PROFILE_DELTA,  // по умолчанию: DELTA_TELEMETRY_ENABLED, без пакетов
+    PROFILE_FULL,   // DELTA_TELEMETRY_ENABLED = false
+    PROFILE_BATCH,  // TELEMETRY_BATCH_ENABLED = true
+    DEVICE_PROFILES
+};
+
+const char* const DEVICE_PROFILE_NAMES[DEVICE_PROFILES] = {"delta", "full", "batch"};
+
+const RetryPolicy RETRY_POLICY_DEFAULTS[RETRY_POLICIES] = {
+    RETRY_WIFI_POLICY,
+    RETRY_SERVER_POLICY
+};
+
+struct TimeWindow {
+    unsigned long start;
+    unsigned long duration;
+    int percent;
+};
+
+struct Options {
+    std::string url = "http://127.0.0.1:8080/?init";
+    int devices = 1000;
+    int threads = 0;
+    unsigned long duration = 60000;
+    unsigned long interval = 10000;
+    unsigned long ramp = 10000;
+    unsigned long joinTime = 3000;
+    unsigned long reportInterval = 5000;
+    size_t textBytes = 8;
+    int mix[DEVICE_PROFILES] = {100, 0, 0};
+    std::vector<TimeWindow> storms;
+    uint64_t seed = 1;
+
+    int servePort = 0;
+    unsigned long changeInterval = 30000;
+    unsigned long serveUptime = 0;
+    std::vector<TimeWindow> outages;
+};
+
+struct ServerTarget {
+    std::string url;
+    char host[HTTP_HOST_MAX + 1];
+    char path[HTTP_PATH_MAX + 1];
+    uint16_t port;
+    bool resolved;
+    sockaddr_storage address;
+    socklen_t addressLength;
+};
+
+struct DeviceData {
+    std::string boardID;
+    std::string token;
+    std::string user;
+    std::string text;
+    std::string status;
+    std::string serverUrl;
+    long uptime;
+    unsigned long timer;
+};
+
+struct TelemetrySample {
+    uint32_t time;
+    uint32_t timer;
+    uint16_t batteryMv;
+    int8_t rssi;
+    uint8_t flags;
+    char status[24];
+};
+
+const size_t TELEMETRY_QUEUE_MAX = TELEMETRY_RAM_SAMPLES + TELEMETRY_SPILL_MAX_BYTES / sizeof(TelemetrySample);
+
+struct ServerRequest {
+    HttpPhase phase = HTTP_PHASE_IDLE;
+    ServerRequestKind kind = SERVER_REQUEST_UPDATE;
+    std::string out;
+    size_t outSent = 0;
+    std::string in;
+    size_t bodyStart = 0;
+    std::string body;
+    bool bodyOverflow = false;
+    int status = 0;
+    std::string etag;
+    bool keepAlive = true;
+    HttpBodyMode bodyMode = HTTP_BODY_UNTIL_CLOSE;
+    size_t contentLength = 0;
+    bool reused = false;
+    bool retried = false;
+    unsigned long startMicros = 0;
+    unsigned long phaseStart = 0;
+    TelemetrySample sample = {};
+    int batchCount = 0;
+};
+
+struct Worker;
+
+struct Device {
+    Worker* worker = nullptr;
+    int id = 0;
+    DeviceProfile profile = PROFILE_DELTA;
+    unsigned long bootTime = 0;
+
+    DeviceData deviceData;
+    DeviceData ackedDeviceData;
+    bool deviceDataAcked = false;
+    bool resyncRequested = false;
+    uint32_t telemetrySequence = 0;
+    std::string serverEtag;
+    std::string serverRev;
+    std::string serverConnectionUrl;
+    std::shared_ptr<const ServerTarget> target;
+    RetryPolicy retryPolicies[RETRY_POLICIES];
+    std::deque<TelemetrySample> telemetryQueue;
+
+    bool wifiConnected = false;
+    bool wifiJoining = false;
+    bool wifiBooting = true;
+
+    // Время следующего запуска задачи, 0 - задача остановлена (как stopTask())
+    unsigned long wifiAt = 0;
+    unsigned long updateAt = 0;
+    unsigned long drainAt = 0;
+    unsigned long armedAt = 0;
+
+    int fd = -1;
+    uint32_t epollEvents = 0;
+    ServerRequest serverRequest;
+};
+
+typedef std::atomic<uint64_t> Counter;
+
+struct LoadStats {
+    Counter requests[SERVER_REQUEST_KINDS] = {};
+    Counter success{};
+    Counter notModified{};
+    Counter clientErrors{};
+    Counter serverErrors{};
+    Counter otherStatus{};
+    Counter errors[HTTP_ERRORS] = {};
+    Counter applied{};
+    Counter unchanged{};
+    Counter badJson{};
+    Counter uptimeChanges{};
+    Counter urlChanges{};
+    Counter resyncs{};
+    Counter connects{};
+    Counter reused{};
+    Counter dropped{};
+    Counter idleClosed{};
+    Counter payloadBytes{};
+    Counter responseBytes{};
+    Counter queued{};
+    Counter queueOverflow{};
+    Counter drained{};
+    Counter batchedSamples{};
+    Counter trips[RETRY_POLICIES] = {};
+    Counter wifiJoins{};
+    Counter wifiLosses{};
+    std::atomic<int64_t> wifiConnected{0};
+    std::atomic<int64_t> openConnections{0};
+    Counter latency[LATENCY_HIST_BUCKETS] = {};
+    Counter latencyTotalMicros{};
+    Counter latencyMaxMicros{};
+};
+
+struct TimerEntry {
+    unsigned long due;
+    Device* device;
+
+    bool operator>(const TimerEntry& other) const {
+        return due > other.due;
+    }
+};
+
+struct Worker {
+    int index = 0;
+    int epollFd = -1;
+    std::vector<Device> devices;
+    std::priority_queue<TimerEntry, std::vector<TimerEntry>, std::greater<TimerEntry>> timers;
+    std::vector<bool> stormStarted;
+    LoadStats stats;
+    std::thread thread;
+};
+
+Options opts;
+std::atomic<bool> stopRequested{false};
+thread_local std::mt19937_64 rng;
+
+std::mutex serverTargetsLock;
+std::map<std::string, std::shared_ptr<const ServerTarget>> serverTargets;
+
+unsigned long millis();
+unsigned long micros();
+unsigned long retryJitter(unsigned long low, unsigned long high);
+bool retryReady(Device& dev, RetryPolicyId id);
+unsigned long retryFailed(Device& dev, RetryPolicyId id);
+void retrySucceeded(Device& dev, RetryPolicyId id);
+void retryDefer(Device& dev, RetryPolicyId id);
+void retryTrip(Device& dev, RetryPolicyId id);
+unsigned long retryWait(Device& dev, RetryPolicyId id);
+std::shared_ptr<const ServerTarget> resolveServerTarget(const std::string& url);
+void bootDevice(Device& dev);
+void serviceDevice(Device& dev);
+void armDevice(Device& dev);
+void serviceWiFi(Device& dev);
+void loseWiFi(Device& dev);
+bool accessPointDown(const Device& dev, unsigned long now);
+void runServerUpdate(Device& dev);
+bool sendDataToServer(Device& dev, bool isHello);
+void addDeviceFields(Device& dev, std::string& out, bool fullSync);
+void addHeapSummary(std::string& out);
+void captureTelemetrySample(Device& dev, TelemetrySample& sample);
+void enqueueTelemetrySample(Device& dev, const TelemetrySample& sample);
+void popTelemetrySamples(Device& dev, int count);
+void drainTelemetryQueue(Device& dev);
+void pauseTelemetryDrain(Device& dev);
+bool sendQueuedSample(Device& dev, const TelemetrySample& sample);
+bool telemetryBatchDue(Device& dev);
+bool sendTelemetryBatch(Device& dev);
+bool startServerRequest(Device& dev, ServerRequestKind kind, const std::string& payload);
+bool serverRequestActive(const Device& dev);
+void setServerRequestPhase(Device& dev, HttpPhase phase);
+unsigned long httpPhaseTimeout(HttpPhase phase);
+void openServerConnection(Device& dev);
+void closeServerConnection(Device& dev);
+void watchServerConnection(Device& dev, uint32_t events);
+void serviceServerConnection(Device& dev, uint32_t events);
+void sendServerRequest(Device& dev);
+void readServerResponse(Device& dev);
+bool parseServerResponse(Device& dev);
+bool readServerResponseHeaders(ServerRequest& req, size_t headerEnd);
+int decodeChunkedBody(ServerRequest& req);
+void setServerResponseBody(ServerRequest& req, const char* data, size_t length);
+void lostServerConnection(Device& dev);
+void finishServerRequest(Device& dev, int httpCode);
+void onServerResponse(Device& dev, ServerRequestKind kind, int httpCode, const std::string& body);
+bool applyServerResponse(Device& dev, int httpCode, const std::string& body);
+void applyServerFields(Device& dev, const std::vector<std::pair<std::string, std::string>>& fields);
+void acknowledgeServerUpdate(Device& dev);
+const std::string* findField(const std::vector<std::pair<std::string, std::string>>& fields, const char* key);
+bool parseFlatJson(const char* body, size_t length, std::vector<std::pair<std::string, std::string>>& fields);
+void appendJsonString(std::string& out, const char* key, const std::string& value);
+void appendJsonNumber(std::string& out, const char* key, long long value);
+void recordLatency(LoadStats& stats, unsigned long micros);
+int latencyBucket(uint64_t micros);
+uint64_t latencyBucketBound(int bucket);
+uint64_t latencyPercentile(const std::vector<uint64_t>& buckets, double percentile);
+void runWorker(Worker& worker);
+int runLoad();
+int runServer();
+bool parseOptions(int argc, char** argv);
+bool parseWindow(const char* text, TimeWindow& window);
+bool parseMix(const char* text);
+void raiseFileLimit(size_t wanted);
+
+unsigned long millis() {
+    static const auto start = std::chrono::steady_clock::now();
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+unsigned long micros() {
+    static const auto start = std::chrono::steady_clock::now();
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+void count(Counter& counter, uint64_t value = 1) {
+    counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t load(const Counter& counter) {
+    return counter.load(std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------
+// Политики повторов: retryPolicy*() из protocol.h, состояние у каждого устройства своё
+
+unsigned long retryJitter(unsigned long low, unsigned long high) {
+    if (high <= low) return low;
+    return low + (unsigned long)(rng() % (high - low + 1));
+}
+
+bool retryReady(Device& dev, RetryPolicyId id) {
+    return retryPolicyReady(dev.retryPolicies[id], millis());
+}
+
+unsigned long retryFailed(Device& dev, RetryPolicyId id) {
+    RetryPolicy& policy = dev.retryPolicies[id];
+    uint32_t trips = policy.trips;
+    unsigned long delay = retryPolicyFailed(policy, millis(), retryJitter);
+    if (policy.trips != trips) count(dev.worker->stats.trips[id]);
+    return delay;
+}
+
+void retrySucceeded(Device& dev, RetryPolicyId id) {
+    retryPolicySucceeded(dev.retryPolicies[id]);
+}
+
+void retryDefer(Device& dev, RetryPolicyId id) {
+    retryPolicyDefer(dev.retryPolicies[id], millis(), retryJitter);
+}
+
+void retryTrip(Device& dev, RetryPolicyId id) {
+    RetryPolicy& policy = dev.retryPolicies[id];
+    uint32_t trips = policy.trips;
+    retryPolicyTrip(policy, millis(), retryJitter);
+    if (policy.trips != trips) count(dev.worker->stats.trips[id]);
+}
+
+unsigned long retryWait(Device& dev, RetryPolicyId id) {
+    return retryPolicyWait(dev.retryPolicies[id], millis());
+}
+
+// ---------------------------------------------------------------------------
+// Адрес сервера
+
+std::shared_ptr<const ServerTarget> resolveServerTarget(const std::string& url) {
+    std::lock_guard<std::mutex> guard(serverTargetsLock);
+    auto found = serverTargets.find(url);
+    if (found != serverTargets.end()) return found->second;
+
+    // Разрешаем один раз на адрес: сервер может раздать новый serverUrl всему парку сразу
+    std::shared_ptr<ServerTarget> target = std::make_shared<ServerTarget>();
+    target->url = url;
+    target->resolved = false;
+    if (!parseUrl(url.c_str(), "http://", 80, target->host, target->path, target->port)) {
+        serverTargets[url] = nullptr;
+        return nullptr;
+    }
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    char port[8];
+    snprintf(port, sizeof(port), "%u", target->port);
+    if (getaddrinfo(target->host, port, &hints, &result) == 0 && result != nullptr) {
+        memcpy(&target->address, result->ai_addr, result->ai_addrlen);
+        target->addressLength = result->ai_addrlen;
+        target->resolved = true;
+        freeaddrinfo(result);
+    }
+
+    serverTargets[url] = target;
+    return target;
+}
+
+// ---------------------------------------------------------------------------
+// Устройство: задачи планировщика
+
+void bootDevice(Device& dev) {
+    for (int i = 0; i < RETRY_POLICIES; i++) {
+        dev.retryPolicies[i] = RETRY_POLICY_DEFAULTS[i];
+    }
+
+    char boardID[24];
+    snprintf(boardID, sizeof(boardID), "LOAD_%06x", dev.id);
+    dev.deviceData.boardID = boardID;
+    dev.deviceData.token = boardID;
+    dev.deviceData.user = "";
+    dev.deviceData.status = "New device";
+    dev.deviceData.uptime = opts.interval;
+    dev.deviceData.serverUrl = opts.url;
+    dev.deviceData.timer = 0;
+
+    // Текст по умолчанию "Welcome!", повторённый до нужной длины
+    const char* welcome = "Welcome!";
+    dev.deviceData.text.clear();
+    for (size_t i = 0; i < opts.textBytes; i++) {
+        dev.deviceData.text += welcome[i % 8];
+    }
+
+    // Включения разнесены по --ramp, подключение к точке доступа занимает --join
+    dev.bootTime = millis() + retryJitter(0, opts.ramp);
+    dev.wifiJoining = true;
+    dev.wifiAt = dev.bootTime + opts.joinTime;
+    dev.updateAt = dev.bootTime + dev.deviceData.uptime;
+    armDevice(dev);
+}
+
+unsigned long deviceMillis(const Device& dev) {
+    unsigned long now = millis();
+    return now > dev.bootTime ? now - dev.bootTime : 0;
+}
+
+void armDevice(Device& dev) {
+    unsigned long next = 0;
+    auto consider = [&next](unsigned long at) {
+        if (at != 0 && (next == 0 || at < next)) next = at;
+    };
+
+    consider(dev.wifiAt);
+    consider(dev.updateAt);
+    consider(dev.drainAt);
+    if (dev.serverRequest.phase != HTTP_PHASE_IDLE) {
+        consider(dev.serverRequest.phaseStart + httpPhaseTimeout(dev.serverRequest.phase));
+    }
+
+    if (next == 0) return;
+    if (dev.armedAt != 0 && dev.armedAt <= next) return;
+
+    dev.armedAt = next;
+    dev.worker->timers.push({next, &dev});
+}
+
+void serviceDevice(Device& dev) {
+    ServerRequest& req = dev.serverRequest;
+    unsigned long now = millis();
+
+    if (req.phase == HTTP_PHASE_DNS) {
+        openServerConnection(dev);
+    }
+    else if (req.phase != HTTP_PHASE_IDLE && now - req.phaseStart >= httpPhaseTimeout(req.phase)) {
+        finishServerRequest(dev, HTTP_ERROR_TIMEOUT);
+    }
+
+    if (dev.wifiAt != 0 && now >= dev.wifiAt) serviceWiFi(dev);
+    if (dev.updateAt != 0 && now >= dev.updateAt) runServerUpdate(dev);
+    if (dev.drainAt != 0 && now >= dev.drainAt) drainTelemetryQueue(dev);
+}
+
+void serviceWiFi(Device& dev) {
+    LoadStats& stats = dev.worker->stats;
+    unsigned long now = millis();
+
+    if (!dev.wifiJoining) {
+        retryReady(dev, RETRY_WIFI);
+        dev.wifiJoining = true;
+        dev.wifiAt = now + opts.joinTime;
+        return;
+    }
+
+    dev.wifiJoining = false;
+    if (accessPointDown(dev, now)) {
+        // При загрузке устройство сразу уходит в режим точки доступа, дальше - как retrySavedNetwork()
+        if (dev.wifiBooting) retryTrip(dev, RETRY_WIFI);
+        else retryFailed(dev, RETRY_WIFI);
+        dev.wifiAt = now + retryWait(dev, RETRY_WIFI);
+        return;
+    }
+
+    dev.wifiAt = 0;
+    dev.wifiBooting = false;
+    dev.wifiConnected = true;
+    count(stats.wifiJoins);
+    stats.wifiConnected.fetch_add(1, std::memory_order_relaxed);
+    retrySucceeded(dev, RETRY_WIFI);
+
+    sendDataToServer(dev, true);
+}
+
+void loseWiFi(Device& dev) {
+    LoadStats& stats = dev.worker->stats;
+    if (!dev.wifiConnected) return;
+
+    dev.wifiConnected = false;
+    count(stats.wifiLosses);
+    stats.wifiConnected.fetch_sub(1, std::memory_order_relaxed);
+
+    if (serverRequestActive(dev)) finishServerRequest(dev, HTTP_ERROR_NO_WIFI);
+    closeServerConnection(dev);
+    dev.drainAt = 0;
+
+    // Как reconnectWiFi(): первая попытка тоже с разбросом
+    retryDefer(dev, RETRY_WIFI);
+    dev.wifiAt = millis() + retryWait(dev, RETRY_WIFI);
+}
+
+bool stormAffects(const TimeWindow& storm, const Device& dev) {
+    return (uint32_t)(dev.id * 2654435761u) % 100 < (uint32_t)storm.percent;
+}
+
+bool accessPointDown(const Device& dev, unsigned long now) {
+    for (const TimeWindow& storm : opts.storms) {
+        if (now >= storm.start && now < storm.start + storm.duration && stormAffects(storm, dev)) return true;
+    }
+    return false;
+}
+
+void runServerUpdate(Device& dev) {
+    dev.updateAt = millis() + dev.deviceData.uptime;
+
+    TelemetrySample sample;
+    captureTelemetrySample(dev, sample);
+
+    if (dev.profile == PROFILE_BATCH) {
+        enqueueTelemetrySample(dev, sample);
+        if (dev.wifiConnected && !serverRequestActive(dev) && telemetryBatchDue(dev) && retryReady(dev, RETRY_SERVER)) {
+            sendTelemetryBatch(dev);
+        }
+        return;
+    }
+
+    if (!dev.wifiConnected || serverRequestActive(dev) || !retryReady(dev, RETRY_SERVER)) {
+        enqueueTelemetrySample(dev, sample);
+        return;
+    }
+
+    dev.deviceData.timer = deviceMillis(dev);
+    if (sendDataToServer(dev, false)) {
+        dev.serverRequest.sample = sample;
+    }
+    else {
+        enqueueTelemetrySample(dev, sample);
+    }
+}
+
+bool sendDataToServer(Device& dev, bool isHello) {
+    if (!dev.wifiConnected || serverRequestActive(dev)) return false;
+
+    bool fullSync = isHello || dev.profile == PROFILE_FULL || !dev.deviceDataAcked || dev.resyncRequested;
+
+    std::string payload = "{";
+    addDeviceFields(dev, payload, fullSync);
+    appendJsonNumber(payload, "time", deviceMillis(dev));
+    if (isHello) {
+        appendJsonString(payload, "hello", "Привет от ESP8266");
+    }
+    else {
+        appendJsonNumber(payload, "timer", dev.deviceData.timer);
+        addHeapSummary(payload);
+    }
+    payload += '}';
+
+    return startServerRequest(dev, isHello ? SERVER_REQUEST_HELLO : SERVER_REQUEST_UPDATE, payload);
+}
+
+// Приёмник для writeDeviceFields(): поля дописываются в тело запроса
+struct PayloadFieldWriter {
+    std::string& out;
+
+    void add(const char* key, const char* value) {
+        appendJsonString(out, key, value);
+    }
+
+    void add(const char* key, long long value) {
+        appendJsonNumber(out, key, value);
+    }
+
+    void addFlag(const char* key) {
+        if (out.size() > 1) out += ',';
+        out += '"';
+        out += key;
+        out += "\":true";
+    }
+};
+
+void addDeviceFields(Device& dev, std::string& out, bool fullSync) {
+    char mac[18];
+    snprintf(mac, sizeof(mac), "5C:CF:7F:%02X:%02X:%02X", (dev.id >> 16) & 0xFF, (dev.id >> 8) & 0xFF, dev.id & 0xFF);
+
+    PayloadFieldWriter writer = { out };
+    writeDeviceFields(writer, dev.deviceData, dev.ackedDeviceData, ++dev.telemetrySequence, dev.serverRev.c_str(), mac, fullSync);
+}
+
+void addHeapSummary(std::string& out) {
+    // Размер как у настоящей сводки после первых замеров
+    char heap[160];
+    snprintf(heap, sizeof(heap),
+        ",\"heap\":{\"free\":%lu,\"block\":%lu,\"frag\":%lu,\"server\":[%lu,%lu,%lu]}",
+        retryJitter(18000, 26000), retryJitter(9000, 16000), retryJitter(5, 30),
+        retryJitter(14000, 18000), retryJitter(7000, 9000), retryJitter(20, 40));
+    out += heap;
+}
+
+// ---------------------------------------------------------------------------
+// Очередь телеметрии
+
+void captureTelemetrySample(Device& dev, TelemetrySample& sample) {
+    sample.time = deviceMillis(dev);
+    sample.timer = dev.deviceData.timer;
+    sample.batteryMv = (uint16_t)retryJitter(3600, 4200);
+    sample.rssi = dev.wifiConnected ? -(int8_t)retryJitter(45, 85) : 0;
+    sample.flags = 0;
+    strncpy(sample.status, dev.deviceData.status.c_str(), sizeof(sample.status) - 1);
+    sample.status[sizeof(sample.status) - 1] = '\0';
+}
+
+void enqueueTelemetrySample(Device& dev, const TelemetrySample& sample) {
+    if (dev.telemetryQueue.size() >= TELEMETRY_QUEUE_MAX) {
+        dev.telemetryQueue.pop_front();
+        count(dev.worker->stats.queueOverflow);
+    }
+    dev.telemetryQueue.push_back(sample);
+    count(dev.worker->stats.queued);
+}
+
+void popTelemetrySamples(Device& dev, int count) {
+    while (count-- > 0 && !dev.telemetryQueue.empty()) {
+        dev.telemetryQueue.pop_front();
+    }
+}
+
+void drainTelemetryQueue(Device& dev) {
+    dev.drainAt = millis() + TELEMETRY_DRAIN_INTERVAL;
+
+    if (!dev.wifiConnected) {
+        dev.drainAt = 0;
+        return;
+    }
+
+    if (serverRequestActive(dev)) return;
+
+    if (!retryReady(dev, RETRY_SERVER)) {
+        dev.drainAt = millis() + retryWait(dev, RETRY_SERVER);
+        return;
+    }
+
+    if (dev.profile == PROFILE_BATCH) {
+        if (!telemetryBatchDue(dev)) {
+            dev.drainAt = 0;
+        }
+        else if (!sendTelemetryBatch(dev)) {
+            pauseTelemetryDrain(dev);
+        }
+        return;
+    }
+
+    if (dev.telemetryQueue.empty()) {
+        dev.drainAt = 0;
+        return;
+    }
+
+    if (!sendQueuedSample(dev, dev.telemetryQueue.front())) {
+        pauseTelemetryDrain(dev);
+    }
+}
+
+void pauseTelemetryDrain(Device& dev) {
+    unsigned long retryIn = retryWait(dev, RETRY_SERVER);
+    dev.drainAt = retryIn == 0 ? 0 : millis() + retryIn;
+}
+
+bool sendQueuedSample(Device& dev, const TelemetrySample& sample) {
+    std::string payload = "{";
+    appendJsonString(payload, "boardID", dev.deviceData.boardID);
+    appendJsonString(payload, "token", dev.deviceData.token);
+    appendJsonNumber(payload, "seq", ++dev.telemetrySequence);
+    payload += ",\"queued\":true";
+    appendJsonNumber(payload, "age", deviceMillis(dev) - sample.time);
+    appendJsonNumber(payload, "time", sample.time);
+    appendJsonNumber(payload, "timer", sample.timer);
+    appendJsonNumber(payload, "battery", sample.batteryMv);
+    appendJsonNumber(payload, "rssi", sample.rssi);
+    appendJsonString(payload, "status", sample.status);
+    payload += '}';
+
+    return startServerRequest(dev, SERVER_REQUEST_QUEUED, payload);
+}
+
+bool telemetryBatchDue(Device& dev) {
+    if ((int)dev.telemetryQueue.size() >= TELEMETRY_BATCH_SIZE) return true;
+    return !dev.telemetryQueue.empty() && deviceMillis(dev) - dev.telemetryQueue.front().time >= TELEMETRY_BATCH_WINDOW;
+}
+
+bool sendTelemetryBatch(Device& dev) {
+    int batchCount = std::min((int)dev.telemetryQueue.size(), TELEMETRY_BATCH_SIZE);
+    if (batchCount == 0) return true;
+
+    bool fullSync = !dev.deviceDataAcked || dev.resyncRequested;
+
+    std::string payload = "{";
+    addDeviceFields(dev, payload, fullSync);
+    appendJsonNumber(payload, "time", deviceMillis(dev));
+    payload += ",\"samples\":[";
+    for (int i = 0; i < batchCount; i++) {
+        const TelemetrySample& sample = dev.telemetryQueue[i];
+        std::string item = "{";
+        appendJsonNumber(item, "age", deviceMillis(dev) - sample.time);
+        appendJsonNumber(item, "time", sample.time);
+        appendJsonNumber(item, "timer", sample.timer);
+        appendJsonNumber(item, "battery", sample.batteryMv);
+        appendJsonNumber(item, "rssi", sample.rssi);
+        appendJsonString(item, "status", sample.status);
+        item += '}';
+        if (i > 0) payload += ',';
+        payload += item;
+    }
+    payload += "]}";
+
+    if (!startServerRequest(dev, SERVER_REQUEST_BATCH, payload)) return false;
+    dev.serverRequest.batchCount = batchCount;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// HTTP-запрос: те же фазы и таймауты, что у serviceServerRequest()
+
+bool startServerRequest(Device& dev, ServerRequestKind kind, const std::string& payload) {
+    ServerRequest& req = dev.serverRequest;
+    LoadStats& stats = dev.worker->stats;
+    if (req.phase != HTTP_PHASE_IDLE) return false;
+
+    const std::string& url = dev.deviceData.serverUrl;
+    if (!dev.target || dev.target->url != url) {
+        dev.target = resolveServerTarget(url);
+    }
+    if (!dev.target) return false;
+
+    if (url != dev.serverConnectionUrl) {
+        closeServerConnection(dev);
+        dev.serverConnectionUrl = url;
+        dev.serverEtag.clear();
+        dev.serverRev.clear();
+    }
+
+    char head[HTTP_HOST_MAX + HTTP_PATH_MAX + STATE_TAG_MAX + 180];
+    int headLength = snprintf(head, sizeof(head),
+        "POST %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: ESP8266\r\nConnection: keep-alive\r\n"
+        "Content-Type: application/json\r\nContent-Length: %u\r\n",
+        dev.target->path, dev.target->host, (unsigned)payload.size());
+    if (kind != SERVER_REQUEST_QUEUED && !dev.serverEtag.empty()) {
+        headLength += snprintf(head + headLength, sizeof(head) - headLength, "If-None-Match: %s\r\n", dev.serverEtag.c_str());
+    }
+    headLength += snprintf(head + headLength, sizeof(head) - headLength, "\r\n");
+
+    req.out.assign(head, headLength);
+    req.out += payload;
+    req.outSent = 0;
+    req.in.clear();
+    req.bodyStart = 0;
+    req.body.clear();
+    req.bodyOverflow = false;
+    req.status = 0;
+    req.etag.clear();
+    req.keepAlive = true;
+    req.bodyMode = HTTP_BODY_UNTIL_CLOSE;
+    req.contentLength = 0;
+    req.batchCount = 0;
+    req.kind = kind;
+    req.retried = false;
+    req.startMicros = micros();
+    req.reused = dev.fd >= 0;
+
+    count(stats.requests[kind]);
+    count(stats.payloadBytes, payload.size());
+
+    if (req.reused) {
+        count(stats.reused);
+        setServerRequestPhase(dev, HTTP_PHASE_SEND);
+        watchServerConnection(dev, EPOLLIN | EPOLLOUT);
+    }
+    else {
+        // Соединение открывает следующий проход таймеров, как scheduleTask(serverRequestTaskId, 0)
+        setServerRequestPhase(dev, HTTP_PHASE_DNS);
+    }
+    armDevice(dev);
+    return true;
+}
+
+bool serverRequestActive(const Device& dev) {
+    return dev.serverRequest.phase != HTTP_PHASE_IDLE;
+}
+
+void setServerRequestPhase(Device& dev, HttpPhase phase) {
+    dev.serverRequest.phase = phase;
+    dev.serverRequest.phaseStart = millis();
+}
+
+unsigned long httpPhaseTimeout(HttpPhase phase) {
+    switch (phase) {
+    case HTTP_PHASE_CONNECT: return HTTP_CONNECT_TIMEOUT;
+    case HTTP_PHASE_SEND: return HTTP_SEND_TIMEOUT;
+    case HTTP_PHASE_FIRST_BYTE: return HTTP_FIRST_BYTE_TIMEOUT;
+    case HTTP_PHASE_HEADERS:
+    case HTTP_PHASE_BODY: return HTTP_BODY_TIMEOUT;
+    default: return 0;
+    }
+}
+
+void openServerConnection(Device& dev) {
+    LoadStats& stats = dev.worker->stats;
+    const ServerTarget& target = *dev.target;
+
+    if (!target.resolved) {
+        finishServerRequest(dev, HTTP_ERROR_DNS);
+        return;
+    }
+
+    int fd = socket(target.address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        finishServerRequest(dev, HTTP_ERROR_CONNECT);
+        return;
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(fd, (const sockaddr*)&target.address, target.addressLength) != 0 && errno != EINPROGRESS) {
+        close(fd);
+        finishServerRequest(dev, HTTP_ERROR_CONNECT);
+        return;
+    }
+
+    dev.fd = fd;
+    dev.epollEvents = 0;
+    count(stats.connects);
+    stats.openConnections.fetch_add(1, std::memory_order_relaxed);
+    setServerRequestPhase(dev, HTTP_PHASE_CONNECT);
+    watchServerConnection(dev, EPOLLIN | EPOLLOUT);
+}
+
+void closeServerConnection(Device& dev) {
+    if (dev.fd < 0) return;
+
+    close(dev.fd);
+    dev.fd = -1;
+    dev.epollEvents = 0;
+    dev.worker->stats.openConnections.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void watchServerConnection(Device& dev, uint32_t events) {
+    if (dev.fd < 0 || dev.epollEvents == events) return;
+
+    epoll_event event = {};
+    event.events = events;
+    event.data.ptr = &dev;
+    epoll_ctl(dev.worker->epollFd, dev.epollEvents == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, dev.fd, &event);
+    dev.epollEvents = events;
+}
+
+void serviceServerConnection(Device& dev, uint32_t events) {
+    ServerRequest& req = dev.serverRequest;
+
+    if (req.phase == HTTP_PHASE_IDLE) {
+        // Простаивающее соединение: сервер его закрыл, следующий запрос откроет новое
+        char discard[256];
+        ssize_t n = recv(dev.fd, discard, sizeof(discard), 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            count(dev.worker->stats.idleClosed);
+            closeServerConnection(dev);
+        }
+        return;
+    }
+
+    if (req.phase == HTTP_PHASE_CONNECT) {
+        if (!(events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) return;
+
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(dev.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+        if (error != 0) {
+            finishServerRequest(dev, HTTP_ERROR_CONNECT);
+            return;
+        }
+        setServerRequestPhase(dev, HTTP_PHASE_SEND);
+    }
+
+    if (req.phase == HTTP_PHASE_SEND && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+        sendServerRequest(dev);
+    }
+
+    if (req.phase >= HTTP_PHASE_FIRST_BYTE && (events & (EPOLLIN | EPOLLERR | EPOLLHUP))) {
+        readServerResponse(dev);
+    }
+}
+
+void sendServerRequest(Device& dev) {
+    ServerRequest& req = dev.serverRequest;
+
+    while (req.outSent < req.out.size()) {
+        ssize_t n = send(dev.fd, req.out.data() + req.outSent, req.out.size() - req.outSent, MSG_NOSIGNAL);
+        if (n > 0) {
+            req.outSent += n;
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+
+        lostServerConnection(dev);
+        return;
+    }
+
+    setServerRequestPhase(dev, HTTP_PHASE_FIRST_BYTE);
+    watchServerConnection(dev, EPOLLIN);
+}
+
+void readServerResponse(Device& dev) {
+    ServerRequest& req = dev.serverRequest;
+    char chunk[4096];
+
+    while (req.phase >= HTTP_PHASE_FIRST_BYTE) {
+        ssize_t n = recv(dev.fd, chunk, sizeof(chunk), 0);
+        if (n > 0) {
+            if (req.phase == HTTP_PHASE_FIRST_BYTE) setServerRequestPhase(dev, HTTP_PHASE_HEADERS);
+            count(dev.worker->stats.responseBytes, n);
+            req.in.append(chunk, n);
+            if (parseServerResponse(dev)) return;
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+
+        // Сервер закрыл соединение: для ответа без длины это и есть конец тела
+        if (n == 0 && req.phase == HTTP_PHASE_BODY && req.bodyMode == HTTP_BODY_UNTIL_CLOSE) {
+            setServerResponseBody(req, req.in.data() + req.bodyStart, req.in.size() - req.bodyStart);
+            req.keepAlive = false;
+            finishServerRequest(dev, req.status);
+        }
+        else if (req.in.empty()) {
+            lostServerConnection(dev);
+        }
+        else {
+            finishServerRequest(dev, HTTP_ERROR_CONNECTION_LOST);
+        }
+        return;
+    }
+}
+
+bool parseServerResponse(Device& dev) {
+    ServerRequest& req = dev.serverRequest;
+
+    if (req.in.size() > HTTP_RESPONSE_MAX) {
+        finishServerRequest(dev, HTTP_ERROR_BAD_RESPONSE);
+        return true;
+    }
+
+    if (req.phase == HTTP_PHASE_HEADERS) {
+        size_t headerEnd = req.in.find("\r\n\r\n");
+        if (headerEnd == std::string::npos) return false;
+
+        if (!readServerResponseHeaders(req, headerEnd)) {
+            finishServerRequest(dev, HTTP_ERROR_BAD_RESPONSE);
+            return true;
+        }
+        req.bodyStart = headerEnd + 4;
+        setServerRequestPhase(dev, HTTP_PHASE_BODY);
+    }
+
+    switch (req.bodyMode) {
+    case HTTP_BODY_NONE:
+        finishServerRequest(dev, req.status);
+        return true;
+
+    case HTTP_BODY_LENGTH:
+        if (req.in.size() - req.bodyStart < req.contentLength) return false;
+        setServerResponseBody(req, req.in.data() + req.bodyStart, req.contentLength);
+        finishServerRequest(dev, req.status);
+        return true;
+
+    case HTTP_BODY_CHUNKED: {
+        int decoded = decodeChunkedBody(req);
+        if (decoded == 0) return false;
+        finishServerRequest(dev, decoded > 0 ? req.status : HTTP_ERROR_BAD_RESPONSE);
+        return true;
+    }
+
+    default:
+        return false;
+    }
+}
+
+bool readServerResponseHeaders(ServerRequest& req, size_t headerEnd) {
+    const std::string& in = req.in;
+    if (headerEnd < 12 || in.compare(0, 7, "HTTP/1.") != 0) return false;
+
+    req.status = atoi(in.c_str() + 9);
+    if (req.status < 100) return false;
+    req.keepAlive = in[7] == '1';
+
+    bool chunked = false;
+    bool hasLength = false;
+    size_t lineStart = in.find("\r\n") + 2;
+    while (lineStart < headerEnd) {
+        size_t lineEnd = in.find("\r\n", lineStart);
+        const char* line = in.c_str() + lineStart;
+        size_t lineLength = lineEnd - lineStart;
+        const char* colon = (const char*)memchr(line, ':', lineLength);
+        lineStart = lineEnd + 2;
+        if (colon == nullptr) continue;
+
+        size_t nameLength = colon - line;
+        const char* value = colon + 1;
+        while (*value == ' ' || *value == '\t') value++;
+        std::string text(value, line + lineLength - value);
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.pop_back();
+
+        if (nameLength == 14 && strncasecmp(line, "Content-Length", 14) == 0) {
+            req.contentLength = strtoul(text.c_str(), nullptr, 10);
+            hasLength = true;
+        }
+        else if (nameLength == 17 && strncasecmp(line, "Transfer-Encoding", 17) == 0) {
+            chunked = strcasestr(text.c_str(), "chunked") != nullptr;
+        }
+        else if (nameLength == 10 && strncasecmp(line, "Connection", 10) == 0) {
+            if (strcasestr(text.c_str(), "close") != nullptr) req.keepAlive = false;
+            else if (strcasestr(text.c_str(), "keep-alive") != nullptr) req.keepAlive = true;
+        }
+        else if (nameLength == 4 && strncasecmp(line, "ETag", 4) == 0) {
+            // Обрезанный тег не совпал бы с серверным - лучше без него
+            if (text.size() <= STATE_TAG_MAX) req.etag = text;
+        }
+    }
+
+    if (req.status == HTTP_CODE_NOT_MODIFIED || req.status == 204 || req.status < 200) req.bodyMode = HTTP_BODY_NONE;
+    else if (chunked) req.bodyMode = HTTP_BODY_CHUNKED;
+    else if (hasLength) req.bodyMode = HTTP_BODY_LENGTH;
+    else {
+        req.bodyMode = HTTP_BODY_UNTIL_CLOSE;
+        req.keepAlive = false;
+    }
+    return true;
+}
+
+int decodeChunkedBody(ServerRequest& req) {
+    const std::string& in = req.in;
+    std::string body;
+    size_t pos = req.bodyStart;
+
+    for (;;) {
+        size_t lineEnd = in.find("\r\n", pos);
+        if (lineEnd == std::string::npos) return 0;
+
+        char* sizeEnd = nullptr;
+        unsigned long size = strtoul(in.c_str() + pos, &sizeEnd, 16);
+        if (sizeEnd == in.c_str() + pos) return -1;
+        pos = lineEnd + 2;
+
+        if (size == 0) {
+            // Заголовки-трейлеры до пустой строки
+            for (;;) {
+                lineEnd = in.find("\r\n", pos);
+                if (lineEnd == std::string::npos) return 0;
+                if (lineEnd == pos) break;
+                pos = lineEnd + 2;
+            }
+            setServerResponseBody(req, body.data(), body.size());
+            return 1;
+        }
+
+        if (in.size() < pos + size + 2) return 0;
+        body.append(in, pos, size);
+        pos += size + 2;
+    }
+}
+
+void setServerResponseBody(ServerRequest& req, const char* data, size_t length) {
+    req.bodyOverflow = length > RESPONSE_BODY_MAX;
+    req.body.assign(data, std::min(length, RESPONSE_BODY_MAX));
+}
+
+void lostServerConnection(Device& dev) {
+    ServerRequest& req = dev.serverRequest;
+
+    // Сервер мог закрыть простаивавшее соединение - один раз переподключаемся заново
+    if (req.reused && !req.retried) {
+        count(dev.worker->stats.dropped);
+        closeServerConnection(dev);
+        req.reused = false;
+        req.retried = true;
+        req.outSent = 0;
+        req.in.clear();
+        setServerRequestPhase(dev, HTTP_PHASE_DNS);
+        return;
+    }
+
+    finishServerRequest(dev, HTTP_ERROR_CONNECTION_LOST);
+}
+
+void finishServerRequest(Device& dev, int httpCode) {
+    ServerRequest& req = dev.serverRequest;
+    LoadStats& stats = dev.worker->stats;
+
+    if (httpCode < 0 || !req.keepAlive) {
+        closeServerConnection(dev);
+    }
+
+    if (httpCode < 0) {
+        count(stats.errors[-httpCode - 1]);
+        if (httpCode != HTTP_ERROR_NO_WIFI) retryFailed(dev, RETRY_SERVER);
+    }
+    else {
+        // Задержку считаем только для ответов - таймауты и обрывы идут отдельными счётчиками
+        recordLatency(stats, micros() - req.startMicros);
+
+        if (httpCode >= 500) count(stats.serverErrors);
+        else if (httpCode >= 400) count(stats.clientErrors);
+        else if (httpCode == HTTP_CODE_NOT_MODIFIED) count(stats.notModified);
+        else if (httpCode >= 200 && httpCode < 300) count(stats.success);
+        else count(stats.otherStatus);
+
+        if (httpCode >= 500) retryFailed(dev, RETRY_SERVER);
+        else retrySucceeded(dev, RETRY_SERVER);
+    }
+
+    std::string body;
+    body.swap(req.body);
+    req.out.clear();
+    req.in.clear();
+    req.phase = HTTP_PHASE_IDLE;
+    if (dev.fd >= 0) watchServerConnection(dev, EPOLLIN);
+
+    onServerResponse(dev, req.kind, httpCode, body);
+}
+
+void onServerResponse(Device& dev, ServerRequestKind kind, int httpCode, const std::string& body) {
+    LoadStats& stats = dev.worker->stats;
+
+    switch (kind) {
+    case SERVER_REQUEST_UPDATE:
+    case SERVER_REQUEST_HELLO:
+        if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_NOT_MODIFIED) {
+            applyServerResponse(dev, httpCode, body);
+            break;
+        }
+
+        if (kind == SERVER_REQUEST_UPDATE) {
+            enqueueTelemetrySample(dev, dev.serverRequest.sample);
+            pauseTelemetryDrain(dev);
+        }
+        break;
+
+    case SERVER_REQUEST_QUEUED:
+        if (httpCode != HTTP_CODE_OK) {
+            pauseTelemetryDrain(dev);
+            break;
+        }
+
+        popTelemetrySamples(dev, 1);
+        count(stats.drained);
+        if (dev.telemetryQueue.empty()) dev.drainAt = 0;
+        break;
+
+    case SERVER_REQUEST_BATCH:
+        if (httpCode != HTTP_CODE_OK && httpCode != HTTP_CODE_NOT_MODIFIED) {
+            pauseTelemetryDrain(dev);
+            break;
+        }
+
+        popTelemetrySamples(dev, dev.serverRequest.batchCount);
+        count(stats.batchedSamples, dev.serverRequest.batchCount);
+        applyServerResponse(dev, httpCode, body);
+        break;
+
+    default:
+        break;
+    }
+}
+
+bool applyServerResponse(Device& dev, int httpCode, const std::string& body) {
+    LoadStats& stats = dev.worker->stats;
+
+    if (httpCode == HTTP_CODE_NOT_MODIFIED || isEmptyResponse(body.data(), body.size())) {
+        // 304 уже посчитан в finishServerRequest(), здесь только пустые 200
+        if (httpCode != HTTP_CODE_NOT_MODIFIED) count(stats.unchanged);
+        acknowledgeServerUpdate(dev);
+        return true;
+    }
+
+    std::vector<std::pair<std::string, std::string>> fields;
+    if (!parseFlatJson(body.data(), body.size(), fields)) {
+        count(stats.badJson);
+        return false;
+    }
+
+    const std::string* resync = findField(fields, "resync");
+    dev.resyncRequested = resync != nullptr && *resync == "true";
+    if (dev.resyncRequested) count(stats.resyncs);
+
+    applyServerFields(dev, fields);
+
+    dev.serverEtag = dev.serverRequest.etag;
+    const std::string* rev = findField(fields, "rev");
+    if (rev != nullptr && *rev != "null") dev.serverRev = *rev;
+
+    count(stats.applied);
+    acknowledgeServerUpdate(dev);
+    return true;
+}
+
+void applyServerFields(Device& dev, const std::vector<std::pair<std::string, std::string>>& fields) {
+    LoadStats& stats = dev.worker->stats;
+    DeviceData& data = dev.deviceData;
+
+    auto applyServerString = [&fields](const char* key, std::string& field) {
+        const std::string* value = findField(fields, key);
+        if (value == nullptr || value->empty() || *value == field) return false;
+        field = *value;
+        return true;
+    };
+
+    applyServerString("boardID", data.boardID);
+    applyServerString("user", data.user);
+    applyServerString("text", data.text);
+    applyServerString("status", data.status);
+    applyServerString("token", data.token);
+
+    const std::string* uptime = findField(fields, "uptime");
+    if (uptime != nullptr) {
+        long newUptime = strtol(uptime->c_str(), nullptr, 10);
+        if (newUptime > 0 && data.uptime != newUptime) {
+            data.uptime = newUptime;
+            count(stats.uptimeChanges);
+        }
+    }
+
+    if (applyServerString("serverUrl", data.serverUrl)) {
+        count(stats.urlChanges);
+    }
+}
+
+void acknowledgeServerUpdate(Device& dev) {
+    dev.ackedDeviceData = dev.deviceData;
+    dev.deviceDataAcked = true;
+    dev.updateAt = millis() + dev.deviceData.uptime;
+
+    if (!dev.telemetryQueue.empty()) {
+        dev.drainAt = millis() + TELEMETRY_DRAIN_INTERVAL;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// JSON: устройство шлёт и разбирает только плоские объекты, полноценный парсер не нужен
+
+const std::string* findField(const std::vector<std::pair<std::string, std::string>>& fields, const char* key) {
+    for (const auto& field : fields) {
+        if (field.first == key) return &field.second;
+    }
+    return nullptr;
+}
+
+bool parseJsonString(const char*& p, const char* end, std::string& out) {
+    out.clear();
+    p++;
+    while (p < end && *p != '"') {
+        if (*p != '\\') {
+            out += *p++;
+            continue;
+        }
+        if (++p >= end) return false;
+        switch (*p) {
+        case 'n': out += '\n'; break;
+        case 't': out += '\t'; break;
+        case 'r': out += '\r'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'u': {
+            if (end - p < 5) return false;
+            unsigned code = strtoul(std::string(p + 1, 4).c_str(), nullptr, 16);
+            if (code < 0x80) out += (char)code;
+            else if (code < 0x800) {
+                out += (char)(0xC0 | (code >> 6));
+                out += (char)(0x80 | (code & 0x3F));
+            }
+            else {
+                out += (char)(0xE0 | (code >> 12));
+                out += (char)(0x80 | ((code >> 6) & 0x3F));
+                out += (char)(0x80 | (code & 0x3F));
+            }
+            p += 4;
+            break;
+        }
+        default: out += *p; break;
+        }
+        p++;
+    }
+    if (p >= end) return false;
+    p++;
+    return true;
+}
+
+bool skipJsonValue(const char*& p, const char* end) {
+    int depth = 0;
+    std::string ignored;
+    while (p < end) {
+        char c = *p;
+        if (c == '"') {
+            if (!parseJsonString(p, end, ignored)) return false;
+            if (depth == 0) return true;
+            continue;
+        }
+        if (c == '{' || c == '[') depth++;
+        else if (c == '}' || c == ']') {
+            if (depth == 0) return true;
+            if (--depth == 0) {
+                p++;
+                return true;
+            }
+        }
+        else if (depth == 0 && (c == ',' || isspace((unsigned char)c))) return true;
+        p++;
+    }
+    return depth == 0;
+}
+
+bool parseFlatJson(const char* body, size_t length, std::vector<std::pair<std::string, std::string>>& fields) {
+    const char* p = body;
+    const char* end = body + length;
+    auto skipSpace = [&p, end]() {
+        while (p < end && isspace((unsigned char)*p)) p++;
+    };
+
+    skipSpace();
+    if (p >= end || *p != '{') return false;
+    p++;
+
+    std::string key;
+    for (;;) {
+        skipSpace();
+        if (p < end && *p == '}' && fields.empty()) return true;
+        if (p >= end || *p != '"' || !parseJsonString(p, end, key)) return false;
+
+        skipSpace();
+        if (p >= end || *p != ':') return false;
+        p++;
+        skipSpace();
+        if (p >= end) return false;
+
+        std::string value;
+        if (*p == '"') {
+            if (!parseJsonString(p, end, value)) return false;
+        }
+        else {
+            const char* start = p;
+            if (!skipJsonValue(p, end)) return false;
+            value.assign(start, p - start);
+        }
+        fields.emplace_back(key, value);
+
+        skipSpace();
+        if (p < end && *p == ',') {
+            p++;
+            continue;
+        }
+        return p < end && *p == '}';
+    }
+}
+
+void appendJsonString(std::string& out, const char* key, const std::string& value) {
+    if (out.size() > 1) out += ',';
+    out += '"';
+    out += key;
+    out += "\":\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        }
+        else if ((unsigned char)c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        }
+        else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+void appendJsonNumber(std::string& out, const char* key, long long value) {
+    char number[32];
+    snprintf(number, sizeof(number), "%s\"%s\":%lld", out.size() > 1 ? "," : "", key, value);
+    out += number;
+}
+
+// ---------------------------------------------------------------------------
+// Гистограмма задержек: степени двойки по 8 поддиапазонов, погрешность до 12.5%
+
+int latencyBucket(uint64_t micros) {
+    if (micros < 16) return (int)micros;
+    int exponent = 63 - __builtin_clzll(micros);
+    int bucket = 16 + (exponent - 4) * LATENCY_SUB_BUCKETS + (int)((micros >> (exponent - 3)) & 7);
+    return std::min(bucket, LATENCY_HIST_BUCKETS - 1);
+}
+
+uint64_t latencyBucketBound(int bucket) {
+    if (bucket < 16) return bucket;
+    int exponent = (bucket - 16) / LATENCY_SUB_BUCKETS + 4;
+    int sub = (bucket - 16) % LATENCY_SUB_BUCKETS;
+    return ((uint64_t)(LATENCY_SUB_BUCKETS + sub + 1) << (exponent - 3)) - 1;
+}
+
+void recordLatency(LoadStats& stats, unsigned long micros) {
+    count(stats.latency[latencyBucket(micros)]);
+    count(stats.latencyTotalMicros, micros);
+    if (micros > load(stats.latencyMaxMicros)) {
+        stats.latencyMaxMicros.store(micros, std::memory_order_relaxed);
+    }
+}
+
+uint64_t latencyPercentile(const std::vector<uint64_t>& buckets, double percentile) {
+    uint64_t total = 0;
+    for (uint64_t value : buckets) total += value;
+    if (total == 0) return 0;
+
+    uint64_t target = (uint64_t)(total * percentile / 100.0 + 0.999999);
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= target) return latencyBucketBound(i);
+    }
+    return latencyBucketBound(LATENCY_HIST_BUCKETS - 1);
+}
+
+// ---------------------------------------------------------------------------
+// Рабочий поток: epoll и куча таймеров своих устройств
+
+void runWorker(Worker& worker) {
+    rng.seed(opts.seed * 1000003 + worker.index);
+    for (Device& dev : worker.devices) {
+        bootDevice(dev);
+    }
+
+    epoll_event events[EPOLL_BATCH];
+    while (!stopRequested.load(std::memory_order_relaxed)) {
+        unsigned long now = millis();
+
+        for (size_t i = 0; i < opts.storms.size(); i++) {
+            if (worker.stormStarted[i] || now < opts.storms[i].start) continue;
+            worker.stormStarted[i] = true;
+            for (Device& dev : worker.devices) {
+                if (!stormAffects(opts.storms[i], dev)) continue;
+                loseWiFi(dev);
+                armDevice(dev);
+            }
+        }
+
+        while (!worker.timers.empty() && worker.timers.top().due <= now) {
+            TimerEntry entry = worker.timers.top();
+            worker.timers.pop();
+            Device& dev = *entry.device;
+            if (entry.due != dev.armedAt) continue;
+
+            dev.armedAt = 0;
+            serviceDevice(dev);
+            armDevice(dev);
+        }
+
+        unsigned long wait = LOOP_IDLE_WAIT;
+        if (!worker.timers.empty()) {
+            unsigned long due = worker.timers.top().due;
+            now = millis();
+            wait = due > now ? std::min(due - now, LOOP_IDLE_WAIT) : 0;
+        }
+
+        int ready = epoll_wait(worker.epollFd, events, EPOLL_BATCH, (int)wait);
+        for (int i = 0; i < ready; i++) {
+            Device& dev = *(Device*)events[i].data.ptr;
+            if (dev.fd < 0) continue;
+            serviceServerConnection(dev, events[i].events);
+            armDevice(dev);
+        }
+    }
+
+    for (Device& dev : worker.devices) {
+        closeServerConnection(dev);
+    }
+}
+
+struct LoadSnapshot {
+    uint64_t completed = 0;
+    uint64_t success = 0;
+    uint64_t notModified = 0;
+    uint64_t unchanged = 0;
+    uint64_t clientErrors = 0;
+    uint64_t serverErrors = 0;
+    uint64_t errors = 0;
+    int64_t wifiConnected = 0;
+    int64_t openConnections = 0;
+    std::vector<uint64_t> latency = std::vector<uint64_t>(LATENCY_HIST_BUCKETS);
+};
+
+LoadSnapshot takeSnapshot(const std::vector<std::unique_ptr<Worker>>& workers) {
+    LoadSnapshot snap;
+    for (const auto& worker : workers) {
+        const LoadStats& stats = worker->stats;
+        snap.success += load(stats.success);
+        snap.notModified += load(stats.notModified);
+        snap.unchanged += load(stats.unchanged);
+        snap.clientErrors += load(stats.clientErrors);
+        snap.serverErrors += load(stats.serverErrors);
+        snap.completed += load(stats.success) + load(stats.notModified) + load(stats.clientErrors)
+            + load(stats.serverErrors) + load(stats.otherStatus);
+        for (int i = 0; i < HTTP_ERRORS; i++) {
+            snap.errors += load(stats.errors[i]);
+        }
+        snap.wifiConnected += stats.wifiConnected.load(std::memory_order_relaxed);
+        snap.openConnections += stats.openConnections.load(std::memory_order_relaxed);
+        for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+            snap.latency[i] += load(stats.latency[i]);
+        }
+    }
+    snap.completed += snap.errors;
+    return snap;
+}
+
+uint64_t sumStat(const std::vector<std::unique_ptr<Worker>>& workers, const Counter LoadStats::*field) {
+    uint64_t total = 0;
+    for (const auto& worker : workers) total += load(worker->stats.*field);
+    return total;
+}
+
+double ms(uint64_t micros) {
+    return micros / 1000.0;
+}
+
+int runLoad() {
+    char host[HTTP_HOST_MAX + 1];
+    char path[HTTP_PATH_MAX + 1];
+    uint16_t port;
+    if (!parseUrl(opts.url.c_str(), "http://", 80, host, path, port)) {
+        fprintf(stderr, "Unsupported --url %s: only http://host[:port]/path, terminate TLS in front of the backend\n", opts.url.c_str());
+        return 1;
+    }
+    std::shared_ptr<const ServerTarget> target = resolveServerTarget(opts.url);
+    if (!target || !target->resolved) {
+        fprintf(stderr, "Cannot resolve %s\n", host);
+        return 1;
+    }
+
+    raiseFileLimit(opts.devices + 64);
+
+    int mixTotal = 0;
+    for (int weight : opts.mix) mixTotal += weight;
+
+    std::mt19937_64 profileRng(opts.seed);
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < opts.threads; i++) {
+        std::unique_ptr<Worker> worker(new Worker());
+        worker->index = i;
+        worker->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        worker->stormStarted.assign(opts.storms.size(), false);
+        worker->devices.resize(opts.devices / opts.threads + (i < opts.devices % opts.threads ? 1 : 0));
+        workers.push_back(std::move(worker));
+    }
+
+    int profiles[DEVICE_PROFILES] = {};
+    int nextId = 0;
+    for (auto& worker : workers) {
+        for (Device& dev : worker->devices) {
+            dev.worker = worker.get();
+            dev.id = nextId++;
+            int pick = (int)(profileRng() % mixTotal);
+            int profile = 0;
+            while (pick >= opts.mix[profile]) pick -= opts.mix[profile++];
+            dev.profile = (DeviceProfile)profile;
+            profiles[profile]++;
+        }
+    }
+
+    printf("%d devices (delta %d, full %d, batch %d) on %d threads -> %s\n",
+        opts.devices, profiles[PROFILE_DELTA], profiles[PROFILE_FULL], profiles[PROFILE_BATCH], opts.threads, opts.url.c_str());
+    printf("interval %lu s, ramp %lu s, join %lu s, text %zu bytes, duration %lu s\n",
+        opts.interval / 1000, opts.ramp / 1000, opts.joinTime / 1000, opts.textBytes, opts.duration / 1000);
+    for (const TimeWindow& storm : opts.storms) {
+        printf("AP outage at %lu s for %lu s, %d%% of devices\n", storm.start / 1000, storm.duration / 1000, storm.percent);
+    }
+
+    unsigned long start = millis();
+    for (TimeWindow& storm : opts.storms) {
+        storm.start += start;
+    }
+    for (auto& worker : workers) {
+        Worker* w = worker.get();
+        w->thread = std::thread([w]() { runWorker(*w); });
+    }
+
+    printf("%7s %7s %7s %8s %7s %6s %6s %6s %6s %7s %8s %8s %8s %8s\n",
+        "time s", "wifi", "conns", "req/s", "2xx", "304", "{}", "4xx", "5xx", "errors",
+        "p50 ms", "p90 ms", "p99 ms", "p999 ms");
+
+    LoadSnapshot previous = takeSnapshot(workers);
+    unsigned long previousTime = start;
+    while (!stopRequested.load() && millis() - start < opts.duration) {
+        unsigned long wake = std::min(previousTime + opts.reportInterval, start + opts.duration);
+        while (!stopRequested.load() && millis() < wake) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+
+        unsigned long now = millis();
+        LoadSnapshot snap = takeSnapshot(workers);
+        std::vector<uint64_t> interval(LATENCY_HIST_BUCKETS);
+        for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+            interval[i] = snap.latency[i] - previous.latency[i];
+        }
+        double seconds = std::max(1UL, now - previousTime) / 1000.0;
+
+        printf("%7.1f %7lld %7lld %8.1f %7llu %6llu %6llu %6llu %6llu %7llu %8.2f %8.2f %8.2f %8.2f\n",
+            (now - start) / 1000.0, (long long)snap.wifiConnected, (long long)snap.openConnections,
+            (snap.completed - previous.completed) / seconds,
+            (unsigned long long)(snap.success - previous.success),
+            (unsigned long long)(snap.notModified - previous.notModified),
+            (unsigned long long)(snap.unchanged - previous.unchanged),
+            (unsigned long long)(snap.clientErrors - previous.clientErrors),
+            (unsigned long long)(snap.serverErrors - previous.serverErrors),
+            (unsigned long long)(snap.errors - previous.errors),
+            ms(latencyPercentile(interval, 50)), ms(latencyPercentile(interval, 90)),
+            ms(latencyPercentile(interval, 99)), ms(latencyPercentile(interval, 99.9)));
+        fflush(stdout);
+
+        previous = std::move(snap);
+        previousTime = now;
+    }
+
+    stopRequested = true;
+    for (auto& worker : workers) {
+        worker->thread.join();
+        close(worker->epollFd);
+    }
+
+    unsigned long elapsed = millis() - start;
+    LoadSnapshot total = takeSnapshot(workers);
+    uint64_t pending = 0;
+    for (const auto& worker : workers) {
+        for (const Device& dev : worker->devices) pending += dev.telemetryQueue.size();
+    }
+
+    printf("\nSummary after %.1f s\n", elapsed / 1000.0);
+    printf("  requests:    ");
+    for (int kind = 0; kind < SERVER_REQUEST_KINDS; kind++) {
+        uint64_t sent = 0;
+        for (const auto& worker : workers) sent += load(worker->stats.requests[kind]);
+        printf("%s %llu%s", SERVER_REQUEST_NAMES[kind], (unsigned long long)sent, kind + 1 < SERVER_REQUEST_KINDS ? ", " : "\n");
+    }
+    printf("  throughput:  %.1f req/s completed, %.1f KB/s sent, %.1f KB/s received\n",
+        total.completed * 1000.0 / elapsed,
+        sumStat(workers, &LoadStats::payloadBytes) / 1.024 / elapsed,
+        sumStat(workers, &LoadStats::responseBytes) / 1.024 / elapsed);
+    printf("  responses:   2xx %llu, 304 %llu, 4xx %llu, 5xx %llu, other %llu\n",
+        (unsigned long long)total.success, (unsigned long long)total.notModified,
+        (unsigned long long)total.clientErrors, (unsigned long long)total.serverErrors,
+        (unsigned long long)sumStat(workers, &LoadStats::otherStatus));
+    printf("  state:       applied %llu, unchanged {} %llu, bad JSON %llu, resync %llu, uptime changes %llu, serverUrl changes %llu\n",
+        (unsigned long long)sumStat(workers, &LoadStats::applied), (unsigned long long)total.unchanged,
+        (unsigned long long)sumStat(workers, &LoadStats::badJson), (unsigned long long)sumStat(workers, &LoadStats::resyncs),
+        (unsigned long long)sumStat(workers, &LoadStats::uptimeChanges), (unsigned long long)sumStat(workers, &LoadStats::urlChanges));
+
+    const char* const errorNames[HTTP_ERRORS] = {"timeout", "connection lost", "DNS", "connect", "bad response", "no WiFi"};
+    printf("  errors:      ");
+    for (int i = 0; i < HTTP_ERRORS; i++) {
+        uint64_t errors = 0;
+        for (const auto& worker : workers) errors += load(worker->stats.errors[i]);
+        printf("%s %llu%s", errorNames[i], (unsigned long long)errors, i + 1 < HTTP_ERRORS ? ", " : "\n");
+    }
+    printf("  connections: opened %llu, reused %llu, dropped kept-alive %llu, closed idle %llu\n",
+        (unsigned long long)sumStat(workers, &LoadStats::connects), (unsigned long long)sumStat(workers, &LoadStats::reused),
+        (unsigned long long)sumStat(workers, &LoadStats::dropped), (unsigned long long)sumStat(workers, &LoadStats::idleClosed));
+    printf("  wifi:        joins %llu, losses %llu, connected at end %lld\n",
+        (unsigned long long)sumStat(workers, &LoadStats::wifiJoins), (unsigned long long)sumStat(workers, &LoadStats::wifiLosses),
+        (long long)total.wifiConnected);
+    printf("  retry:       ");
+    for (int id = 0; id < RETRY_POLICIES; id++) {
+        uint64_t trips = 0;
+        for (const auto& worker : workers) trips += load(worker->stats.trips[id]);
+        printf("%s breaker trips %llu%s", RETRY_POLICY_NAMES[id], (unsigned long long)trips, id + 1 < RETRY_POLICIES ? ", " : "\n");
+    }
+    printf("  telemetry:   queued %llu, overflowed %llu, drained %llu, batched %llu, pending %llu\n",
+        (unsigned long long)sumStat(workers, &LoadStats::queued), (unsigned long long)sumStat(workers, &LoadStats::queueOverflow),
+        (unsigned long long)sumStat(workers, &LoadStats::drained), (unsigned long long)sumStat(workers, &LoadStats::batchedSamples),
+        (unsigned long long)pending);
+
+    uint64_t responses = 0;
+    uint64_t maxMicros = 0;
+    for (uint64_t value : total.latency) responses += value;
+    for (const auto& worker : workers) maxMicros = std::max(maxMicros, load(worker->stats.latencyMaxMicros));
+    printf("  latency ms:  mean %.2f, p50 %.2f, p90 %.2f, p99 %.2f, p99.9 %.2f, max %.2f\n",
+        responses > 0 ? ms(sumStat(workers, &LoadStats::latencyTotalMicros) / responses) : 0.0,
+        ms(latencyPercentile(total.latency, 50)), ms(latencyPercentile(total.latency, 90)),
+        ms(latencyPercentile(total.latency, 99)), ms(latencyPercentile(total.latency, 99.9)), ms(maxMicros));
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Заглушка сервера для --serve
+
+struct ServeConnection {
+    int fd;
+    std::string in;
+    std::string out;
+    size_t outSent = 0;
+    bool closeAfter = false;
+};
+
+struct ServeStats {
+    Counter requests{};
+    Counter full{};
+    Counter unchanged{};
+    Counter notModified{};
+    Counter rejected{};
+};
+
+ServeStats serveStats;
+
+bool serverOutage(unsigned long now) {
+    for (const TimeWindow& outage : opts.outages) {
+        if (now >= outage.start && now < outage.start + outage.duration) return true;
+    }
+    return false;
+}
+
+std::string findHeader(const std::string& head, const char* name) {
+    size_t nameLength = strlen(name);
+    size_t lineStart = head.find("\r\n");
+    while (lineStart != std::string::npos && lineStart + 2 < head.size()) {
+        lineStart += 2;
+        size_t lineEnd = head.find("\r\n", lineStart);
+        if (lineEnd == std::string::npos) lineEnd = head.size();
+        if (lineEnd - lineStart > nameLength && head[lineStart + nameLength] == ':'
+            && strncasecmp(head.c_str() + lineStart, name, nameLength) == 0) {
+            size_t value = lineStart + nameLength + 1;
+            while (value < lineEnd && head[value] == ' ') value++;
+            return head.substr(value, lineEnd - value);
+        }
+        lineStart = lineEnd;
+    }
+    return "";
+}
+
+// Ответ на один запрос устройства; false - запрос ещё не пришёл целиком
+bool serveRequest(ServeConnection& conn) {
+    size_t headEnd = conn.in.find("\r\n\r\n");
+    if (headEnd == std::string::npos) return false;
+
+    std::string head = conn.in.substr(0, headEnd);
+    size_t length = strtoul(findHeader(head, "Content-Length").c_str(), nullptr, 10);
+    if (conn.in.size() < headEnd + 4 + length) return false;
+
+    std::string body = conn.in.substr(headEnd + 4, length);
+    conn.in.erase(0, headEnd + 4 + length);
+    count(serveStats.requests);
+
+    unsigned long now = millis();
+    if (serverOutage(now)) {
+        count(serveStats.rejected);
+        conn.out += "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        conn.closeAfter = true;
+        return true;
+    }
+
+    if (strcasestr(findHeader(head, "Connection").c_str(), "close") != nullptr) conn.closeAfter = true;
+
+    unsigned long rev = 1 + now / opts.changeInterval;
+    char etag[32];
+    snprintf(etag, sizeof(etag), "\"r%lu\"", rev);
+
+    std::vector<std::pair<std::string, std::string>> fields;
+    parseFlatJson(body.data(), body.size(), fields);
+    const std::string* queued = findField(fields, "queued");
+    const std::string* deviceRev = findField(fields, "rev");
+
+    char response[512];
+    if (findHeader(head, "If-None-Match") == etag) {
+        count(serveStats.notModified);
+        snprintf(response, sizeof(response), "HTTP/1.1 304 Not Modified\r\nETag: %s\r\n\r\n", etag);
+    }
+    else if ((queued != nullptr && *queued == "true") || (deviceRev != nullptr && strtoul(deviceRev->c_str(), nullptr, 10) == rev)) {
+        count(serveStats.unchanged);
+        snprintf(response, sizeof(response),
+            "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nETag: %s\r\nContent-Length: 2\r\n\r\n{}", etag);
+    }
+    else {
+        count(serveStats.full);
+        char json[256];
+        int jsonLength = snprintf(json, sizeof(json), "{\"text\":\"Update %lu\",\"status\":\"rev %lu\",\"rev\":%lu", rev, rev, rev);
+        if (opts.serveUptime > 0) {
+            jsonLength += snprintf(json + jsonLength, sizeof(json) - jsonLength, ",\"uptime\":%lu", opts.serveUptime);
+        }
+        jsonLength += snprintf(json + jsonLength, sizeof(json) - jsonLength, "}");
+        snprintf(response, sizeof(response),
+            "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nETag: %s\r\nContent-Length: %d\r\n\r\n%s", etag, jsonLength, json);
+    }
+    conn.out += response;
+    return true;
+}
+
+void closeServeConnection(int epollFd, ServeConnection* conn) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, conn->fd, nullptr);
+    close(conn->fd);
+    delete conn;
+}
+
+void runServeWorker(int listenFd) {
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+
+    epoll_event events[EPOLL_BATCH];
+    char chunk[4096];
+    while (!stopRequested.load(std::memory_order_relaxed)) {
+        int ready = epoll_wait(epollFd, events, EPOLL_BATCH, (int)LOOP_IDLE_WAIT);
+        for (int i = 0; i < ready; i++) {
+            ServeConnection* conn = (ServeConnection*)events[i].data.ptr;
+            if (conn == nullptr) {
+                int fd;
+                while ((fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    int one = 1;
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                    ServeConnection* accepted = new ServeConnection();
+                    accepted->fd = fd;
+                    epoll_event added = {};
+                    added.events = EPOLLIN;
+                    added.data.ptr = accepted;
+                    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &added);
+                }
+                continue;
+            }
+
+            bool open = true;
+            for (;;) {
+                ssize_t n = recv(conn->fd, chunk, sizeof(chunk), 0);
+                if (n > 0) {
+                    conn->in.append(chunk, n);
+                    continue;
+                }
+                if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) open = false;
+                break;
+            }
+
+            while (open && !conn->closeAfter && serveRequest(*conn)) {
+            }
+
+            while (conn->outSent < conn->out.size()) {
+                ssize_t n = send(conn->fd, conn->out.data() + conn->outSent, conn->out.size() - conn->outSent, MSG_NOSIGNAL);
+                if (n <= 0) break;
+                conn->outSent += n;
+            }
+            if (conn->outSent == conn->out.size()) {
+                conn->out.clear();
+                conn->outSent = 0;
+            }
+
+            // Ответы маленькие и почти всегда уходят целиком; недописанное досылаем с EPOLLOUT
+            uint32_t wanted = conn->out.empty() ? EPOLLIN : EPOLLIN | EPOLLOUT;
+            if (!open || (conn->closeAfter && conn->out.empty())) {
+                closeServeConnection(epollFd, conn);
+            }
+            else if (wanted != events[i].events) {
+                epoll_event modified = {};
+                modified.events = wanted;
+                modified.data.ptr = conn;
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, conn->fd, &modified);
+            }
+        }
+    }
+    close(epollFd);
+}
+
+int runServer() {
+    raiseFileLimit(65536);
+
+    unsigned long start = millis();
+    for (TimeWindow& outage : opts.outages) {
+        outage.start += start;
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < opts.threads; i++) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(opts.servePort);
+        if (bind(fd, (sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 4096) != 0) {
+            fprintf(stderr, "Cannot listen on port %d: %s\n", opts.servePort, strerror(errno));
+            return 1;
+        }
+        threads.emplace_back([fd]() {
+            runServeWorker(fd);
+            close(fd);
+        });
+    }
+
+    printf("serving http://0.0.0.0:%d/ on %d threads, state changes every %lu s\n",
+        opts.servePort, opts.threads, opts.changeInterval / 1000);
+    for (const TimeWindow& outage : opts.outages) {
+        printf("outage (503) at %lu s for %lu s\n", (outage.start - start) / 1000, outage.duration / 1000);
+    }
+    printf("%7s %8s %8s %8s %8s %8s\n", "time s", "req/s", "full", "{}", "304", "503");
+
+    uint64_t previous = 0;
+    unsigned long previousTime = start;
+    while (!stopRequested.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(opts.reportInterval));
+        unsigned long now = millis();
+        uint64_t requests = load(serveStats.requests);
+        printf("%7.1f %8.1f %8llu %8llu %8llu %8llu\n", (now - start) / 1000.0,
+            (requests - previous) * 1000.0 / std::max(1UL, now - previousTime),
+            (unsigned long long)load(serveStats.full), (unsigned long long)load(serveStats.unchanged),
+            (unsigned long long)load(serveStats.notModified), (unsigned long long)load(serveStats.rejected));
+        fflush(stdout);
+        previous = requests;
+        previousTime = now;
+    }
+
+    for (std::thread& thread : threads) thread.join();
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+
+void raiseFileLimit(size_t wanted) {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) return;
+
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    if (limit.rlim_cur < wanted) {
+        fprintf(stderr, "Open file limit %llu is below %zu, raise it with ulimit -n\n",
+            (unsigned long long)limit.rlim_cur, wanted);
+    }
+}
+
+bool parseWindow(const char* text, TimeWindow& window) {
+    double start = 0;
+    double duration = 0;
+    int percent = 100;
+    int fields = sscanf(text, "%lf:%lf:%d", &start, &duration, &percent);
+    if (fields < 2 || start < 0 || duration <= 0 || percent <= 0 || percent > 100) return false;
+
+    window.start = (unsigned long)(start * 1000);
+    window.duration = (unsigned long)(duration * 1000);
+    window.percent = percent;
+    return true;
+}
+
+bool parseMix(const char* text) {
+    int mix[DEVICE_PROFILES] = {};
+    std::string spec = text;
+    size_t pos = 0;
+    while (pos < spec.size()) {
+        size_t comma = spec.find(',', pos);
+        if (comma == std::string::npos) comma = spec.size();
+        std::string item = spec.substr(pos, comma - pos);
+        pos = comma + 1;
+
+        size_t equals = item.find('=');
+        if (equals == std::string::npos) return false;
+        std::string name = item.substr(0, equals);
+        int weight = atoi(item.c_str() + equals + 1);
+
+        int profile = 0;
+        while (profile < DEVICE_PROFILES && name != DEVICE_PROFILE_NAMES[profile]) profile++;
+        if (profile == DEVICE_PROFILES || weight < 0) return false;
+        mix[profile] = weight;
+    }
+
+    int total = 0;
+    for (int i = 0; i < DEVICE_PROFILES; i++) total += mix[i];
+    if (total == 0) return false;
+    std::copy(mix, mix + DEVICE_PROFILES, opts.mix);
+    return true;
+}
+
+void printUsage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [load options] | --serve PORT [serve options]\n"
+        "\n"
+        "Load:\n"
+        "  --url URL          backend endpoint, http:// only (default %s)\n"
+        "  --devices N        virtual devices (default %d)\n"
+        "  --threads N        worker threads (default: CPU count)\n"
+        "  --duration S       test length, s (default %lu)\n"
+        "  --interval S       initial deviceData.uptime, s; the server may change it (default %lu)\n"
+        "  --ramp S           spread device boots over S seconds (default %lu)\n"
+        "  --join S           Wi-Fi join time, s (default %lu)\n"
+        "  --text N           length of the text field, bytes (default %zu)\n"
+        "  --mix SPEC         firmware mix, e.g. delta=70,full=20,batch=10 (default delta=100)\n"
+        "  --storm AT:DUR[:P] AP outage for P%% of devices, s; repeatable\n"
+        "  --report S         report interval, s (default %lu)\n"
+        "  --seed N           random seed (default %llu)\n"
+        "\n"
+        "Serve:\n"
+        "  --serve PORT       run the stand-in backend instead\n"
+        "  --change S         state (rev) changes every S seconds (default %lu)\n"
+        "  --set-uptime S     push this uptime to every device, s\n"
+        "  --outage AT:DUR    answer 503 during this window, s; repeatable\n",
+        program, opts.url.c_str(), opts.devices, opts.duration / 1000, opts.interval / 1000, opts.ramp / 1000,
+        opts.joinTime / 1000, opts.textBytes, opts.reportInterval / 1000, (unsigned long long)opts.seed,
+        opts.changeInterval / 1000);
+}
+
+bool parseOptions(int argc, char** argv) {
+    auto seconds = [](const char* text) {
+        return (unsigned long)(atof(text) * 1000);
+    };
+
+    for (int i = 1; i < argc; i++) {
+        std::string name = argv[i];
+        if (i + 1 >= argc) return false;
+        const char* value = argv[++i];
+
+        if (name == "--url") opts.url = value;
+        else if (name == "--devices") opts.devices = atoi(value);
+        else if (name == "--threads") opts.threads = atoi(value);
+        else if (name == "--duration") opts.duration = seconds(value);
+        else if (name == "--interval") opts.interval = seconds(value);
+        else if (name == "--ramp") opts.ramp = seconds(value);
+        else if (name == "--join") opts.joinTime = seconds(value);
+        else if (name == "--text") opts.textBytes = strtoul(value, nullptr, 10);
+        else if (name == "--report") opts.reportInterval = seconds(value);
+        else if (name == "--seed") opts.seed = strtoull(value, nullptr, 10);
+        else if (name == "--serve") opts.servePort = atoi(value);
+        else if (name == "--change") opts.changeInterval = seconds(value);
+        else if (name == "--set-uptime") opts.serveUptime = seconds(value);
+        else if (name == "--mix") {
+            if (!parseMix(value)) return false;
+        }
+        else if (name == "--storm" || name == "--outage") {
+            TimeWindow window;
+            if (!parseWindow(value, window)) return false;
+            (name == "--storm" ? opts.storms : opts.outages).push_back(window);
+        }
+        else return false;
+    }
+
+    if (opts.threads <= 0) opts.threads = std::max(1u, std::thread::hardware_concurrency());
+    return opts.devices > 0 && opts.interval > 0 && opts.reportInterval > 0 && opts.changeInterval > 0;
+}
+
+void onSignal(int) {
+    stopRequested = true;
+}
+
+int main(int argc, char** argv) {
+    millis();
+    micros();
+
+    if (!parseOptions(argc, argv)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    return opts.servePort > 0 ? runServer() : runLoad();
+}
@@ -0,0 +1,247 @@
+// Herd simulation: a fleet of devices running main.cpp on the host shims
+// recovers from an access point and backend restart (thundering herd).
+//
+//     cmake -S . -B build && cmake --build build
+//     ./build/herd_sim --devices 100 --ap-down 30 --server-down 120
+//
+// Each device is a forked copy of the sketch with its own flash, clock and
+// random seed. It boots at a random offset within one update interval and
+// runs until --warmup seconds, when the access point and the backend both go
+// down. The access point returns after --ap-down seconds and the backend
+// after --server-down seconds. Both have limited capacity, counted per whole
+// second of virtual time across the fleet in shared memory:
+// - a join beyond --ap-rate per second is not accepted and the station
+//   stays disconnected until the sketch's own connect timeout;
+// - a request beyond --server-rate per second gets a 503 and a closed
+//   connection.
+// The reconnect, backoff and circuit breaker behaviour is the firmware's own.
+// The first rejoin is spread over a window sized for WIFI_FLEET_SIZE devices
+// at WIFI_AP_JOIN_RATE (protocol.h, 100 and 10 by default); for a larger
+// --devices or a smaller --ap-rate, build with matching definitions.
+//
+// Devices run --jobs at a time. With fewer jobs than devices, the arrival
+// order within a second is by device rather than random. Capacity per second
+// is the same either way.
+//
+// Options:
+//     --devices N       fleet size, default 100
+//     --ap-down S       access point restart time, default 30
+//     --server-down S   backend restart time, default 60
+//     --ap-rate N       joins the access point accepts per second, default 10
+//     --server-rate N   requests the backend accepts per second, default 20
+//     --interval S      update interval the backend hands out, default 600
+//     --warmup S        time before the outage, at least --interval, default 660
+//     --horizon S       time simulated after the outage starts, default 3600
+//     --jobs N          devices simulated in parallel, default the CPU count
+//     --seed N          base random seed, default 1
+//     --verbose         echo device 0's Serial output
+
+#include <Arduino.h>
+
+#include "host.h"
+#include "driver.h"
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+void setup();
+void loop();
+
+namespace {
+
+struct Fleet {
+    unsigned seconds;
+    // Per virtual second since boot
+    std::atomic<uint32_t>* joinAttempts;
+    std::atomic<uint32_t>* joinsAccepted;
+    std::atomic<uint32_t>* requestAttempts;
+    std::atomic<uint32_t>* requestsAccepted;
+    // Per device: first update or queued sample delivered after the outage, ms after it started; 0 if none
+    std::atomic<uint32_t>* recovered;
+};
+
+struct Scenario {
+    unsigned long devices;
+    unsigned long apDown;
+    unsigned long serverDown;
+    unsigned long apRate;
+    unsigned long serverRate;
+    unsigned long interval;
+    unsigned long warmup;
+    unsigned long horizon;
+    unsigned long seed;
+    bool verbose;
+};
+
+template <typename T>
+T* sharedArray(size_t count) {
+    void* p = mmap(nullptr, count * sizeof(T), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    return new (p) T[count]();
+}
+
+unsigned currentSecond(const Fleet& fleet) {
+    return (unsigned)std::min<uint64_t>(host::clockMicros() / 1000000, fleet.seconds - 1);
+}
+
+bool admit(std::atomic<uint32_t>* accepted, unsigned second, unsigned long rate) {
+    if (accepted[second].fetch_add(1) < rate) return true;
+    accepted[second]--;
+    return false;
+}
+
+void runDevice(const Scenario& scenario, Fleet& fleet, unsigned long device) {
+    const uint64_t outageStart = scenario.warmup * 1000000ULL;
+    const uint64_t apBack = outageStart + scenario.apDown * 1000000ULL;
+    const uint64_t serverBack = outageStart + scenario.serverDown * 1000000ULL;
+    const uint64_t end = outageStart + scenario.horizon * 1000000ULL;
+
+    host::setSerialEcho(scenario.verbose && device == 0);
+    host::seedRandom(scenario.seed * 1000003 + device);
+    host::makeTempFsRoot();
+    host::provisionWiFi("HostNet", "password");
+
+    host::Backend::Options options;
+    options.uptime = scenario.interval * 1000;
+    host::Backend backend(options);
+
+    host::setJoinAdmission([&]() {
+        return admit(fleet.joinsAccepted, currentSecond(fleet), scenario.apRate);
+    });
+    host::setHttpResponder([&](host::HttpExchange& exchange) {
+        unsigned second = currentSecond(fleet);
+        fleet.requestAttempts[second]++;
+        if (!admit(fleet.requestsAccepted, second, scenario.serverRate)) {
+            exchange.response = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            exchange.keepAlive = false;
+            return;
+        }
+        uint64_t delivered = backend.stats().updates + backend.stats().telemetry;
+        backend.handle(exchange);
+        uint64_t now = host::clockMicros();
+        bool accepted = backend.stats().updates + backend.stats().telemetry != delivered;
+        if (accepted && now >= outageStart && fleet.recovered[device] == 0) {
+            fleet.recovered[device] = std::max<uint32_t>(1, (now - outageStart) / 1000);
+        }
+    });
+
+    host::resetClock();
+    host::advanceClock((uint64_t)random((long)scenario.interval * 1000) * 1000);
+    setup();
+
+    // Попытки считаются в момент начала: подключение к WiFi - по WiFi.begin(),
+    // запрос - в ответчике или по неудачному подключению к выключенному серверу
+    uint64_t connectFailures = host::netStats().connectFailures;
+    uint64_t joins = host::wifiStats().joins;
+    bool apDown = false;
+    bool serverDown = false;
+    while (host::clockMicros() < end) {
+        uint64_t now = host::clockMicros();
+        bool apShouldBeDown = now >= outageStart && now < apBack;
+        bool serverShouldBeDown = now >= outageStart && now < serverBack;
+        if (apShouldBeDown != apDown) {
+            apDown = apShouldBeDown;
+            host::setAccessPoint(!apDown);
+        }
+        if (serverShouldBeDown != serverDown) {
+            serverDown = serverShouldBeDown;
+            host::setServerReachable(!serverDown);
+        }
+
+        loop();
+
+        unsigned second = currentSecond(fleet);
+        uint64_t failures = host::netStats().connectFailures;
+        fleet.requestAttempts[second] += failures - connectFailures;
+        connectFailures = failures;
+
+        uint64_t started = host::wifiStats().joins;
+        fleet.joinAttempts[second] += started - joins;
+        joins = started;
+    }
+}
+
+uint32_t percentile(std::vector<uint32_t>& values, size_t p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, values.size() * p / 100)];
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Scenario scenario;
+    scenario.devices = host::optionValue(argc, argv, "devices", 100);
+    scenario.apDown = host::optionValue(argc, argv, "ap-down", 30);
+    scenario.serverDown = host::optionValue(argc, argv, "server-down", 60);
+    scenario.apRate = host::optionValue(argc, argv, "ap-rate", 10);
+    scenario.serverRate = host::optionValue(argc, argv, "server-rate", 20);
+    scenario.interval = host::optionValue(argc, argv, "interval", 600);
+    scenario.warmup = std::max(scenario.interval, host::optionValue(argc, argv, "warmup", scenario.interval + 60));
+    scenario.horizon = host::optionValue(argc, argv, "horizon", 3600);
+    scenario.seed = host::optionValue(argc, argv, "seed", 1);
+    scenario.verbose = host::option(argc, argv, "verbose") != nullptr;
+    unsigned long jobs = std::max(1UL, host::optionValue(argc, argv, "jobs", sysconf(_SC_NPROCESSORS_ONLN)));
+
+    Fleet fleet;
+    fleet.seconds = scenario.warmup + scenario.horizon + 1;
+    fleet.joinAttempts = sharedArray<std::atomic<uint32_t>>(fleet.seconds);
+    fleet.joinsAccepted = sharedArray<std::atomic<uint32_t>>(fleet.seconds);
+    fleet.requestAttempts = sharedArray<std::atomic<uint32_t>>(fleet.seconds);
+    fleet.requestsAccepted = sharedArray<std::atomic<uint32_t>>(fleet.seconds);
+    fleet.recovered = sharedArray<std::atomic<uint32_t>>(scenario.devices);
+
+    printf("%lu devices, AP down %lu s, backend down %lu s, capacity %lu joins/s, %lu requests/s\n",
+        scenario.devices, scenario.apDown, scenario.serverDown, scenario.apRate, scenario.serverRate);
+    fflush(stdout);
+
+    unsigned long running = 0;
+    for (unsigned long device = 0; device < scenario.devices; device++) {
+        if (running == jobs) {
+            wait(nullptr);
+            running--;
+        }
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            runDevice(scenario, fleet, device);
+            exit(0);
+        }
+        running++;
+    }
+    while (running > 0 && wait(nullptr) > 0) running--;
+
+    std::vector<uint32_t> recovery;
+    for (unsigned long device = 0; device < scenario.devices; device++) {
+        if (fleet.recovered[device] > 0) recovery.push_back(fleet.recovered[device]);
+    }
+
+    uint64_t joins = 0;
+    uint64_t requests = 0;
+    uint32_t peakJoins = 0;
+    uint32_t peakRequests = 0;
+    for (unsigned second = scenario.warmup; second < fleet.seconds; second++) {
+        joins += fleet.joinAttempts[second];
+        requests += fleet.requestAttempts[second];
+        peakJoins = std::max<uint32_t>(peakJoins, fleet.joinAttempts[second]);
+        peakRequests = std::max<uint32_t>(peakRequests, fleet.requestAttempts[second]);
+    }
+
+    size_t delivered = recovery.size();
+    printf("%9s %8s %8s %8s %8s %8s %9s %9s\n", "recovered", "missing", "p50 s", "p99 s", "joins", "requests", "peak j/s", "peak r/s");
+    printf("%9zu %8zu %8.1f %8.1f %8llu %8llu %9u %9u\n", delivered, (size_t)scenario.devices - delivered,
+        percentile(recovery, 50) / 1000.0, percentile(recovery, 99) / 1000.0,
+        (unsigned long long)joins, (unsigned long long)requests, peakJoins, peakRequests);
+    return 0;
+}
@@ -0,0 +1,85 @@
+// Journal simulation: runs main.cpp on the host shims for hours of virtual
+// time and reports how many bytes the sketch writes to flash per day, per
+// file, under a given rate of server-side changes and Wi-Fi drops.
+//
+//     cmake -S . -B build && cmake --build build
+//     ./build/journal_sim --hours 24 --change 10 --drops 6
+//
+// Bytes are what the sketch hands to File::write(), so they cover journal
+// appends, compactions (written to /journal.tmp and renamed) and telemetry
+// spills, but not LittleFS metadata or block erase overhead.
+//
+// Options:
+//     --hours N        virtual run time, default 24
+//     --change N       backend state changes every N updates, default 10;
+//                      0 never changes it
+//     --uptime MS      update interval the backend hands out, default 60000
+//     --drops N        access point outages per day, 2 minutes each, default 0
+//     --verbose        echo the sketch's Serial output
+
+#include <Arduino.h>
+
+#include "host.h"
+#include "driver.h"
+
+void setup();
+void loop();
+
+int main(int argc, char** argv) {
+    unsigned long hours = host::optionValue(argc, argv, "hours", 24);
+    unsigned long drops = host::optionValue(argc, argv, "drops", 0);
+    host::Backend::Options backendOptions;
+    backendOptions.changeEvery = host::optionValue(argc, argv, "change", 10);
+    backendOptions.uptime = host::optionValue(argc, argv, "uptime", 60000);
+
+    host::setSerialEcho(host::option(argc, argv, "verbose") != nullptr);
+    host::makeTempFsRoot();
+    host::provisionWiFi("HostNet", "password");
+
+    host::Backend backend(backendOptions);
+    backend.install();
+
+    host::resetClock();
+    setup();
+    // Setup migrates /wifi.json and creates the first records; count steady state only
+    host::resetFlashStats();
+
+    const uint64_t outage = 2ULL * 60 * 1000000;
+    const uint64_t dropInterval = drops > 0 ? 24ULL * 3600 * 1000000 / drops : 0;
+    uint64_t start = host::clockMicros();
+    uint64_t end = start + (uint64_t)hours * 3600 * 1000000;
+    uint64_t nextDrop = start + dropInterval / 2;
+    unsigned long outages = 0;
+
+    while (host::clockMicros() < end) {
+        uint64_t now = host::clockMicros();
+        if (dropInterval > 0 && now >= nextDrop) {
+            host::setAccessPoint(false);
+            outages++;
+            nextDrop += dropInterval;
+        }
+        else if (!host::accessPointUp() && now >= nextDrop - dropInterval + outage) {
+            host::setAccessPoint(true);
+        }
+        loop();
+    }
+
+    double days = (host::clockMicros() - start) / (86400.0 * 1000000);
+    host::FlashStats flash = host::flashStats();
+    const host::Backend::Stats& server = backend.stats();
+    const char* files[] = { "/journal.bin", "/journal.tmp", "/telemetry.bin" };
+
+    printf("--- journal_sim: %lu virtual hours ---\n", hours);
+    printf("server: %llu updates, %llu not modified, state changed every %u updates; %lu AP outages\n",
+        (unsigned long long)server.updates, (unsigned long long)server.notModified, backendOptions.changeEvery, outages);
+    printf("%-16s %12s %14s\n", "file", "bytes", "bytes/day");
+    for (const char* file : files) {
+        uint64_t bytes = host::flashBytesWritten(file);
+        printf("%-16s %12llu %14.0f\n", file, (unsigned long long)bytes, bytes / days);
+    }
+    printf("%-16s %12llu %14.0f\n", "total", (unsigned long long)flash.bytesWritten, flash.bytesWritten / days);
+    printf("write calls: %llu, opens for write: %llu, renames: %llu, removes: %llu\n",
+        (unsigned long long)flash.writeCalls, (unsigned long long)flash.opensForWrite,
+        (unsigned long long)flash.renames, (unsigned long long)flash.removes);
+    return 0;
+}
@@ -0,0 +1,131 @@
+// Layout benchmark: runs main.cpp's display path on the host shims and
+// reports frames per second and heap allocations per frame for the text
+// layout before the cache, and for today's layout with the cache off and on.
+//
+//     cmake -S . -B build && cmake --build build
+//     ./build/layout_bench --frames 2000
+//
+// Rows, all on the virtual clock, so the GFX text costs and the I2C transfer
+// time charged by the shims are included:
+//     baseline  compose with centerText() as it was before the cache: a
+//               String per line, getTextBounds() and println() on every call
+//     cache off today's FixedString layout with the cache disabled, so every
+//               line is measured again
+//     cached    today's layout with the cache
+// and two measurements:
+//     compose   clearDisplay() and three centered lines, as
+//               benchmarkTextLayout() in main.cpp does
+//     frame     updateDisplay() with a changing time line, including the
+//               partial page flush over I2C (cache off and cached only; the
+//               frame path before the cache also differed outside the layout)
+//
+// Options:
+//     --frames N       frames per measurement, default 1000
+//     --verbose        echo the sketch's Serial output
+
+#include <Arduino.h>
+#include <Adafruit_SSD1306.h>
+#include <Wire.h>
+
+#include "host.h"
+#include "driver.h"
+
+void setup();
+void centerText(const char* text, int y);
+void updateDisplay(const char* line1, const char* line2, const char* line3);
+
+extern Adafruit_SSD1306 display;
+extern bool displayEnabled;
+extern bool textLayoutCacheEnabled;
+
+struct Measurement {
+    double fps;
+    double allocations;
+    double i2cBytes;
+};
+
+// centerText() before the layout cache, for the baseline row
+static void centerTextBaseline(String text, int y) {
+    int16_t x1, y1;
+    uint16_t w, h;
+
+    display.getTextBounds(text, 0, 0, &x1, &y1, &w, &h);
+
+    display.setCursor((display.width() - w) / 2, y);
+
+    display.println(text);
+}
+
+template <typename Frame>
+static Measurement measure(unsigned long frames, Frame frame) {
+    uint64_t start = host::clockMicros();
+    uint64_t allocations = host::heapAllocations();
+    uint64_t i2cBytes = Wire.bytesSent();
+
+    for (unsigned long i = 0; i < frames; i++) {
+        frame(i);
+    }
+
+    uint64_t elapsed = host::clockMicros() - start;
+    Measurement result;
+    result.fps = elapsed > 0 ? frames * 1e6 / elapsed : 0;
+    result.allocations = (double)(host::heapAllocations() - allocations) / frames;
+    result.i2cBytes = (double)(Wire.bytesSent() - i2cBytes) / frames;
+    return result;
+}
+
+int main(int argc, char** argv) {
+    unsigned long frames = host::optionValue(argc, argv, "frames", 1000);
+
+    host::setSerialEcho(host::option(argc, argv, "verbose") != nullptr);
+    host::makeTempFsRoot();
+    host::setAccessPoint(false);
+
+    host::resetClock();
+    setup();
+    if (!displayEnabled) {
+        fprintf(stderr, "display did not initialize\n");
+        return 1;
+    }
+
+    const char* line1 = "Welcome to the device!";
+    const char* line3 = "Status: New device";
+
+    printf("--- layout_bench: %lu frames ---\n", frames);
+    printf("%-10s %-8s %10s %14s %14s\n", "layout", "test", "frames/s", "allocs/frame", "I2C B/frame");
+
+    Measurement baseline = measure(frames, [&](unsigned long i) {
+        char line2[24];
+        snprintf(line2, sizeof(line2), "Time: %lu", 123456 + i);
+        display.clearDisplay();
+        centerTextBaseline(line1, 0);
+        centerTextBaseline(line2, 11);
+        centerTextBaseline(line3, 22);
+    });
+    printf("%-10s %-8s %10.0f %14.2f %14.1f\n", "baseline", "compose", baseline.fps, baseline.allocations, baseline.i2cBytes);
+
+    for (int pass = 0; pass < 2; pass++) {
+        textLayoutCacheEnabled = pass == 1;
+        const char* label = textLayoutCacheEnabled ? "cached" : "cache off";
+
+        Measurement compose = measure(frames, [&](unsigned long i) {
+            char line2[24];
+            snprintf(line2, sizeof(line2), "Time: %lu", 123456 + i);
+            display.clearDisplay();
+            centerText(line1, 0);
+            centerText(line2, 11);
+            centerText(line3, 22);
+        });
+        printf("%-10s %-8s %10.0f %14.2f %14.1f\n", label, "compose", compose.fps, compose.allocations, compose.i2cBytes);
+
+        Measurement frame = measure(frames, [&](unsigned long i) {
+            char line2[24];
+            snprintf(line2, sizeof(line2), "Time: %lu", 123456 + i);
+            updateDisplay(line1, line2, line3);
+        });
+        printf("%-10s %-8s %10.0f %14.2f %14.1f\n", label, "frame", frame.fps, frame.allocations, frame.i2cBytes);
+    }
+
+    textLayoutCacheEnabled = true;
+    return 0;
+}
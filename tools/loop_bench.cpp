@@ -0,0 +1,90 @@
+// Loop benchmark: runs main.cpp on the host shims, setup() and then loop()
+// for a stretch of virtual time, and reports scheduler pass latency
+// percentiles and heap high-water marks.
+//
+// Built by CMake together with main.cpp (compiled with LOOP_BENCHMARK):
+//
+//     cmake -S . -B build && cmake --build build
+//     ./build/loop_bench --minutes 60
+//
+// The device joins a simulated access point and talks to the in-process
+// backend from host/driver.h. delay() skips virtual time, so an hour of
+// device time takes seconds. Latency is the virtual time a loop() pass took,
+// less its trailing delay(): host CPU time plus the blocking costs the shims
+// charge (TLS handshakes, DNS, I2C transfers, text drawing).
+//
+// Options:
+//     --minutes N      virtual run time, default 60
+//     --change N       backend state changes every N updates, default 10
+//     --uptime MS      update interval the backend hands out, default 60000
+//     --padding BYTES  filler member in every backend response, default 0;
+//                      above 1024 the response no longer fits the device's body buffer
+//     --heap BYTES     simulated heap size, default 49152
+//     --metrics        print the /metrics page at the end
+//     --verbose        echo the sketch's Serial output
+
+#include <Arduino.h>
+#include <ESP8266WebServer.h>
+
+#include "host.h"
+#include "driver.h"
+
+void setup();
+void loop();
+
+extern ESP8266WebServer metricsServer;
+
+int main(int argc, char** argv) {
+    unsigned long minutes = host::optionValue(argc, argv, "minutes", 60);
+    host::Backend::Options backendOptions;
+    backendOptions.changeEvery = host::optionValue(argc, argv, "change", 10);
+    backendOptions.uptime = host::optionValue(argc, argv, "uptime", 60000);
+    backendOptions.padding = host::optionValue(argc, argv, "padding", 0);
+
+    host::setSerialEcho(host::option(argc, argv, "verbose") != nullptr);
+    host::setHeapSize(host::optionValue(argc, argv, "heap", 48 * 1024));
+    host::makeTempFsRoot();
+    host::provisionWiFi("HostNet", "password");
+
+    host::Backend backend(backendOptions);
+    backend.install();
+
+    host::resetClock();
+    setup();
+    size_t heapAfterSetup = host::heapInUse();
+    uint64_t setupMicros = host::clockMicros();
+
+    host::Samples passes;
+    uint64_t end = setupMicros + (uint64_t)minutes * 60 * 1000000;
+    while (host::clockMicros() < end) {
+        uint64_t start = host::clockMicros();
+        uint64_t delayed = host::delayedMicros();
+        loop();
+        uint64_t busy = (host::clockMicros() - start) - (host::delayedMicros() - delayed);
+        passes.add(busy > UINT32_MAX ? UINT32_MAX : (uint32_t)busy);
+    }
+
+    host::NetStats net = host::netStats();
+    host::FlashStats flash = host::flashStats();
+    const host::Backend::Stats& server = backend.stats();
+
+    printf("--- loop_bench: %lu virtual minutes ---\n", minutes);
+    printf("setup: %.1f ms virtual, heap in use after setup %zu bytes\n", setupMicros / 1000.0, heapAfterSetup);
+    printf("loop passes: %zu, mean %.1f us\n", passes.count(), passes.mean());
+    printf("latency p50 %u us, p90 %u us, p99 %u us, p99.9 %u us, max %u us\n",
+        passes.percentile(50), passes.percentile(90), passes.percentile(99), passes.percentile(99.9), passes.max());
+    printf("heap: peak %zu of %zu bytes in use, min free %zu bytes, %llu allocations\n",
+        host::heapPeak(), host::heapSize(), host::heapSize() - std::min(host::heapPeak(), host::heapSize()),
+        (unsigned long long)host::heapAllocations());
+    printf("network: %llu connects, %llu requests (%llu updates, %llu not modified, %llu telemetry)\n",
+        (unsigned long long)net.connects, (unsigned long long)net.requests, (unsigned long long)server.updates,
+        (unsigned long long)server.notModified, (unsigned long long)server.telemetry);
+    printf("flash: %llu bytes in %llu writes\n", (unsigned long long)flash.bytesWritten, (unsigned long long)flash.writeCalls);
+    printf("host CPU: %.2f s\n", host::busyMicros() / 1e6);
+
+    if (host::option(argc, argv, "metrics") != nullptr) {
+        ESP8266WebServer::Response response = metricsServer.hostRequest("/metrics");
+        printf("--- /metrics (HTTP %d) ---\n%s", response.code, response.body.c_str());
+    }
+    return 0;
+}
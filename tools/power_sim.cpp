@@ -0,0 +1,237 @@
+// Power simulation: runs main.cpp on the host shims for hours of virtual time
+// and estimates the duty cycle and battery life of the POWER_PROFILE it was
+// built with. CMake builds one binary per profile:
+//
+//     cmake -S . -B build && cmake --build build
+//     ./build/power_sim_modem_sleep --hours 24 --interval 600
+//     ./build/power_sim_deep_sleep --hours 24 --interval 600
+//
+// Time is split from what the sketch actually did on the virtual clock:
+//     tx        blocking DNS lookups, connect timeouts and TLS handshakes
+//               charged by the shims, plus --post per HTTP request (the shims
+//               do not model air time for the request itself)
+//     active    CPU busy outside delay(), Wi-Fi joins in progress, and idle
+//               time with WIFI_NONE_SLEEP
+//     idle      time inside delay(), at the modem or light sleep current for
+//               the sleep mode the sketch set; light sleep wakes the radio
+//               for every DTIM beacon at its listen interval
+//     deep      time the sketch asked ESP.deepSleep() for
+// The deep sleep profile runs as one forked boot per wake with the RTC memory
+// and flash carried over, so the restored state, journal and telemetry spill
+// are the firmware's own. Each wake adds --boot of active time before setup().
+//
+// Currents are typical ESP8266 datasheet figures plus the SSD1306, which is
+// lit whenever the device is awake; adjust them to measurements on real
+// hardware.
+//
+// Options:
+//     --hours N        virtual run time, default 24
+//     --interval S     update interval the backend hands out, default 600
+//     --change N       backend state changes every N updates, default 10
+//     --capacity MAH   battery capacity, default 1000
+//     --post S         radio time per request and response, default 0.4
+//     --boot S         wake from deep sleep to setup(), default 0.25
+//     --outage         backend answers 503 from the second boot on
+//     --ap-outage      access point is down from the second boot on
+//     --verbose        echo the sketch's Serial output
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+#include "host.h"
+#include "driver.h"
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+void setup();
+void loop();
+
+const char* powerProfileName();
+
+namespace {
+
+// mA
+const double CURRENT_ACTIVE = 70.0;       // CPU running, radio receiving
+const double CURRENT_TX = 170.0;          // radio transmitting (TLS handshake, POST)
+const double CURRENT_MODEM_SLEEP = 15.0;  // CPU running, radio off between DTIM beacons
+const double CURRENT_LIGHT_SLEEP = 0.9;   // CPU clock gated, radio off
+const double CURRENT_DEEP_SLEEP = 0.02;   // RTC only
+const double CURRENT_DISPLAY = 8.0;       // SSD1306 with a few lines lit
+
+const double BEACON_INTERVAL = 0.1024;    // s
+const double BEACON_RX_TIME = 0.003;      // s awake per received beacon
+
+// Shared with the forked boots; seconds of each state
+struct Ledger {
+    double tx;
+    double active;
+    double modemSleep;
+    double lightSleep;
+    double beacons;
+    double deepSleep;
+    uint64_t elapsedMicros;
+    uint64_t sleepMicros;
+    bool slept;
+    unsigned long wakeups;
+    unsigned long requests;
+    unsigned long joins;
+};
+
+struct Settings {
+    uint64_t endMicros;
+    double post;
+    double boot;
+    bool verbose;
+    bool outage;
+    bool apOutage;
+    host::Backend::Options backend;
+};
+
+// One boot of the sketch, until it goes to deep sleep or the run ends
+void runBoot(const Settings& settings, Ledger& ledger) {
+    host::setSerialEcho(settings.verbose);
+    host::seedRandom(ledger.wakeups + 1);
+    host::Backend backend(settings.backend);
+    backend.install();
+    // Отказ начинается после первой загрузки: устройство успевает получить настройки и уснуть
+    if (settings.outage && ledger.wakeups > 0) backend.setFailStatus(503);
+    host::setAccessPoint(!(settings.apOutage && ledger.wakeups > 0));
+    host::setDeepSleepHandler([&](uint64_t micros) {
+        ledger.sleepMicros = micros;
+        ledger.slept = true;
+        exit(0);
+    });
+
+    host::resetClock();
+    uint64_t clock = 0;
+    uint64_t delayed = host::delayedMicros();
+    uint64_t blocked = host::netStats().blockedMicros;
+    uint64_t joining = host::wifiStats().joiningMicros;
+    uint64_t requests = host::netStats().requests;
+    uint64_t joins = host::wifiStats().joins;
+
+    bool started = false;
+    while (ledger.elapsedMicros < settings.endMicros) {
+        if (!started) {
+            setup();
+            started = true;
+        }
+        else {
+            loop();
+        }
+
+        host::WiFiStats wifi = host::wifiStats();
+        host::NetStats net = host::netStats();
+        uint64_t now = host::clockMicros();
+        double passed = (now - clock) / 1e6;
+        double idle = (host::delayedMicros() - delayed) / 1e6;
+        double tx = (net.blockedMicros - blocked) / 1e6;
+        double join = std::min((wifi.joiningMicros - joining) / 1e6, idle);
+        idle -= join;
+
+        ledger.tx += tx + (net.requests - requests) * settings.post;
+        ledger.active += std::max(passed - idle - join - tx, 0.0) + join;
+        if (wifi.sleepMode == WIFI_MODEM_SLEEP) {
+            ledger.modemSleep += idle;
+        }
+        else if (wifi.sleepMode == WIFI_LIGHT_SLEEP) {
+            double beacons = idle / (BEACON_INTERVAL * std::max<uint8_t>(wifi.listenInterval, 1)) * BEACON_RX_TIME;
+            ledger.beacons += std::min(beacons, idle);
+            ledger.lightSleep += idle - std::min(beacons, idle);
+        }
+        else {
+            ledger.active += idle;
+        }
+        ledger.requests += net.requests - requests;
+        ledger.joins += wifi.joins - joins;
+        ledger.elapsedMicros += now - clock;
+
+        clock = now;
+        delayed = host::delayedMicros();
+        blocked = net.blockedMicros;
+        joining = wifi.joiningMicros;
+        requests = net.requests;
+        joins = wifi.joins;
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    unsigned long hours = host::optionValue(argc, argv, "hours", 24);
+    unsigned long interval = host::optionValue(argc, argv, "interval", 600);
+    double capacity = host::optionReal(argc, argv, "capacity", 1000);
+
+    Settings settings;
+    settings.endMicros = (uint64_t)hours * 3600 * 1000000;
+    settings.post = host::optionReal(argc, argv, "post", 0.4);
+    settings.boot = host::optionReal(argc, argv, "boot", 0.25);
+    settings.verbose = host::option(argc, argv, "verbose") != nullptr;
+    settings.outage = host::option(argc, argv, "outage") != nullptr;
+    settings.apOutage = host::option(argc, argv, "ap-outage") != nullptr;
+    settings.backend.uptime = interval * 1000;
+    settings.backend.changeEvery = host::optionValue(argc, argv, "change", 10);
+
+    host::makeTempFsRoot();
+    host::provisionWiFi("HostNet", "password");
+
+    void* shared = mmap(nullptr, sizeof(Ledger), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    Ledger& ledger = *new (shared) Ledger();
+
+    while (ledger.elapsedMicros < settings.endMicros) {
+        if (ledger.wakeups > 0) {
+            host::setResetReason(REASON_DEEP_SLEEP_AWAKE);
+            ledger.active += settings.boot;
+            ledger.elapsedMicros += (uint64_t)(settings.boot * 1e6);
+        }
+        ledger.slept = false;
+        fflush(stdout);
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            runBoot(settings, ledger);
+            exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "boot %lu failed\n", ledger.wakeups);
+            return 1;
+        }
+        if (!ledger.slept) break;
+
+        uint64_t sleep = std::min(ledger.sleepMicros, settings.endMicros - std::min(settings.endMicros, ledger.elapsedMicros));
+        ledger.deepSleep += sleep / 1e6;
+        ledger.elapsedMicros += sleep;
+        ledger.wakeups++;
+    }
+
+    double total = ledger.tx + ledger.active + ledger.modemSleep + ledger.lightSleep + ledger.beacons + ledger.deepSleep;
+    double awake = total - ledger.deepSleep;
+    double charge = ledger.tx * CURRENT_TX + (ledger.active + ledger.beacons) * CURRENT_ACTIVE +
+        ledger.modemSleep * CURRENT_MODEM_SLEEP + ledger.lightSleep * CURRENT_LIGHT_SLEEP +
+        ledger.deepSleep * CURRENT_DEEP_SLEEP + awake * CURRENT_DISPLAY;
+    double current = total > 0 ? charge / total : 0;
+    double duty = total > 0 ? (ledger.tx + ledger.active + ledger.beacons) / total : 0;
+
+    printf("--- power_sim: %lu virtual hours, interval %lu s, battery %.0f mAh%s%s ---\n", hours, interval, capacity,
+        settings.outage ? ", backend outage" : "", settings.apOutage ? ", access point outage" : "");
+    printf("%-12s %8s %8s %6s %9s %8s %9s %8s %8s\n", "profile", "wakeups", "requests", "joins",
+        "tx s", "active s", "duty", "avg mA", "life d");
+    printf("%-12s %8lu %8lu %6lu %9.1f %8.1f %8.2f%% %8.2f %8.1f\n", powerProfileName(), ledger.wakeups,
+        ledger.requests, ledger.joins, ledger.tx, ledger.active, duty * 100, current,
+        current > 0 ? capacity / current / 24 : 0);
+    return 0;
+}
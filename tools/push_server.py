@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""Minimal WebSocket stand-in for testing the device push channel locally.
+
+Set PUSH_URL in main.cpp to "ws://<this machine>:8765/" and PUSH_ENABLED to
+true, then run:
+
+    python3 tools/push_server.py --port 8765
+
+Every line typed on stdin is pushed to all connected devices. A line that
+is valid JSON is sent as is, e.g. {"text": "Hello", "status": "busy"};
+anything else is sent as {"text": "<line>"}. Subscribe messages, pings and
+closes from the devices are printed.
+"""
+
+import argparse
+import base64
+import hashlib
+import json
+import socket
+import struct
+import sys
+import threading
+
+GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+OP_TEXT = 0x1
+OP_CLOSE = 0x8
+OP_PING = 0x9
+OP_PONG = 0xA
+
+clients = []
+clients_lock = threading.Lock()
+
+
+def encode_frame(opcode, payload):
+    header = bytes([0x80 | opcode])
+    length = len(payload)
+    if length < 126:
+        header += bytes([length])
+    elif length < 65536:
+        header += bytes([126]) + struct.pack(">H", length)
+    else:
+        header += bytes([127]) + struct.pack(">Q", length)
+    return header + payload
+
+
+def read_exact(sock, count):
+    data = b""
+    while len(data) < count:
+        chunk = sock.recv(count - len(data))
+        if not chunk:
+            raise ConnectionError("closed")
+        data += chunk
+    return data
+
+
+def read_frame(sock):
+    first, second = read_exact(sock, 2)
+    opcode = first & 0x0F
+    length = second & 0x7F
+    if length == 126:
+        length = struct.unpack(">H", read_exact(sock, 2))[0]
+    elif length == 127:
+        length = struct.unpack(">Q", read_exact(sock, 8))[0]
+    mask = read_exact(sock, 4) if second & 0x80 else None
+    payload = read_exact(sock, length)
+    if mask:
+        payload = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+    return opcode, payload
+
+
+def handshake(sock):
+    request = b""
+    while b"\r\n\r\n" not in request:
+        chunk = sock.recv(1024)
+        if not chunk:
+            raise ConnectionError("closed during handshake")
+        request += chunk
+
+    key = None
+    for line in request.decode("latin-1").split("\r\n")[1:]:
+        name, _, value = line.partition(":")
+        if name.strip().lower() == "sec-websocket-key":
+            key = value.strip()
+    if key is None:
+        sock.sendall(b"HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n")
+        raise ConnectionError("not a WebSocket upgrade")
+
+    accept = base64.b64encode(hashlib.sha1((key + GUID).encode()).digest()).decode()
+    sock.sendall(("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                  "Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n" % accept).encode())
+
+
+def serve_client(sock, address):
+    name = "%s:%d" % address
+    try:
+        handshake(sock)
+        print("[%s] connected" % name)
+        with clients_lock:
+            clients.append(sock)
+
+        while True:
+            opcode, payload = read_frame(sock)
+            if opcode == OP_TEXT:
+                print("[%s] %s" % (name, payload.decode("utf-8", "replace")))
+            elif opcode == OP_PING:
+                print("[%s] ping" % name)
+                sock.sendall(encode_frame(OP_PONG, payload))
+            elif opcode == OP_CLOSE:
+                sock.sendall(encode_frame(OP_CLOSE, payload[:2]))
+                break
+    except (ConnectionError, OSError) as e:
+        print("[%s] %s" % (name, e))
+    finally:
+        with clients_lock:
+            if sock in clients:
+                clients.remove(sock)
+        sock.close()
+        print("[%s] disconnected" % name)
+
+
+def broadcast(line):
+    try:
+        json.loads(line)
+        message = line
+    except ValueError:
+        message = json.dumps({"text": line}, ensure_ascii=False)
+
+    frame = encode_frame(OP_TEXT, message.encode("utf-8"))
+    with clients_lock:
+        targets = list(clients)
+    for sock in targets:
+        try:
+            sock.sendall(frame)
+        except OSError:
+            pass
+    print("pushed to %d device(s): %s" % (len(targets), message))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=8765)
+    args = parser.parse_args()
+
+    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind((args.host, args.port))
+    server.listen()
+    print("listening on ws://%s:%d/" % (args.host, args.port))
+
+    def accept_loop():
+        while True:
+            sock, address = server.accept()
+            threading.Thread(target=serve_client, args=(sock, address), daemon=True).start()
+
+    threading.Thread(target=accept_loop, daemon=True).start()
+
+    for line in sys.stdin:
+        line = line.strip()
+        if line:
+            broadcast(line)
+
+
+if __name__ == "__main__":
+    main()